@@ -2,7 +2,13 @@
  * File name     :      adc.h
  * Description   :      Header file for ADC peripheral configuration and control.
  *                      Provides function prototypes for initializing ADC1,
- *                      starting conversions, and reading ADC values.
+ *                      starting conversions, and reading ADC values, either
+ *                      polled or streamed by DMA1 Channel 1 into a circular
+ *                      ping-pong buffer, for one channel or a scan sequence
+ *                      of up to 16 channels with per-channel sampling time,
+ *                      or with ADC2 slaved for simultaneous/interleaved sampling.
+ *                      Analog watchdogs AWD1..AWD3 flag out-of-range channels
+ *                      by interrupt.
  *
  * Author        :      Jere Piirainen
  * Date          :      2025-06-15
@@ -16,9 +22,10 @@
 /* --- Clock Enable Defines --- */
 #define GPIOAEN         (1U << 17)  // Clock enable bit for GPIOA in RCC_AHBENR
 #define ADC1EN          (1U << 28)  // Clock enable bit for ADC1/ADC2 in RCC_AHBENR
+#define DMA1EN          (1U << 0)   // Clock enable bit for DMA1 in RCC_AHBENR
 
 /* --- ADC Channel and Sequence Defines --- */
-#define ADC1_CH1        (1U << 6)   // SQR1_SQ1 bits for Channel 1 (PA1)
+#define ADC1_CH2        (2U << 6)   // SQR1_SQ1 bits for Channel 2 (PA1 is ADC1_IN2)
 #define ADC1_SEQ_LEN    0x00        // L bits in SQR1 = 0000b for 1 conversion in sequence
 
 /* --- ADC Control Register (CR) Bit Defines --- */
@@ -29,14 +36,180 @@
 /* --- ADC Interrupt and Status Register (ISR) Bit Defines --- */
 #define ISR_ADRDY       (1U << 0)   // ADC Ready flag
 #define ISR_EOC         (1U << 2)   // End Of Conversion flag
+#define ISR_OVR         (1U << 4)   // Overrun flag, a result was lost
+#define ISR_AWD1        (1U << 7)   // Analog watchdog 1 flag, AWD2 and AWD3 follow
+
+/* --- ADC Interrupt Enable Register (IER) Bit Defines --- */
+#define IER_OVRIE       (1U << 4)   // Overrun interrupt enable
+#define IER_AWD1IE      (1U << 7)   // Analog watchdog 1 interrupt enable, AWD2IE and AWD3IE follow
 
 /* --- ADC Configuration Register (CFGR) Bit Defines --- */
+#define CFGR_DMAEN      (1U << 0)   // DMA request on every end of conversion
+#define CFGR_DMACFG     (1U << 1)   // DMA circular mode (requests never stop)
 #define CFGR_CONT       (1U << 13)  // Continuous Conversion Mode bit
 
+/* --- DMA1 Channel 1 (ADC1) CCR Bit Defines --- */
+#define DMA1_CCR_EN     (1U << 0)   // Channel enable
+#define DMA1_CCR_TCIE   (1U << 1)   // Transfer complete interrupt enable
+#define DMA1_CCR_HTIE   (1U << 2)   // Half transfer interrupt enable
+#define DMA1_CCR_TEIE   (1U << 3)   // Transfer error interrupt enable
+#define DMA1_CIRC       (1U << 5)   // Circular mode
+#define DMA1_MINC       (1U << 7)   // Memory increment
+#define DMA1_PSIZE16    (1U << 8)   // Peripheral size 16 bits
+#define DMA1_PSIZE32    (2U << 8)   // Peripheral size 32 bits
+#define DMA1_MSIZE16    (1U << 10)  // Memory size 16 bits
+#define DMA1_MSIZE32    (2U << 10)  // Memory size 32 bits
+#define DMA1_PL_HIGH    (2U << 12)  // Priority level high
+
+/* --- DMA1 ISR/IFCR Channel 1 Flags --- */
+#define DMA1_ISR_GIF1   (1U << 0)   // Global flag, IFCR: clears all channel 1 flags
+#define DMA1_ISR_TCIF1  (1U << 1)   // Transfer complete
+#define DMA1_ISR_HTIF1  (1U << 2)   // Half transfer
+#define DMA1_ISR_TEIF1  (1U << 3)   // Transfer error
+
+/* --- Scan sequence --- */
+#define ADC_SEQ_MAX         16U     // Regular sequence length limit (SQ1..SQ16)
+#define ADC_CHANNEL_MAX     18U     // IN1..IN18 (16 = temperature sensor, 18 = VREFINT on ADC1)
+
+/**
+ * @brief Sampling time, in ADC clock cycles. Conversion adds 12.5 cycles.
+ */
+typedef enum {
+    ADC_SMP_1C5 = 0,
+    ADC_SMP_2C5,
+    ADC_SMP_4C5,
+    ADC_SMP_7C5,
+    ADC_SMP_19C5,
+    ADC_SMP_61C5,
+    ADC_SMP_181C5,
+    ADC_SMP_601C5,
+} adc_smp_t;
+
+/**
+ * @brief One entry of the regular sequence.
+ */
+typedef struct {
+    uint8_t channel;        // 1..ADC_CHANNEL_MAX
+    adc_smp_t smp;          // Sampling time; a channel listed twice keeps the last one
+} adc_seq_entry_t;
+
+/**
+ * @brief Strided, zero-copy view of one channel inside an interleaved block.
+ * Sample i of the channel is base[i * stride].
+ */
+typedef struct {
+    const uint16_t *base;
+    uint32_t stride;        // Sequence length
+    uint32_t count;         // Frames in the block
+} adc_channel_view_t;
+
+/* --- Streaming configuration --- */
+#define ADC_DMA_BUF_LEN     512U    // Samples in the circular buffer, two blocks of half this
+#define ADC_DMA_BLOCK_LEN   (ADC_DMA_BUF_LEN / 2U)  // Trimmed to whole frames for a scan sequence
+#define ADC_IRQ_PRIORITY    1U      // DMA1 CH1 and ADC1_2 interrupts
+
+/*
+ * Rate: ADC clock HCLK/1 = 72 MHz, 1.5 cycle sampling + 12.5 cycle conversion
+ * gives 14 cycles per sample, 5.14 MSPS in continuous mode. One block
+ * callback then arrives every ~50 us.
+ */
+
+/**
+ * @brief Called from the DMA1 Channel 1 interrupt with a block of samples.
+ * The block stays valid until the DMA comes back around to it, i.e. for the
+ * time it takes to fill the other half of the buffer.
+ * With a scan sequence the block holds whole frames, samples interleaved in
+ * sequence order; use adcChannelView() to walk one channel.
+ * @param block First sample of the block (12-bit right-aligned values).
+ * @param len Number of samples, a multiple of the sequence length.
+ */
+typedef void (*adc_block_callback_t)(const uint16_t *block, uint32_t len);
+
+/**
+ * @brief Dual mode variant, ADC1 master and ADC2 slave.
+ * Simultaneous: both convert their channel on the same TIM3 TRGO edge,
+ * e.g. voltage on one and current on the other, phase coherent.
+ * Interleaved: both convert the same channel, ADC2 starting 7 cycles after
+ * ADC1, for 72 MHz / 7 = 10.3 MSPS on one input. The channel must be one
+ * wired to both ADCs (ADC12_INx, e.g. IN6..IN9 on PC0..PC3).
+ */
+typedef enum {
+    ADC_DUAL_SIMULTANEOUS = 0,
+    ADC_DUAL_INTERLEAVED,
+} adc_dual_mode_t;
+
+/**
+ * @brief Called from the DMA1 Channel 1 interrupt with a block of dual results.
+ * Each word is one CDR read: ADC1 result in bits 15:0, ADC2 in bits 31:16.
+ * In interleaved mode the samples in time order are low, high, low, high...
+ * @param pairs First packed result of the block.
+ * @param len Number of words, ADC_DMA_BUF_LEN / 4.
+ */
+typedef void (*adc_dual_callback_t)(const uint32_t *pairs, uint32_t len);
+
+/* CDR halves */
+#define ADC_CDR_MASTER(w)   ((uint16_t)((w) & 0xFFFFU))
+#define ADC_CDR_SLAVE(w)    ((uint16_t)((w) >> 16))
+
+/*
+ * Throughput: a CDR word per pair halves the DMA load. Interleaved at
+ * 10.3 MSPS is 5.14 M word transfers/s on DMA1, about one AHB access in
+ * seven cycles for each side, which the bus sustains with the CPU running
+ * from flash. Anything else on DMA1 or a long ISR on the same priority
+ * shows up in adc_stats_t.overruns; main's ADC_DUAL_DEMO prints the rate
+ * actually delivered.
+ */
+
+/**
+ * @brief Streaming counters.
+ */
+typedef struct {
+    uint32_t blocks;        // Blocks handed to the callback
+    uint32_t overruns;      // ADC results lost because the DMA did not read DR in time
+    uint32_t dma_errors;    // DMA transfer errors (streaming stops)
+    uint32_t resyncs;       // Scan restarts after an overrun broke the frame alignment
+} adc_stats_t;
+
+
+/* --- Analog watchdogs --- */
+/**
+ * @brief ADC1 analog watchdogs. AWD1 compares all 12 bits, AWD2 and AWD3
+ * only the 8 most significant bits, so their thresholds are rounded to
+ * multiples of 16 LSB. Each one guards a single channel here, which keeps
+ * the trip counters per channel.
+ */
+typedef enum {
+    ADC_AWD1 = 0,
+    ADC_AWD2,
+    ADC_AWD3,
+    ADC_AWD_COUNT,
+} adc_awd_t;
+
+/**
+ * @brief Called from the ADC1_2 interrupt when a watchdog trips.
+ * @param awd Watchdog that tripped.
+ * @param channel Channel it guards.
+ * @param timestamp DWT->CYCCNT at the interrupt, HCLK cycles.
+ */
+typedef void (*adc_awd_callback_t)(adc_awd_t awd, uint8_t channel, uint32_t timestamp);
+
+/**
+ * @brief Watchdog state and trip counters.
+ */
+typedef struct {
+    uint8_t channel;        // 0 when the watchdog is off
+    uint8_t armed;          // Interrupt enabled, cleared on a trip
+    uint16_t low;           // Thresholds actually programmed, 12-bit scale
+    uint16_t high;
+    uint32_t trips;         // Trips since adcWatchdogConfig()
+    uint32_t last_trip;     // DWT->CYCCNT of the last trip
+} adc_awd_stats_t;
+
 
 /**
  * @brief Initializes GPIOA pin 1 (PA1) for analog input and configures the ADC1 module.
  * This includes enabling clocks, voltage regulator, calibration, and basic ADC setup.
+ * PA1 (IN2) is sampled for 19.5 ADC cycles, 32 cycles per conversion.
  */
 void pa1ADCInit(void);
 
@@ -53,5 +226,127 @@ void startConversion(void);
  */
 uint32_t adcRead(void);
 
+/**
+ * @brief Programs the regular sequence (SQR1..SQR4) and the sampling time of
+ * each listed channel (SMPR1/SMPR2). Enables the temperature sensor or
+ * VREFINT when channel 16 or 18 is listed. The analog pins themselves
+ * must already be in analog mode.
+ * @param seq Channels in conversion order.
+ * @param len Sequence length, 1..ADC_SEQ_MAX.
+ * @return 0 on success, -1 on a bad entry or while conversions are running.
+ */
+int adcSequenceConfig(const adc_seq_entry_t *seq, uint32_t len);
+
+/**
+ * @brief Returns the programmed sequence length (frame size in samples).
+ */
+uint32_t adcSequenceLength(void);
+
+/**
+ * @brief Builds a view of one sequence position inside an interleaved block.
+ * No data is copied; the view is valid as long as the block is.
+ * @param block Block from the callback.
+ * @param len Block length from the callback.
+ * @param index Position in the sequence, 0..adcSequenceLength()-1.
+ * @param view Filled with base, stride and frame count.
+ */
+void adcChannelView(const uint16_t *block, uint32_t len, uint32_t index, adc_channel_view_t *view);
+
+/**
+ * @brief Sample i of a channel view.
+ */
+static inline uint16_t adcViewAt(const adc_channel_view_t *view, uint32_t i)
+{
+	return view->base[i * view->stride];
+}
+
+/**
+ * @brief Starts gap-free continuous conversion into the circular DMA buffer.
+ * DMA1 Channel 1 moves every result; its half-transfer and transfer-complete
+ * interrupts hand the first and second half of the buffer to the callback.
+ * Assumes pa1ADCInit() has been called. adcRead() must not be used while
+ * streaming, the DMA consumes the results.
+ * @param callback Block handler, called from interrupt context.
+ * @return 0 on success, -1 while conversions are running (e.g. after startConversion()).
+ */
+int adcDmaStart(adc_block_callback_t callback);
+
+/**
+ * @brief Starts conversions paced by TIM3 TRGO into the circular DMA buffer.
+ * Each TIM3 update event starts exactly one conversion, so the sample rate
+ * is TIM3_TRGO_FREQ (1 Hz .. 1 MSPS, checked at compile time) with the
+ * timer's crystal-derived accuracy and no software in the timing path.
+ * Blocks are delivered like in adcDmaStart(), every ADC_DMA_BLOCK_LEN / rate seconds.
+ * With a scan sequence each trigger converts one whole frame.
+ * Assumes pa1ADCInit() has been called.
+ * @param callback Block handler, called from interrupt context.
+ * @return 0 on success, -1 if a frame takes longer to convert than the trigger period
+ * or while conversions are running.
+ */
+int adcTimerStart(adc_block_callback_t callback);
+
+/**
+ * @brief Starts ADC1 and ADC2 in dual mode with packed results on DMA1 Channel 1.
+ * Brings ADC2 up on first use. Simultaneous mode samples at TIM3_TRGO_FREQ
+ * with 19.5 cycle sampling, interleaved mode free-runs with 1.5 cycle
+ * sampling. The analog pins must already be in analog mode.
+ * @param mode Simultaneous or interleaved.
+ * @param ch_master ADC1 channel.
+ * @param ch_slave ADC2 channel (the same input as ch_master for interleaving).
+ * @param callback Block handler, called from interrupt context.
+ * @return 0 on success, -1 on a bad channel or while conversions are running.
+ */
+int adcDualStart(adc_dual_mode_t mode, uint8_t ch_master, uint8_t ch_slave, adc_dual_callback_t callback);
+
+/**
+ * @brief Stops conversions, the trigger timer and the DMA stream.
+ * Leaves dual mode if it was active and puts back the ADC1 sequence and
+ * sampling times it replaced.
+ */
+void adcDmaStop(void);
+
+/**
+ * @brief Returns a snapshot of the streaming counters.
+ * @param stats Destination.
+ */
+void adcGetStats(adc_stats_t *stats);
+
+/**
+ * @brief Guards one channel with a watchdog. A conversion of the channel
+ * outside [low, high] raises the ADC1_2 interrupt; nothing runs until then,
+ * whatever the sample rate.
+ * The watchdog disarms itself on a trip so a channel that stays out of
+ * range does not interrupt on every conversion; adcWatchdogRearm() turns it
+ * back on. Must be called while conversions are stopped.
+ * @param awd Watchdog to use.
+ * @param channel Channel to guard, 1..ADC_CHANNEL_MAX.
+ * @param low Lowest in-range value, 12-bit.
+ * @param high Highest in-range value, 12-bit.
+ * @param callback Trip handler, called from interrupt context, or NULL.
+ * @return 0 on success, -1 on a bad argument or while conversions are running.
+ */
+int adcWatchdogConfig(adc_awd_t awd, uint8_t channel, uint16_t low, uint16_t high, adc_awd_callback_t callback);
+
+/**
+ * @brief Clears a pending trip and re-enables the watchdog interrupt.
+ * Can be called while converting.
+ * @param awd Watchdog to re-arm.
+ */
+void adcWatchdogRearm(adc_awd_t awd);
+
+/**
+ * @brief Turns a watchdog off and releases its channel.
+ * @param awd Watchdog to turn off.
+ * @return 0 on success, -1 while conversions are running.
+ */
+int adcWatchdogDisable(adc_awd_t awd);
+
+/**
+ * @brief Returns a snapshot of one watchdog's state and counters.
+ * @param awd Watchdog.
+ * @param stats Destination.
+ */
+void adcWatchdogGetStats(adc_awd_t awd, adc_awd_stats_t *stats);
+
 
 #endif /* ADC_H_ */
@@ -0,0 +1,61 @@
+/***************************************************************************
+ * File name     :  clock.h
+ * Description   :  Header file for the clock tree configuration.
+ *                  Defines the target bus frequencies brought up by
+ *                  SystemInit() and declares functions returning the
+ *                  frequencies actually running, so peripheral drivers can
+ *                  derive their dividers instead of hard-coding them.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include <stdint.h>
+
+/* --- Oscillator frequencies --- */
+#define HSI_VALUE           8000000U    // Internal RC oscillator
+#define HSE_VALUE           8000000U    // ST-LINK MCO output on Nucleo boards
+
+/* --- Clock source selection --- */
+#define CLOCK_USE_HSE       0           // 1: PLL from HSE bypass (falls back to HSI), 0: PLL from HSI
+
+/* --- Target frequencies after SystemInit() --- */
+#define CLOCK_SYSCLK_FREQ   72000000U   // PLL: 8 MHz / 1 * 9
+#define CLOCK_HCLK_FREQ     72000000U   // AHB prescaler /1
+#define CLOCK_PCLK1_FREQ    36000000U   // APB1 prescaler /2 (36 MHz max)
+#define CLOCK_PCLK2_FREQ    72000000U   // APB2 prescaler /1
+#define CLOCK_TIM_APB1_FREQ 72000000U   // APB1 timers run at 2 x PCLK1 when APB1 is divided
+#define CLOCK_I2C1_FREQ     HSI_VALUE   // I2C1 kernel clock is left on HSI
+
+
+/**
+ * @brief Returns the AHB (HCLK) frequency in Hz, also used by the core and SysTick.
+ */
+uint32_t clockGetHclkFreq(void);
+
+/**
+ * @brief Returns the APB1 peripheral clock (PCLK1) frequency in Hz.
+ * Feeds USART2/3, I2C1/2 (register interface) and the APB1 timer prescaler.
+ */
+uint32_t clockGetPclk1Freq(void);
+
+/**
+ * @brief Returns the APB2 peripheral clock (PCLK2) frequency in Hz.
+ */
+uint32_t clockGetPclk2Freq(void);
+
+/**
+ * @brief Returns the counter clock of the timers on APB1 (TIM2/3/4/6/7) in Hz.
+ * This is PCLK1 when APB1 is undivided and 2 x PCLK1 otherwise.
+ */
+uint32_t clockGetTimApb1Freq(void);
+
+/**
+ * @brief Returns the I2C1 kernel clock (I2CCLK) frequency in Hz, HSI or SYSCLK
+ * depending on RCC_CFGR3.I2C1SW.
+ */
+uint32_t clockGetI2c1Freq(void);
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,64 @@
+/***************************************************************************
+ * File name     :  decim.h
+ * Description   :  Header file for the ADC decimation stage. Declares a
+ *                  sum-and-dump (first-order CIC) decimator with an optional
+ *                  Q15 FIR, run on DMA blocks with the Cortex-M4 SIMD
+ *                  instructions, trading sample rate for resolution.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef DECIM_H_
+#define DECIM_H_
+
+#include <stdint.h>
+
+/* --- Decimation configuration --- */
+#ifndef DECIM_RATIO_LOG4
+#define DECIM_RATIO_LOG4    4U      // Ratio 4^n, each factor of 4 buys one bit (white noise)
+#endif
+#define DECIM_RATIO         (1U << (2U * DECIM_RATIO_LOG4))
+#define DECIM_OUT_BITS      (12U + DECIM_RATIO_LOG4)    // Effective resolution of the output
+#define DECIM_FIR_TAPS      16U     // Optional low-pass after the decimator, even, Q15
+
+_Static_assert((DECIM_RATIO_LOG4 >= 1U) && (DECIM_RATIO_LOG4 <= 4U), "Decimation gives 13..16 bit output");
+
+/**
+ * @brief Decimation cost, measured with DWT->CYCCNT.
+ * Load is the share of the block period spent in decimProcess().
+ */
+typedef struct {
+    uint32_t blocks;
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint32_t load_permille;     // Last block
+    uint32_t max_load_permille;
+} decim_stats_t;
+
+
+/**
+ * @brief Resets the decimator and FIR state and starts the cycle counter.
+ * @param sample_rate_hz ADC sample rate feeding decimProcess(), for the load figure.
+ * @param fir Non-zero to run the FIR on the decimated samples.
+ */
+void decimInit(uint32_t sample_rate_hz, int fir);
+
+/**
+ * @brief Decimates one DMA block of single-channel 12-bit samples.
+ * Samples are summed four at a time with UADD16 + SMLAD; a partial window
+ * carries over to the next block, so outputs are evenly spaced at
+ * sample_rate / DECIM_RATIO regardless of block boundaries.
+ * @param block Block from the ADC callback, 4-byte aligned, even length.
+ * @param len Number of samples.
+ * @param out Destination for DECIM_OUT_BITS-bit results, room for len / DECIM_RATIO + 1.
+ * @return Number of output samples written.
+ */
+uint32_t decimProcess(const uint16_t *block, uint32_t len, uint16_t *out);
+
+/**
+ * @brief Returns the decimation cost counters.
+ * @param stats Destination.
+ */
+void decimGetStats(decim_stats_t *stats);
+
+#endif /* DECIM_H_ */
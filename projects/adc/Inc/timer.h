@@ -0,0 +1,51 @@
+/***************************************************************************
+ * File name     :  timer.h
+ * Description   :  Header file for Timer3 configuration and control.
+ *                  Defines constants for Timer3 settings and declares the
+ *                  initialization functions, including the TRGO time base
+ *                  that paces ADC1 conversions.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2025-06-16
+ **************************************************************************/
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#define TIM3EN		(1U << 1)   // Clock enable bit for TIM3 in RCC_APB1ENR
+#define CR1_CEN		(1U << 0)   // Counter Enable bit in TIMx_CR1
+#define SR_UIF		(1U << 0)   // Update Interrupt Flag in TIMx_SR
+#define CR2_MMS_UPDATE	(2U << 4)   // Master mode: update event drives TRGO
+#define CR2_MMS_MASK	(7U << 4)
+#define EGR_UG		(1U << 0)   // Update generation, loads PSC/ARR
+
+#define TIM3_UPDATE_FREQ	1U      // Update event rate (Hz)
+#define TIM3_TRGO_FREQ		100000U // ADC sample rate (Hz), 1 Hz .. 1 MHz; must divide 72 MHz within 0.1 %
+
+/**
+ * @brief Initializes Timer3 to generate an update event every 1 second.
+ * This function configures the prescaler (PSC) and auto-reload register (ARR)
+ * to achieve the desired timing.
+ */
+void timer3Init(void);
+
+/**
+ * @brief Configures Timer3 as a TRGO source at TIM3_TRGO_FREQ.
+ * Every update event pulses TRGO, which ADC1 uses as its conversion
+ * trigger, so the sample period is exactly (PSC + 1) * (ARR + 1) timer
+ * clocks. The counter is left stopped; timer3Start() starts it once the
+ * consumer is armed.
+ */
+void timer3TrgoInit(void);
+
+/**
+ * @brief Starts the Timer3 counter from zero.
+ */
+void timer3Start(void);
+
+/**
+ * @brief Stops the Timer3 counter.
+ */
+void timer3Stop(void);
+
+
+#endif /* TIMER_H_ */
@@ -4,15 +4,115 @@
  * 					  	the ADC1 module on an STM32F3 microcontroller.
  * 						It configures PA1 as an analog input, performs ADC
  * 						calibration, and enables continuous conversion to read
- * 						analog sensor data.
+ * 						analog sensor data. Results are either polled or
+ * 						streamed by DMA1 Channel 1 into a circular buffer whose
+ * 						halves are handed off from the HT/TC interrupts.
+ * 						Analog watchdog trips are counted and timestamped in
+ * 						the ADC interrupt.
  *
  * Author        :    	Jere Piirainen
  * Date          :    	2025-06-15
  **************************************************************************/
 
+#include <stddef.h>
 #include "adc.h"
+#include "timer.h"
+#include "clock.h"
 #include "stm32f3xx.h"
 
+#define CR_ADSTP        (1U << 4)   // ADC Stop conversion of regular group
+
+/* --- Hardware trigger: TIM3 TRGO on EXT4, rising edge --- */
+#define CFGR_EXTSEL_MASK    (0xFU << 6)
+#define CFGR_EXTSEL_TIM3    (0x4U << 6)     // EXT4 = TIM3_TRGO for ADC1/2
+#define CFGR_EXTEN_MASK     (0x3U << 10)
+#define CFGR_EXTEN_RISING   (0x1U << 10)
+#define ADC_CONV_HALF_CYC   25U             // 12.5 cycle successive approximation, in half cycles
+#define ADC_TRIG_PERIOD_CYC (CLOCK_HCLK_FREQ / TIM3_TRGO_FREQ)
+
+_Static_assert((TIM3_TRGO_FREQ >= 1U) && (TIM3_TRGO_FREQ <= 1000000U), "Triggered ADC rate must be 1 Hz .. 1 MSPS");
+_Static_assert(ADC_TRIG_PERIOD_CYC >= 14U, "Trigger period shorter than one conversion");
+
+/* --- Sequence registers: SQR1 holds L and SQ1..SQ4, SQR2..SQR4 five, five and two more --- */
+#define SQR1_L_MASK         (0xFU << 0)
+#define SQ_BITS             6U
+#define SQ_MASK             0x1FU
+#define SMP_BITS            3U
+#define SMP_MASK            0x7U
+#define PA1_CHANNEL         2U              // PA1 is ADC1_IN2, sampling time in SMPR1 SMP2
+#define PA1_SMP             ADC_SMP_19C5    // 19.5 cycle sampling, 32 cycles per conversion
+#define PA1_SMP_HALF_CYC    39U             // smp_half_cycles[PA1_SMP]
+
+/* --- Internal channels (ADC1_2 CCR) --- */
+#define CCR_VREFEN          (1U << 22)      // VREFINT on ADC1 IN18
+#define CCR_TSEN            (1U << 23)      // Temperature sensor on ADC1 IN16
+#define ADC_CH_TEMP         16U
+#define ADC_CH_VREFINT      18U
+
+/* --- Dual mode (ADC1_2 CCR) --- */
+#define CCR_DUAL_MASK       (0x1FU << 0)
+#define CCR_DUAL_SIMULT     (0x06U << 0)    // Regular simultaneous only
+#define CCR_DUAL_INTERL     (0x07U << 0)    // Interleaved only
+#define CCR_DELAY_MASK      (0xFU << 8)
+#define CCR_DELAY_7CYC      (0x6U << 8)     // Half of a 14 cycle conversion between ADC1 and ADC2
+#define CCR_DMACFG          (1U << 13)      // Common DMA circular mode
+#define CCR_MDMA_MASK       (0x3U << 14)
+#define CCR_MDMA_12BIT      (0x2U << 14)    // One DMA request per ADC1/ADC2 pair, packed into CDR
+#define ADC_DUAL_BLOCK_LEN  (ADC_DMA_BUF_LEN / 4U)  // Pairs per half buffer
+
+/* --- Analog watchdogs: AWD1 in CFGR/TR1, AWD2 and AWD3 in AWDxCR/TRx --- */
+#define CFGR_AWD1SGL        (1U << 22)      // AWD1 on a single channel
+#define CFGR_AWD1EN         (1U << 23)      // AWD1 on the regular group
+#define CFGR_AWD1CH_POS     26U
+#define CFGR_AWD1_MASK      ((0x1FU << CFGR_AWD1CH_POS) | CFGR_AWD1EN | CFGR_AWD1SGL)
+#define TR1_HT_POS          16U             // 12-bit thresholds
+#define TRX_HT_POS          16U             // 8-bit thresholds, compared with result bits 11:4
+#define AWD_8BIT_SHIFT      4U
+#define IER_AWD_ALL         (IER_AWD1IE | (IER_AWD1IE << 1) | (IER_AWD1IE << 2))
+
+/* Sampling time in half ADC cycles, indexed by adc_smp_t */
+static const uint16_t smp_half_cycles[8] = { 3U, 5U, 9U, 15U, 39U, 123U, 363U, 1203U };
+
+/* --- DMA streaming state --- */
+/* Half-words for ADC1 alone, packed ADC1/ADC2 words from CDR in dual mode */
+static union {
+	uint16_t half[ADC_DMA_BUF_LEN];
+	uint32_t word[ADC_DMA_BUF_LEN / 2U];
+} adc_buf __attribute__((aligned(4)));
+static adc_block_callback_t adc_callback = NULL;
+static volatile adc_stats_t adc_stats;
+static adc_dual_callback_t adc_dual_callback = NULL;
+static uint8_t adc_triggered = 0;               // TIM3 paces the conversions
+static uint8_t adc_dual = 0;                    // ADC2 slaved to ADC1, DMA reads CDR
+static uint32_t adc_dma_count = ADC_DMA_BUF_LEN;        // CNDTR reload, two blocks
+static uint32_t adc_seq_len = 1;                // Samples per frame
+static uint32_t adc_block_len = ADC_DMA_BLOCK_LEN;      // Whole frames per half buffer
+static uint32_t adc_frame_half_cyc = PA1_SMP_HALF_CYC + ADC_CONV_HALF_CYC;   // Conversion time of one frame
+
+/* ADC1 single-mode sequence and timing, put back when dual mode stops */
+static struct {
+	uint32_t sqr1;
+	uint32_t smpr1;
+	uint32_t smpr2;
+	uint32_t seq_len;
+	uint32_t block_len;
+	uint32_t frame_half_cyc;
+} adc_single;
+
+/* --- Analog watchdog state, indexed by adc_awd_t --- */
+static volatile adc_awd_stats_t adc_awd[ADC_AWD_COUNT];
+static adc_awd_callback_t adc_awd_callback[ADC_AWD_COUNT];
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void adc_dma_start(adc_block_callback_t callback);
+static void adc_dma_setup(uint32_t cpar, uint32_t size_bits, uint32_t count);
+static void adc2_enable(void);
+static void adc_stop_conversions(void);
+static void adc_resync(void);
+static uint32_t adc_irq_mask(IRQn_Type irq);
+static void adc_irq_restore(IRQn_Type irq, uint32_t enabled);
+
 
 void pa1ADCInit(void)
 {
@@ -62,10 +162,14 @@ void pa1ADCInit(void)
 
 	/* Step 5: configure conversion sequence and length */
 	/* Conversion sequence start */
-	ADC1->SQR1 = ADC1_CH1;
+	ADC1->SQR1 = ADC1_CH2;
 
 	/* Conversion sequence length */
 	ADC1->SQR1 |= ADC1_SEQ_LEN;
+
+	/* Longer sampling for accuracy, still well inside the shortest trigger period */
+	ADC1->SMPR1 = (ADC1->SMPR1 & ~(SMP_MASK << (PA1_CHANNEL * SMP_BITS))) | ((uint32_t)PA1_SMP << (PA1_CHANNEL * SMP_BITS));
+	adc_frame_half_cyc = smp_half_cycles[PA1_SMP] + ADC_CONV_HALF_CYC;
 }
 
 
@@ -91,4 +195,585 @@ uint32_t adcRead(void)
 }
 
 
+int adcDmaStart(adc_block_callback_t callback)
+{
+	/* CFGR DMA and trigger bits are ignored while the regular group runs */
+	if (ADC1->CR & CR_ADSTART) {
+		return -1;
+	}
+
+	adc_triggered = 0;
+	adc_dma_start(callback);
+
+	/* Free running: the next conversion starts as soon as one ends */
+	ADC1->CFGR &= ~(CFGR_EXTEN_MASK | CFGR_EXTSEL_MASK);
+	ADC1->CFGR |= CFGR_CONT;
+
+	/* Start ADC conversion */
+	ADC1->CR |= CR_ADSTART;
+
+	return 0;
+}
+
+
+int adcTimerStart(adc_block_callback_t callback)
+{
+	/*
+	 * The whole frame has to be converted before the next trigger, and CFGR
+	 * DMA and trigger bits are ignored while the regular group runs
+	 */
+	if ((((adc_frame_half_cyc + 1U) / 2U) > ADC_TRIG_PERIOD_CYC) || (ADC1->CR & CR_ADSTART)) {
+		return -1;
+	}
+
+	adc_triggered = 1;
+	timer3TrgoInit();
+	adc_dma_start(callback);
+
+	/* One conversion per TIM3 TRGO rising edge */
+	ADC1->CFGR &= ~(CFGR_CONT | CFGR_EXTEN_MASK | CFGR_EXTSEL_MASK);
+	ADC1->CFGR |= CFGR_EXTSEL_TIM3 | CFGR_EXTEN_RISING;
+
+	/* ADSTART arms the trigger, the timer then paces every conversion */
+	ADC1->CR |= CR_ADSTART;
+	timer3Start();
+
+	return 0;
+}
+
+
+int adcDualStart(adc_dual_mode_t mode, uint8_t ch_master, uint8_t ch_slave, adc_dual_callback_t callback)
+{
+	uint32_t smp;
+
+	if ((ch_master == 0U) || (ch_master > ADC_CHANNEL_MAX) || (ch_slave == 0U) || (ch_slave > ADC_CHANNEL_MAX) ||
+	    (ADC1->CR & CR_ADSTART)) {
+		return -1;
+	}
+
+	/* Everything below overwrites the single-mode setup, adcDmaStop() restores it */
+	if (!adc_dual) {
+		adc_single.sqr1 = ADC1->SQR1;
+		adc_single.smpr1 = ADC1->SMPR1;
+		adc_single.smpr2 = ADC1->SMPR2;
+		adc_single.seq_len = adc_seq_len;
+		adc_single.block_len = adc_block_len;
+		adc_single.frame_half_cyc = adc_frame_half_cyc;
+	}
+
+	/* Interleaving needs the 14 cycle conversion the 7 cycle delay is half of */
+	smp = (mode == ADC_DUAL_INTERLEAVED) ? ADC_SMP_1C5 : ADC_SMP_19C5;
+
+	adc2_enable();
+
+	/* One conversion each, ADC1 is the master and owns the trigger */
+	ADC1->SQR1 = (uint32_t)ch_master << SQ_BITS;
+	ADC2->SQR1 = (uint32_t)ch_slave << SQ_BITS;
+	if (ch_master < 10U) {
+		ADC1->SMPR1 = (ADC1->SMPR1 & ~(SMP_MASK << (ch_master * SMP_BITS))) | (smp << (ch_master * SMP_BITS));
+	} else {
+		ADC1->SMPR2 = (ADC1->SMPR2 & ~(SMP_MASK << ((ch_master - 10U) * SMP_BITS))) | (smp << ((ch_master - 10U) * SMP_BITS));
+	}
+	if (ch_slave < 10U) {
+		ADC2->SMPR1 = (ADC2->SMPR1 & ~(SMP_MASK << (ch_slave * SMP_BITS))) | (smp << (ch_slave * SMP_BITS));
+	} else {
+		ADC2->SMPR2 = (ADC2->SMPR2 & ~(SMP_MASK << ((ch_slave - 10U) * SMP_BITS))) | (smp << ((ch_slave - 10U) * SMP_BITS));
+	}
+	adc_seq_len = 1;
+	adc_block_len = ADC_DMA_BLOCK_LEN;
+	adc_frame_half_cyc = smp_half_cycles[smp] + ADC_CONV_HALF_CYC;
+
+	/* --- DMA1 Channel 1: common CDR -> adc_buf, circular, one word per pair --- */
+	adc_dual = 1;
+	adc_dual_callback = callback;
+	adc_dma_setup((uint32_t)&ADC1_2_COMMON->CDR, DMA1_PSIZE32 | DMA1_MSIZE32, ADC_DMA_BUF_LEN / 2U);
+
+	/* MDMA replaces the per-ADC DMA requests */
+	ADC1->CFGR &= ~(CFGR_DMAEN | CFGR_DMACFG | CFGR_CONT | CFGR_EXTEN_MASK | CFGR_EXTSEL_MASK);
+	ADC2->CFGR &= ~(CFGR_DMAEN | CFGR_DMACFG | CFGR_CONT | CFGR_EXTEN_MASK | CFGR_EXTSEL_MASK);
+	ADC1_2_COMMON->CCR = (ADC1_2_COMMON->CCR & ~(CCR_DUAL_MASK | CCR_DELAY_MASK | CCR_DMACFG | CCR_MDMA_MASK)) |
+	                     CCR_MDMA_12BIT | CCR_DMACFG |
+	                     ((mode == ADC_DUAL_INTERLEAVED) ? (CCR_DUAL_INTERL | CCR_DELAY_7CYC) : CCR_DUAL_SIMULT);
+
+	ADC1->ISR = ISR_OVR;
+	ADC2->ISR = ISR_OVR;
+	NVIC_DisableIRQ(ADC1_2_IRQn);
+	ADC1->IER |= IER_OVRIE;
+	ADC2->IER |= IER_OVRIE;
+	NVIC_SetPriority(ADC1_2_IRQn, ADC_IRQ_PRIORITY);
+	NVIC_EnableIRQ(ADC1_2_IRQn);
+
+	if (mode == ADC_DUAL_INTERLEAVED) {
+		/* Free running, ADC2 starts half a conversion after every ADC1 start */
+		adc_triggered = 0;
+		ADC1->CFGR |= CFGR_CONT;
+		ADC2->CFGR |= CFGR_CONT;
+		ADC1->CR |= CR_ADSTART;
+	} else {
+		/* Both sample on the same TIM3 edge */
+		adc_triggered = 1;
+		timer3TrgoInit();
+		ADC1->CFGR |= CFGR_EXTSEL_TIM3 | CFGR_EXTEN_RISING;
+		ADC1->CR |= CR_ADSTART;
+		timer3Start();
+	}
+
+	return 0;
+}
+
+
+int adcSequenceConfig(const adc_seq_entry_t *seq, uint32_t len)
+{
+	uint32_t sqr[4] = { 0 };
+	uint32_t smpr1 = ADC1->SMPR1;
+	uint32_t smpr2 = ADC1->SMPR2;
+	uint32_t half_cyc = 0;
+	uint32_t ccr = 0;
+
+	/* SQRx and SMPRx are only writable with no regular conversion ongoing */
+	if ((len == 0U) || (len > ADC_SEQ_MAX) || (ADC1->CR & CR_ADSTART)) {
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < len; i++) {
+		uint32_t ch = seq[i].channel;
+		uint32_t smp = (uint32_t)seq[i].smp;
+		/* SQ1 sits above L in SQR1, every register after that starts at bit 0 */
+		uint32_t slot = i + 1U;
+
+		if ((ch == 0U) || (ch > ADC_CHANNEL_MAX) || (smp > SMP_MASK)) {
+			return -1;
+		}
+
+		sqr[slot / 5U] |= ch << ((slot % 5U) * SQ_BITS);
+
+		if (ch < 10U) {
+			smpr1 = (smpr1 & ~(SMP_MASK << (ch * SMP_BITS))) | (smp << (ch * SMP_BITS));
+		} else {
+			smpr2 = (smpr2 & ~(SMP_MASK << ((ch - 10U) * SMP_BITS))) | (smp << ((ch - 10U) * SMP_BITS));
+		}
+
+		half_cyc += smp_half_cycles[smp] + ADC_CONV_HALF_CYC;
+
+		if (ch == ADC_CH_TEMP) {
+			ccr |= CCR_TSEN;
+		} else if (ch == ADC_CH_VREFINT) {
+			ccr |= CCR_VREFEN;
+		}
+	}
+
+	ADC1->SQR1 = (sqr[0] & ~SQR1_L_MASK) | (len - 1U);
+	ADC1->SQR2 = sqr[1];
+	ADC1->SQR3 = sqr[2];
+	ADC1->SQR4 = sqr[3];
+	ADC1->SMPR1 = smpr1;
+	ADC1->SMPR2 = smpr2;
+	ADC1_2_COMMON->CCR |= ccr;
+
+	/* Every half buffer holds whole frames, so a block never splits one */
+	adc_seq_len = len;
+	adc_block_len = (ADC_DMA_BLOCK_LEN / len) * len;
+	adc_frame_half_cyc = half_cyc;
+
+	return 0;
+}
+
+
+uint32_t adcSequenceLength(void)
+{
+	return adc_seq_len;
+}
+
+
+void adcChannelView(const uint16_t *block, uint32_t len, uint32_t index, adc_channel_view_t *view)
+{
+	view->base = &block[index];
+	view->stride = adc_seq_len;
+	view->count = len / adc_seq_len;
+}
+
+
+void adcDmaStop(void)
+{
+	uint32_t adc_irq;
+
+	if (adc_triggered) {
+		timer3Stop();
+		adc_triggered = 0;
+	}
+
+	/* Stop the regular group first so no request is left pending in the DMA */
+	adc_stop_conversions();
+
+	ADC1->CFGR &= ~(CFGR_DMAEN | CFGR_DMACFG);
+
+	/* The watchdog handler clears its IER bits too, mask it around the read-modify-write */
+	adc_irq = adc_irq_mask(ADC1_2_IRQn);
+	ADC1->IER &= ~IER_OVRIE;
+
+	/* Back to independent mode with the single-mode sequence, ADC2 stays enabled but idle */
+	if (adc_dual) {
+		ADC1_2_COMMON->CCR &= ~(CCR_DUAL_MASK | CCR_DELAY_MASK | CCR_DMACFG | CCR_MDMA_MASK);
+		ADC2->IER &= ~IER_OVRIE;
+		ADC1->SQR1 = adc_single.sqr1;
+		ADC1->SMPR1 = adc_single.smpr1;
+		ADC1->SMPR2 = adc_single.smpr2;
+		adc_seq_len = adc_single.seq_len;
+		adc_block_len = adc_single.block_len;
+		adc_frame_half_cyc = adc_single.frame_half_cyc;
+		adc_dual = 0;
+	}
+
+	/* Still needed while a watchdog is armed */
+	adc_irq_restore(ADC1_2_IRQn, adc_irq && (ADC1->IER & IER_AWD_ALL));
+
+	DMA1_Channel1->CCR &= ~DMA1_CCR_EN;
+	NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+	DMA1->IFCR = DMA1_ISR_GIF1;
+}
+
+
+void adcGetStats(adc_stats_t *stats)
+{
+	/* Only what was enabled comes back on, a stopped stream stays stopped */
+	uint32_t dma_irq = adc_irq_mask(DMA1_Channel1_IRQn);
+	uint32_t adc_irq = adc_irq_mask(ADC1_2_IRQn);
+
+	*stats = *(const adc_stats_t *)&adc_stats;
+	adc_irq_restore(ADC1_2_IRQn, adc_irq);
+	adc_irq_restore(DMA1_Channel1_IRQn, dma_irq);
+}
+
+
+int adcWatchdogConfig(adc_awd_t awd, uint8_t channel, uint16_t low, uint16_t high, adc_awd_callback_t callback)
+{
+	uint32_t tr;
+
+	/* CFGR, TRx and AWDxCR are only writable with no regular conversion ongoing */
+	if ((awd >= ADC_AWD_COUNT) || (channel == 0U) || (channel > ADC_CHANNEL_MAX) ||
+	    (low > high) || (high > 0xFFFU) || (ADC1->CR & CR_ADSTART)) {
+		return -1;
+	}
+
+	/* Trips are timestamped with the cycle counter */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	NVIC_DisableIRQ(ADC1_2_IRQn);
+	ADC1->IER &= ~(IER_AWD1IE << awd);
 
+	if (awd == ADC_AWD1) {
+		ADC1->TR1 = ((uint32_t)high << TR1_HT_POS) | low;
+		ADC1->CFGR = (ADC1->CFGR & ~CFGR_AWD1_MASK) |
+		             ((uint32_t)channel << CFGR_AWD1CH_POS) | CFGR_AWD1EN | CFGR_AWD1SGL;
+	} else {
+		/* 8-bit compare: the window covers every 12-bit value whose top bits are in range */
+		tr = ((uint32_t)(high >> AWD_8BIT_SHIFT) << TRX_HT_POS) | (low >> AWD_8BIT_SHIFT);
+		low &= (uint16_t)~((1U << AWD_8BIT_SHIFT) - 1U);
+		high |= (uint16_t)((1U << AWD_8BIT_SHIFT) - 1U);
+		if (awd == ADC_AWD2) {
+			ADC1->TR2 = tr;
+			ADC1->AWD2CR = 1UL << channel;
+		} else {
+			ADC1->TR3 = tr;
+			ADC1->AWD3CR = 1UL << channel;
+		}
+	}
+
+	adc_awd[awd].channel = channel;
+	adc_awd[awd].low = low;
+	adc_awd[awd].high = high;
+	adc_awd[awd].trips = 0;
+	adc_awd[awd].last_trip = 0;
+	adc_awd_callback[awd] = callback;
+
+	NVIC_SetPriority(ADC1_2_IRQn, ADC_IRQ_PRIORITY);
+	NVIC_EnableIRQ(ADC1_2_IRQn);
+	adcWatchdogRearm(awd);
+
+	return 0;
+}
+
+
+void adcWatchdogRearm(adc_awd_t awd)
+{
+	uint32_t adc_irq;
+
+	if ((awd >= ADC_AWD_COUNT) || (adc_awd[awd].channel == 0U)) {
+		return;
+	}
+
+	/* A trip of another watchdog would clear its IER bit in the middle of the read-modify-write */
+	adc_irq = adc_irq_mask(ADC1_2_IRQn);
+
+	/* A flag left over from before the trip was handled would fire straight away */
+	ADC1->ISR = ISR_AWD1 << awd;
+	adc_awd[awd].armed = 1;
+	ADC1->IER |= IER_AWD1IE << awd;
+
+	adc_irq_restore(ADC1_2_IRQn, adc_irq);
+}
+
+
+int adcWatchdogDisable(adc_awd_t awd)
+{
+	uint32_t adc_irq;
+
+	if ((awd >= ADC_AWD_COUNT) || (ADC1->CR & CR_ADSTART)) {
+		return -1;
+	}
+
+	adc_irq = adc_irq_mask(ADC1_2_IRQn);
+	ADC1->IER &= ~(IER_AWD1IE << awd);
+	ADC1->ISR = ISR_AWD1 << awd;
+	adc_irq_restore(ADC1_2_IRQn, adc_irq);
+
+	if (awd == ADC_AWD1) {
+		ADC1->CFGR &= ~CFGR_AWD1_MASK;
+	} else if (awd == ADC_AWD2) {
+		ADC1->AWD2CR = 0;
+	} else {
+		ADC1->AWD3CR = 0;
+	}
+
+	adc_awd[awd].channel = 0;
+	adc_awd[awd].armed = 0;
+	adc_awd_callback[awd] = NULL;
+
+	return 0;
+}
+
+
+void adcWatchdogGetStats(adc_awd_t awd, adc_awd_stats_t *stats)
+{
+	uint32_t adc_irq;
+
+	if (awd >= ADC_AWD_COUNT) {
+		return;
+	}
+
+	adc_irq = adc_irq_mask(ADC1_2_IRQn);
+	*stats = *(const adc_awd_stats_t *)&adc_awd[awd];
+	adc_irq_restore(ADC1_2_IRQn, adc_irq);
+}
+
+
+/**
+ * @brief DMA1 Channel 1 Interrupt Service Routine (ISR).
+ * Half transfer: the first half of adc_buf is complete while the DMA fills
+ * the second. Transfer complete: the reverse.
+ */
+void DMA1_CH1_IRQHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+
+	if (isr & DMA1_ISR_TEIF1) {
+		/* The channel disables itself on a transfer error */
+		DMA1->IFCR = DMA1_ISR_GIF1;
+		adc_stats.dma_errors++;
+		return;
+	}
+
+	if (isr & DMA1_ISR_HTIF1) {
+		DMA1->IFCR = DMA1_ISR_HTIF1;
+		adc_stats.blocks++;
+		if (adc_dual) {
+			if (adc_dual_callback != NULL) {
+				adc_dual_callback(&adc_buf.word[0], ADC_DUAL_BLOCK_LEN);
+			}
+		} else if (adc_callback != NULL) {
+			adc_callback(&adc_buf.half[0], adc_block_len);
+		}
+	}
+
+	if (isr & DMA1_ISR_TCIF1) {
+		DMA1->IFCR = DMA1_ISR_TCIF1;
+		adc_stats.blocks++;
+		if (adc_dual) {
+			if (adc_dual_callback != NULL) {
+				adc_dual_callback(&adc_buf.word[ADC_DUAL_BLOCK_LEN], ADC_DUAL_BLOCK_LEN);
+			}
+		} else if (adc_callback != NULL) {
+			adc_callback(&adc_buf.half[adc_block_len], adc_block_len);
+		}
+	}
+}
+
+
+/**
+ * @brief ADC1/ADC2 Interrupt Service Routine (ISR), overruns and analog watchdogs.
+ * With OVRMOD = 0 the old result is kept and DMA requests are held off
+ * while OVR is set, so clearing it resumes the stream; the loss is counted.
+ * A lost result in a scan sequence would shift every later frame by one
+ * channel, so the sequence and the DMA are restarted at a frame boundary.
+ * A watchdog trip is timestamped, counted and disarmed before its callback.
+ */
+void ADC1_2_IRQHandler(void)
+{
+	uint32_t now = DWT->CYCCNT;
+	uint32_t awd_flags = ADC1->ISR & ADC1->IER & IER_AWD_ALL;
+
+	for (uint32_t awd = 0; awd_flags != 0U; awd++) {
+		if (awd_flags & (ISR_AWD1 << awd)) {
+			awd_flags &= ~(ISR_AWD1 << awd);
+			ADC1->IER &= ~(IER_AWD1IE << awd);
+			ADC1->ISR = ISR_AWD1 << awd;
+
+			adc_awd[awd].trips++;
+			adc_awd[awd].last_trip = now;
+			adc_awd[awd].armed = 0;
+			if (adc_awd_callback[awd] != NULL) {
+				adc_awd_callback[awd]((adc_awd_t)awd, adc_awd[awd].channel, now);
+			}
+		}
+	}
+
+	/* Packed pairs cannot slip against each other, counting is enough */
+	if (adc_dual && (ADC2->ISR & ISR_OVR)) {
+		ADC2->ISR = ISR_OVR;
+		adc_stats.overruns++;
+	}
+
+	if (ADC1->ISR & ISR_OVR) {
+		adc_stats.overruns++;
+
+		if ((adc_seq_len > 1U) && !adc_dual) {
+			adc_resync();
+			adc_stats.resyncs++;
+		} else {
+			ADC1->ISR = ISR_OVR;
+		}
+	}
+}
+
+
+/**
+ * @brief Sets up DMA1 Channel 1 and the ADC1 DMA/overrun configuration
+ * shared by the free-running and triggered modes. Conversions are not started.
+ */
+static void adc_dma_start(adc_block_callback_t callback)
+{
+	adc_callback = callback;
+
+	/* --- DMA1 Channel 1: ADC1 DR -> adc_buf, circular, half-words --- */
+	adc_dma_setup((uint32_t)&ADC1->DR, DMA1_PSIZE16 | DMA1_MSIZE16, 2U * adc_block_len);
+
+	/* --- ADC1: a DMA request per result, never stopping, overruns reported --- */
+	ADC1->ISR = ISR_OVR;
+	ADC1->CFGR |= CFGR_DMAEN | CFGR_DMACFG;
+	NVIC_DisableIRQ(ADC1_2_IRQn);
+	ADC1->IER |= IER_OVRIE;
+
+	NVIC_SetPriority(ADC1_2_IRQn, ADC_IRQ_PRIORITY);
+	NVIC_EnableIRQ(ADC1_2_IRQn);
+}
+
+
+/**
+ * @brief Points DMA1 Channel 1 at a result register and starts it in
+ * circular mode over adc_buf with half and full transfer interrupts.
+ * @param cpar Peripheral address (ADC1 DR or the common CDR).
+ * @param size_bits DMA1_PSIZE/MSIZE bits for the transfer width.
+ * @param count Transfers per buffer turn.
+ */
+static void adc_dma_setup(uint32_t cpar, uint32_t size_bits, uint32_t count)
+{
+	RCC->AHBENR |= DMA1EN;
+
+	DMA1_Channel1->CCR &= ~DMA1_CCR_EN;
+	while (DMA1_Channel1->CCR & DMA1_CCR_EN) {}
+
+	adc_dma_count = count;
+	DMA1->IFCR = DMA1_ISR_GIF1;
+	DMA1_Channel1->CPAR = cpar;
+	DMA1_Channel1->CMAR = (uint32_t)adc_buf.half;
+	DMA1_Channel1->CNDTR = count;
+	DMA1_Channel1->CCR = DMA1_MINC | DMA1_CIRC | size_bits |
+	                     DMA1_PL_HIGH | DMA1_CCR_HTIE | DMA1_CCR_TCIE | DMA1_CCR_TEIE;
+
+	NVIC_SetPriority(DMA1_Channel1_IRQn, ADC_IRQ_PRIORITY);
+	NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	DMA1_Channel1->CCR |= DMA1_CCR_EN;
+}
+
+
+/**
+ * @brief Stops the regular group and waits until the ADC has acknowledged.
+ */
+static void adc_stop_conversions(void)
+{
+	if (ADC1->CR & CR_ADSTART) {
+		ADC1->CR |= CR_ADSTP;
+		while (ADC1->CR & CR_ADSTP) {}
+	}
+}
+
+
+/**
+ * @brief Restarts the scan at SQ1 with the DMA back at the start of adc_buf.
+ * Half-filled blocks are dropped rather than handed out misaligned.
+ */
+static void adc_resync(void)
+{
+	adc_stop_conversions();
+
+	DMA1_Channel1->CCR &= ~DMA1_CCR_EN;
+	DMA1->IFCR = DMA1_ISR_GIF1;
+	DMA1_Channel1->CNDTR = adc_dma_count;
+	DMA1_Channel1->CCR |= DMA1_CCR_EN;
+
+	ADC1->ISR = ISR_OVR;
+	ADC1->CR |= CR_ADSTART;
+}
+
+
+/**
+ * @brief Brings ADC2 up the same way pa1ADCInit() does ADC1: regulator,
+ * calibration, enable. Clock and CKMODE are shared with ADC1.
+ */
+static void adc2_enable(void)
+{
+	if (ADC2->CR & CR_ADEN) {
+		return;
+	}
+
+	/* Enable voltage regulator ADVREGEN[1:0] = 01 */
+	ADC2->CR &= ~(1U << 29);
+	ADC2->CR |= (1U << 28);
+
+	/* Small delay to allow regulator to stabilize */
+	for (volatile int i = 0; i < 1000; i++);
+
+	/* Calibrate while disabled */
+	ADC2->CR |= CR_ADCAL;
+	while (ADC2->CR & CR_ADCAL) {}
+
+	/* Enable and wait until ready */
+	ADC2->CR |= CR_ADEN;
+	while (!(ADC2->ISR & ISR_ADRDY)) {}
+}
+
+
+/**
+ * @brief Disables an interrupt in the NVIC for a short critical section.
+ * @return 1 if it was enabled, for adc_irq_restore().
+ */
+static uint32_t adc_irq_mask(IRQn_Type irq)
+{
+	uint32_t enabled = NVIC_GetEnableIRQ(irq);
+
+	NVIC_DisableIRQ(irq);
+
+	return enabled;
+}
+
+
+/**
+ * @brief Re-enables an interrupt only if adc_irq_mask() found it enabled.
+ */
+static void adc_irq_restore(IRQn_Type irq, uint32_t enabled)
+{
+	if (enabled) {
+		NVIC_EnableIRQ(irq);
+	}
+}
@@ -0,0 +1,157 @@
+/***************************************************************************
+ * File name     :  decim.c
+ * Description   :  ADC decimation stage. Blocks from the DMA half-buffer
+ *                  callback are summed over DECIM_RATIO samples (sum and
+ *                  dump, the first-order CIC), two 16-bit samples per SIMD
+ *                  lane operation, and scaled to DECIM_OUT_BITS bits. An
+ *                  optional Q15 FIR cleans up the boxcar's sinc response
+ *                  with dual multiply-accumulates. Every block is timed so
+ *                  the CPU load of the stage is known.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "stm32f3xx.h"
+#include "decim.h"
+#include "adc.h"
+#include "clock.h"
+
+#define DECIM_SHIFT         DECIM_RATIO_LOG4    // Sum has 12 + 2n bits, keep 12 + n
+#define DECIM_OUT_MAX       (ADC_DMA_BLOCK_LEN / DECIM_RATIO + 1U)
+#define DECIM_OUT_OFFSET    (1U << (DECIM_OUT_BITS - 1U))   // FIR runs on signed samples
+#define SIMD_ONES           0x00010001U         // SMLAD operand: lo * 1 + hi * 1
+
+_Static_assert((DECIM_FIR_TAPS % 2U) == 0U, "FIR taps are processed in pairs");
+
+/*
+ * Hamming-windowed sinc, cutoff 0.2 of the output rate, sum 1.0 in Q15.
+ * Symmetric, so the time-reversed order the convolution needs is the same.
+ * Packed two per word for SMLAD.
+ */
+static const int16_t fir_coef[DECIM_FIR_TAPS] __attribute__((aligned(4))) = {
+	0, 183, 259, -541, -1665, 0, 6025, 12123, 12123, 6025, 0, -1665, -541, 259, 183, 0,
+};
+
+static uint32_t acc_sum;                        // Running window sum
+static uint32_t acc_count;                      // Samples in the running window
+static int16_t fir_hist[DECIM_FIR_TAPS - 1U + DECIM_OUT_MAX];   // Oldest first
+static int fir_enabled;
+static uint32_t cycles_per_sample;
+static decim_stats_t decim_stats;
+
+
+void decimInit(uint32_t sample_rate_hz, int fir)
+{
+	acc_sum = 0;
+	acc_count = 0;
+	fir_enabled = fir;
+	memset(fir_hist, 0, sizeof(fir_hist));
+	memset(&decim_stats, 0, sizeof(decim_stats));
+	cycles_per_sample = CLOCK_HCLK_FREQ / sample_rate_hz;
+
+	/* DWT cycle counter for the load measurement */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t decimProcess(const uint16_t *block, uint32_t len, uint16_t *out)
+{
+	uint32_t start = DWT->CYCCNT;
+	const uint32_t *words = (const uint32_t *)block;
+	uint32_t n_out = 0;
+	uint32_t i = 0;
+	uint32_t cycles;
+	uint32_t load;
+
+	while (i < len) {
+		/* Samples still missing from the current window, never more than the block has left */
+		uint32_t take = DECIM_RATIO - acc_count;
+		uint32_t sum = acc_sum;
+		uint32_t w;
+
+		if (take > (len - i)) {
+			take = len - i;
+		}
+
+		/* Four samples per UADD16 + SMLAD: lanes stay below 2 * 4095, well inside 16 bits */
+		w = i / 2U;
+		for (uint32_t k = take / 4U; k > 0U; k--) {
+			sum = __SMLAD(__UADD16(words[w], words[w + 1U]), SIMD_ONES, sum);
+			w += 2U;
+		}
+		if (take & 2U) {
+			sum = __SMLAD(words[w], SIMD_ONES, sum);
+		}
+
+		i += take;
+		acc_count += take;
+
+		if (acc_count < DECIM_RATIO) {
+			acc_sum = sum;
+			break;
+		}
+
+		/* Window complete: 12 + 2n bits of sum, the n lowest are noise */
+		out[n_out++] = (uint16_t)(sum >> DECIM_SHIFT);
+		acc_sum = 0;
+		acc_count = 0;
+	}
+
+	if (fir_enabled && (n_out > 0U)) {
+		/* New samples go after the history, then each output is a dot product over a sliding window */
+		for (uint32_t k = 0; k < n_out; k++) {
+			fir_hist[DECIM_FIR_TAPS - 1U + k] = (int16_t)((int32_t)out[k] - (int32_t)DECIM_OUT_OFFSET);
+		}
+
+		for (uint32_t k = 0; k < n_out; k++) {
+			const int16_t *x = &fir_hist[k];
+			const uint32_t *c = (const uint32_t *)fir_coef;
+			int32_t acc = 0;
+			int32_t y;
+
+			/* Window starts on odd half-words half the time, LDR handles unaligned on the M4 */
+			for (uint32_t t = 0; t < DECIM_FIR_TAPS / 2U; t++) {
+				acc = (int32_t)__SMLAD(__UNALIGNED_UINT32_READ(&x[2U * t]), c[t], (uint32_t)acc);
+			}
+
+			y = (acc >> 15) + (int32_t)DECIM_OUT_OFFSET;
+			if (y < 0) {
+				y = 0;
+			} else if (y > (int32_t)((1U << DECIM_OUT_BITS) - 1U)) {
+				y = (int32_t)((1U << DECIM_OUT_BITS) - 1U);
+			}
+			out[k] = (uint16_t)y;
+		}
+
+		/* Keep the newest TAPS - 1 inputs for the next block */
+		memmove(fir_hist, &fir_hist[n_out], (DECIM_FIR_TAPS - 1U) * sizeof(fir_hist[0]));
+	}
+
+	cycles = DWT->CYCCNT - start;
+	load = (uint32_t)(((uint64_t)cycles * 1000U) / ((uint64_t)len * cycles_per_sample));
+
+	decim_stats.blocks++;
+	decim_stats.last_cycles = cycles;
+	decim_stats.load_permille = load;
+	if (cycles > decim_stats.max_cycles) {
+		decim_stats.max_cycles = cycles;
+	}
+	if (load > decim_stats.max_load_permille) {
+		decim_stats.max_load_permille = load;
+	}
+
+	return n_out;
+}
+
+void decimGetStats(decim_stats_t *stats)
+{
+	uint32_t dma_irq = NVIC_GetEnableIRQ(DMA1_Channel1_IRQn);
+
+	/* Updated from the DMA interrupt, which stays off if adcDmaStop() turned it off */
+	NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+	*stats = decim_stats;
+	if (dma_irq) {
+		NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	}
+}
@@ -1,27 +1,231 @@
 #include <stdint.h>
+#include <stddef.h>
 #include "stm32f3xx.h"
 #include "uart.h"
 #include "adc.h"
+#include "timer.h"
+#include "clock.h"
+#include "decim.h"
 
-uint32_t sensor_value;
+#ifdef ADC_RAILS_DEMO
+/* Rails scanned every TIM3 trigger: the sensor on PA1 and the internal references */
+static const adc_seq_entry_t rails[] = {
+	{ .channel = 2,  .smp = ADC_SMP_61C5 },     // PA1 = ADC1_IN2
+	{ .channel = 18, .smp = ADC_SMP_181C5 },    // VREFINT, needs >= 2.2 us sampling
+	{ .channel = 16, .smp = ADC_SMP_181C5 },    // Temperature sensor, needs >= 2.2 us sampling
+};
+static const char *const rail_names[] = { "PA1", "VREFINT", "TEMP" };
+
+#define RAIL_COUNT      (sizeof(rails) / sizeof(rails[0]))
+#define REPORT_BLOCKS   (TIM3_TRGO_FREQ / (ADC_DMA_BLOCK_LEN / RAIL_COUNT))  // Blocks between reports, ~1 s
+
+/* Running per-rail statistics, filled by the DMA callback */
+static volatile uint32_t block_sum[RAIL_COUNT];
+static volatile uint32_t block_count;
+static volatile uint32_t report_ready;
+static uint32_t report_mean[RAIL_COUNT];
+
+static void adc_block_ready(const uint16_t *block, uint32_t len);
+#else
+/*
+ * PA1 sampled alone at TIM3_TRGO_FREQ and decimated by DECIM_RATIO to
+ * DECIM_OUT_BITS bits, printed once a second with the decimation CPU load.
+ * AWD1 watches the raw samples for the sensor leaving its range.
+ */
+#define REPORT_OUTPUTS  (TIM3_TRGO_FREQ / DECIM_RATIO)  // Decimated samples per report, ~1 s
+#define PA1_CHANNEL     2U          // PA1 = ADC1_IN2
+#define PA1_LIMIT_LOW   100U        // Raw 12-bit window, outside means an open or shorted sensor
+#define PA1_LIMIT_HIGH  4000U
+
+static uint16_t decim_out[ADC_DMA_BLOCK_LEN / DECIM_RATIO + 1U];
+static volatile uint32_t decim_sum;
+static volatile uint32_t decim_count;
+static volatile uint32_t report_ready;
+static uint32_t report_value;
+
+static void adc_decim_ready(const uint16_t *block, uint32_t len);
+#endif
+
+#ifdef ADC_DUAL_DEMO
+/*
+ * Dual ADC throughput check: interleaved sampling of PC0 (ADC12_IN6) on
+ * both ADCs, printing the sample rate actually delivered to the callback
+ * (measured with the DWT cycle counter) and the overrun count.
+ */
+#define DUAL_CHANNEL    6U          // PC0, wired to ADC1 and ADC2
+#define GPIOCEN         (1U << 19)  // Clock enable bit for GPIOC in RCC_AHBENR
+
+static volatile uint32_t dual_samples;
+
+static void adc_dual_ready(const uint32_t *pairs, uint32_t len)
+{
+	(void)pairs;
+	dual_samples += 2U * len;
+}
+
+static void adc_dual_demo(void)
+{
+	adc_stats_t stats;
+	uint32_t start;
+	uint32_t samples;
+
+	/* PC0 analog */
+	RCC->AHBENR |= GPIOCEN;
+	GPIOC->MODER |= (3U << 0);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	(void)adcDualStart(ADC_DUAL_INTERLEAVED, DUAL_CHANNEL, DUAL_CHANNEL, adc_dual_ready);
+
+    while(1) {
+    	start = DWT->CYCCNT;
+    	dual_samples = 0;
+    	while ((DWT->CYCCNT - start) < CLOCK_HCLK_FREQ) {}
+    	samples = dual_samples;
+
+    	adcGetStats(&stats);
+    	uart3_puts("Interleaved: ");
+    	uart3_put_int((int)samples);
+    	uart3_puts(" samples/s, overruns ");
+    	uart3_put_int((int)stats.overruns);
+    	uart3_puts("\r\n");
+    }
+}
+#endif
 
 int main(void)
 {
+	adc_stats_t stats;
+#ifndef ADC_RAILS_DEMO
+	decim_stats_t dstats;
+	adc_awd_stats_t awd;
+#endif
+
 	uart3_tx_rx_init();
 	pa1ADCInit();
-	startConversion();
+
+#ifdef ADC_DUAL_DEMO
+	adc_dual_demo();
+#endif
+
+#ifdef ADC_RAILS_DEMO
+	if ((adcSequenceConfig(rails, RAIL_COUNT) != 0) || (adcTimerStart(adc_block_ready) != 0)) {
+		uart3_puts("ADC sequence does not fit the trigger period\r\n");
+	}
 
     uart3_puts("ADC sensor monitor\r\n");
 
     while(1) {
-    	sensor_value = adcRead();       // Read raw ADC value
-    	uart3_puts("Sensor value: ");
-        uart3_put_int(sensor_value);
-        uart3_puts(" (raw ADC)\r\n");
+    	/* Nothing to poll, the DMA fills the buffer and the callback condenses it */
+    	if (!report_ready) {
+    		continue;
+    	}
+    	report_ready = 0;
+
+    	for (uint32_t ch = 0; ch < RAIL_COUNT; ch++) {
+    		uart3_puts(rail_names[ch]);
+    		uart3_puts(": ");
+    		uart3_put_int((int)report_mean[ch]);
+    		uart3_puts("  ");
+    	}
+
+    	adcGetStats(&stats);
+        uart3_puts("(raw ADC mean), blocks ");
+        uart3_put_int((int)stats.blocks);
+        uart3_puts(", overruns ");
+        uart3_put_int((int)stats.overruns);
+        uart3_puts("\r\n");
+    }
+#else
+	decimInit(TIM3_TRGO_FREQ, 1);
+	(void)adcWatchdogConfig(ADC_AWD1, PA1_CHANNEL, PA1_LIMIT_LOW, PA1_LIMIT_HIGH, NULL);
+	if (adcTimerStart(adc_decim_ready) != 0) {
+		uart3_puts("ADC sample time does not fit the trigger period\r\n");
+	}
+
+    uart3_puts("ADC decimated monitor\r\n");
+
+    while(1) {
+    	if (!report_ready) {
+    		continue;
+    	}
+    	report_ready = 0;
 
+    	decimGetStats(&dstats);
+    	adcGetStats(&stats);
+    	adcWatchdogGetStats(ADC_AWD1, &awd);
+    	uart3_puts("PA1: ");
+    	uart3_put_int((int)report_value);
+    	uart3_puts(" (");
+    	uart3_put_int((int)DECIM_OUT_BITS);
+    	uart3_puts(" bit), load ");
+    	uart3_put_int((int)dstats.load_permille);
+    	uart3_puts("/");
+    	uart3_put_int((int)dstats.max_load_permille);
+    	uart3_puts(" permille, overruns ");
+    	uart3_put_int((int)stats.overruns);
+    	uart3_puts(", out of range ");
+    	uart3_put_int((int)awd.trips);
+    	uart3_puts("\r\n");
 
-        for (volatile int i = 0; i < 1000000; i++);
+    	/* At most one trip per report, however long PA1 stays out of range */
+    	adcWatchdogRearm(ADC_AWD1);
     }
+#endif
 }
 
+#ifdef ADC_RAILS_DEMO
+/**
+ * @brief Block handler, runs in the DMA1 Channel 1 interrupt.
+ * Walks each rail through a strided view of the interleaved block and
+ * keeps a mean over REPORT_BLOCKS blocks for the main loop to print.
+ */
+static void adc_block_ready(const uint16_t *block, uint32_t len)
+{
+	for (uint32_t ch = 0; ch < RAIL_COUNT; ch++) {
+		adc_channel_view_t view;
+		uint32_t sum = 0;
+
+		adcChannelView(block, len, ch, &view);
+		for (uint32_t i = 0; i < view.count; i++) {
+			sum += adcViewAt(&view, i);
+		}
+		block_sum[ch] += sum / view.count;
+	}
+
+	if (++block_count >= REPORT_BLOCKS) {
+		for (uint32_t ch = 0; ch < RAIL_COUNT; ch++) {
+			report_mean[ch] = block_sum[ch] / block_count;
+			block_sum[ch] = 0;
+		}
+		block_count = 0;
+		report_ready = 1;
+	}
+}
+#endif
 
+#ifndef ADC_RAILS_DEMO
+/**
+ * @brief Block handler, runs in the DMA1 Channel 1 interrupt.
+ * Decimates the block and averages the outputs over about a second for
+ * the main loop to print.
+ */
+static void adc_decim_ready(const uint16_t *block, uint32_t len)
+{
+	uint32_t n = decimProcess(block, len, decim_out);
+
+	for (uint32_t i = 0; i < n; i++) {
+		decim_sum += decim_out[i];
+	}
+	decim_count += n;
+
+	if (decim_count >= REPORT_OUTPUTS) {
+		report_value = decim_sum / decim_count;
+		decim_sum = 0;
+		decim_count = 0;
+		report_ready = 1;
+	}
+}
+#endif
@@ -0,0 +1,72 @@
+/***************************************************************************
+ * File name     :  timer.c
+ * Description   :  This file provides functions to initialize and control
+ *                  the Timer 3 (TIM3) module on an STM32F3 microcontroller.
+ *                  It configures TIM3 for a 1-second periodic update event,
+ *                  or as the TRGO time base that triggers ADC1 conversions.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2025-06-16
+ **************************************************************************/
+#include "timer.h"
+#include "clock.h"
+#include "timing.h"
+
+TIM_CHECK(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
+TIM_CHECK(CLOCK_TIM_APB1_FREQ, TIM3_TRGO_FREQ);
+#include "stm32f3xx.h"
+
+void timer3Init(void)
+{
+	/* Enable clock access to timer3 */
+	RCC->APB1ENR |= TIM3EN;
+
+	/* Set prescaler value, smallest that keeps ARR within 16 bits */
+	TIM3->PSC = TIM_PSC(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
+
+	/* Set auto-reload value */
+	TIM3->ARR = TIM_ARR(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
+
+	/* Clear counter */
+	TIM3->CNT = 0;
+
+	/* Enable timer */
+	TIM3->CR1 = CR1_CEN;
+}
+
+
+void timer3TrgoInit(void)
+{
+	/* Enable clock access to timer3 */
+	RCC->APB1ENR |= TIM3EN;
+
+	/* Stopped while it is being set up */
+	TIM3->CR1 = 0;
+
+	/* Sample period, checked against TIM_MAX_ERR_PPM at compile time */
+	TIM3->PSC = TIM_PSC(CLOCK_TIM_APB1_FREQ, TIM3_TRGO_FREQ);
+	TIM3->ARR = TIM_ARR(CLOCK_TIM_APB1_FREQ, TIM3_TRGO_FREQ);
+
+	/* Load PSC now (it is buffered), the UG update also pulses TRGO once but nothing listens yet */
+	TIM3->EGR = EGR_UG;
+	TIM3->SR = 0;
+
+	/* Update event -> TRGO */
+	TIM3->CR2 = (TIM3->CR2 & ~CR2_MMS_MASK) | CR2_MMS_UPDATE;
+}
+
+
+void timer3Start(void)
+{
+	/* Clear counter */
+	TIM3->CNT = 0;
+
+	/* Enable timer */
+	TIM3->CR1 |= CR1_CEN;
+}
+
+
+void timer3Stop(void)
+{
+	TIM3->CR1 &= ~CR1_CEN;
+}
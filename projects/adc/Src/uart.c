@@ -9,7 +9,10 @@
  * Author        :    Jere Piirainen
  * Date          :    2025-06-13
  **************************************************************************/
+#include <string.h>
 #include "uart.h"
+#include "clock.h"
+#include "timing.h"
 #include "stm32f3xx.h"
 
 /* --- Peripheral base addresses and bit definitions --- */
@@ -22,20 +25,30 @@
 #define CR1_UE          (1U << 0)       // USART enable bit in CR1
 #define ISR_TXE         (1U << 7)       // Transmit data register empty flag
 #define ISR_RXNE		(1U << 5)	    // Read data register not empty flag
+#define ISR_TC          (1U << 6)       // Transmission complete flag
+#define CR1_TXEIE       (1U << 7)       // TXE interrupt enable bit in CR1
 
-/* --- System and UART configuration constants --- */
-#define SYS_FREQ       8000000          // System clock frequency (8 MHz)
-#define APB1_CLK       SYS_FREQ         // APB1 bus clock frequency 
-
+/* --- UART configuration constants --- */
 #define UART_BAUDRATE  115200           // Desired Baud rate
+#define UART3_BRR_VAL  UART_BRR(CLOCK_PCLK1_FREQ, UART_BAUDRATE)
+
+UART_BRR_CHECK(CLOCK_PCLK1_FREQ, UART_BAUDRATE);
 
 
 /* --- Static function prototypes (helper functions local to this file) --- */
 
-static void uart_set_baudrate(USART_TypeDef *UARTx, uint32_t PeriphClk, uint32_t BaudRate);
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate);
 static void uart3_write(int ch);
 
+/* --- Interrupt-driven TX ring buffer --- */
+#define TX_BUF_MASK     (UART3_TX_BUF_SIZE - 1U)
+
+_Static_assert((UART3_TX_BUF_SIZE & TX_BUF_MASK) == 0U, "UART3_TX_BUF_SIZE must be a power of two");
+
+static uint8_t tx_buf[UART3_TX_BUF_SIZE];
+static volatile uint32_t tx_head = 0;       // Next free slot, advanced only by the writer
+static volatile uint32_t tx_tail = 0;       // Next byte to send, advanced only by the TXE ISR
+static volatile uart_tx_policy_t tx_policy = UART_TX_BLOCK;
+
 
 /* --- Printing helping functions --- */
 /**
@@ -44,13 +57,8 @@ static void uart3_write(int ch);
  */
 void uart3_puts(const char *str)
 {
-    /* Loop until the null terminator ('\0') is encountered */
-    while (*str != '\0') {
-        /* Transmit crrent character */
-        uart3_write(*str);
-        /* Move to the next character */
-        str++;
-    }
+    /* Queue the whole string in one go, the TXE interrupt does the rest */
+    (void)uart3_write_async((const uint8_t *)str, strlen(str));
 }
 
 void uart3_put_int(int num)
@@ -112,6 +120,100 @@ void uart3_put_int(int num)
 
 
 
+/**
+ * @brief Queues bytes for interrupt-driven transmission over USART3.
+ * Single-producer/single-consumer: only this function advances tx_head and
+ * only the TXE interrupt advances tx_tail, so no lock is needed. The one
+ * exception is UART_TX_OVERWRITE, which briefly masks the USART3 IRQ while
+ * it discards the oldest byte.
+ * @param data Pointer to the bytes to transmit.
+ * @param len Number of bytes to transmit.
+ * @return Number of bytes accepted into the ring buffer.
+ */
+uint32_t uart3_write_async(const uint8_t *data, uint32_t len)
+{
+    uint32_t accepted = 0;
+
+    while (accepted < len) {
+        /* Indices run freely, their difference is the number of queued bytes */
+        if ((tx_head - tx_tail) == UART3_TX_BUF_SIZE) {
+            if (tx_policy == UART_TX_DROP) {
+                break;
+            }
+
+            if (tx_policy == UART_TX_BLOCK) {
+                /* Make sure the ISR is draining, then wait for a free slot */
+                USART3->CR1 |= CR1_TXEIE;
+                continue;
+            }
+
+            /* UART_TX_OVERWRITE: tx_tail belongs to the ISR, keep it out while we advance it */
+            NVIC_DisableIRQ(USART3_IRQn);
+            if ((tx_head - tx_tail) == UART3_TX_BUF_SIZE) {
+                tx_tail++;
+            }
+            NVIC_EnableIRQ(USART3_IRQn);
+        }
+
+        tx_buf[tx_head & TX_BUF_MASK] = data[accepted++];
+
+        /* Byte must be in the buffer before the ISR can see the new head */
+        __DMB();
+        tx_head++;
+    }
+
+    /* Enable TXE interrupt, the ISR disables it again once the buffer is empty */
+    if (accepted > 0U) {
+        USART3->CR1 |= CR1_TXEIE;
+    }
+
+    return accepted;
+}
+
+
+/**
+ * @brief Selects what uart3_write_async() does when the TX ring buffer is full.
+ * @param policy One of UART_TX_DROP, UART_TX_BLOCK or UART_TX_OVERWRITE.
+ */
+void uart3_set_tx_policy(uart_tx_policy_t policy)
+{
+    tx_policy = policy;
+}
+
+
+/**
+ * @brief Blocks until every queued byte has left the USART3 shift register.
+ */
+void uart3_flush(void)
+{
+    /* Wait for the ISR to empty the ring buffer */
+    while (tx_head != tx_tail) {}
+
+    /* Wait for the last frame to be shifted out */
+    while (!(USART3->ISR & ISR_TC)) {}
+}
+
+
+/**
+ * @brief USART3 global Interrupt Service Routine (ISR).
+ * Feeds the next queued byte into TDR on every TXE event and disables the
+ * TXE interrupt when the ring buffer runs empty.
+ */
+void USART3_EXTI28_IRQHandler(void)
+{
+    if ((USART3->CR1 & CR1_TXEIE) && (USART3->ISR & ISR_TXE)) {
+        if (tx_tail != tx_head) {
+            USART3->TDR = tx_buf[tx_tail & TX_BUF_MASK];
+            tx_tail++;
+        } else {
+            /* Nothing left to send, stop TXE interrupts until new data is queued */
+            USART3->CR1 &= ~CR1_TXEIE;
+        }
+    }
+}
+
+
+
 /**
  * @brief Initializes USART3 for both transmit (TX) and receive (RX) functionality.
  * Configures GPIO pins PB10 (TX) and PB11 (RX) for Alternate Function 7 (AF7),
@@ -151,14 +253,17 @@ void uart3_tx_rx_init(void)
     /* Enable clock access to USART3 */
     RCC->APB1ENR |= USART3EN;
 
-    /* Configure baud rate */
-    uart_set_baudrate(USART3, APB1_CLK, UART_BAUDRATE);
+    /* Configure baud rate, BRR is resolved from PCLK1 at compile time */
+    USART3->BRR = UART3_BRR_VAL;
 
     /* Configure the transfer direction for both transmitter and receiver */
     USART3->CR1 = (CR1_TE |  CR1_RE);
 
     /* Enable uart module (Done AFTER all other configurations) */
     USART3->CR1 |= CR1_UE;
+
+    /* Enable USART3 interrupt in NVIC, TXEIE is set on demand by uart3_write_async() */
+    NVIC_EnableIRQ(USART3_IRQn);
 }
 
 
@@ -180,46 +285,14 @@ char uart3_read(void)
 
 
 /**
- * @brief Writes a single character to the USART3 transmit data register.
- * This function blocks until the transmit data register is empty,
- * indicating it's ready to accept new data.
+ * @brief Queues a single character for transmission over USART3.
+ * The character is handed to the TX ring buffer and sent by the TXE
+ * interrupt; the current overflow policy applies when the buffer is full.
  * @param ch The character to be transmitted.
  */
 void uart3_write(int ch)
 {
-    /* Make sure transmit data register is empty */
-    while ( !(USART3->ISR & ISR_TXE) ) {}      // Returns true if bit SR_TXE is set inside ISR register
-
-    /* Write to transmit data register */
-    USART3->TDR = (ch & 0xFF);
-}
-
-
-
-/**
- * @brief Sets the baud rate for the specified UART peripheral.
- * @param USARTx Pointer to the USART peripheral (e.g., USART3).
- * @param PeriphClk The peripheral clock frequency feeding the UART.
- * @param BaudRate The desired baud rate.
- */
-static void uart_set_baudrate(USART_TypeDef *USARTx, uint32_t PeriphClk, uint32_t BaudRate)
-{
-	USARTx->BRR = compute_uart_bd(PeriphClk, BaudRate);
-}
-
-
+    uint8_t byte = (uint8_t)(ch & 0xFF);
 
-/**
- * @brief Computes the value for the USART Baud Rate Register (BRR).
- * This calculation performs integer division with rounding for simplicity.
- * For high precision, refer to the MCU's reference manual for fractional baud rate settings.
- * @param PeriphClk The peripheral clock frequency.
- * @param BaudRate The desired baud rate.
- * @return The calculated 16-bit value for the BRR register.
- */
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate)
-{
-    // Calculation: BRR = PeriphClk / BaudRate
-    // Adding (BaudRate / 2U) before division performs rounding to the nearest integer.
-    return ((PeriphClk + (BaudRate / 2U)) / BaudRate);
+    (void)uart3_write_async(&byte, 1);
 }
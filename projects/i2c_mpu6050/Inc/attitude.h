@@ -0,0 +1,93 @@
+/***************************************************************************
+ * File name     :  attitude.h
+ * Description   :  Header file for the attitude estimator. Declares the
+ *                  quaternion complementary and Mahony filters that fuse
+ *                  MPU6050 accelerometer and gyroscope samples on the FPU,
+ *                  and the per-update cycle statistics.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef ATTITUDE_H_
+#define ATTITUDE_H_
+
+#include <stdint.h>
+#include "mpu6050.h"
+
+/* --- Filter gains --- */
+#define ATTITUDE_KP                 1.0f    // Accel correction gain (rad/s per unit error), ~0.16 Hz crossover
+#define ATTITUDE_KI                 0.1f    // Mahony gyro bias integral gain
+#define ATTITUDE_BIAS_MAX           0.1f    // Mahony bias estimate clamp, rad/s (~6 °/s)
+#define ATTITUDE_ACCEL_MIN_G        0.8f    // Outside this norm the accel is not trusted as gravity
+#define ATTITUDE_ACCEL_MAX_G        1.2f
+
+/* --- Time budget --- */
+#define ATTITUDE_CYCLE_BUDGET       1500U   // Core cycles per update, ~2 % of a 1 kHz period at 72 MHz
+
+/**
+ * @brief Estimator variant.
+ * Complementary: gyro integration corrected towards gravity with a fixed
+ * proportional gain (explicit complementary filter, no bias estimate).
+ * Mahony: the same plus an integral term that tracks the gyro bias.
+ */
+typedef enum {
+    ATTITUDE_COMPLEMENTARY = 0,
+    ATTITUDE_MAHONY,
+} attitude_filter_t;
+
+/**
+ * @brief Orientation as Euler angles in degrees (aerospace ZYX order).
+ * Yaw is unobserved without a magnetometer and drifts with the gyro bias.
+ */
+typedef struct {
+    float roll;
+    float pitch;
+    float yaw;
+} attitude_euler_t;
+
+/**
+ * @brief Per-update cost, measured with DWT->CYCCNT.
+ */
+typedef struct {
+    uint32_t updates;
+    uint32_t last_cycles;
+    uint32_t max_cycles;
+    uint32_t over_budget;       // Updates that took more than ATTITUDE_CYCLE_BUDGET
+} attitude_stats_t;
+
+
+/**
+ * @brief Resets the estimator to level and zero bias and selects the variant.
+ * @param filter Estimator variant.
+ */
+void attitude_Init(attitude_filter_t filter);
+
+/**
+ * @brief Advances the estimate by one sample.
+ * A fixed number of FPU operations and one square root per normalization,
+ * no branches that depend on the data except the accel trust check.
+ * @param scaled Calibrated sample, accel in g and gyro in °/s.
+ * @param dt Time since the previous sample in seconds.
+ */
+void attitude_Update(const mpu6050_scaled_t *scaled, float dt);
+
+/**
+ * @brief Returns the current orientation quaternion (w, x, y, z), body to earth.
+ * @param q Destination array of 4.
+ */
+void attitude_GetQuaternion(float q[4]);
+
+/**
+ * @brief Converts the current orientation to Euler angles.
+ * Uses atan2f/asinf, meant for reporting rather than the sample-rate path.
+ * @param euler Destination.
+ */
+void attitude_GetEuler(attitude_euler_t *euler);
+
+/**
+ * @brief Returns the update cycle statistics.
+ * @param stats Destination.
+ */
+void attitude_GetStats(attitude_stats_t *stats);
+
+#endif /* ATTITUDE_H_ */
@@ -0,0 +1,55 @@
+/***************************************************************************
+ * File name     :  fixed.h
+ * Description   :  Q16.16 fixed-point helpers for sensor scaling. Raw 16-bit
+ *                  readings are converted with one 32x32->64 multiply by a
+ *                  compile-time Q32 factor, and values are printed through a
+ *                  decimal formatter so no float support is needed in printf.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef FIXED_H_
+#define FIXED_H_
+
+#include <stdint.h>
+
+/* --- Q16.16 format --- */
+typedef int32_t q16_t;
+
+#define Q16_SHIFT               16U
+#define Q16_ONE                 ((q16_t)1 << Q16_SHIFT)
+#define Q16_FRAC_MASK           (Q16_ONE - 1)
+#define Q16_MAX_DECIMALS        4U          // 2^-16 ~ 0.000015, more digits are noise
+
+/* Constant x / y in Q16.16, rounded, for offsets known at compile time */
+#define Q16_CONST(x, y)         ((q16_t)((((int64_t)(x) << Q16_SHIFT) + ((y) / 2)) / (y)))
+
+/* Per-LSB factor num / den in Q0.32, rounded. Must fit in int32_t (num / den < 0.5) */
+#define Q16_SCALE_Q32(num, den) ((int32_t)((((uint64_t)(num) << 32) + ((den) / 2U)) / (den)))
+
+/* Longest q16_format() output: sign, 5 integer digits, point, decimals, NUL */
+#define Q16_STR_MAX             (1U + 5U + 1U + Q16_MAX_DECIMALS + 1U)
+
+/**
+ * @brief Scales a raw reading to Q16.16.
+ * raw * scale is a Q32 product, shifting by 16 leaves Q16.16. Compiles to a
+ * single SMULL plus a shift on Cortex-M4.
+ * @param raw Raw signed reading.
+ * @param scale_q32 Per-LSB factor from Q16_SCALE_Q32().
+ */
+static inline q16_t q16_from_raw(int16_t raw, int32_t scale_q32)
+{
+	return (q16_t)(((int64_t)raw * scale_q32) >> Q16_SHIFT);
+}
+
+/**
+ * @brief Formats a Q16.16 value as a decimal string, e.g. "-1.0312".
+ * The last digit is rounded to nearest.
+ * @param buf Destination, at least Q16_STR_MAX bytes.
+ * @param value Value to format.
+ * @param decimals Digits after the point, clamped to Q16_MAX_DECIMALS (0 omits the point).
+ * @return Number of characters written, excluding the terminating NUL.
+ */
+uint32_t q16_format(char *buf, q16_t value, uint32_t decimals);
+
+#endif /* FIXED_H_ */
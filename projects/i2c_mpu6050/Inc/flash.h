@@ -0,0 +1,46 @@
+/***************************************************************************
+ * File name     :  flash.h
+ * Description   :  Header file for the on-chip flash programming driver.
+ *                  Declares page erase and half-word programming functions
+ *                  for storing small records (calibration data) in a flash
+ *                  page reserved by the linker script.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef FLASH_H_
+#define FLASH_H_
+
+#include <stdint.h>
+
+/* --- STM32F303xE flash geometry --- */
+#define FLASH_BASE_ADDR         0x08000000U
+#define FLASH_SIZE_BYTES        (512U * 1024U)
+#define FLASH_PAGE_BYTES        2048U
+
+/* --- Reserved pages, must match the CALIB region in stm32f303retx_FLASH.ld --- */
+#define FLASH_CALIB_PAGE_ADDR   0x0807F800U     // Last page
+
+/* --- Programming timeouts (loop iterations, worst case erase is ~40 ms) --- */
+#define FLASH_TIMEOUT           4000000U
+
+
+/**
+ * @brief Erases one flash page.
+ * The CPU stalls on any flash fetch while the erase runs, so interrupt
+ * latency grows to the erase time (tens of ms).
+ * @param page_addr Start address of the page, FLASH_PAGE_BYTES aligned.
+ * @return 0 on success, -1 on a bad address, write protection or timeout.
+ */
+int flash_ErasePage(uint32_t page_addr);
+
+/**
+ * @brief Programs a buffer into erased flash, one half-word at a time.
+ * @param addr Destination, half-word aligned and erased.
+ * @param data Source buffer.
+ * @param len Number of bytes, rounded up to a whole half-word (the pad byte is 0xFF).
+ * @return 0 on success, -1 on a bad address, programming error or timeout.
+ */
+int flash_Program(uint32_t addr, const void *data, uint32_t len);
+
+#endif /* FLASH_H_ */
@@ -11,27 +11,48 @@
  **************************************************************************/
 #ifndef I2C_H_
 #define I2C_H_
+#include <stdint.h>
 #include "stm32f3xx.h"
 
  // --- Peripheral Clock Enable Defines ---
 #define GPIOB_EN       (1U << 18)  // Clock enable bit for GPIOB in RCC_AHBENR register
 #define I2C1_EN        (1U << 21)  // Clock enable bit for I2C1 in RCC_APB1ENR register
+#define DMA1_EN        (1U << 0)   // Clock enable bit for DMA1 in RCC_AHBENR register
 
 // --- I2C Control Register 1 (CR1) Bit Defines ---
 #define CR1_PE         (1U << 0)   // Peripheral Enable bit in I2C_CR1
+#define CR1_NACKIE     (1U << 4)   // NACKF interrupt enable
+#define CR1_STOPIE     (1U << 5)   // STOPF interrupt enable
+#define CR1_TCIE       (1U << 6)   // TC/TCR interrupt enable
+#define CR1_ERRIE      (1U << 7)   // BERR/ARLO/OVR interrupt enable
+#define CR1_TXDMAEN    (1U << 14)  // DMA request on TXIS
+#define CR1_RXDMAEN    (1U << 15)  // DMA request on RXNE
 
-// --- I2C Timing Register (TIMINGR) Configuration Values ---
-// These values are specific to achieve a 100kHz I2C clock speed with an 8MHz PCLK.
-// They are combined into the TIMINGR register during initialization.
-#define I2C1_SCLL      (0x13U << 0)    // SCL low period (Master mode)
-#define I2C1_SCLH      (0xFU << 8)     // SCL high period (Master mode)
-#define I2C1_SDADEL    (0x2U << 16)    // SDA data hold up time
-#define I2C1_SCLDEL    (0x4U << 20)    // SCL data setup time
-#define I2C1_PRESC     (0x1U << 28)    // Prescaler value
+// --- SYSCFG Configuration Register 1 (CFGR1) Fast-mode Plus Drive Bits ---
+#define SYSCFG_EN              (1U << 0)   // Clock enable bit for SYSCFG in RCC_APB2ENR register
+#define SYSCFG_CFGR1_PB8_FMP   (1U << 18)  // 20 mA Fm+ drive on PB8 (SCL)
+#define SYSCFG_CFGR1_PB9_FMP   (1U << 19)  // 20 mA Fm+ drive on PB9 (SDA)
+
+/**
+ * @brief I2C1 bus speed profiles, each backed by a timing.h target set.
+ */
+typedef enum {
+    I2C_SPEED_STANDARD = 0,     // 100 kHz
+    I2C_SPEED_FAST,             // 400 kHz
+    I2C_SPEED_FAST_PLUS,        // 1 MHz, needs the Fm+ drive and I2CCLK >= 17 MHz
+    I2C_SPEED_COUNT
+} i2c_speed_t;
+
+#define I2C1_DEFAULT_SPEED  I2C_SPEED_FAST  // MPU6050 is rated for 400 kHz
 
 // --- I2C Interrupt and Status Register (ISR) Flags ---
 // These bits indicate the current status or events during I2C transfers.
 #define ISR_BUSY       (1U << 15)  // Bus busy flag (1=bus is busy)
+#define ISR_TXE        (1U << 0)   // Transmit data register empty, writing 1 flushes TXDR
+#define ISR_BERR       (1U << 8)   // Bus error (misplaced START/STOP)
+#define ISR_ARLO       (1U << 9)   // Arbitration lost
+#define ISR_OVR        (1U << 10)  // Overrun/underrun (slave mode)
+#define ISR_TIMEOUT    (1U << 12)  // SCL held low longer than TIMEOUTR allows
 #define ISR_ADDR       (1U << 3)   // Address matched flag (slave mode: own address matched)
 #define ISR_TXIS       (1U << 1)   // Transmit Interrupt Status (transmit data register empty)
 #define ISR_TC         (1U << 6)   // Transfer Complete (NBYTES reached, AUTOEND=0)
@@ -46,6 +67,8 @@
 #define CR2_STOP       (1U << 14)  // Generate STOP condition
 #define CR2_RD_WRN     (1U << 10)  // Transfer direction (0: Write, 1: Read)
 #define CR2_NBYTES_POS 16          // Bit position for NBYTES field (number of bytes to transfer)
+#define CR2_NBYTES_MASK (0xFFU << 16) // NBYTES field
+#define CR2_NBYTES_MAX 255U        // Largest NBYTES chunk, longer transfers use RELOAD
 #define CR2_RELOAD     (1U << 24)  // RELOAD bit (for transfers > 255 bytes)
 #define CR2_AUTOEND    (1U << 25)  // Automatic END mode (generates STOP and NACK on last byte)
 
@@ -53,16 +76,197 @@
 // Writing a '1' to these bits clears the corresponding flag in the ISR.
 #define ICR_STOPCF     (1U << 5)   // Clear STOP detection flag
 #define ICR_NACKCF     (1U << 4)   // Clear NACK received flag
+#define ICR_BERRCF     (1U << 8)   // Clear bus error flag
+#define ICR_ARLOCF     (1U << 9)   // Clear arbitration lost flag
+#define ICR_OVRCF      (1U << 10)  // Clear overrun/underrun flag
+#define ICR_TIMOUTCF   (1U << 12)  // Clear timeout flag
+
+// --- I2C Timeout Register (TIMEOUTR) Bit Defines ---
+#define TIMEOUTR_TIMOUTEN   (1U << 15)  // Enable SCL-low timeout detection (TIDLE = 0)
+#define TIMEOUTR_TIMEOUTA_MAX 0xFFFU    // 12-bit timeout field, tTIMEOUT = (TIMEOUTA + 1) * 2048 * tI2CCLK
+
+// --- Timeouts and Bus Recovery ---
+#define I2C1_SCL_LOW_TIMEOUT_US 25000U  // Hardware timeout on a slave stretching SCL (SMBus value)
+#define I2C1_TIMEOUT_US         10000U  // Default allowance on top of the nominal bus time of a transaction
+#define I2C1_RECOVERY_PULSES    9U      // SCL pulses to free a slave holding SDA low
+#define I2C1_RECOVERY_HALF_US   5U      // Half period of the bit-banged SCL (100 kHz)
+
+// --- DMA Channel Configuration Register (CCR) Bit Defines ---
+// I2C1_TX is on DMA1 Channel 6, I2C1_RX on DMA1 Channel 7.
+#define DMA1_CCR_EN    (1U << 0)   // Channel enable
+#define DMA1_CCR_TCIE  (1U << 1)   // Transfer complete interrupt enable
+#define DMA1_CCR_TEIE  (1U << 3)   // Transfer error interrupt enable
+#define DMA1_DIR       (1U << 4)   // Direction: 1 = memory to peripheral
+#define DMA1_MINC      (1U << 7)   // Memory increment mode
+
+// --- DMA Interrupt Status (ISR) / Flag Clear (IFCR) Register Bits ---
+#define DMA1_ISR_TCIF6   (1U << 21)  // Channel 6 transfer complete
+#define DMA1_ISR_TEIF6   (1U << 23)  // Channel 6 transfer error
+#define DMA1_IFCR_CGIF6  (1U << 20)  // Clear all channel 6 flags
+#define DMA1_ISR_TEIF7   (1U << 27)  // Channel 7 transfer error
+#define DMA1_IFCR_CGIF7  (1U << 24)  // Clear all channel 7 flags
+
+// --- Transaction Queue ---
+#define I2C1_XFER_QUEUE_DEPTH   8U  // Queued transactions, including the active one (power of two)
+#define I2C1_IRQ_PRIORITY       2U  // NVIC priority of the event and error interrupts
+
+/**
+ * @brief Progress of a queued I2C transaction.
+ * Everything from I2C_XFER_DONE on is final.
+ */
+typedef enum {
+    I2C_XFER_QUEUED = 0,    // Waiting in the queue
+    I2C_XFER_BUSY,          // On the bus
+    I2C_XFER_DONE,          // Completed, all bytes moved
+    I2C_XFER_NACK,          // Slave did not acknowledge its address or a data byte
+    I2C_XFER_BUS_ERROR,     // Misplaced START/STOP on the bus (BERR), bus was recovered
+    I2C_XFER_ARB_LOST,      // Arbitration lost (ARLO)
+    I2C_XFER_TIMEOUT,       // SCL held low or the transaction overran its deadline, bus was recovered
+    I2C_XFER_ERROR          // DMA error, overrun, or the transaction could not be queued
+} i2c_xfer_status_t;
+
+/**
+ * @brief Link health counters, incremented where each event is detected.
+ */
+typedef struct {
+    uint32_t completed;     // Transactions that ended I2C_XFER_DONE
+    uint32_t nack;          // NACK received
+    uint32_t bus_error;     // BERR
+    uint32_t arb_lost;      // ARLO
+    uint32_t overrun;       // OVR
+    uint32_t timeout;       // Hardware SCL-low timeout or software deadline
+    uint32_t dma_error;     // DMA1 CH6/CH7 transfer error
+    uint32_t recoveries;    // Bus-clear sequences run
+} i2c_stats_t;
+
+typedef struct i2c_xfer i2c_xfer_t;
+
+/**
+ * @brief Transaction completion callback, always called from the I2C1 event,
+ * error or DMA interrupts (priority I2C1_IRQ_PRIORITY), also for deadlines
+ * caught by I2C1_Poll().
+ * The transaction has already been retired, so it may be resubmitted here.
+ */
+typedef void (*i2c_xfer_callback_t)(i2c_xfer_t *xfer);
+
+#define I2C_XFER_HDR_MAX        2U  // Register address bytes carried in the descriptor
+
+/**
+ * @brief One I2C transaction: hdr_len + tx_len bytes written, then rx_len
+ * bytes read. The header (typically the register address) is sent ahead of
+ * the tx buffer in the same write, so no copy is needed to prefix it. With
+ * both a write and a read the read follows a repeated START; leave either
+ * side empty for a write-only or read-only transaction. Both buffers are
+ * moved by DMA and may be of any length, NBYTES is reloaded every 255 bytes.
+ * The descriptor and buffers are owned by the caller and must stay valid
+ * until status is final.
+ */
+struct i2c_xfer {
+    uint8_t saddr;                      // 7-bit slave address
+    uint8_t hdr_len;                    // Header bytes to write first (0..I2C_XFER_HDR_MAX)
+    uint8_t hdr[I2C_XFER_HDR_MAX];      // Header, e.g. register address
+    uint16_t tx_len;                    // Bytes to write after the header
+    uint16_t rx_len;                    // Bytes to read
+    const uint8_t *tx;                  // Write buffer
+    uint8_t *rx;                        // Read buffer
+    i2c_xfer_callback_t callback;       // Completion callback, may be NULL
+    volatile i2c_xfer_status_t status;  // Updated by the interrupt
+};
 
 
 /**
  * @brief Initializes the I2C1 peripheral.
- * Configures GPIO pins for I2C (PB8 SCL, PB9 SDA), enables clocks,
- * and sets up I2C timing for standard mode (100kHz).
+ * Configures GPIO pins for I2C (PB8 SCL, PB9 SDA), enables clocks, moves
+ * the I2C1 kernel clock to SYSCLK and applies I2C1_DEFAULT_SPEED.
+ * Event and error interrupts drive the transaction queue, DMA1 Channels 6/7
+ * move the data.
  */
 void I2C1_Init(void);
 
 
+/**
+ * @brief Switches the bus speed profile.
+ * Loads the TIMINGR value precomputed for the profile and sets or clears the
+ * Fast-mode Plus drive on PB8/PB9. Only allowed while no transaction is queued.
+ * @param speed Profile to apply.
+ * @return 0 on success, -1 if the queue is not empty or the profile is invalid.
+ */
+int I2C1_SetSpeed(i2c_speed_t speed);
+
+
+/**
+ * @brief Returns the active bus speed profile.
+ */
+i2c_speed_t I2C1_GetSpeed(void);
+
+
+/**
+ * @brief Queues a transaction, starting it at once if the bus is idle.
+ * Returns immediately; completion is reported through xfer->status and the
+ * optional callback.
+ * @param xfer Transaction descriptor, status is set to I2C_XFER_QUEUED.
+ * @return 0 on success, -1 if the queue is full or the descriptor is empty.
+ */
+int I2C1_Submit(i2c_xfer_t *xfer);
+
+
+/**
+ * @brief Runs a transaction through the queue and waits for it to finish.
+ * The wait is bounded by the transaction deadline (see I2C1_SetTimeout()).
+ * Must not be called from an interrupt at or above I2C1_IRQ_PRIORITY.
+ * @param xfer Transaction descriptor.
+ * @return Final status of the transaction.
+ */
+i2c_xfer_status_t I2C1_Transfer(i2c_xfer_t *xfer);
+
+
+/**
+ * @brief Enforces the deadline of the active transaction.
+ * A transaction that outlives its deadline is aborted with I2C_XFER_TIMEOUT
+ * from the I2C1 event interrupt, which this pends: the bus is recovered and
+ * the queue moves on there. Blocking calls do this on their own; code using
+ * I2C1_Submit() should call it from its main loop.
+ */
+void I2C1_Poll(void);
+
+
+/**
+ * @brief Sets the deadline allowance for each transaction.
+ * A transaction may take its nominal bus time at the current speed plus
+ * this allowance, measured on the DWT cycle counter.
+ * @param timeout_us Allowance in microseconds.
+ */
+void I2C1_SetTimeout(uint32_t timeout_us);
+
+
+/**
+ * @brief Copies the link health counters.
+ * @param stats Destination.
+ */
+void I2C1_GetStats(i2c_stats_t *stats);
+
+
+/**
+ * @brief Frees a bus held by a slave: clocks SCL until SDA is released,
+ * sends a STOP by hand and re-enables the peripheral.
+ * Runs automatically after a bus error or timeout; only call it directly
+ * while no transaction is queued.
+ */
+void I2C1_BusRecover(void);
+
+
+/**
+ * @brief Returns non-zero while a transaction is still queued for xfer.
+ */
+int I2C1_XferPending(const i2c_xfer_t *xfer);
+
+
+/**
+ * @brief Returns the number of transactions queued, including the active one.
+ */
+uint32_t I2C1_QueueDepth(void);
+
+
 /**
  * @brief Reads a single byte from an I2C slave device.
  * Performs a write operation to send the memory address, followed by a
@@ -70,32 +274,39 @@ void I2C1_Init(void);
  * @param saddr   7-bit slave address.
  * @param maddr   8-bit memory address within the slave device to read from.
  * @param data    Pointer to a uint8_t variable where the read byte will be stored.
+ * @return        Final status, I2C_XFER_DONE on success.
  */
-void I2C1_ByteRead(char saddr, char maddr, uint8_t *data);
+i2c_xfer_status_t I2C1_ByteRead(char saddr, char maddr, uint8_t *data);
 
 
 /**
  * @brief Performs a sequential (burst) read of multiple bytes from an I2C slave.
  * Sends the starting memory address, then reads 'n' consecutive bytes.
- * This function handles up to 255 bytes in a single transfer.
+ * Any length is handled in one transfer (NBYTES RELOAD every 255 bytes),
+ * and the call blocks until the transaction queued through I2C1_Transfer()
+ * completes.
  * @param saddr   7-bit slave address.
  * @param maddr   8-bit starting memory address within the slave device.
  * @param n       Number of bytes to read.
  * @param data    Pointer to a uint8_t array where the read bytes will be stored.
+ * @return        Final status, I2C_XFER_DONE on success.
  */
-void I2C1_BurstRead(char saddr, char maddr, int n, uint8_t *data);
+i2c_xfer_status_t I2C1_BurstRead(char saddr, char maddr, int n, uint8_t *data);
 
 
 /**
  * @brief Performs a sequential (burst) write of multiple bytes to an I2C slave.
  * Sends the starting memory address, then writes 'n' consecutive bytes.
- * This function handles up to 254 data bytes plus the memory address in a single transfer.
+ * Any length is handled in one transfer (NBYTES RELOAD every 255 bytes),
+ * and the call blocks until the transaction queued through I2C1_Transfer()
+ * completes.
  * @param saddr   7-bit slave address.
  * @param maddr   8-bit starting memory address within the slave device.
  * @param n       Number of bytes to write.
  * @param data    Pointer to a uint8_t array containing the bytes to be written.
+ * @return        Final status, I2C_XFER_DONE on success.
  */
-void I2C1_BurstWrite(char saddr, char maddr, int n, uint8_t *data);
+i2c_xfer_status_t I2C1_BurstWrite(char saddr, char maddr, int n, uint8_t *data);
 
 
 /**
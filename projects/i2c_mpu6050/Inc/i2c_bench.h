@@ -0,0 +1,33 @@
+/***************************************************************************
+ * File name     :  i2c_bench.h
+ * Description   :  Header file for the I2C1 speed profile benchmark.
+ *                  Declares a function that times motion-sample reads from
+ *                  the MPU6050 under each bus speed profile and prints the
+ *                  achieved throughput and per-transaction latency, and one
+ *                  that compares split and burst motion-sample reads.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef I2C_BENCH_H_
+#define I2C_BENCH_H_
+
+#define I2C_BENCH_XFERS     200U    // Transactions timed per speed profile
+#define I2C_BENCH_BYTES     14U     // Accel + temperature + gyro, one motion sample
+
+/**
+ * @brief Runs the benchmark for every I2C1 speed profile and prints the results.
+ * Requires I2C1 and the MPU6050 to be initialized and the UART for printf.
+ * Restores I2C1_DEFAULT_SPEED when done. The MPU6050 is only rated for
+ * 400 kHz, so the Fast-mode Plus figures are only meaningful for other slaves.
+ */
+void i2c_benchmark(void);
+
+/**
+ * @brief Times a complete accel + temperature + gyro sample at the current
+ * I2C1 speed: accel-only read, accel and gyro as two transactions, and the
+ * single mpu6050_ReadMotion() burst. Same requirements as i2c_benchmark().
+ */
+void i2c_benchmark_motion(void);
+
+#endif /* I2C_BENCH_H_ */
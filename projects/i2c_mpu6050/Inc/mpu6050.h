@@ -13,50 +13,254 @@
 #define MPU6050_H_
 
 #include <stdint.h>
+#include "fixed.h"
 
 // --- MPU6050 device address ---
 #define MPU6050_DEVICE_ADDR		0x68	// Slave address, AD0 pin low
 
 // --- MPU6050 register addresses ---
 #define MPU6050_ACCEL_XOUT_H_REG    0x3B    // X-axis acceleration high byte
+#define MPU6050_GYRO_XOUT_H_REG     0x43    // X-axis angular rate high byte
 #define MPU6050_PWR_MGMT_1_REG      0x6B    // Power management 1 register
 #define MPU6050_WHO_AM_I_REG        0x75    // Device identification register
 #define MPU6050_ACCEL_CONFIG        0x1C    // Accelerometer configuration register
+#define MPU6050_GYRO_CONFIG         0x1B    // Gyroscope configuration register
+#define MPU6050_SMPLRT_DIV_REG      0x19    // Sample rate divider
+#define MPU6050_CONFIG_REG          0x1A    // Digital low pass filter configuration
+#define MPU6050_FIFO_EN_REG         0x23    // Sensors written to the FIFO
+#define MPU6050_INT_PIN_CFG_REG     0x37    // INT pin behaviour
+#define MPU6050_INT_ENABLE_REG      0x38    // Interrupt sources
+#define MPU6050_USER_CTRL_REG       0x6A    // FIFO enable and reset
+#define MPU6050_FIFO_COUNTH_REG     0x72    // FIFO byte count, high byte first
+#define MPU6050_FIFO_R_W_REG        0x74    // FIFO data port
 
 // --- MPU050 configuration values --- 
 #define MPU6050_PWR_MGMT_1_RESET	    0x80	        // Bit 7 device reset
 #define MPU6050_PWR_MGMT_1_WAKE_CLKSEL  (0x00 | 0x01)   // Wake up and select PLL with X-axis gyro as clock source
+#define MPU6050_RESET_DELAY_MS          100U            // Device reset to first register access
+#define MPU6050_ACCEL_FS_2G             (0x00 << 3)     // ±2g full-scale range
 #define MPU6050_ACCEL_FS_4G             (0x01 << 3)     // ±4g full-scale range
+#define MPU6050_ACCEL_FS_8G             (0x02 << 3)     // ±8g full-scale range
+#define MPU6050_ACCEL_FS_16G            (0x03 << 3)     // ±16g full-scale range
+#define MPU6050_GYRO_FS_250DPS          (0x00 << 3)     // ±250 °/s full-scale range
+#define MPU6050_GYRO_FS_500DPS          (0x01 << 3)     // ±500 °/s full-scale range
+#define MPU6050_GYRO_FS_1000DPS         (0x02 << 3)     // ±1000 °/s full-scale range
+#define MPU6050_GYRO_FS_2000DPS         (0x03 << 3)     // ±2000 °/s full-scale range
+#define MPU6050_SMPLRT_DIV_1KHZ         0x00            // 1 kHz gyro output rate / (1 + 0)
+#define MPU6050_DLPF_CFG_188HZ          0x01            // 184/188 Hz bandwidth, gyro output rate 1 kHz
+#define MPU6050_FIFO_EN_MOTION          0xF8            // TEMP, XG, YG, ZG and ACCEL into the FIFO
+#define MPU6050_INT_PIN_CFG_PULSE       0x00            // Active high, push-pull, 50 us pulse
+#define MPU6050_INT_DATA_RDY_EN         0x01            // Interrupt on every new sample
+#define MPU6050_USER_CTRL_FIFO_EN       0x40            // FIFO enable
+#define MPU6050_USER_CTRL_FIFO_RESET    0x04            // FIFO reset, self clearing
+
+// --- Full-scale selection, override with -DMPU6050_ACCEL_FS_G=8 etc. ---
+#ifndef MPU6050_ACCEL_FS_G
+#define MPU6050_ACCEL_FS_G          4
+#endif
+#ifndef MPU6050_GYRO_FS_DPS
+#define MPU6050_GYRO_FS_DPS         250
+#endif
+
+#if MPU6050_ACCEL_FS_G == 2
+#define MPU6050_ACCEL_FS_SEL        MPU6050_ACCEL_FS_2G
+#define MPU6050_ACCEL_LSB_PER_G     16384U
+#elif MPU6050_ACCEL_FS_G == 4
+#define MPU6050_ACCEL_FS_SEL        MPU6050_ACCEL_FS_4G
+#define MPU6050_ACCEL_LSB_PER_G     8192U
+#elif MPU6050_ACCEL_FS_G == 8
+#define MPU6050_ACCEL_FS_SEL        MPU6050_ACCEL_FS_8G
+#define MPU6050_ACCEL_LSB_PER_G     4096U
+#elif MPU6050_ACCEL_FS_G == 16
+#define MPU6050_ACCEL_FS_SEL        MPU6050_ACCEL_FS_16G
+#define MPU6050_ACCEL_LSB_PER_G     2048U
+#else
+#error "MPU6050_ACCEL_FS_G must be 2, 4, 8 or 16"
+#endif
+
+// Gyro sensitivity is fractional (131, 65.5, 32.8, 16.4 LSB per °/s), kept in tenths
+#if MPU6050_GYRO_FS_DPS == 250
+#define MPU6050_GYRO_FS_SEL         MPU6050_GYRO_FS_250DPS
+#define MPU6050_GYRO_LSB10_PER_DPS  1310U
+#elif MPU6050_GYRO_FS_DPS == 500
+#define MPU6050_GYRO_FS_SEL         MPU6050_GYRO_FS_500DPS
+#define MPU6050_GYRO_LSB10_PER_DPS  655U
+#elif MPU6050_GYRO_FS_DPS == 1000
+#define MPU6050_GYRO_FS_SEL         MPU6050_GYRO_FS_1000DPS
+#define MPU6050_GYRO_LSB10_PER_DPS  328U
+#elif MPU6050_GYRO_FS_DPS == 2000
+#define MPU6050_GYRO_FS_SEL         MPU6050_GYRO_FS_2000DPS
+#define MPU6050_GYRO_LSB10_PER_DPS  164U
+#else
+#error "MPU6050_GYRO_FS_DPS must be 250, 500, 1000 or 2000"
+#endif
+
+// --- Raw to Q16.16 factors (see q16_from_raw()) ---
+// A raw reading is also Q15 of full scale, so no factor is needed for that form.
+#define MPU6050_ACCEL_SCALE_Q32     Q16_SCALE_Q32(1U, MPU6050_ACCEL_LSB_PER_G)        // g per LSB
+#define MPU6050_GYRO_SCALE_Q32      Q16_SCALE_Q32(10U, MPU6050_GYRO_LSB10_PER_DPS)    // °/s per LSB
+#define MPU6050_TEMP_SCALE_Q32      Q16_SCALE_Q32(1U, 340U)                           // °C per LSB
+#define MPU6050_TEMP_OFFSET_Q16     Q16_CONST(3653, 100)                              // 36.53 °C at raw 0
+
+// --- Motion burst: ACCEL_XOUT_H (0x3B) .. GYRO_ZOUT_L (0x48) ---
+#define MPU6050_ACCEL_LEN           6U      // Accel XYZ, big-endian
+#define MPU6050_MOTION_LEN          14U     // Accel XYZ, temperature, gyro XYZ, big-endian
+
+// --- FIFO streaming ---
+#define MPU6050_SAMPLE_RATE_HZ      1000U   // Output rate with the settings above
+#define MPU6050_FIFO_SIZE           1024U   // FIFO depth in bytes
+#define MPU6050_FIFO_FRAME_SIZE     MPU6050_MOTION_LEN  // Same layout as the register burst
+#define MPU6050_FIFO_BATCH          8U      // Samples per FIFO drain transaction
+#define MPU6050_FIFO_MAX_FRAMES     32U     // Largest drain, lets a late drain catch up
+#define MPU6050_SAMPLE_RING         64U     // Samples buffered for the application (power of two)
+
+/**
+ * @brief Raw accel, temperature and gyro readings, in register order.
+ */
+typedef struct __attribute__((packed)) {
+    int16_t accel[3];
+    int16_t temp;
+    int16_t gyro[3];
+} mpu6050_motion_t;
+
+/**
+ * @brief Motion readings in physical units, Q16.16.
+ */
+typedef struct {
+    q16_t accel[3];             // g
+    q16_t temp;                 // °C
+    q16_t gyro[3];              // °/s
+} mpu6050_scaled_t;
+
+/**
+ * @brief One motion sample from the FIFO.
+ * timestamp is DWT->CYCCNT at the data-ready edge that latched the sample
+ * (core cycles, wraps every 2^32 cycles).
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;
+    mpu6050_motion_t motion;
+} mpu6050_sample_t;
+
+/**
+ * @brief FIFO streaming counters.
+ */
+typedef struct {
+    uint32_t samples;           // Samples delivered to the ring
+    uint32_t dropped;           // Samples lost because the ring was full
+    uint32_t fifo_resets;       // FIFO overflows or misaligned counts recovered by a reset
+    uint32_t bus_errors;        // Drain transactions that failed
+} mpu6050_stream_stats_t;
+
+/**
+ * @brief Async read completion callback, called from the I2C1 interrupt.
+ * @param ok Non-zero if the read completed, 0 on NACK or bus error.
+ */
+typedef void (*mpu6050_callback_t)(int ok);
 
 
 /**
  * @brief Initializes the MPU6050 sensor.
  * This function initializes I2C, verifies the device ID, resets the sensor,
- * and configures it with default settings.
+ * and configures it with default settings. Blocks for MPU6050_RESET_DELAY_MS
+ * on systickDelayMs(), so systickInit() must have run.
+ * @return 0 on success, -1 if the device did not answer or is not an MPU6050.
  */
-void mpu6050_Init(void);
+int mpu6050_Init(void);
 
 /**
  * @brief Reads a single byte from the specified MPU6050 register.
  * @param reg The register address to read from.
  * @param data Pointer to store the read byte.
+ * @return 0 on success, -1 on an I2C error.
  */
-void mpu6050_ReadByte(uint8_t reg, uint8_t *data);
+int mpu6050_ReadByte(uint8_t reg, uint8_t *data);
 
 /**
  * @brief Writes a single byte to the specified MPU6050 register.
  * @param reg The register address to write to.
  * @param value The byte value to write.
+ * @return 0 on success, -1 on an I2C error.
  */
-void mpu6050_WriteByte(uint8_t reg, uint8_t value);
+int mpu6050_WriteByte(uint8_t reg, uint8_t value);
 
 /**
  * @brief Reads accelerometer values from the MPU6050.
  * @param accel_x Pointer to store X-axis acceleration.
  * @param accel_y Pointer to store Y-axis acceleration.
  * @param accel_z Pointer to store Z-axis acceleration.
+ * @return 0 on success, -1 on an I2C error (outputs are left untouched).
  * @note Values are returned as raw 16-bit integers.
  */
-void mpu6050_ReadAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z);
+int mpu6050_ReadAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z);
+
+/**
+ * @brief Reads accel, temperature and gyro in one 14-byte burst.
+ * One START/address/repeated START instead of one per sensor block.
+ * @param motion Pointer to store the raw readings.
+ * @return 0 on success, -1 on an I2C error or while an async read owns the
+ * shared buffer (motion is left untouched).
+ */
+int mpu6050_ReadMotion(mpu6050_motion_t *motion);
+
+/**
+ * @brief Converts raw readings to g, °C and °/s for the compiled-in full-scale ranges.
+ * One multiply and shift per field, no floating point.
+ * @param raw Raw readings.
+ * @param scaled Pointer to store the Q16.16 values.
+ */
+void mpu6050_Scale(const mpu6050_motion_t *raw, mpu6050_scaled_t *scaled);
+
+/**
+ * @brief Starts a non-blocking accelerometer read on the I2C1 queue.
+ * The 6 raw bytes land in the driver's buffer; poll mpu6050_AccelReady()
+ * or use the callback, then fetch the values with mpu6050_GetAccelValues().
+ * @param callback Called from the I2C1 interrupt when the read ends, may be NULL.
+ * @return 0 if queued, -1 if a read is still in flight or the queue is full.
+ */
+int mpu6050_ReadAccelAsync(mpu6050_callback_t callback);
+
+/**
+ * @brief Returns non-zero once the last async accelerometer read has ended.
+ * Also enforces the I2C1 transaction deadline, so polling this cannot hang.
+ */
+int mpu6050_AccelReady(void);
+
+/**
+ * @brief Decodes the result of the last async accelerometer read.
+ * @param accel_x Pointer to store X-axis acceleration.
+ * @param accel_y Pointer to store Y-axis acceleration.
+ * @param accel_z Pointer to store Z-axis acceleration.
+ * @return 0 on success, -1 if the read failed or has not completed.
+ */
+int mpu6050_GetAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z);
+
+/**
+ * @brief Starts 1 kHz FIFO streaming.
+ * Configures the sample rate divider, DLPF, FIFO and data-ready interrupt,
+ * and takes the MPU6050 INT pin on PA0 / EXTI0. Each edge is timestamped
+ * and every MPU6050_FIFO_BATCH samples the FIFO is drained in one I2C burst.
+ * mpu6050_Init() must have succeeded first.
+ * @return 0 on success, -1 on an I2C error.
+ */
+int mpu6050_StreamStart(void);
+
+/**
+ * @brief Stops FIFO streaming: masks EXTI0 and disables the FIFO.
+ */
+void mpu6050_StreamStop(void);
+
+/**
+ * @brief Takes the oldest sample from the streaming ring buffer.
+ * @param sample Destination.
+ * @return 0 if a sample was copied, -1 if the ring is empty.
+ */
+int mpu6050_SampleGet(mpu6050_sample_t *sample);
+
+/**
+ * @brief Copies the FIFO streaming counters.
+ * @param stats Destination.
+ */
+void mpu6050_GetStreamStats(mpu6050_stream_stats_t *stats);
 
 #endif /* MPU6050_H__*/
\ No newline at end of file
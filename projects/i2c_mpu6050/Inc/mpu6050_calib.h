@@ -0,0 +1,117 @@
+/***************************************************************************
+ * File name     :  mpu6050_calib.h
+ * Description   :  Header file for MPU6050 bias/scale calibration and
+ *                  temperature compensation. Declares functions that measure
+ *                  a stationary sensor, optionally fit a bias-vs-temperature
+ *                  polynomial per axis, persist the result in the reserved
+ *                  flash page and apply it to raw samples.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef MPU6050_CALIB_H_
+#define MPU6050_CALIB_H_
+
+#include <stdint.h>
+#include "mpu6050.h"
+
+/* --- Calibration settings --- */
+#define MPU6050_CALIB_SAMPLES       500U    // Stationary samples collected by mpu6050_CalibRun()
+#define MPU6050_CALIB_AXES          6U      // Accel XYZ, gyro XYZ
+#define MPU6050_CALIB_TEMP_ORDER    2U      // Bias polynomial in (T - T0): c1*dT + c2*dT^2
+#define MPU6050_CALIB_TEMP_SPAN     5.0f    // °C the fit data must cover
+#define MPU6050_CALIB_GYRO_MAX_SD   2.0f    // °/s noise above which the sensor is taken as moving
+#define MPU6050_CALIB_ACCEL_MAX_SD  0.05f   // g noise above which the sensor is taken as moving
+#define MPU6050_CALIB_TEMP_GYRO_GATE  5.0f  // °/s off the bias that keeps a sample out of the temperature fit
+#define MPU6050_CALIB_TEMP_ACCEL_GATE 0.1f  // g change that restarts the temperature fit (board reoriented)
+
+/* --- Flash record --- */
+#define MPU6050_CALIB_MAGIC         0x4C414331U     // "CAL1", bump when the layout changes
+
+/**
+ * @brief Calibration record, stored as-is in the flash calibration page.
+ * bias is in raw counts at temperature t0, temp_coef[k] is the bias
+ * drift per (T - t0)^(k+1). gain_q32 is the per-LSB factor to physical
+ * units with the scale correction folded in.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t fs_sel;                                            // ACCEL_CONFIG << 8 | GYRO_CONFIG the data was taken with
+    int32_t gain_q32[MPU6050_CALIB_AXES];
+    float bias[MPU6050_CALIB_AXES];
+    float temp_coef[MPU6050_CALIB_AXES][MPU6050_CALIB_TEMP_ORDER];
+    float t0;                                                   // °C
+    uint32_t checksum;                                          // Sum of all preceding words, inverted
+} mpu6050_calib_t;
+
+
+/**
+ * @brief Loads the calibration record from flash.
+ * @return 0 if a valid record for the compiled-in full-scale ranges was
+ * found, -1 otherwise (nominal scale and zero bias stay in effect).
+ */
+int mpu6050_CalibLoad(void);
+
+/**
+ * @brief Writes the active calibration to the flash calibration page.
+ * Erases the page first, so call it before the stream is started.
+ * @return 0 on success, -1 on a flash error.
+ */
+int mpu6050_CalibSave(void);
+
+/**
+ * @brief Measures bias and scale from stationary samples.
+ * Reads samples with blocking motion bursts and accumulates a running mean
+ * and variance per axis. The gyro bias is the mean rate. On the axis that
+ * carries gravity the accel gain is corrected to read exactly 1 g. The
+ * other accel axes get their mean as bias. The sensor must lie still with
+ * one axis vertical, and any previous temperature fit is cleared.
+ * @param samples Number of samples, at least 2.
+ * @return 0 on success, -1 on an I2C error or if the noise shows the sensor moved.
+ */
+int mpu6050_CalibRun(uint32_t samples);
+
+/**
+ * @brief Adds a stationary sample to the temperature fit.
+ * Call at a low rate while the board warms up or cools down.
+ * @param raw Raw sample, temperature field included.
+ */
+void mpu6050_CalibTempAdd(const mpu6050_motion_t *raw);
+
+/**
+ * @brief Fits the bias-vs-temperature polynomial from the collected samples.
+ * Least squares on (T - t0), the constant term is left to mpu6050_CalibRun().
+ * @return 0 on success, -1 if the data covers less than MPU6050_CALIB_TEMP_SPAN.
+ */
+int mpu6050_CalibTempFit(void);
+
+/**
+ * @brief Collects the temperature fit in the background and fits it once
+ * the data covers MPU6050_CALIB_TEMP_SPAN.
+ * Does nothing if the active calibration already has a fit. Samples with
+ * rotation are skipped, an accel change of MPU6050_CALIB_TEMP_ACCEL_GATE
+ * restarts the collection. Call at a low rate with stream samples.
+ * @param raw Raw sample, temperature field included.
+ * @return 1 when a new fit is ready to be saved, 0 otherwise.
+ */
+int mpu6050_CalibTempTrack(const mpu6050_motion_t *raw);
+
+/**
+ * @brief Updates the per-axis offsets for a new die temperature.
+ * Evaluates the polynomials once, so the per-sample correction stays a
+ * single multiply-add. Call whenever the temperature has moved (every
+ * 100 ms is plenty).
+ * @param temp_raw Raw temperature reading.
+ */
+void mpu6050_CalibSetTemp(int16_t temp_raw);
+
+/**
+ * @brief Converts raw readings to calibrated g, °C and °/s.
+ * One multiply-add per axis: raw * gain + offset, in Q16.16.
+ * mpu6050_CalibLoad() or mpu6050_CalibRun() must have been called first.
+ * @param raw Raw readings.
+ * @param scaled Pointer to store the calibrated values.
+ */
+void mpu6050_CalibApply(const mpu6050_motion_t *raw, mpu6050_scaled_t *scaled);
+
+#endif /* MPU6050_CALIB_H_ */
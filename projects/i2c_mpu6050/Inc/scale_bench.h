@@ -0,0 +1,25 @@
+/***************************************************************************
+ * File name     :  scale_bench.h
+ * Description   :  Header file for the sensor scaling benchmark. Declares
+ *                  a function that times the float and fixed-point
+ *                  conversion of an MPU6050 motion sample and the Q16.16
+ *                  decimal formatter in core cycles.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef SCALE_BENCH_H_
+#define SCALE_BENCH_H_
+
+#define SCALE_BENCH_RUNS    1000U   // Conversions timed per scaling path
+
+/**
+ * @brief Times the float (divide per field) and Q16.16 (mpu6050_Scale())
+ * conversion of one motion sample, and one q16_format() call, in core cycles.
+ * Prints each conversion next to its instruction-count model; a figure well
+ * under the model means the loop was optimized away. Requires the DWT cycle
+ * counter to be running (I2C1_Init() starts it) and the UART for printf.
+ */
+void scale_benchmark(void);
+
+#endif /* SCALE_BENCH_H_ */
@@ -43,11 +43,20 @@
 /* --- DMA Clock Enable Define (specific for RCC_AHBENR) --- */
 //#define RCC_AHBENR_DMA1EN   (1U << 0)   // Clock enable bit for DMA1 in RCC_AHBENR
 
-/* --- System and UART Configuration Constants --- */
-#define SYS_FREQ       8000000          // System clock frequency (e.g., 8 MHz HSI)
-#define APB1_CLK       SYS_FREQ         // APB1 bus clock frequency (assuming no prescaler for APB1)
-
+/* --- UART Configuration Constants --- */
 #define UART_BAUDRATE  115200           // Desired UART Baud rate
+
+/* --- Interrupt-driven transmit configuration --- */
+#define UART3_TX_BUF_SIZE   256U        // TX ring buffer size in bytes (must be a power of two)
+
+/**
+ * @brief Policy applied by uart3_write_async() when the TX ring buffer is full.
+ */
+typedef enum {
+    UART_TX_DROP = 0,       // Reject the bytes that do not fit
+    UART_TX_BLOCK,          // Wait until the TX interrupt has freed enough space
+    UART_TX_OVERWRITE       // Discard the oldest queued bytes to make room
+} uart_tx_policy_t;
  
 void _putchar(char character);
 
@@ -82,5 +91,27 @@ char uart3_read(void);
  * @note This function is provided for basic string transmission without DMA.
  */
 void uart3_puts(const char *str);
- 
+
+/**
+ * @brief Queues bytes for interrupt-driven transmission over USART3.
+ * The bytes are copied into the TX ring buffer and drained by the USART3
+ * TXE interrupt, so the call returns without waiting for the line.
+ * @param data Pointer to the bytes to transmit.
+ * @param len Number of bytes to transmit.
+ * @return Number of bytes accepted into the ring buffer.
+ * @note With UART_TX_BLOCK this must not be called with interrupts disabled.
+ */
+uint32_t uart3_write_async(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Selects what uart3_write_async() does when the TX ring buffer is full.
+ * @param policy One of UART_TX_DROP, UART_TX_BLOCK or UART_TX_OVERWRITE.
+ */
+void uart3_set_tx_policy(uart_tx_policy_t policy);
+
+/**
+ * @brief Blocks until every queued byte has left the USART3 shift register.
+ */
+void uart3_flush(void);
+
 #endif /* UART_H_ */
\ No newline at end of file
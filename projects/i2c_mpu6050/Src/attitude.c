@@ -0,0 +1,154 @@
+/***************************************************************************
+ * File name     :  attitude.c
+ * Description   :  Attitude estimator on the Cortex-M4 single-precision FPU.
+ *                  The orientation is a unit quaternion integrated from the
+ *                  gyro rate. The accelerometer, when it reads about 1 g, is
+ *                  taken as the gravity direction and the cross product
+ *                  between measured and estimated gravity feeds back into the
+ *                  rate as a proportional (complementary) or proportional plus
+ *                  integral (Mahony) correction. Every update is timed with
+ *                  the DWT cycle counter against a fixed budget.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <math.h>
+#include "stm32f3xx.h"
+#include "attitude.h"
+
+#define DEG_TO_RAD      0.017453292f
+#define RAD_TO_DEG      57.29577951f
+#define Q16_TO_FLOAT    (1.0f / 65536.0f)
+
+static attitude_filter_t att_filter = ATTITUDE_COMPLEMENTARY;
+static float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f;
+static float bias_x, bias_y, bias_z;    // Mahony integral term, rad/s
+static attitude_stats_t att_stats;
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static float clampf(float v, float limit);
+
+
+void attitude_Init(attitude_filter_t filter)
+{
+	att_filter = filter;
+	q0 = 1.0f;
+	q1 = q2 = q3 = 0.0f;
+	bias_x = bias_y = bias_z = 0.0f;
+	att_stats = (attitude_stats_t){ 0 };
+}
+
+void attitude_Update(const mpu6050_scaled_t *scaled, float dt)
+{
+	uint32_t start = DWT->CYCCNT;
+	float ax = (float)scaled->accel[0] * Q16_TO_FLOAT;
+	float ay = (float)scaled->accel[1] * Q16_TO_FLOAT;
+	float az = (float)scaled->accel[2] * Q16_TO_FLOAT;
+	float gx = (float)scaled->gyro[0] * (Q16_TO_FLOAT * DEG_TO_RAD);
+	float gy = (float)scaled->gyro[1] * (Q16_TO_FLOAT * DEG_TO_RAD);
+	float gz = (float)scaled->gyro[2] * (Q16_TO_FLOAT * DEG_TO_RAD);
+	float a2 = ax * ax + ay * ay + az * az;
+	float norm;
+	float qa, qb, qc;
+	uint32_t cycles;
+
+	// Gravity is only observable while the sensor is not accelerating
+	if ((a2 > ATTITUDE_ACCEL_MIN_G * ATTITUDE_ACCEL_MIN_G) && (a2 < ATTITUDE_ACCEL_MAX_G * ATTITUDE_ACCEL_MAX_G)) {
+		float vx, vy, vz;
+		float ex, ey, ez;
+
+		norm = 1.0f / sqrtf(a2);
+		ax *= norm;
+		ay *= norm;
+		az *= norm;
+
+		// Estimated gravity direction in the body frame (third row of the rotation matrix)
+		vx = 2.0f * (q1 * q3 - q0 * q2);
+		vy = 2.0f * (q0 * q1 + q2 * q3);
+		vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+		// Error is the rotation that takes the estimate onto the measurement
+		ex = ay * vz - az * vy;
+		ey = az * vx - ax * vz;
+		ez = ax * vy - ay * vx;
+
+		if (att_filter == ATTITUDE_MAHONY) {
+			bias_x = clampf(bias_x + ATTITUDE_KI * ex * dt, ATTITUDE_BIAS_MAX);
+			bias_y = clampf(bias_y + ATTITUDE_KI * ey * dt, ATTITUDE_BIAS_MAX);
+			bias_z = clampf(bias_z + ATTITUDE_KI * ez * dt, ATTITUDE_BIAS_MAX);
+		}
+
+		gx += ATTITUDE_KP * ex;
+		gy += ATTITUDE_KP * ey;
+		gz += ATTITUDE_KP * ez;
+	}
+
+	gx += bias_x;
+	gy += bias_y;
+	gz += bias_z;
+
+	// q' = 0.5 * q (x) (0, w), first-order step
+	gx *= 0.5f * dt;
+	gy *= 0.5f * dt;
+	gz *= 0.5f * dt;
+	qa = q0;
+	qb = q1;
+	qc = q2;
+	q0 += -qb * gx - qc * gy - q3 * gz;
+	q1 += qa * gx + qc * gz - q3 * gy;
+	q2 += qa * gy - qb * gz + q3 * gx;
+	q3 += qa * gz + qb * gy - qc * gx;
+
+	norm = 1.0f / sqrtf(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+	q0 *= norm;
+	q1 *= norm;
+	q2 *= norm;
+	q3 *= norm;
+
+	cycles = DWT->CYCCNT - start;
+	att_stats.updates++;
+	att_stats.last_cycles = cycles;
+	if (cycles > att_stats.max_cycles) {
+		att_stats.max_cycles = cycles;
+	}
+	if (cycles > ATTITUDE_CYCLE_BUDGET) {
+		att_stats.over_budget++;
+	}
+}
+
+void attitude_GetQuaternion(float q[4])
+{
+	q[0] = q0;
+	q[1] = q1;
+	q[2] = q2;
+	q[3] = q3;
+}
+
+void attitude_GetEuler(attitude_euler_t *euler)
+{
+	float sinp = 2.0f * (q0 * q2 - q3 * q1);
+
+	euler->roll = atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)) * RAD_TO_DEG;
+	euler->pitch = asinf(clampf(sinp, 1.0f)) * RAD_TO_DEG;
+	euler->yaw = atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)) * RAD_TO_DEG;
+}
+
+void attitude_GetStats(attitude_stats_t *stats)
+{
+	*stats = att_stats;
+}
+
+/**
+ * @brief Limits v to [-limit, limit], compiles to compares and VMOVs.
+ */
+static float clampf(float v, float limit)
+{
+	if (v > limit) {
+		return limit;
+	}
+	if (v < -limit) {
+		return -limit;
+	}
+	return v;
+}
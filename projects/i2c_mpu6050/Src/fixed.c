@@ -0,0 +1,62 @@
+/***************************************************************************
+ * File name     :  fixed.c
+ * Description   :  Q16.16 to decimal string conversion. Integer-only, so the
+ *                  build can drop float formatting from printf.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "fixed.h"
+
+static const uint32_t pow10_table[Q16_MAX_DECIMALS + 1U] = { 1U, 10U, 100U, 1000U, 10000U };
+
+uint32_t q16_format(char *buf, q16_t value, uint32_t decimals)
+{
+	char digits[5];
+	uint32_t len = 0;
+	uint32_t n = 0;
+	uint32_t mag;
+	uint32_t int_part;
+	uint32_t frac;
+
+	if (decimals > Q16_MAX_DECIMALS) {
+		decimals = Q16_MAX_DECIMALS;
+	}
+
+	// Work on the magnitude, INT32_MIN maps to 32768.0 without overflow
+	mag = (value < 0) ? (0U - (uint32_t)value) : (uint32_t)value;
+	int_part = mag >> Q16_SHIFT;
+
+	// Fraction scaled to the requested digits, rounded; a carry bumps the integer part
+	frac = (uint32_t)((((uint64_t)(mag & (uint32_t)Q16_FRAC_MASK) * pow10_table[decimals]) + (1U << (Q16_SHIFT - 1U))) >> Q16_SHIFT);
+	if (frac >= pow10_table[decimals]) {
+		frac -= pow10_table[decimals];
+		int_part++;
+	}
+
+	// No "-0.0000" for values that round to zero
+	if ((value < 0) && ((int_part != 0U) || (frac != 0U))) {
+		buf[len++] = '-';
+	}
+
+	do {
+		digits[n++] = (char)('0' + (int_part % 10U));
+		int_part /= 10U;
+	} while (int_part != 0U);
+	while (n > 0U) {
+		buf[len++] = digits[--n];
+	}
+
+	if (decimals > 0U) {
+		buf[len++] = '.';
+		for (uint32_t i = decimals; i > 0U; i--) {
+			buf[len + i - 1U] = (char)('0' + (frac % 10U));
+			frac /= 10U;
+		}
+		len += decimals;
+	}
+
+	buf[len] = '\0';
+
+	return len;
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+ * File name     :  flash.c
+ * Description   :  On-chip flash programming driver for the STM32F303.
+ *                  Unlocks the flash controller around each operation,
+ *                  erases single pages and programs half-words, and checks
+ *                  the status flags so a failed write is reported instead of
+ *                  leaving a half-written record behind silently.
+ *                  The flash controller runs from HSI, which SystemInit()
+ *                  leaves enabled.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "stm32f3xx.h"
+#include "flash.h"
+
+/* --- FLASH Key values (KEYR) --- */
+#define KEYR_KEY1           0x45670123U
+#define KEYR_KEY2           0xCDEF89ABU
+
+/* --- FLASH Status Register (SR) Bit Defines --- */
+#define SR_BSY              (1U << 0)   // Operation in progress
+#define SR_PGERR            (1U << 2)   // Programming error, target not erased
+#define SR_WRPRTERR         (1U << 4)   // Write protection error
+#define SR_EOP              (1U << 5)   // End of operation
+#define SR_ERRORS           (SR_PGERR | SR_WRPRTERR)
+
+/* --- FLASH Control Register (CR) Bit Defines --- */
+#define CR_PG               (1U << 0)   // Programming
+#define CR_PER              (1U << 1)   // Page erase
+#define CR_STRT             (1U << 6)   // Start erase
+#define CR_LOCK             (1U << 7)   // Controller locked
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void flash_unlock(void);
+static void flash_lock(void);
+static int flash_wait(void);
+
+
+int flash_ErasePage(uint32_t page_addr)
+{
+	int ret;
+
+	if ((page_addr < FLASH_BASE_ADDR) || (page_addr >= FLASH_BASE_ADDR + FLASH_SIZE_BYTES) ||
+	    ((page_addr % FLASH_PAGE_BYTES) != 0U)) {
+		return -1;
+	}
+
+	flash_unlock();
+
+	FLASH->CR |= CR_PER;
+	FLASH->AR = page_addr;
+	FLASH->CR |= CR_STRT;
+	ret = flash_wait();
+	FLASH->CR &= ~CR_PER;
+
+	flash_lock();
+
+	return ret;
+}
+
+int flash_Program(uint32_t addr, const void *data, uint32_t len)
+{
+	const uint8_t *src = data;
+	int ret = 0;
+
+	if ((addr < FLASH_BASE_ADDR) || ((addr + len) > FLASH_BASE_ADDR + FLASH_SIZE_BYTES) ||
+	    ((addr & 1U) != 0U)) {
+		return -1;
+	}
+
+	flash_unlock();
+	FLASH->CR |= CR_PG;
+
+	for (uint32_t i = 0; (i < len) && (ret == 0); i += 2U) {
+		// Little-endian half-word, pad an odd tail with the erased value
+		uint16_t half = (uint16_t)(src[i] | (((i + 1U) < len ? src[i + 1U] : 0xFFU) << 8));
+
+		*(volatile uint16_t *)(addr + i) = half;
+		ret = flash_wait();
+
+		// Read back, the controller only flags writes to non-erased locations
+		if ((ret == 0) && (*(volatile const uint16_t *)(addr + i) != half)) {
+			ret = -1;
+		}
+	}
+
+	FLASH->CR &= ~CR_PG;
+	flash_lock();
+
+	return ret;
+}
+
+/**
+ * @brief Unlocks the flash control register if it is locked.
+ */
+static void flash_unlock(void)
+{
+	if (FLASH->CR & CR_LOCK) {
+		FLASH->KEYR = KEYR_KEY1;
+		FLASH->KEYR = KEYR_KEY2;
+	}
+}
+
+/**
+ * @brief Locks the flash control register against stray writes.
+ */
+static void flash_lock(void)
+{
+	FLASH->CR |= CR_LOCK;
+}
+
+/**
+ * @brief Waits for the running operation to end and clears its status flags.
+ * @return 0 on success, -1 on a programming or protection error or timeout.
+ */
+static int flash_wait(void)
+{
+	uint32_t timeout = FLASH_TIMEOUT;
+	uint32_t sr;
+
+	while ((FLASH->SR & SR_BSY) && (--timeout != 0U)) {}
+	if (timeout == 0U) {
+		return -1;
+	}
+
+	// Status flags are write-1-to-clear
+	sr = FLASH->SR;
+	FLASH->SR = sr & (SR_EOP | SR_ERRORS);
+
+	return (sr & SR_ERRORS) ? -1 : 0;
+}
@@ -3,13 +3,95 @@
  * Description   :	This file implements the I2C1 driver for STM32F3 microcontrollers.
  * 					It provides functions to initialize I2C1 and perform single byte
  * 					and multi-byte (burst) read/write operations with I2C slave devices.
- * 					The implementation uses polling for status flags and handles common
- * 					I2C transfer sequences like START, STOP, NACK, and data transfer.
+ * 					Transactions are queued and run by the I2C1 event/error interrupts
+ * 					(write, read, or write then read with a repeated START), so the
+ * 					caller can keep working while the bus is busy. Data moves on
+ * 					DMA1 Channel 6 (TX) and Channel 7 (RX); transfers longer than
+ * 					255 bytes are split with NBYTES RELOAD on TCR. The blocking
+ * 					byte/burst functions are thin wrappers around the queue.
+ * 					Every transaction has a deadline on the DWT cycle counter and
+ * 					SCL-low is caught by the hardware timeout; a stuck bus is
+ * 					cleared by bit-banging SCL before the queue moves on.
+ * 					Transactions are retired, and their callbacks run, only in
+ * 					the I2C1/DMA interrupts: an expired deadline pends the
+ * 					event interrupt rather than retiring it in thread mode.
  *
  * Author        :	Jere Piirainen
  * Date          :	2025-06-18
  **************************************************************************/
+#include <stddef.h>
 #include "i2c.h"
+#include "clock.h"
+#include "timing.h"
+
+#define CFGR3_I2C1SW	(1U << 4)	// I2C1 kernel clock: 0 = HSI, 1 = SYSCLK
+
+#define OSPEEDR_PB8_PB9_HIGH	((3U << 16) | (3U << 18))	// High speed edges on PB8/PB9
+
+/* --- Bus recovery pins --- */
+#define PIN_SCL				(1U << 8)					// PB8
+#define PIN_SDA				(1U << 9)					// PB9
+#define MODER_PB8_PB9_MASK	((3U << 16) | (3U << 18))
+#define MODER_PB8_PB9_AF	((2U << 16) | (2U << 18))	// Alternate function (I2C1)
+#define MODER_PB8_PB9_OUT	((1U << 16) | (1U << 18))	// General purpose output (open drain)
+
+#define CYCLES_PER_US		(CLOCK_HCLK_FREQ / 1000000U)
+
+/* --- Hardware SCL-low timeout --- */
+#define I2C1_TIMEOUTA_VAL	((uint32_t)(((uint64_t)CLOCK_I2C1_FREQ * I2C1_SCL_LOW_TIMEOUT_US) / (2048ULL * 1000000ULL)) - 1U)
+
+_Static_assert(I2C1_TIMEOUTA_VAL <= TIMEOUTR_TIMEOUTA_MAX, "I2C1_SCL_LOW_TIMEOUT_US too long for TIMEOUTR");
+
+/* --- I2C1 timing per speed profile, resolved at compile time --- */
+I2C_TIMING_CHECK(CLOCK_I2C1_FREQ, STD);
+I2C_TIMING_CHECK(CLOCK_I2C1_FREQ, FAST);
+I2C_TIMING_CHECK(CLOCK_I2C1_FREQ, FASTPLUS);
+
+static const uint32_t i2c1_timingr[I2C_SPEED_COUNT] = {
+	[I2C_SPEED_STANDARD]  = I2C_TIMINGR(CLOCK_I2C1_FREQ, STD),
+	[I2C_SPEED_FAST]      = I2C_TIMINGR(CLOCK_I2C1_FREQ, FAST),
+	[I2C_SPEED_FAST_PLUS] = I2C_TIMINGR(CLOCK_I2C1_FREQ, FASTPLUS),
+};
+
+static const uint32_t i2c1_scl_freq[I2C_SPEED_COUNT] = {
+	[I2C_SPEED_STANDARD]  = I2C_STD_SCL_FREQ,
+	[I2C_SPEED_FAST]      = I2C_FAST_SCL_FREQ,
+	[I2C_SPEED_FAST_PLUS] = I2C_FASTPLUS_SCL_FREQ,
+};
+
+static i2c_speed_t i2c1_speed = I2C1_DEFAULT_SPEED;
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void i2c1_apply_speed(i2c_speed_t speed);
+static void i2c1_xfer_start(i2c_xfer_t *xfer);
+static void i2c1_xfer_start_read(i2c_xfer_t *xfer);
+static void i2c1_xfer_finish(i2c_xfer_status_t status);
+static uint32_t i2c1_next_chunk(void);
+static void i2c1_dma_start(DMA_Channel_TypeDef *ch, const uint8_t *buf, uint32_t len);
+static uint32_t i2c1_deadline_cycles(const i2c_xfer_t *xfer);
+static int i2c1_deadline_passed(void);
+static void i2c1_reset(void);
+static void i2c1_bus_clear(void);
+static void i2c1_delay_us(uint32_t us);
+
+/* --- Transaction queue state --- */
+#define XFER_Q_MASK		(I2C1_XFER_QUEUE_DEPTH - 1U)
+
+_Static_assert((I2C1_XFER_QUEUE_DEPTH & XFER_Q_MASK) == 0U, "I2C1_XFER_QUEUE_DEPTH must be a power of two");
+
+static i2c_xfer_t *xfer_queue[I2C1_XFER_QUEUE_DEPTH];
+static volatile uint32_t xfer_q_head = 0;		// Next free slot
+static volatile uint32_t xfer_q_tail = 0;		// Active (or next) transaction
+static volatile uint8_t xfer_active = 0;		// A transaction owns the bus
+static uint32_t xfer_remaining = 0;			// Bytes of the current phase not yet given to NBYTES (ISR only)
+static uint8_t xfer_tx_payload = 0;				// DMA TX has moved on from the header to tx (ISR only)
+static volatile uint32_t xfer_start_cyc = 0;	// DWT->CYCCNT when the active transaction started
+static volatile uint32_t xfer_limit_cyc = 0;	// Cycles the active transaction may take
+static volatile uint32_t xfer_timeout_us = I2C1_TIMEOUT_US;
+
+/* --- Link health --- */
+static volatile i2c_stats_t i2c1_stats;
+
 
 void I2C1_Init(void)
 {
@@ -37,265 +119,603 @@ void I2C1_Init(void)
 	/* Enable clock access to I2C1*/
 	RCC->APB1ENR |= I2C1_EN;
 
+	/* Free-running core cycle counter for deadlines and recovery timing */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	/* A slave reset mid-byte may still be holding SDA low */
+	if (!(GPIOB->IDR & PIN_SDA)) {
+		i2c1_bus_clear();
+	}
+
 	/* Disable I2C1 peripheral (PE bit) to allow configuration/reset */
 	I2C1->CR1 &= ~CR1_PE;
 
-	/* Configure I2C1 Timing Register (TIMINGR) for 100kHz clock speed */
-    // These values are derived from the reference manual
-    // based on PCLK1 frequency (8MHz) to achieve a 100kHz I2C clock.
-	I2C1->TIMINGR = I2C1_SCLL | I2C1_SCLH | I2C1_SDADEL | I2C1_SCLDEL | I2C1_PRESC;
+	/* Run the I2C1 kernel clock from SYSCLK, Fast-mode Plus needs more than HSI */
+	RCC->CFGR3 |= CFGR3_I2C1SW;
+
+	/* SYSCFG holds the Fast-mode Plus drive bits */
+	RCC->APB2ENR |= SYSCFG_EN;
+
+	/* Configure I2C1 Timing Register (TIMINGR) for the default bus speed */
+	i2c1_apply_speed(I2C1_DEFAULT_SPEED);
+
+	/* Hardware timeout on SCL held low (TIMEOUTA must be set before TIMOUTEN) */
+	I2C1->TIMEOUTR = I2C1_TIMEOUTA_VAL;
+	I2C1->TIMEOUTR |= TIMEOUTR_TIMOUTEN;
+
+	/* Data bytes go through DMA, phase changes and errors through the interrupts */
+	I2C1->CR1 |= CR1_TXDMAEN | CR1_RXDMAEN | CR1_NACKIE | CR1_STOPIE | CR1_TCIE | CR1_ERRIE;
+
+	/* DMA1 Channel 6: memory -> TXDR, Channel 7: RXDR -> memory */
+	RCC->AHBENR |= DMA1_EN;
+	DMA1_Channel6->CCR = 0;
+	DMA1_Channel7->CCR = 0;
+	DMA1_Channel6->CPAR = (uint32_t)&I2C1->TXDR;
+	DMA1_Channel7->CPAR = (uint32_t)&I2C1->RXDR;
+	DMA1_Channel6->CCR = DMA1_MINC | DMA1_DIR | DMA1_CCR_TCIE | DMA1_CCR_TEIE;
+	DMA1_Channel7->CCR = DMA1_MINC | DMA1_CCR_TEIE;
 
 	/* Peripheral enable */
 	I2C1->CR1 |= CR1_PE;
+
+	NVIC_SetPriority(I2C1_EV_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_SetPriority(I2C1_ER_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_SetPriority(DMA1_Channel6_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_SetPriority(DMA1_Channel7_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_EnableIRQ(I2C1_EV_IRQn);
+	NVIC_EnableIRQ(I2C1_ER_IRQn);
+	NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+	NVIC_EnableIRQ(DMA1_Channel7_IRQn);
 }
 
 
-void I2C1_ByteRead(char saddr, char maddr, uint8_t* data)
+int I2C1_SetSpeed(i2c_speed_t speed)
 {
-	/* Wait until bus not busy */
-	while (I2C1->ISR & ISR_BUSY) {}
-
-	/* --- 1. Master transmitter, send memory address --- */
-	/* Configure CR2 for slave address + write */
-	I2C1->CR2 = 0;							// Clear CR2
-	I2C1->CR2 |= (uint32_t)saddr << 1; 		// Slace address (7-bit)
-	I2C1->CR2 &= ~CR2_RD_WRN;				// Write operation
-	I2C1->CR2 |= (1U << CR2_NBYTES_POS);	// NBYTES = 1
-	I2C1->CR2 &= ~CR2_AUTOEND;				// Software endmode (RESTART)
-
-	/* Generate START condition */
-	I2C1->CR2 |= CR2_START;
-
-	/* Wait for TXIS is set (or NACKF) */
-	while (!(I2C1->ISR & ISR_TXIS)) {
-		if (I2C1->ISR & ISR_NACKF) {
-			/* Handle NACK error */
-			I2C1->ICR |= ICR_NACKCF;
-			I2C1->CR2 |= CR2_STOP;
-			while (!(I2C1->ISR & ISR_STOPF)) {}
-			I2C1->ICR |= ICR_STOPCF;
-			return;
-		}
+	int status = 0;
+	uint32_t primask;
+
+	if (speed >= I2C_SPEED_COUNT) {
+		return -1;
 	}
 
-	/* Write memory address to the transmit data register (TXDR) */
-	I2C1->TXDR = maddr;
+	/* TIMINGR can only change with the peripheral off, keep the queue still meanwhile */
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if (xfer_q_head != xfer_q_tail) {
+		status = -1;
+	} else {
+		I2C1->CR1 &= ~CR1_PE;
+		i2c1_apply_speed(speed);
+		I2C1->CR1 |= CR1_PE;
+	}
 
-	/* Wait for TC flag, indicating maddr has been sent */
-	while (!(I2C1->ISR & ISR_TC)) {}
+	__set_PRIMASK(primask);
 
+	return status;
+}
 
-	/* --- 2. read data from slave --- */
-	/* Configure CR2 for slave address + read */
-	I2C1->CR2 = 0;							// Clear CR2 before reconfiguring
-	I2C1->CR2 |= (uint32_t)saddr << 1;		// Set 7-bit slave address
-	I2C1->CR2 |= CR2_RD_WRN;				// Read operation
-	I2C1->CR2 |= (1U << CR2_NBYTES_POS);	// NBYTES = 1
-	I2C1->CR2 |= CR2_AUTOEND;				// Automatic NACK and STOP
 
-	/* Generate RESTART condition (or START if bus was freed) */
-	I2C1->CR2 = CR2_START;
+i2c_speed_t I2C1_GetSpeed(void)
+{
+	return i2c1_speed;
+}
+
+
+int I2C1_Submit(i2c_xfer_t *xfer)
+{
+	int status = 0;
+	uint32_t primask;
+
+	if (((xfer->hdr_len + xfer->tx_len) == 0U && xfer->rx_len == 0U) || (xfer->hdr_len > I2C_XFER_HDR_MAX)) {
+		return -1;
+	}
 
-	/* Wait for RXNE flag (or possibly NACKF) */
-	while (!(I2C1->ISR & ISR_RXNE)) {
-		if (I2C1->ISR & ISR_NACKF) {
-			I2C1->ICR |= ICR_NACKCF;
-			/* Handle NACK error */
-			I2C1->CR2 |= CR2_STOP;
-			while (!(I2C1->ISR & ISR_STOPF)) {}
-			I2C1->ICR |= ICR_STOPCF;
-			return;
+	/*
+	 * The interrupts consume the queue and decide when the bus goes idle, and
+	 * EXTI0 submits from interrupt context: nothing may run until the slot is
+	 * filled and the head moved. PRIMASK is restored, so this nests.
+	 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	if ((xfer_q_head - xfer_q_tail) == I2C1_XFER_QUEUE_DEPTH) {
+		status = -1;
+	} else {
+		xfer->status = I2C_XFER_QUEUED;
+		xfer_queue[xfer_q_head & XFER_Q_MASK] = xfer;
+		xfer_q_head++;
+
+		/* Bus idle: start this transaction right away */
+		if (!xfer_active) {
+			i2c1_xfer_start(xfer_queue[xfer_q_tail & XFER_Q_MASK]);
 		}
 	}
 
-	/* Read the received byte from RXDR */
-	*data = (uint8_t)I2C1->RXDR;
+	__set_PRIMASK(primask);
+
+	return status;
+}
+
+
+i2c_xfer_status_t I2C1_Transfer(i2c_xfer_t *xfer)
+{
+	if (I2C1_Submit(xfer) != 0) {
+		return I2C_XFER_ERROR;
+	}
+
+	/* Bounded: I2C1_Poll() has the transaction retired once its deadline passes */
+	while (I2C1_XferPending(xfer)) {
+		I2C1_Poll();
+	}
+
+	return xfer->status;
+}
+
+
+void I2C1_Poll(void)
+{
+	/* The event interrupt re-checks and retires it, callbacks never run in the caller's context */
+	if (xfer_active && i2c1_deadline_passed()) {
+		NVIC_SetPendingIRQ(I2C1_EV_IRQn);
+	}
+}
+
+
+void I2C1_SetTimeout(uint32_t timeout_us)
+{
+	xfer_timeout_us = timeout_us;
+}
+
+
+void I2C1_GetStats(i2c_stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	*stats = *(const i2c_stats_t *)&i2c1_stats;
+	__set_PRIMASK(primask);
+}
+
+
+void I2C1_BusRecover(void)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	i2c1_bus_clear();
+	__set_PRIMASK(primask);
+}
+
+
+int I2C1_XferPending(const i2c_xfer_t *xfer)
+{
+	return xfer->status < I2C_XFER_DONE;
+}
+
+
+uint32_t I2C1_QueueDepth(void)
+{
+	return xfer_q_head - xfer_q_tail;
+}
 
-	/* AUTOEND will handle NACK and STOP. Wait for STOPF */
-	while (!(I2C1->ISR & ISR_STOPF)) {}
 
-	/* Clear STOPF flag */
-	I2C1->ICR = ICR_STOPCF;
+i2c_xfer_status_t I2C1_ByteRead(char saddr, char maddr, uint8_t* data)
+{
+	return I2C1_BurstRead(saddr, maddr, 1, data);
 }
 
 
-void I2C1_BurstRead(char saddr, char maddr, int n, uint8_t *data)
+i2c_xfer_status_t I2C1_BurstRead(char saddr, char maddr, int n, uint8_t *data)
 {
+	i2c_xfer_t xfer = {0};
+
+	if ((n <= 0) || (n > 0xFFFF)) return I2C_XFER_ERROR;
+
+	// Write the memory address, then read 'n' bytes after a repeated START
+	xfer.saddr = (uint8_t)saddr;
+	xfer.hdr[0] = (uint8_t)maddr;
+	xfer.hdr_len = 1;
+	xfer.rx = data;
+	xfer.rx_len = (uint16_t)n;
+
+	return I2C1_Transfer(&xfer);
+}
+
 
-	if (n <= 0) return;	// Return if no bytes to read
-
-	// --- Phase 1: Write memory address (maddr) ---
-	// Wait until bus not busy
-	while (I2C1->ISR & ISR_BUSY) {}
-
-	// Configure CR2 for writing maddr: slave address, 1 byte, AUTOEND=0 (software end for RESTART)
-	I2C1->CR2 = 0; 							// Clear CR2 for a fresh configuration
-    I2C1->CR2 |= (uint32_t)saddr << 1;      // Set 7-bit slave address
-    I2C1->CR2 &= ~CR2_RD_WRN;               // Set transfer direction to WRITE
-    I2C1->CR2 |= (1U << CR2_NBYTES_POS);    // Set NBYTES to 1 (for sending maddr)
-    I2C1->CR2 &= ~CR2_AUTOEND;              // Disable AUTOEND for this phase to allow RESTART
-
-	// Generate START condition
-	I2C1->CR2 |= CR2_START;
-
-	// Wait for TXIS (or NACKF for slave address)
-	while (!(I2C1->ISR & ISR_TXIS)) {
-		if (I2C1->ISR & ISR_NACKF) {
-            I2C1->ICR |= ICR_NACKCF; // Clear NACK flag
-            I2C1->CR2 |= CR2_STOP;   // Generate STOP to abort
-            while (!(I2C1->ISR & ISR_STOPF)) {}
-            I2C1->ICR |= ICR_STOPCF; // Clear STOP flag
-            return; // Exit on NACK error
-        }
-	}
-
-	I2C1->TXDR = maddr; // Send memory address
-
-	// Wait for TC (Transfer Complete for the maddr write)
-	// SCL will be stretched low if TC is set and AUTOEND=0
-	while (!(I2C1->ISR & ISR_TC)) {
-		if (I2C1->ISR & ISR_NACKF) { // Should ideally be caught by TXIS check earlier
-			I2C1->ICR |= ICR_NACKCF;
-			I2C1->CR2 |= CR2_STOP;
-			while (!(I2C1->ISR & ISR_STOPF)) {}
-			I2C1->ICR |= ICR_STOPCF;
-			return;
+i2c_xfer_status_t I2C1_BurstWrite(char saddr, char maddr, int n, uint8_t* data)
+{
+	i2c_xfer_t xfer = {0};
+
+	if ((n <= 0) || (n > 0xFFFF)) return I2C_XFER_ERROR;
+
+	// The memory address and the data go out as one write
+	xfer.saddr = (uint8_t)saddr;
+	xfer.hdr[0] = (uint8_t)maddr;
+	xfer.hdr_len = 1;
+	xfer.tx = data;
+	xfer.tx_len = (uint16_t)n;
+
+	return I2C1_Transfer(&xfer);
+}
+
+
+/**
+ * @brief I2C1 event Interrupt Service Routine (ISR).
+ * The bytes themselves are moved by DMA. This reloads NBYTES on TCR, turns
+ * the write phase around into the read phase with a repeated START on TC,
+ * and retires the transaction on STOPF. Entered without any of those, it
+ * was pended by I2C1_Poll() and retires an expired transaction.
+ */
+void I2C1_EV_EXTI23_IRQHandler(void)
+{
+	uint32_t isr = I2C1->ISR;
+	i2c_xfer_t *xfer;
+
+	if (!xfer_active) {
+		/* Nothing owns the bus, drop a stray STOP */
+		I2C1->ICR = ICR_STOPCF | ICR_NACKCF;
+		return;
+	}
+
+	/* A real event wins over the deadline, the transaction may just have finished */
+	if (!(isr & (ISR_NACKF | ISR_TCR | ISR_TC | ISR_STOPF))) {
+		if (i2c1_deadline_passed()) {
+			i2c1_stats.timeout++;
+			i2c1_bus_clear();
+			i2c1_xfer_finish(I2C_XFER_TIMEOUT);
 		}
+		return;
 	}
-	// Note: TC flag is cleared by setting START or STOP bit in I2C_CR2
 
+	xfer = xfer_queue[xfer_q_tail & XFER_Q_MASK];
 
-	// --- Phase 2: Read 'n' bytes of data ---
-	// Configure CR2 for read: slave address, 'n' bytes.
-	// Use AUTOEND=1 for automatic NACK of last byte and STOP.
-	// For >255 byte reads, RELOAD mechanism would be needed.
-	if (n > 255) {
-		// Error: This simplified function doesn't handle >255 byte reads with RELOAD.
-		I2C1->CR2 |= CR2_STOP;
-		while (!(I2C1->ISR & ISR_STOPF)) {}
-		I2C1->ICR |= ICR_STOPCF;
+	/* NACK: the hardware sends STOP on its own, finish on STOPF */
+	if (isr & ISR_NACKF) {
+		I2C1->ICR = ICR_NACKCF;
+		I2C1->ISR |= ISR_TXE;		// Flush a byte that will never be sent
+		xfer->status = I2C_XFER_NACK;
+		i2c1_stats.nack++;
+	}
+
+	/* NBYTES chunk done with RELOAD=1: hand the next chunk to the hardware */
+	if (isr & ISR_TCR) {
+		I2C1->CR2 = (I2C1->CR2 & ~(CR2_NBYTES_MASK | CR2_RELOAD)) | i2c1_next_chunk();
+	}
+
+	/* Write phase done with AUTOEND=0: turn around with a repeated START */
+	if (isr & ISR_TC) {
+		i2c1_xfer_start_read(xfer);
+	}
+
+	if (isr & ISR_STOPF) {
+		I2C1->ICR = ICR_STOPCF;
+		i2c1_xfer_finish((xfer->status == I2C_XFER_BUSY) ? I2C_XFER_DONE : xfer->status);
+	}
+}
+
+
+/**
+ * @brief DMA1 Channel 6 (I2C1_TX) Interrupt Service Routine (ISR).
+ * Switches the channel from the header to the tx buffer once the header is
+ * out, and turns a DMA error into a STOP so the transaction ends.
+ */
+void DMA1_CH6_IRQHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+	i2c_xfer_t *xfer;
+
+	DMA1->IFCR = DMA1_IFCR_CGIF6;
+
+	if (!xfer_active) {
 		return;
 	}
 
-	I2C1->CR2 = 0; // Clear CR2 before reconfiguring
-    I2C1->CR2 |= (uint32_t)saddr << 1;      // Set 7-bit slave address
-    I2C1->CR2 |= CR2_RD_WRN;                // Set transfer direction to READ
-    I2C1->CR2 |= ((uint32_t)n << CR2_NBYTES_POS); // Set NBYTES to the number of bytes to read
-    I2C1->CR2 |= CR2_AUTOEND;               // Enable AUTOEND: automatically NACKs the last byte
-                                            // and generates a STOP condition after NBYTES are received.
+	xfer = xfer_queue[xfer_q_tail & XFER_Q_MASK];
 
+	if (isr & DMA1_ISR_TEIF6) {
+		i2c1_stats.dma_error++;
+		xfer->status = I2C_XFER_ERROR;
+		I2C1->CR2 |= CR2_STOP;
+	} else if ((isr & DMA1_ISR_TCIF6) && !xfer_tx_payload && (xfer->tx_len != 0U)) {
+		/* TXIS stays pending, the request is served as soon as the channel is back on */
+		xfer_tx_payload = 1;
+		i2c1_dma_start(DMA1_Channel6, xfer->tx, xfer->tx_len);
+	}
+}
 
-	// Generate RESTART condition (this also clears the previous TC flag)
-	I2C1->CR2 |= CR2_START;
 
-	for (int i = 0; i < n; i++) {
-		// Wait for RXNE (or NACKF if slave NACKed its address for read)
-		while (!(I2C1->ISR & ISR_RXNE)) {
-			if (I2C1->ISR & ISR_NACKF) {
-				I2C1->ICR |= ICR_NACKCF;
-				// AUTOEND should handle STOP on NACK.
-				return; // Or error code
-			}
-		}
-		data[i] = (uint8_t)I2C1->RXDR;	// Read the received byte into the data buffer
+/**
+ * @brief DMA1 Channel 7 (I2C1_RX) Interrupt Service Routine (ISR).
+ * Only transfer errors are enabled; the read ends on STOPF.
+ */
+void DMA1_CH7_IRQHandler(void)
+{
+	uint32_t isr = DMA1->ISR;
+
+	DMA1->IFCR = DMA1_IFCR_CGIF7;
+
+	if ((isr & DMA1_ISR_TEIF7) && xfer_active) {
+		i2c1_stats.dma_error++;
+		xfer_queue[xfer_q_tail & XFER_Q_MASK]->status = I2C_XFER_ERROR;
+		I2C1->CR2 |= CR2_STOP;
 	}
+}
+
+
+/**
+ * @brief I2C1 error Interrupt Service Routine (ISR).
+ * Bus error, lost arbitration, overrun and SCL-low timeout all end the
+ * transaction without a STOP of our own. The peripheral is reset (and the
+ * bus cleared when a slave may be stuck) and the transaction retired here.
+ */
+void I2C1_ER_IRQHandler(void)
+{
+	uint32_t isr = I2C1->ISR;
+	i2c_xfer_status_t status = I2C_XFER_ERROR;
+
+	if (!(isr & (ISR_BERR | ISR_ARLO | ISR_OVR | ISR_TIMEOUT))) {
+		return;
+	}
+
+	I2C1->ICR = ICR_BERRCF | ICR_ARLOCF | ICR_OVRCF | ICR_TIMOUTCF;
 
-	// With AUTOEND=1, NACK for the last byte and STOP are generated automatically.
-	// Wait for the STOPF flag.
-	while (!(I2C1->ISR & ISR_STOPF)) {
-		// Check for NACKF again, though it implies slave didn't send all data if it occurs here.
-		 if (I2C1->ISR & ISR_NACKF) {
-			 I2C1->ICR |= ICR_NACKCF;
-		 }
+	if (isr & ISR_OVR) {
+		i2c1_stats.overrun++;
+	}
+	if (isr & ISR_ARLO) {
+		i2c1_stats.arb_lost++;
+		status = I2C_XFER_ARB_LOST;
+	}
+	if (isr & ISR_BERR) {
+		i2c1_stats.bus_error++;
+		status = I2C_XFER_BUS_ERROR;
+	}
+	if (isr & ISR_TIMEOUT) {
+		i2c1_stats.timeout++;
+		status = I2C_XFER_TIMEOUT;
+	}
+
+	if ((status == I2C_XFER_BUS_ERROR) || (status == I2C_XFER_TIMEOUT)) {
+		i2c1_bus_clear();
+	} else {
+		i2c1_reset();
+	}
+
+	if (xfer_active) {
+		i2c1_xfer_finish(status);
 	}
-	I2C1->ICR |= ICR_STOPCF; // Clear STOPF flag
 }
 
 
-void I2C1_BurstWrite(char saddr, char maddr, int n, uint8_t* data)
+/**
+ * @brief Writes TIMINGR for a speed profile and sets the matching pad drive.
+ * The peripheral must be disabled (PE = 0).
+ * @param speed Profile to apply.
+ */
+static void i2c1_apply_speed(i2c_speed_t speed)
 {
-	// volatile uint32_t tmpreg; // Not strictly needed for F3 flag clearing method
+	I2C1->TIMINGR = i2c1_timingr[speed];
+
+	if (speed == I2C_SPEED_FAST_PLUS) {
+		/* 20 mA sink and fast edges to reach 1 MHz on a loaded bus */
+		GPIOB->OSPEEDR |= OSPEEDR_PB8_PB9_HIGH;
+		SYSCFG->CFGR1 |= SYSCFG_CFGR1_PB8_FMP | SYSCFG_CFGR1_PB9_FMP;
+	} else {
+		SYSCFG->CFGR1 &= ~(SYSCFG_CFGR1_PB8_FMP | SYSCFG_CFGR1_PB9_FMP);
+	}
 
-	if (n <= 0) return;
+	i2c1_speed = speed;
+}
 
-	// Wait until bus not busy
-	while (I2C1->ISR & ISR_BUSY) {}
 
-	// Configure CR2 for master write operation
-	// Total bytes to send = 1 (for maddr) + n (for data)
-	// Ensure this total does not exceed 255 for this simple implementation.
-	// For >255 bytes, RELOAD mechanism would be needed.
-	uint32_t num_bytes_total = 1 + n;
-	if (num_bytes_total > 255) {
-		// Error: This simplified function doesn't handle >255 byte writes with RELOAD.
-		// Consider generating a STOP and returning an error.
-		I2C1->CR2 |= CR2_STOP;
-		while (!(I2C1->ISR & ISR_STOPF)) {}
-		I2C1->ICR |= ICR_STOPCF;
+/**
+ * @brief Starts a transaction: arms DMA for its first phase, programs CR2 and
+ * sends START. A write followed by a read runs with AUTOEND=0 so TC can
+ * restart; the last phase always uses AUTOEND for the final NACK and STOP.
+ * @param xfer Transaction to start.
+ */
+static void i2c1_xfer_start(i2c_xfer_t *xfer)
+{
+	uint32_t cr2;
+
+	xfer->status = I2C_XFER_BUSY;
+	xfer_active = 1;
+	xfer_start_cyc = DWT->CYCCNT;
+	xfer_limit_cyc = i2c1_deadline_cycles(xfer);
+
+	if ((xfer->hdr_len + xfer->tx_len) == 0U) {
+		i2c1_xfer_start_read(xfer);
 		return;
 	}
 
-	I2C1->CR2 = 0; // Clear CR2 before configuring
-	I2C1->CR2 |= (uint32_t)saddr << 1;          // SADD[7:1]
-	I2C1->CR2 &= ~CR2_RD_WRN;               // Write operation
-	I2C1->CR2 |= (num_bytes_total << CR2_NBYTES_POS); // NBYTES = 1 (maddr) + n (data)
-	I2C1->CR2 |= CR2_AUTOEND;               // Automatic STOP after all bytes are sent
-	// I2C1->CR2 &= ~CR2_RELOAD;            // Not using reload
-
-	// Generate START condition
-	I2C1->CR2 |= CR2_START;
-
-	// Send memory address (maddr)
-	// Wait for TXIS (or NACKF)
-	while (!(I2C1->ISR & ISR_TXIS)) {
-		if (I2C1->ISR & ISR_NACKF) {
-			I2C1->ICR |= ICR_NACKCF;
-			// AUTOEND should handle STOP on NACK if NACKF is detected by hardware correctly.
-			// Or, ensure STOP is generated.
-			// while (!(I2C1->ISR & I2C_ISR_STOPF)) {} // Might be handled by AUTOEND
-			// I2C1->ICR |= I2C_ICR_STOPCF; // Clear STOPF if it occurs
-			return; // Or error code
-		}
+	/* The header goes first, DMA1 CH6 switches to tx when it is done */
+	xfer_remaining = xfer->hdr_len + xfer->tx_len;
+	if (xfer->hdr_len != 0U) {
+		xfer_tx_payload = 0;
+		i2c1_dma_start(DMA1_Channel6, xfer->hdr, xfer->hdr_len);
+	} else {
+		xfer_tx_payload = 1;
+		i2c1_dma_start(DMA1_Channel6, xfer->tx, xfer->tx_len);
 	}
-	I2C1->TXDR = maddr;
-
-	// Send data bytes
-	for (int i = 0; i < n; i++) {
-		// Wait for TXIS (or NACKF)
-		while (!(I2C1->ISR & ISR_TXIS)) {
-			if (I2C1->ISR & ISR_NACKF) {
-				I2C1->ICR |= ICR_NACKCF;
-				// AUTOEND should handle STOP on NACK.
-				// while (!(I2C1->ISR & I2C_ISR_STOPF)) {}
-				// I2C1->ICR |= I2C_ICR_STOPCF;
-				return; // Or error code
-			}
-		}
-		I2C1->TXDR = data[i];
+
+	cr2 = ((uint32_t)xfer->saddr << 1) | i2c1_next_chunk() | CR2_START;
+	if (xfer->rx_len == 0U) {
+		cr2 |= CR2_AUTOEND;		// Ignored by the hardware while RELOAD is set
 	}
 
-	// With AUTOEND=1, NBYTES will be decremented by hardware, and STOP is generated automatically.
-	// Wait for the STOPF flag.
-	while (!(I2C1->ISR & ISR_STOPF)) {
-		// Check for NACKF again, though it should have been caught earlier
-		if (I2C1->ISR & ISR_NACKF) {
-			 I2C1->ICR |= ICR_NACKCF; // Clear it, though transfer already failed
-			 // STOP should still occur with AUTOEND
-		}
+	I2C1->CR2 = cr2;
+}
+
+
+/**
+ * @brief Arms DMA for the read phase and sends (repeated) START for it.
+ * @param xfer Transaction being run.
+ */
+static void i2c1_xfer_start_read(i2c_xfer_t *xfer)
+{
+	xfer_remaining = xfer->rx_len;
+	i2c1_dma_start(DMA1_Channel7, xfer->rx, xfer->rx_len);
+
+	I2C1->CR2 = ((uint32_t)xfer->saddr << 1) | CR2_RD_WRN | i2c1_next_chunk() | CR2_AUTOEND | CR2_START;
+}
+
+
+/**
+ * @brief Takes the next NBYTES chunk off the current phase.
+ * @return NBYTES field and RELOAD bit for CR2, RELOAD set while bytes remain.
+ */
+static uint32_t i2c1_next_chunk(void)
+{
+	uint32_t n = (xfer_remaining > CR2_NBYTES_MAX) ? CR2_NBYTES_MAX : xfer_remaining;
+
+	xfer_remaining -= n;
+
+	return (n << CR2_NBYTES_POS) | ((xfer_remaining != 0U) ? CR2_RELOAD : 0U);
+}
+
+
+/**
+ * @brief Loads a buffer into a DMA channel and enables it.
+ * @param ch  DMA1 Channel 6 or 7.
+ * @param buf Memory side of the transfer.
+ * @param len Number of bytes.
+ */
+static void i2c1_dma_start(DMA_Channel_TypeDef *ch, const uint8_t *buf, uint32_t len)
+{
+	/* CMAR/CNDTR can only be written while the channel is disabled */
+	ch->CCR &= ~DMA1_CCR_EN;
+
+	ch->CMAR = (uint32_t)buf;
+	ch->CNDTR = len;
+
+	ch->CCR |= DMA1_CCR_EN;
+}
+
+
+/**
+ * @brief Retires the active transaction, chains the next one and only then
+ * runs the completion callback.
+ * @param status Final status of the active transaction.
+ */
+static void i2c1_xfer_finish(i2c_xfer_status_t status)
+{
+	i2c_xfer_t *done = xfer_queue[xfer_q_tail & XFER_Q_MASK];
+
+	/* Both channels are done with this transaction's buffers */
+	DMA1_Channel6->CCR &= ~DMA1_CCR_EN;
+	DMA1_Channel7->CCR &= ~DMA1_CCR_EN;
+	DMA1->IFCR = DMA1_IFCR_CGIF6 | DMA1_IFCR_CGIF7;
+
+	if (status == I2C_XFER_DONE) {
+		i2c1_stats.completed++;
+	}
+
+	xfer_q_tail++;
+	xfer_active = 0;
+	done->status = status;
+
+	/* Chain the next transaction before doing anything slow */
+	if (xfer_q_tail != xfer_q_head) {
+		i2c1_xfer_start(xfer_queue[xfer_q_tail & XFER_Q_MASK]);
+	}
+
+	if (done->callback != NULL) {
+		done->callback(done);
 	}
-	I2C1->ICR |= ICR_STOPCF; // Clear STOP flag
 }
 
 
+/**
+ * @brief Computes how long a transaction may take: its nominal bus time at
+ * the current speed (9 clocks per byte plus both address bytes) plus the
+ * configured allowance.
+ * @param xfer Transaction about to start.
+ * @return Deadline in core cycles.
+ */
+static uint32_t i2c1_deadline_cycles(const i2c_xfer_t *xfer)
+{
+	uint64_t bytes = (uint64_t)xfer->hdr_len + xfer->tx_len + xfer->rx_len + 2U;
+	uint64_t cycles = (bytes * 9U * CLOCK_HCLK_FREQ) / i2c1_scl_freq[i2c1_speed] +
+	                  (uint64_t)xfer_timeout_us * CYCLES_PER_US;
 
+	/* Keep well inside the 32-bit wrap of CYCCNT */
+	return (cycles > (UINT32_MAX / 2U)) ? (UINT32_MAX / 2U) : (uint32_t)cycles;
+}
 
 
+/**
+ * @brief Returns non-zero once the active transaction has outlived its deadline.
+ */
+static int i2c1_deadline_passed(void)
+{
+	return (DWT->CYCCNT - xfer_start_cyc) > xfer_limit_cyc;
+}
 
 
+/**
+ * @brief Software reset: PE low for at least three APB cycles clears the
+ * state machine and all status flags, configuration registers are kept.
+ */
+static void i2c1_reset(void)
+{
+	I2C1->CR1 &= ~CR1_PE;
+	for (uint32_t i = 0; i < 3U; i++) {
+		(void)I2C1->CR1;
+	}
+	I2C1->CR1 |= CR1_PE;
+}
 
 
+/**
+ * @brief Bus clear: takes PB8/PB9 away from I2C1, clocks SCL until the slave
+ * releases SDA (at most I2C1_RECOVERY_PULSES times), sends a STOP by hand and
+ * hands the pins back to a freshly reset peripheral.
+ */
+static void i2c1_bus_clear(void)
+{
+	I2C1->CR1 &= ~CR1_PE;
+
+	/* Both lines released, then PB8/PB9 as open-drain GPIO outputs */
+	GPIOB->BSRR = PIN_SCL | PIN_SDA;
+	GPIOB->MODER = (GPIOB->MODER & ~MODER_PB8_PB9_MASK) | MODER_PB8_PB9_OUT;
+	i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+
+	/* Each pulse lets the slave shift out one more bit of whatever it was sending */
+	for (uint32_t i = 0; (i < I2C1_RECOVERY_PULSES) && !(GPIOB->IDR & PIN_SDA); i++) {
+		GPIOB->BRR = PIN_SCL;
+		i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+		GPIOB->BSRR = PIN_SCL;
+		i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+	}
+
+	/* STOP: SDA low while SCL is low, then SCL high, then SDA high */
+	GPIOB->BRR = PIN_SCL;
+	i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+	GPIOB->BRR = PIN_SDA;
+	i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+	GPIOB->BSRR = PIN_SCL;
+	i2c1_delay_us(I2C1_RECOVERY_HALF_US);
+	GPIOB->BSRR = PIN_SDA;
+	i2c1_delay_us(I2C1_RECOVERY_HALF_US);
 
+	/* Pins back to I2C1 */
+	GPIOB->MODER = (GPIOB->MODER & ~MODER_PB8_PB9_MASK) | MODER_PB8_PB9_AF;
 
+	i2c1_stats.recoveries++;
 
+	I2C1->CR1 |= CR1_PE;
+}
 
 
+/**
+ * @brief Busy-waits on the DWT cycle counter.
+ * @param us Delay in microseconds.
+ */
+static void i2c1_delay_us(uint32_t us)
+{
+	uint32_t start = DWT->CYCCNT;
+
+	while ((DWT->CYCCNT - start) < (us * CYCLES_PER_US)) {}
+}
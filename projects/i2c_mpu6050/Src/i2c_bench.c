@@ -0,0 +1,113 @@
+/***************************************************************************
+ * File name     :  i2c_bench.c
+ * Description   :  I2C1 speed profile benchmark. Times back-to-back 14-byte
+ *                  motion-sample reads from the MPU6050 with the DWT cycle
+ *                  counter and reports payload throughput plus average and
+ *                  worst-case transaction latency for each profile, then
+ *                  compares the bus time per complete sample of the
+ *                  accel-only register path against the 14-byte motion burst.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "i2c_bench.h"
+#include "i2c.h"
+#include "mpu6050.h"
+#include "clock.h"
+#include "printf.h"
+
+#define CYCLES_PER_US   (CLOCK_HCLK_FREQ / 1000000U)
+
+static const char *const speed_names[I2C_SPEED_COUNT] = {
+	[I2C_SPEED_STANDARD]  = "standard 100k",
+	[I2C_SPEED_FAST]      = "fast     400k",
+	[I2C_SPEED_FAST_PLUS] = "fast+      1M",
+};
+
+void i2c_benchmark(void)
+{
+	uint8_t sample[I2C_BENCH_BYTES];
+
+	/* DWT->CYCCNT is already running, I2C1_Init() starts it for the deadlines */
+	for (uint32_t speed = 0; speed < I2C_SPEED_COUNT; speed++) {
+		uint32_t worst = 0;
+		uint32_t errors = 0;
+		uint32_t start;
+		uint32_t total;
+
+		if (I2C1_SetSpeed((i2c_speed_t)speed) != 0) {
+			printf("%s: skipped, bus busy\n\r", speed_names[speed]);
+			continue;
+		}
+
+		start = DWT->CYCCNT;
+		for (uint32_t i = 0; i < I2C_BENCH_XFERS; i++) {
+			uint32_t t0 = DWT->CYCCNT;
+
+			if (I2C1_BurstRead(MPU6050_DEVICE_ADDR, MPU6050_ACCEL_XOUT_H_REG, I2C_BENCH_BYTES, sample) != I2C_XFER_DONE) {
+				errors++;
+			}
+
+			if ((DWT->CYCCNT - t0) > worst) {
+				worst = DWT->CYCCNT - t0;
+			}
+		}
+		total = DWT->CYCCNT - start;
+
+		/* Payload bytes only, address and register bytes are overhead */
+		printf("%s: %lu B/s, avg %lu us, max %lu us, %lu errors\n\r",
+		       speed_names[speed],
+		       (unsigned long)(((uint64_t)I2C_BENCH_XFERS * I2C_BENCH_BYTES * CLOCK_HCLK_FREQ) / total),
+		       (unsigned long)(total / I2C_BENCH_XFERS / CYCLES_PER_US),
+		       (unsigned long)(worst / CYCLES_PER_US),
+		       (unsigned long)errors);
+	}
+
+	(void)I2C1_SetSpeed(I2C1_DEFAULT_SPEED);
+}
+
+void i2c_benchmark_motion(void)
+{
+	mpu6050_motion_t motion;
+	uint8_t gyro[MPU6050_ACCEL_LEN];
+	int16_t x, y, z;
+	uint32_t errors = 0;
+	uint32_t start;
+	uint32_t accel_only;
+	uint32_t split;
+	uint32_t burst;
+
+	/* Accel only, what mpu6050_ReadAccelValues() costs today */
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < I2C_BENCH_XFERS; i++) {
+		if (mpu6050_ReadAccelValues(&x, &y, &z) != 0) {
+			errors++;
+		}
+	}
+	accel_only = DWT->CYCCNT - start;
+
+	/* Complete sample on the accel path: a second transaction for the gyro block */
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < I2C_BENCH_XFERS; i++) {
+		if ((mpu6050_ReadAccelValues(&x, &y, &z) != 0) ||
+		    (I2C1_BurstRead(MPU6050_DEVICE_ADDR, MPU6050_GYRO_XOUT_H_REG, sizeof(gyro), gyro) != I2C_XFER_DONE)) {
+			errors++;
+		}
+	}
+	split = DWT->CYCCNT - start;
+
+	/* Complete sample in one burst */
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < I2C_BENCH_XFERS; i++) {
+		if (mpu6050_ReadMotion(&motion) != 0) {
+			errors++;
+		}
+	}
+	burst = DWT->CYCCNT - start;
+
+	printf("accel only     : avg %lu us\n\r", (unsigned long)(accel_only / I2C_BENCH_XFERS / CYCLES_PER_US));
+	printf("accel + gyro   : avg %lu us per sample\n\r", (unsigned long)(split / I2C_BENCH_XFERS / CYCLES_PER_US));
+	printf("motion burst   : avg %lu us per sample, %lu errors\n\r",
+	       (unsigned long)(burst / I2C_BENCH_XFERS / CYCLES_PER_US),
+	       (unsigned long)errors);
+}
@@ -1,12 +1,26 @@
 #include "stm32f3xx.h"
 #include "uart.h"
 #include "mpu6050.h"
+#include "mpu6050_calib.h"
+#include "attitude.h"
+#include "clock.h"
 #include "systick.h"
 #include "printf.h"
+#ifdef I2C_BENCHMARK
+#include "i2c_bench.h"
+#endif
+#ifdef SCALE_BENCHMARK
+#include "scale_bench.h"
+#endif
 
-/* Variables to store processed accelerometer values */
-int16_t x, y, z;
-float xg, yg, zg;
+/* Variables to store processed sensor values */
+mpu6050_sample_t sample;
+mpu6050_scaled_t scaled;
+attitude_euler_t euler;
+attitude_stats_t att_stats;
+uint32_t sample_count;
+uint32_t last_timestamp;
+char roll[Q16_STR_MAX], pitch[Q16_STR_MAX], yaw[Q16_STR_MAX];
 
 int main(void)
 {
@@ -17,22 +31,78 @@ int main(void)
 
 
     uart3_tx_rx_init(); // Initialize UART3 (required for _putchar to work)
+    systickInit();      // 1 ms time base, calibration paces its reads on it
 
 
-	mpu6050_Init();
+	if (mpu6050_Init() != 0) {
+		printf("MPU6050 not responding\n\r");
+	}
+
+	/* Stored calibration, or a fresh one if the board is lying still */
+	if (mpu6050_CalibLoad() != 0) {
+		if ((mpu6050_CalibRun(MPU6050_CALIB_SAMPLES) == 0) && (mpu6050_CalibSave() == 0)) {
+			printf("MPU6050 calibrated\n\r");
+		} else {
+			printf("MPU6050 calibration failed, using nominal scale\n\r");
+		}
+	}
+
+#ifdef I2C_BENCHMARK
+	i2c_benchmark();
+	i2c_benchmark_motion();
+#endif
+#ifdef SCALE_BENCHMARK
+	scale_benchmark();
+#endif
+
+	attitude_Init(ATTITUDE_MAHONY);
+
+	/* 1 kHz FIFO stream, timestamped by the data-ready interrupt */
+	if (mpu6050_StreamStart() != 0) {
+		printf("MPU6050 stream start failed\n\r");
+	}
+
     while(1) {
-    	/* Read 16-bit raw accelerometer values into x, y, z */
-    	mpu6050_ReadAccelValues(&x, &y, &z);
+    	/* Fuse every sample the interrupts have collected, print at 10 Hz */
+    	while (mpu6050_SampleGet(&sample) == 0) {
+    		/* Sample spacing from the data-ready timestamps, nominal for the first one */
+    		float dt = (last_timestamp != 0U) ? (float)(sample.timestamp - last_timestamp) / (float)CLOCK_HCLK_FREQ
+    		                                  : 1.0f / (float)MPU6050_SAMPLE_RATE_HZ;
+    		last_timestamp = sample.timestamp;
+
+    		mpu6050_CalibApply(&sample.motion, &scaled);
+    		attitude_Update(&scaled, dt);
+
+    		if (++sample_count < MPU6050_SAMPLE_RATE_HZ / 10U) {
+    			continue;
+    		}
+    		sample_count = 0;
 
-    	/* COnvert raw values */
-    	xg = (float)x / 8192.0f;
-    	yg = (float)y / 8192.0f;
-    	zg = (float)z / 8192.0f;
+    		/* Temperature moves slowly, refresh the calibration offsets at the print rate */
+    		mpu6050_CalibSetTemp(sample.motion.temp);
 
-		printf("xg = %f yg = %f, zg = %f\n\r", xg, yg, zg);
+    		/* Drift data while the board warms up; a finished fit goes to flash with the stream paused */
+    		if (mpu6050_CalibTempTrack(&sample.motion) > 0) {
+    			mpu6050_StreamStop();
+    			if (mpu6050_CalibSave() == 0) {
+    				printf("MPU6050 temperature fit saved\n\r");
+    			}
+    			mpu6050_CalibSetTemp(sample.motion.temp);
+    			if (mpu6050_StreamStart() != 0) {
+    				printf("MPU6050 stream restart failed\n\r");
+    			}
+    			last_timestamp = 0;
+    		}
 
-    	/* Add small delay here */
-    	systickDelayMs(100);
+    		/* Angles go out through q16_format(), printf needs no float support */
+    		attitude_GetEuler(&euler);
+    		attitude_GetStats(&att_stats);
+    		(void)q16_format(roll, (q16_t)(euler.roll * 65536.0f), 2);
+    		(void)q16_format(pitch, (q16_t)(euler.pitch * 65536.0f), 2);
+    		(void)q16_format(yaw, (q16_t)(euler.yaw * 65536.0f), 2);
 
+    		printf("roll = %s pitch = %s yaw = %s (%lu/%lu cycles)\n\r", roll, pitch, yaw,
+    		       (unsigned long)att_stats.last_cycles, (unsigned long)att_stats.max_cycles);
+    	}
     }
 }
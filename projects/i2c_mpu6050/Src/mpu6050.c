@@ -2,45 +2,172 @@
  * File name     :  mpu6050.c
  * Description   :  Implementation of MPU6050 accelerometer/gyroscope functions.
  *                  Provides initialization, register read/write, and data
- *                  acquisition functions for the MPU6050 sensor.
+ *                  acquisition functions for the MPU6050 sensor. In streaming
+ *                  mode the sensor fills its FIFO at 1 kHz, the INT pin on
+ *                  EXTI0 timestamps every sample and the FIFO is drained in
+ *                  bursts from the I2C1 completion callbacks.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-18
  **************************************************************************/
 
+#include <stddef.h>
 #include "mpu6050.h"
 #include "i2c.h"
+#include "clock.h"
+#include "systick.h"
 
-// Global buffer for raw accelerometer data 
-static uint8_t accel_raw_data[6];
+// Global buffer for raw register data, shared by the accel and motion reads.
+// Word aligned for the DMA, the accel read uses the first 6 bytes.
+static uint8_t motion_raw_data[MPU6050_MOTION_LEN] __attribute__((aligned(4)));
 
-void mpu6050_ReadByte(uint8_t reg, uint8_t *data)
+// Queued accelerometer read, shared by the async API
+static i2c_xfer_t accel_xfer = { .status = I2C_XFER_DONE };
+static mpu6050_callback_t accel_callback = NULL;
+
+static void mpu6050_accel_xfer_done(i2c_xfer_t *xfer);
+static void mpu6050_decode_motion(const uint8_t *raw, mpu6050_motion_t *motion);
+
+// --- INT pin: PA0 on EXTI0 ---
+#define GPIOA_EN            (1U << 17)  // Clock enable bit for GPIOA in RCC_AHBENR register
+#define MODER_PA0_MASK      (3U << 0)   // PA0 mode, 00 = input
+#define EXTICR1_EXTI0_MASK  (0xFU << 0) // EXTI0 source, 0 = PA0
+#define EXTI_LINE0          (1U << 0)
+
+// --- FIFO streaming state ---
+#define SAMPLE_RING_MASK    (MPU6050_SAMPLE_RING - 1U)
+#define TS_RING_SIZE        128U        // Timestamps of samples still in the FIFO (power of two)
+#define TS_RING_MASK        (TS_RING_SIZE - 1U)
+#define SAMPLE_PERIOD_CYC   (CLOCK_HCLK_FREQ / MPU6050_SAMPLE_RATE_HZ)
+
+_Static_assert((MPU6050_SAMPLE_RING & SAMPLE_RING_MASK) == 0U, "MPU6050_SAMPLE_RING must be a power of two");
+_Static_assert(TS_RING_SIZE >= MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE, "Timestamp ring must cover a full FIFO");
+
+static mpu6050_sample_t sample_ring[MPU6050_SAMPLE_RING];
+static volatile uint32_t sample_head = 0;       // Written by the I2C1 callback
+static volatile uint32_t sample_tail = 0;       // Written by mpu6050_SampleGet()
+
+static uint32_t ts_ring[TS_RING_SIZE];          // ISR only: EXTI0 shares the I2C1 priority, I2C1 callbacks never run in thread mode
+static uint32_t ts_head = 0;
+static uint32_t ts_tail = 0;
+static uint32_t ts_last = 0;
+
+static uint8_t fifo_buf[MPU6050_FIFO_MAX_FRAMES * MPU6050_FIFO_FRAME_SIZE] __attribute__((aligned(4)));
+static uint8_t fifo_count_buf[2];
+static const uint8_t fifo_reset_val = MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RESET;
+static i2c_xfer_t fifo_count_xfer;
+static i2c_xfer_t fifo_read_xfer;
+static i2c_xfer_t fifo_reset_xfer;
+static uint8_t fifo_draining = 0;               // A count/read/reset chain is on the queue
+
+static volatile mpu6050_stream_stats_t stream_stats;
+
+static void mpu6050_fifo_drain(void);
+static void mpu6050_fifo_count_done(i2c_xfer_t *xfer);
+static void mpu6050_fifo_read_done(i2c_xfer_t *xfer);
+static void mpu6050_fifo_reset_done(i2c_xfer_t *xfer);
+
+int mpu6050_ReadByte(uint8_t reg, uint8_t *data)
 {
 	// Use I2C1_ByteRead to read a single byte from the specified register
-	I2C1_ByteRead(MPU6050_DEVICE_ADDR, reg, data);
+	return (I2C1_ByteRead(MPU6050_DEVICE_ADDR, reg, data) == I2C_XFER_DONE) ? 0 : -1;
 }
 
-void mpu6050_WriteByte(uint8_t reg, uint8_t value)
+int mpu6050_WriteByte(uint8_t reg, uint8_t value)
 {
 	// Create temporary buffer for single byte to write 
 	uint8_t data_to_write[1];	// Using char to match I2C1_BurstWrite parameter type
 	data_to_write[0] = value;
 
 	// Write the single byte to the specified register
-	I2C1_BurstWrite(MPU6050_DEVICE_ADDR, reg, 1, data_to_write);
+	return (I2C1_BurstWrite(MPU6050_DEVICE_ADDR, reg, 1, data_to_write) == I2C_XFER_DONE) ? 0 : -1;
 }
-void mpu6050_ReadAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z)
+int mpu6050_ReadAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z)
 {
-	// Read 6 bytes starting from ACCEL_XOUT_H register (0x3B)
-	I2C1_BurstRead(MPU6050_DEVICE_ADDR, MPU6050_ACCEL_XOUT_H_REG, 6, accel_raw_data);
+	// The async read owns the buffer until it ends
+	if (I2C1_XferPending(&accel_xfer)) {
+		return -1;
+	}
+
+	// Read 6 bytes starting from ACCEL_XOUT_H register (0x3B), keep the old values on failure
+	if (I2C1_BurstRead(MPU6050_DEVICE_ADDR, MPU6050_ACCEL_XOUT_H_REG, MPU6050_ACCEL_LEN, motion_raw_data) != I2C_XFER_DONE) {
+		return -1;
+	}
 
 	// Combine high and low bytes to form 16-bit signed integers 
-	*accel_x = (int16_t)((accel_raw_data[0] << 8) | accel_raw_data[1]);
-	*accel_y = (int16_t)((accel_raw_data[2] << 8) | accel_raw_data[3]);
-	*accel_z = (int16_t)((accel_raw_data[4] << 8) | accel_raw_data[5]);
+	*accel_x = (int16_t)((motion_raw_data[0] << 8) | motion_raw_data[1]);
+	*accel_y = (int16_t)((motion_raw_data[2] << 8) | motion_raw_data[3]);
+	*accel_z = (int16_t)((motion_raw_data[4] << 8) | motion_raw_data[5]);
+
+	return 0;
+}
+
+int mpu6050_ReadMotion(mpu6050_motion_t *motion)
+{
+	if (I2C1_XferPending(&accel_xfer)) {
+		return -1;
+	}
+
+	// ACCEL_XOUT_H .. GYRO_ZOUT_L are contiguous, one transaction covers all three blocks
+	if (I2C1_BurstRead(MPU6050_DEVICE_ADDR, MPU6050_ACCEL_XOUT_H_REG, MPU6050_MOTION_LEN, motion_raw_data) != I2C_XFER_DONE) {
+		return -1;
+	}
+
+	mpu6050_decode_motion(motion_raw_data, motion);
+
+	return 0;
+}
+
+void mpu6050_Scale(const mpu6050_motion_t *raw, mpu6050_scaled_t *scaled)
+{
+	for (uint32_t i = 0; i < 3U; i++) {
+		scaled->accel[i] = q16_from_raw(raw->accel[i], MPU6050_ACCEL_SCALE_Q32);
+		scaled->gyro[i] = q16_from_raw(raw->gyro[i], MPU6050_GYRO_SCALE_Q32);
+	}
+	scaled->temp = q16_from_raw(raw->temp, MPU6050_TEMP_SCALE_Q32) + MPU6050_TEMP_OFFSET_Q16;
+}
+
+int mpu6050_ReadAccelAsync(mpu6050_callback_t callback)
+{
+	// Only one read in flight, it owns motion_raw_data
+	if (I2C1_XferPending(&accel_xfer)) {
+		return -1;
+	}
+
+	// Write ACCEL_XOUT_H, then read 6 bytes after a repeated START
+	accel_xfer.saddr = MPU6050_DEVICE_ADDR;
+	accel_xfer.hdr[0] = MPU6050_ACCEL_XOUT_H_REG;
+	accel_xfer.hdr_len = 1;
+	accel_xfer.rx = motion_raw_data;
+	accel_xfer.rx_len = MPU6050_ACCEL_LEN;
+	accel_xfer.callback = mpu6050_accel_xfer_done;
+	accel_callback = callback;
+
+	return I2C1_Submit(&accel_xfer);
 }
 
-void mpu6050_Init(void)
+int mpu6050_AccelReady(void)
+{
+	// Polling is what bounds a read that never completes
+	I2C1_Poll();
+
+	return !I2C1_XferPending(&accel_xfer);
+}
+
+int mpu6050_GetAccelValues(int16_t *accel_x, int16_t *accel_y, int16_t *accel_z)
+{
+	if (accel_xfer.status != I2C_XFER_DONE) {
+		return -1;
+	}
+
+	*accel_x = (int16_t)((motion_raw_data[0] << 8) | motion_raw_data[1]);
+	*accel_y = (int16_t)((motion_raw_data[2] << 8) | motion_raw_data[3]);
+	*accel_z = (int16_t)((motion_raw_data[4] << 8) | motion_raw_data[5]);
+
+	return 0;
+}
+
+int mpu6050_Init(void)
 {
 	uint8_t who_am_i_val;
 
@@ -48,15 +175,280 @@ void mpu6050_Init(void)
 	I2C1_Init();
 
 	// Check WHO_AM_I register 
-	mpu6050_ReadByte(MPU6050_WHO_AM_I_REG, &who_am_i_val);
+	if ((mpu6050_ReadByte(MPU6050_WHO_AM_I_REG, &who_am_i_val) != 0) ||
+	    (who_am_i_val != MPU6050_DEVICE_ADDR)) {
+		return -1;
+	}
 
 	// Reset MPU-6050 
-	mpu6050_WriteByte(MPU6050_PWR_MGMT_1_REG, MPU6050_PWR_MGMT_1_RESET);
-	for (volatile int i = 0; i < 10000; i++) {}
+	if (mpu6050_WriteByte(MPU6050_PWR_MGMT_1_REG, MPU6050_PWR_MGMT_1_RESET) != 0) {
+		return -1;
+	}
+	systickDelayMs(MPU6050_RESET_DELAY_MS);
 
 	// Wake up MPU-6050 and select clock source 
-	mpu6050_WriteByte(MPU6050_PWR_MGMT_1_REG, MPU6050_PWR_MGMT_1_WAKE_CLKSEL);
+	if (mpu6050_WriteByte(MPU6050_PWR_MGMT_1_REG, MPU6050_PWR_MGMT_1_WAKE_CLKSEL) != 0) {
+		return -1;
+	}
+
+	// Set gyroscope and accelerometer full-scale ranges, the scale factors follow them
+	if (mpu6050_WriteByte(MPU6050_GYRO_CONFIG, MPU6050_GYRO_FS_SEL) != 0) {
+		return -1;
+	}
+	return mpu6050_WriteByte(MPU6050_ACCEL_CONFIG, MPU6050_ACCEL_FS_SEL);
+}
+
+/**
+ * @brief Converts a 14-byte big-endian register or FIFO frame to host order.
+ */
+static void mpu6050_decode_motion(const uint8_t *raw, mpu6050_motion_t *motion)
+{
+	motion->accel[0] = (int16_t)((raw[0] << 8) | raw[1]);
+	motion->accel[1] = (int16_t)((raw[2] << 8) | raw[3]);
+	motion->accel[2] = (int16_t)((raw[4] << 8) | raw[5]);
+	motion->temp     = (int16_t)((raw[6] << 8) | raw[7]);
+	motion->gyro[0]  = (int16_t)((raw[8] << 8) | raw[9]);
+	motion->gyro[1]  = (int16_t)((raw[10] << 8) | raw[11]);
+	motion->gyro[2]  = (int16_t)((raw[12] << 8) | raw[13]);
+}
+
+static void mpu6050_accel_xfer_done(i2c_xfer_t *xfer)
+{
+	// Forward the outcome of the queued read to the application
+	if (accel_callback != NULL) {
+		accel_callback(xfer->status == I2C_XFER_DONE);
+	}
+}
+
+int mpu6050_StreamStart(void)
+{
+	// 1 kHz sample rate: DLPF on (gyro output 1 kHz), divider 0
+	if ((mpu6050_WriteByte(MPU6050_CONFIG_REG, MPU6050_DLPF_CFG_188HZ) != 0) ||
+	    (mpu6050_WriteByte(MPU6050_SMPLRT_DIV_REG, MPU6050_SMPLRT_DIV_1KHZ) != 0)) {
+		return -1;
+	}
+
+	// Accel, temperature and gyro into a freshly reset FIFO
+	if ((mpu6050_WriteByte(MPU6050_FIFO_EN_REG, MPU6050_FIFO_EN_MOTION) != 0) ||
+	    (mpu6050_WriteByte(MPU6050_USER_CTRL_REG, MPU6050_USER_CTRL_FIFO_EN | MPU6050_USER_CTRL_FIFO_RESET) != 0)) {
+		return -1;
+	}
+
+	// Fixed descriptors for the drain chain
+	fifo_count_xfer.saddr = MPU6050_DEVICE_ADDR;
+	fifo_count_xfer.hdr[0] = MPU6050_FIFO_COUNTH_REG;
+	fifo_count_xfer.hdr_len = 1;
+	fifo_count_xfer.rx = fifo_count_buf;
+	fifo_count_xfer.rx_len = sizeof(fifo_count_buf);
+	fifo_count_xfer.callback = mpu6050_fifo_count_done;
+
+	fifo_read_xfer.saddr = MPU6050_DEVICE_ADDR;
+	fifo_read_xfer.hdr[0] = MPU6050_FIFO_R_W_REG;
+	fifo_read_xfer.hdr_len = 1;
+	fifo_read_xfer.rx = fifo_buf;
+	fifo_read_xfer.callback = mpu6050_fifo_read_done;
+
+	fifo_reset_xfer.saddr = MPU6050_DEVICE_ADDR;
+	fifo_reset_xfer.hdr[0] = MPU6050_USER_CTRL_REG;
+	fifo_reset_xfer.hdr_len = 1;
+	fifo_reset_xfer.tx = &fifo_reset_val;
+	fifo_reset_xfer.tx_len = 1;
+	fifo_reset_xfer.callback = mpu6050_fifo_reset_done;
+
+	ts_head = ts_tail = 0;
+	fifo_draining = 0;
+
+	// PA0 input, EXTI0 on the rising edge of the data-ready pulse
+	RCC->AHBENR |= GPIOA_EN;
+	GPIOA->MODER &= ~MODER_PA0_MASK;
+	SYSCFG->EXTICR[0] &= ~EXTICR1_EXTI0_MASK;
+	EXTI->RTSR |= EXTI_LINE0;
+	EXTI->PR = EXTI_LINE0;
+	EXTI->IMR |= EXTI_LINE0;
 
-	// Set accelerometer full-scale range 
-	mpu6050_WriteByte(MPU6050_ACCEL_CONFIG, MPU6050_ACCEL_FS_4G);
-}
\ No newline at end of file
+	// Same priority as I2C1: the EXTI handler submits to the I2C1 queue
+	NVIC_SetPriority(EXTI0_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_EnableIRQ(EXTI0_IRQn);
+
+	// Data-ready pulses start now
+	if ((mpu6050_WriteByte(MPU6050_INT_PIN_CFG_REG, MPU6050_INT_PIN_CFG_PULSE) != 0) ||
+	    (mpu6050_WriteByte(MPU6050_INT_ENABLE_REG, MPU6050_INT_DATA_RDY_EN) != 0)) {
+		mpu6050_StreamStop();
+		return -1;
+	}
+
+	return 0;
+}
+
+void mpu6050_StreamStop(void)
+{
+	EXTI->IMR &= ~EXTI_LINE0;
+	NVIC_DisableIRQ(EXTI0_IRQn);
+
+	// Best effort, the sensor may be the reason streaming is stopped
+	(void)mpu6050_WriteByte(MPU6050_INT_ENABLE_REG, 0x00);
+	(void)mpu6050_WriteByte(MPU6050_USER_CTRL_REG, 0x00);
+}
+
+int mpu6050_SampleGet(mpu6050_sample_t *sample)
+{
+	if (sample_tail == sample_head) {
+		// Nothing new, make sure a stuck drain still times out
+		I2C1_Poll();
+		return -1;
+	}
+
+	*sample = sample_ring[sample_tail & SAMPLE_RING_MASK];
+
+	// Copied out before the slot is handed back to the drain
+	__DMB();
+	sample_tail++;
+
+	return 0;
+}
+
+void mpu6050_GetStreamStats(mpu6050_stream_stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	// Updated from both the EXTI0 and the I2C1 completion context
+	__disable_irq();
+	*stats = *(const mpu6050_stream_stats_t *)&stream_stats;
+	__set_PRIMASK(primask);
+}
+
+/**
+ * @brief EXTI line 0 Interrupt Service Routine (ISR), MPU6050 data ready.
+ * Timestamps the sample just latched into the FIFO and starts a drain
+ * once a batch has built up.
+ */
+void EXTI0_IRQHandler(void)
+{
+	uint32_t now = DWT->CYCCNT;
+
+	if (!(EXTI->PR & EXTI_LINE0)) {
+		return;
+	}
+	EXTI->PR = EXTI_LINE0;
+
+	// A full timestamp ring means the FIFO has overflowed too, the drain resets both
+	if ((ts_head - ts_tail) < TS_RING_SIZE) {
+		ts_ring[ts_head & TS_RING_MASK] = now;
+		ts_head++;
+	}
+
+	if (((ts_head - ts_tail) >= MPU6050_FIFO_BATCH) && !fifo_draining) {
+		mpu6050_fifo_drain();
+	}
+}
+
+/**
+ * @brief Starts the drain chain: FIFO count, then FIFO data (or reset).
+ */
+static void mpu6050_fifo_drain(void)
+{
+	fifo_draining = 1;
+
+	if (I2C1_Submit(&fifo_count_xfer) != 0) {
+		// Queue full, the next data-ready edge tries again
+		fifo_draining = 0;
+	}
+}
+
+static void mpu6050_fifo_count_done(i2c_xfer_t *xfer)
+{
+	uint32_t count = ((uint32_t)fifo_count_buf[0] << 8) | fifo_count_buf[1];
+	uint32_t frames;
+
+	if (xfer->status != I2C_XFER_DONE) {
+		stream_stats.bus_errors++;
+		fifo_draining = 0;
+		return;
+	}
+
+	// An overflowed FIFO drops the oldest bytes, frame boundaries are lost
+	if ((count >= MPU6050_FIFO_SIZE) || ((count % MPU6050_FIFO_FRAME_SIZE) != 0U)) {
+		if (I2C1_Submit(&fifo_reset_xfer) != 0) {
+			fifo_draining = 0;
+		}
+		return;
+	}
+
+	frames = count / MPU6050_FIFO_FRAME_SIZE;
+	if (frames > MPU6050_FIFO_MAX_FRAMES) {
+		frames = MPU6050_FIFO_MAX_FRAMES;
+	}
+
+	if (frames == 0U) {
+		fifo_draining = 0;
+		return;
+	}
+
+	fifo_read_xfer.rx_len = (uint16_t)(frames * MPU6050_FIFO_FRAME_SIZE);
+	if (I2C1_Submit(&fifo_read_xfer) != 0) {
+		fifo_draining = 0;
+	}
+}
+
+static void mpu6050_fifo_read_done(i2c_xfer_t *xfer)
+{
+	uint32_t frames = xfer->rx_len / MPU6050_FIFO_FRAME_SIZE;
+
+	fifo_draining = 0;
+
+	if (xfer->status != I2C_XFER_DONE) {
+		// Part of a frame may have been consumed, realign with a reset
+		stream_stats.bus_errors++;
+		fifo_draining = 1;
+		if (I2C1_Submit(&fifo_reset_xfer) != 0) {
+			fifo_draining = 0;
+		}
+		return;
+	}
+
+	for (uint32_t f = 0; f < frames; f++) {
+		const uint8_t *frame = &fifo_buf[f * MPU6050_FIFO_FRAME_SIZE];
+		mpu6050_sample_t *sample;
+
+		// Oldest pending edge belongs to this frame; extrapolate if edges were missed
+		if (ts_tail != ts_head) {
+			ts_last = ts_ring[ts_tail & TS_RING_MASK];
+			ts_tail++;
+		} else {
+			ts_last += SAMPLE_PERIOD_CYC;
+		}
+
+		if ((sample_head - sample_tail) == MPU6050_SAMPLE_RING) {
+			stream_stats.dropped++;
+			continue;
+		}
+
+		sample = &sample_ring[sample_head & SAMPLE_RING_MASK];
+		sample->timestamp = ts_last;
+		mpu6050_decode_motion(frame, &sample->motion);
+
+		// Sample must be in the ring before the reader can see the new head
+		__DMB();
+		sample_head++;
+		stream_stats.samples++;
+	}
+
+	// Another batch may have built up while this one was on the bus
+	if ((ts_head - ts_tail) >= MPU6050_FIFO_BATCH) {
+		mpu6050_fifo_drain();
+	}
+}
+
+static void mpu6050_fifo_reset_done(i2c_xfer_t *xfer)
+{
+	fifo_draining = 0;
+
+	if (xfer->status != I2C_XFER_DONE) {
+		stream_stats.bus_errors++;
+		return;
+	}
+
+	// The FIFO is empty again, so are the timestamps of what it held
+	ts_tail = ts_head;
+	stream_stats.fifo_resets++;
+}
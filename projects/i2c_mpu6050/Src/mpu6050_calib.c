@@ -0,0 +1,418 @@
+/***************************************************************************
+ * File name     :  mpu6050_calib.c
+ * Description   :  MPU6050 bias/scale calibration and temperature
+ *                  compensation. A stationary capture gives per-axis bias and
+ *                  noise through Welford's running mean and variance, an
+ *                  optional least-squares fit models the bias drift over die
+ *                  temperature, and the record lives in the reserved flash
+ *                  page. The slow parts (temperature polynomial, bias to
+ *                  offset) are evaluated only when the temperature changes,
+ *                  so the per-sample correction is one multiply-add per axis.
+ *                  The fit runs in single precision, which the FPU does in
+ *                  hardware: temperatures are normalized to the fit span and
+ *                  readings taken relative to the first sample, so the sums
+ *                  stay well inside float range and precision.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stddef.h>
+#include "mpu6050_calib.h"
+#include "flash.h"
+#include "systick.h"
+
+#define TFIT_TERMS          (MPU6050_CALIB_TEMP_ORDER + 1U)
+#define CALIB_FS_SEL        (((uint32_t)MPU6050_ACCEL_FS_SEL << 8) | (uint32_t)MPU6050_GYRO_FS_SEL)
+#define CALIB_SUM_WORDS     (offsetof(mpu6050_calib_t, checksum) / sizeof(uint32_t))
+
+_Static_assert(sizeof(mpu6050_calib_t) <= FLASH_PAGE_BYTES, "Calibration record does not fit its flash page");
+_Static_assert((sizeof(mpu6050_calib_t) % sizeof(uint32_t)) == 0U, "Calibration record must be whole words");
+
+// Active calibration and the offsets derived from it for the current temperature
+static mpu6050_calib_t calib;
+static q16_t calib_offset_q16[MPU6050_CALIB_AXES];
+static uint8_t calib_valid = 0;
+
+// Temperature fit accumulators: sums of x^k and of y * x^k, x = dT / span, y = raw - y0
+static float tfit_sx[2U * MPU6050_CALIB_TEMP_ORDER + 1U];
+static float tfit_sxy[MPU6050_CALIB_AXES][TFIT_TERMS];
+static float tfit_y0[MPU6050_CALIB_AXES];
+static float tfit_tmin;
+static float tfit_tmax;
+static uint8_t tfit_done = 0;
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void calib_defaults(void);
+static uint32_t calib_checksum(const mpu6050_calib_t *rec);
+static float calib_temp_c(int16_t temp_raw);
+static void calib_raw_axes(const mpu6050_motion_t *raw, float axes[MPU6050_CALIB_AXES]);
+static void calib_tfit_clear(void);
+static uint8_t calib_tfit_present(void);
+static void calib_update_offsets(float dt);
+
+
+int mpu6050_CalibLoad(void)
+{
+	const mpu6050_calib_t *rec = (const mpu6050_calib_t *)FLASH_CALIB_PAGE_ADDR;
+
+	// An erased page reads all ones and fails the magic check
+	if ((rec->magic != MPU6050_CALIB_MAGIC) || (rec->fs_sel != CALIB_FS_SEL) ||
+	    (rec->checksum != calib_checksum(rec))) {
+		calib_defaults();
+		return -1;
+	}
+
+	calib = *rec;
+	calib_valid = 1;
+	tfit_done = calib_tfit_present();
+	calib_update_offsets(0.0f);
+
+	return 0;
+}
+
+int mpu6050_CalibSave(void)
+{
+	if (!calib_valid) {
+		return -1;
+	}
+
+	calib.checksum = calib_checksum(&calib);
+
+	if (flash_ErasePage(FLASH_CALIB_PAGE_ADDR) != 0) {
+		return -1;
+	}
+
+	return flash_Program(FLASH_CALIB_PAGE_ADDR, &calib, sizeof(calib));
+}
+
+int mpu6050_CalibRun(uint32_t samples)
+{
+	mpu6050_motion_t raw;
+	float mean[MPU6050_CALIB_AXES] = { 0 };
+	float m2[MPU6050_CALIB_AXES] = { 0 };
+	float temp_mean = 0.0f;
+	float limit;
+	uint32_t g_axis = 0;
+
+	if (samples < 2U) {
+		return -1;
+	}
+
+	// Welford: numerically stable running mean and sum of squared deviations
+	for (uint32_t n = 1; n <= samples; n++) {
+		float axes[MPU6050_CALIB_AXES];
+
+		if (mpu6050_ReadMotion(&raw) != 0) {
+			return -1;
+		}
+		calib_raw_axes(&raw, axes);
+
+		for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+			float delta = axes[i] - mean[i];
+
+			mean[i] += delta / (float)n;
+			m2[i] += delta * (axes[i] - mean[i]);
+		}
+		temp_mean += (calib_temp_c(raw.temp) - temp_mean) / (float)n;
+
+		// One new sample per read at the default 1 kHz accel rate
+		systickDelayMs(1);
+	}
+
+	// Noise check in raw counts squared, a moving sensor has a large variance
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		float var = m2[i] / (float)(samples - 1U);
+
+		limit = (i < 3U) ? (MPU6050_CALIB_ACCEL_MAX_SD * (float)MPU6050_ACCEL_LSB_PER_G)
+		                 : (MPU6050_CALIB_GYRO_MAX_SD * (float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+		if (var > limit * limit) {
+			return -1;
+		}
+	}
+
+	// The accel axis with the largest reading carries gravity
+	for (uint32_t i = 1; i < 3U; i++) {
+		if ((mean[i] * mean[i]) > (mean[g_axis] * mean[g_axis])) {
+			g_axis = i;
+		}
+	}
+	limit = (mean[g_axis] < 0.0f) ? -mean[g_axis] : mean[g_axis];
+	if ((limit < 0.5f * (float)MPU6050_ACCEL_LSB_PER_G) || (limit > 1.5f * (float)MPU6050_ACCEL_LSB_PER_G)) {
+		return -1;
+	}
+
+	calib_defaults();
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		calib.bias[i] = mean[i];
+	}
+
+	// One orientation cannot split bias from scale on the gravity axis, the gain absorbs both
+	calib.bias[g_axis] = 0.0f;
+	calib.gain_q32[g_axis] = (int32_t)(4294967296.0f / limit + 0.5f);
+
+	calib.t0 = temp_mean;
+	calib_valid = 1;
+	mpu6050_CalibSetTemp(raw.temp);
+
+	return 0;
+}
+
+void mpu6050_CalibTempAdd(const mpu6050_motion_t *raw)
+{
+	float axes[MPU6050_CALIB_AXES];
+	float t = calib_temp_c(raw->temp);
+	float x = (t - calib.t0) / MPU6050_CALIB_TEMP_SPAN;
+	float xk = 1.0f;
+
+	calib_raw_axes(raw, axes);
+
+	// The first sample is the reference, the constant term takes the difference
+	if (tfit_sx[0] == 0.0f) {
+		tfit_tmin = tfit_tmax = t;
+		for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+			tfit_y0[i] = axes[i];
+		}
+	}
+	if (t < tfit_tmin) {
+		tfit_tmin = t;
+	}
+	if (t > tfit_tmax) {
+		tfit_tmax = t;
+	}
+
+	for (uint32_t k = 0; k <= 2U * MPU6050_CALIB_TEMP_ORDER; k++) {
+		tfit_sx[k] += xk;
+		if (k < TFIT_TERMS) {
+			for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+				tfit_sxy[i][k] += (axes[i] - tfit_y0[i]) * xk;
+			}
+		}
+		xk *= x;
+	}
+}
+
+int mpu6050_CalibTempFit(void)
+{
+	// Normal equations [sum x^(j+k)] c = [sum y x^j], one column per axis
+	float m[TFIT_TERMS][TFIT_TERMS + MPU6050_CALIB_AXES];
+	float span_k;
+
+	if ((tfit_sx[0] < (float)TFIT_TERMS) || ((tfit_tmax - tfit_tmin) < MPU6050_CALIB_TEMP_SPAN)) {
+		return -1;
+	}
+
+	for (uint32_t j = 0; j < TFIT_TERMS; j++) {
+		for (uint32_t k = 0; k < TFIT_TERMS; k++) {
+			m[j][k] = tfit_sx[j + k];
+		}
+		for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+			m[j][TFIT_TERMS + i] = tfit_sxy[i][j];
+		}
+	}
+
+	// Gauss-Jordan with partial pivoting, the system is tiny
+	for (uint32_t c = 0; c < TFIT_TERMS; c++) {
+		uint32_t pivot = c;
+
+		for (uint32_t r = c + 1U; r < TFIT_TERMS; r++) {
+			if (((m[r][c] < 0.0f) ? -m[r][c] : m[r][c]) > ((m[pivot][c] < 0.0f) ? -m[pivot][c] : m[pivot][c])) {
+				pivot = r;
+			}
+		}
+		if (m[pivot][c] == 0.0f) {
+			return -1;
+		}
+		if (pivot != c) {
+			for (uint32_t k = 0; k < TFIT_TERMS + MPU6050_CALIB_AXES; k++) {
+				float tmp = m[c][k];
+				m[c][k] = m[pivot][k];
+				m[pivot][k] = tmp;
+			}
+		}
+
+		for (uint32_t r = 0; r < TFIT_TERMS; r++) {
+			float f;
+
+			if (r == c) {
+				continue;
+			}
+			f = m[r][c] / m[c][c];
+			for (uint32_t k = c; k < TFIT_TERMS + MPU6050_CALIB_AXES; k++) {
+				m[r][k] -= f * m[c][k];
+			}
+		}
+	}
+
+	// Constant terms stay with the stationary bias, only the drift is kept, back in °C
+	span_k = 1.0f;
+	for (uint32_t k = 1; k < TFIT_TERMS; k++) {
+		span_k *= MPU6050_CALIB_TEMP_SPAN;
+		for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+			calib.temp_coef[i][k - 1U] = m[k][TFIT_TERMS + i] / m[k][k] / span_k;
+		}
+	}
+
+	calib_tfit_clear();
+	tfit_done = 1;
+
+	return 0;
+}
+
+int mpu6050_CalibTempTrack(const mpu6050_motion_t *raw)
+{
+	const float gyro_gate = MPU6050_CALIB_TEMP_GYRO_GATE * (float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f;
+	const float accel_gate = MPU6050_CALIB_TEMP_ACCEL_GATE * (float)MPU6050_ACCEL_LSB_PER_G;
+
+	if (!calib_valid || tfit_done) {
+		return 0;
+	}
+
+	// Rotation is not drift: skip the sample
+	for (uint32_t i = 0; i < 3U; i++) {
+		float d = (float)raw->gyro[i] - calib.bias[3U + i];
+
+		if ((d > gyro_gate) || (d < -gyro_gate)) {
+			return 0;
+		}
+	}
+
+	// A new orientation changes gravity on every axis: start over from here
+	if (tfit_sx[0] != 0.0f) {
+		for (uint32_t i = 0; i < 3U; i++) {
+			float d = (float)raw->accel[i] - tfit_y0[i];
+
+			if ((d > accel_gate) || (d < -accel_gate)) {
+				calib_tfit_clear();
+				break;
+			}
+		}
+	}
+
+	mpu6050_CalibTempAdd(raw);
+
+	if ((tfit_tmax - tfit_tmin) < MPU6050_CALIB_TEMP_SPAN) {
+		return 0;
+	}
+
+	return (mpu6050_CalibTempFit() == 0) ? 1 : 0;
+}
+
+void mpu6050_CalibSetTemp(int16_t temp_raw)
+{
+	calib_update_offsets(calib_temp_c(temp_raw) - calib.t0);
+}
+
+void mpu6050_CalibApply(const mpu6050_motion_t *raw, mpu6050_scaled_t *scaled)
+{
+	for (uint32_t i = 0; i < 3U; i++) {
+		scaled->accel[i] = q16_from_raw(raw->accel[i], calib.gain_q32[i]) + calib_offset_q16[i];
+		scaled->gyro[i] = q16_from_raw(raw->gyro[i], calib.gain_q32[3U + i]) + calib_offset_q16[3U + i];
+	}
+	scaled->temp = q16_from_raw(raw->temp, MPU6050_TEMP_SCALE_Q32) + MPU6050_TEMP_OFFSET_Q16;
+}
+
+/**
+ * @brief Nominal datasheet scale, no bias, no temperature drift.
+ */
+static void calib_defaults(void)
+{
+	calib.magic = MPU6050_CALIB_MAGIC;
+	calib.fs_sel = CALIB_FS_SEL;
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		calib.gain_q32[i] = (i < 3U) ? MPU6050_ACCEL_SCALE_Q32 : MPU6050_GYRO_SCALE_Q32;
+		calib.bias[i] = 0.0f;
+		for (uint32_t k = 0; k < MPU6050_CALIB_TEMP_ORDER; k++) {
+			calib.temp_coef[i][k] = 0.0f;
+		}
+		calib_offset_q16[i] = 0;
+	}
+	calib.t0 = 0.0f;
+	calib_valid = 0;
+	tfit_done = 0;
+	calib_tfit_clear();
+}
+
+/**
+ * @brief Inverted sum of the record words up to the checksum field.
+ */
+static uint32_t calib_checksum(const mpu6050_calib_t *rec)
+{
+	const uint32_t *w = (const uint32_t *)rec;
+	uint32_t sum = 0;
+
+	for (uint32_t i = 0; i < CALIB_SUM_WORDS; i++) {
+		sum += w[i];
+	}
+
+	return ~sum;
+}
+
+/**
+ * @brief Die temperature in °C, datasheet formula raw / 340 + 36.53.
+ */
+static float calib_temp_c(int16_t temp_raw)
+{
+	return (float)temp_raw / 340.0f + 36.53f;
+}
+
+/**
+ * @brief Flattens a sample into the calibration axis order.
+ */
+static void calib_raw_axes(const mpu6050_motion_t *raw, float axes[MPU6050_CALIB_AXES])
+{
+	for (uint32_t i = 0; i < 3U; i++) {
+		axes[i] = (float)raw->accel[i];
+		axes[3U + i] = (float)raw->gyro[i];
+	}
+}
+
+/**
+ * @brief Drops the collected temperature fit data.
+ */
+static void calib_tfit_clear(void)
+{
+	for (uint32_t k = 0; k <= 2U * MPU6050_CALIB_TEMP_ORDER; k++) {
+		tfit_sx[k] = 0.0f;
+	}
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		for (uint32_t k = 0; k < TFIT_TERMS; k++) {
+			tfit_sxy[i][k] = 0.0f;
+		}
+	}
+}
+
+/**
+ * @brief Returns 1 if the active record carries a temperature fit.
+ */
+static uint8_t calib_tfit_present(void)
+{
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		for (uint32_t k = 0; k < MPU6050_CALIB_TEMP_ORDER; k++) {
+			if (calib.temp_coef[i][k] != 0.0f) {
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Evaluates the bias polynomials at dt = T - t0 and stores the offsets.
+ */
+static void calib_update_offsets(float x)
+{
+	for (uint32_t i = 0; i < MPU6050_CALIB_AXES; i++) {
+		float bias = calib.bias[i];
+		float xk = x;
+
+		for (uint32_t k = 0; k < MPU6050_CALIB_TEMP_ORDER; k++) {
+			bias += calib.temp_coef[i][k] * xk;
+			xk *= x;
+		}
+
+		// raw * gain + offset == (raw - bias) * gain, offset in Q16.16
+		calib_offset_q16[i] = (q16_t)(-(bias * (float)calib.gain_q32[i]) / 65536.0f);
+	}
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+ * File name     :  scale_bench.c
+ * Description   :  Scaling path benchmark. Times the conversion of one
+ *                  MPU6050 motion sample with a float divide per field
+ *                  against the Q16.16 mpu6050_Scale() path, and one
+ *                  q16_format() call, with the DWT cycle counter, and
+ *                  prints each figure next to its instruction-count model.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "scale_bench.h"
+#include "mpu6050.h"
+#include "fixed.h"
+#include "printf.h"
+#include "stm32f3xx.h"
+
+/*
+ * Instruction-count model of one loop iteration, Cortex-M4F cycle costs
+ * (DDI 0439B tables 3-1 and 7-1): LDRSH 2, VMOV 1, VCVT 1, VMUL/VADD 1,
+ * VDIV 14, VSTR/STR 1 pipelined, SMULL 1, BL/BX 1 + 3 refill, loop 3.
+ *  float: the accel divide by a power of two becomes a VMUL (LDRSH, VMOV,
+ *         VCVT, VMUL, VSTR = 6), temperature and gyro keep the VDIV (19,
+ *         temperature + 1 VADD): 3 * 6 + 20 + 3 * 19 + 3 = 98.
+ *  fixed: LDRSH, SMULL, LSRS + ORR (the 64-bit shift), STR = 6 per field,
+ *         + 1 temperature offset, + call and return 8, + loop 3: 54.
+ */
+#define SCALE_FLOAT_MODEL_CYC   98U
+#define SCALE_FIXED_MODEL_CYC   54U
+
+void scale_benchmark(void)
+{
+	/* A spread of raw values, the FPU divide is data independent but keep it honest */
+	static const mpu6050_motion_t raw = {
+		.accel = { -8192, 123, 32767 }, .temp = -1200, .gyro = { 131, -32768, 4000 },
+	};
+	const volatile mpu6050_motion_t *src = &raw;
+	volatile float sink_f;
+	mpu6050_motion_t in;
+	mpu6050_scaled_t scaled;
+	char buf[Q16_STR_MAX];
+	uint32_t start;
+	uint32_t float_cyc;
+	uint32_t fixed_cyc;
+	uint32_t format_cyc;
+
+	/*
+	 * raw is a constant GCC can see through: read it through a volatile
+	 * pointer and hide the copy behind an asm barrier every iteration, or
+	 * the conversions are folded out of the loop and the loop times nothing.
+	 */
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < SCALE_BENCH_RUNS; i++) {
+		sink_f = (float)src->accel[0] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->accel[1] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->accel[2] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->temp / 340.0f + 36.53f;
+		sink_f = (float)src->gyro[0] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+		sink_f = (float)src->gyro[1] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+		sink_f = (float)src->gyro[2] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+	}
+	float_cyc = DWT->CYCCNT - start;
+	(void)sink_f;
+
+	in = raw;
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < SCALE_BENCH_RUNS; i++) {
+		__asm volatile ("" : : "r" (&in) : "memory");
+		mpu6050_Scale(&in, &scaled);
+		__asm volatile ("" : : "r" (&scaled) : "memory");
+	}
+	fixed_cyc = DWT->CYCCNT - start;
+
+	start = DWT->CYCCNT;
+	for (uint32_t i = 0; i < SCALE_BENCH_RUNS; i++) {
+		__asm volatile ("" : : "r" (&scaled) : "memory");
+		(void)q16_format(buf, scaled.gyro[1], 4);
+		__asm volatile ("" : : "r" (buf) : "memory");
+	}
+	format_cyc = DWT->CYCCNT - start;
+
+	/* Well under the model means the compiler found a way around the barriers */
+	printf("scale float: %lu cycles/sample, model %lu\n\r",
+	       (unsigned long)(float_cyc / SCALE_BENCH_RUNS), (unsigned long)SCALE_FLOAT_MODEL_CYC);
+	printf("scale fixed: %lu cycles/sample, model %lu\n\r",
+	       (unsigned long)(fixed_cyc / SCALE_BENCH_RUNS), (unsigned long)SCALE_FIXED_MODEL_CYC);
+	printf("q16_format : %lu cycles/value (%s)\n\r", (unsigned long)(format_cyc / SCALE_BENCH_RUNS), buf);
+}
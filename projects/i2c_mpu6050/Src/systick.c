@@ -1,31 +1,117 @@
 /***************************************************************************
  * File name     :      systick.c
- * Description   :      This file implements a blocking delay function using
- *                      the ARM Cortex-M SysTick timer. It provides a millisecond
- *                      delay utility based on the system clock.
+ * Description   :      This file implements the system time base on the
+ *                      ARM Cortex-M SysTick timer. SysTick reloads every
+ *                      millisecond and its interrupt advances a 64-bit
+ *                      counter; sub-millisecond time comes from the current
+ *                      counter value. Delays and timeouts are deadlines
+ *                      against this clock instead of SysTick reprogramming.
  *
  * Author        :      Jere Piirainen
  * Date          :      2025-06-16
  **************************************************************************/
 #include "systick.h"
+#include "clock.h"
+#include "timing.h"
+
+SYSTICK_RELOAD_CHECK(CLOCK_HCLK_FREQ, SYSTICK_TICK_HZ);
 #include "stm32f3xx.h"
 
-void systickDelayMs(int delay)
+#define SYSTICK_LOAD        SYSTICK_RELOAD(CLOCK_HCLK_FREQ, SYSTICK_TICK_HZ)
+#define US_PER_TICK         (1000000U / SYSTICK_TICK_HZ)
+
+/* Whole ticks since systickInit(), written only by SysTick_Handler */
+static volatile uint64_t systick_ms = 0;
+
+
+void systickInit(void)
 {
-	/* Configure SysTick timer for 1 ms counting */
-	/* Reload with number of clock cycles per millisecond */
-	SysTick->LOAD = SYSTICK_LOAD_VAL;
+	SysTick->CTRL = 0;
+	systick_ms = 0;
+
+	/* Reload with number of clock cycles per millisecond (counter counts LOAD..0) */
+	SysTick->LOAD = SYSTICK_LOAD;
 
 	/* Clear SysTick current value register */
 	SysTick->VAL = 0;
 
-	/* Enable SysTick and select internal clock source */
-	SysTick->CTRL = (CSR_ENABLE | CSR_CLKSRC);
+	NVIC_SetPriority(SysTick_IRQn, SYSTICK_IRQ_PRIORITY);
+
+	/* Enable SysTick with its interrupt, internal clock source */
+	SysTick->CTRL = (CSR_ENABLE | CSR_TICKINT | CSR_CLKSRC);
+}
+
+
+uint64_t now_ms(void)
+{
+	uint64_t ms;
+
+	/* Two halves, torn by a tick in between: read until stable */
+	do {
+		ms = systick_ms;
+	} while (ms != systick_ms);
+
+	return ms;
+}
+
+
+uint64_t now_us(void)
+{
+	uint64_t ms;
+	uint32_t val;
+	uint32_t pending;
+
+	/* Retry if the handler ran in between, ms and val must come from the same period */
+	do {
+		ms = systick_ms;
+		val = SysTick->VAL;
+
+		/*
+		 * Reloaded but the handler has not run yet (masked, or called from a
+		 * higher priority handler): read VAL again so it is surely past the
+		 * reload, and count the pending tick below.
+		 */
+		pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+		if (pending) {
+			val = SysTick->VAL;
+		}
+	} while (ms != systick_ms);
 
-	for (int i = 0; i < delay; i++) {
-		/* Wait until the countflag is set */
-		while ((SysTick->CTRL & CSR_COUNTFLAG) == 0) {}
+	if (pending) {
+		ms++;
 	}
-    /* Disable SysTick timer after delay completion */
-	SysTick->CTRL = 0;
-}
\ No newline at end of file
+
+	return (ms * US_PER_TICK) + (((SYSTICK_LOAD - val) * US_PER_TICK) / (SYSTICK_LOAD + 1U));
+}
+
+
+uint64_t elapsed_us(uint64_t since_us)
+{
+	return now_us() - since_us;
+}
+
+
+int deadline_expired(uint64_t deadline_us)
+{
+	return now_us() >= deadline_us;
+}
+
+
+void systickDelayMs(int delay)
+{
+	uint64_t deadline = now_us() + ((uint64_t)delay * 1000U);
+
+	/* The tick wakes the core every millisecond, any other interrupt sooner */
+	while (!deadline_expired(deadline)) {
+		__WFI();
+	}
+}
+
+
+/**
+ * @brief SysTick exception handler, once per millisecond.
+ */
+void SysTick_Handler(void)
+{
+	systick_ms++;
+}
@@ -0,0 +1,155 @@
+/***************************************************************************
+ * File name     :  pwm.h
+ * Description   :  Header file for the PWM output driver on TIM1, TIM2 and
+ *                  TIM3. Each timer runs edge-aligned PWM mode 1 at one
+ *                  frequency shared by its four channels, with per-channel
+ *                  duty cycles. TIM1 adds complementary outputs with
+ *                  dead-time insertion. A burst mode streams a table of
+ *                  compare values through TIMx_DMAR, one frame per PWM
+ *                  period, so waveforms and pulse-width coded protocols
+ *                  (WS2812) run without the CPU.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef PWM_H_
+#define PWM_H_
+
+#include <stdint.h>
+
+#define PWM_CHANNELS            4U          // CH1..CH4 on every timer
+#define PWM_COMPLEMENTARY       3U          // CH1N..CH3N, TIM1 only
+#define PWM_DUTY_SCALE          10000U      // Duty in 0.01 % steps, 10000 = always high
+#define PWM_DMA_IRQ_PRIORITY    2U
+#define PWM_DEADTIME_MAX_NS     14000U      // 1008 dead-time ticks at 72 MHz
+
+/* --- WS2812 over PWM: one PWM period per bit at 800 kHz --- */
+#define PWM_WS2812_FREQ         800000U     // 1.25 us per bit
+#define PWM_WS2812_RESET_FRAMES 64U         // 80 us low latches the data (>= 50 us)
+#define PWM_WS2812_FRAMES(bytes)    ((bytes) * 8U + PWM_WS2812_RESET_FRAMES)
+
+/*
+ * Pins, all in alternate function mode:
+ *   TIM1  CH1 PA8, CH2 PA9, CH3 PA10, CH4 PA11, CH1N PA7, CH2N PB0, CH3N PB1
+ *   TIM2  CH1 PA5 (LED), CH2 PA1, CH3 PA2, CH4 PA3
+ *   TIM3  CH1 PC6, CH2 PC7, CH3 PC8, CH4 PC9
+ * Burst DMA uses the update request of each timer on DMA1:
+ *   TIM1_UP Channel 5, TIM2_UP Channel 2, TIM3_UP Channel 3
+ */
+typedef enum {
+    PWM_TIM1 = 0,
+    PWM_TIM2,
+    PWM_TIM3,
+    PWM_TIMER_COUNT
+} pwm_timer_t;
+
+/**
+ * @brief Called from the DMA1 interrupt when a one-shot burst has sent its
+ * last frame or a circular burst has wrapped, and when a transfer error
+ * stops the burst.
+ * @param timer Timer whose burst the DMA was serving.
+ */
+typedef void (*pwm_burst_cb_t)(pwm_timer_t timer);
+
+
+/**
+ * @brief Starts a timer as an edge-aligned PWM time base with every channel
+ * off. The prescaler is the smallest that fits the period in 16 bits.
+ * @param timer PWM_TIM1..PWM_TIM3.
+ * @param freq_hz PWM frequency, at least 2 counter ticks per period.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int pwmInit(pwm_timer_t timer, uint32_t freq_hz);
+
+/**
+ * @brief Changes the PWM frequency of a running timer. Every channel keeps
+ * its duty cycle, and the new period starts at the next update so no
+ * period is cut short.
+ * @param timer PWM_TIM1..PWM_TIM3.
+ * @param freq_hz New frequency.
+ * @return 0 on success, -1 on a bad argument or while a burst is running.
+ */
+int pwmSetFrequency(pwm_timer_t timer, uint32_t freq_hz);
+
+/**
+ * @brief Counter ticks per PWM period (ARR + 1), the full-scale compare
+ * value for burst tables.
+ */
+uint32_t pwmPeriodTicks(pwm_timer_t timer);
+
+/**
+ * @brief Switches a channel's pin to the timer and starts its output.
+ * @param timer PWM_TIM1..PWM_TIM3.
+ * @param channel 0..PWM_CHANNELS-1.
+ * @param duty 0..PWM_DUTY_SCALE.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int pwmChannelEnable(pwm_timer_t timer, uint32_t channel, uint32_t duty);
+
+/**
+ * @brief Sets a channel's duty cycle, applied from the next period.
+ * @param timer PWM_TIM1..PWM_TIM3.
+ * @param channel 0..PWM_CHANNELS-1.
+ * @param duty 0..PWM_DUTY_SCALE.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int pwmSetDuty(pwm_timer_t timer, uint32_t channel, uint32_t duty);
+
+/**
+ * @brief Stops a channel's output and its complementary output. The pins
+ * are no longer driven by the timer.
+ */
+void pwmChannelDisable(pwm_timer_t timer, uint32_t channel);
+
+/**
+ * @brief Adds the complementary output of a TIM1 channel, enabled with
+ * pwmChannelEnable(). Both edges of each pulse are delayed by the dead
+ * time, which is shared by the three pairs; pulses shorter than it vanish.
+ * @param channel 0..PWM_COMPLEMENTARY-1.
+ * @param deadtime_ns Rounded up to the dead-time generator steps,
+ * 0..PWM_DEADTIME_MAX_NS.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int pwmComplementaryEnable(uint32_t channel, uint32_t deadtime_ns);
+
+/**
+ * @brief Streams raw compare values into consecutive channels, a frame of
+ * `channels` values per update event. A frame written at one update is
+ * loaded into the outputs at the next, so the first frame appears one
+ * period after the start. Duties set with pwmSetDuty() are overwritten.
+ * @param timer PWM_TIM1..PWM_TIM3.
+ * @param first_channel First channel of each frame.
+ * @param channels Values per frame, 1..PWM_CHANNELS - first_channel.
+ * @param table Compare values 0..pwmPeriodTicks(), must stay valid while the burst runs.
+ * @param frames Number of frames, frames * channels <= 65535.
+ * @param circular 1: restart at the first frame forever, 0: stop after the last.
+ * @param done Called at the end of the table, may be NULL.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int pwmBurstStart(pwm_timer_t timer, uint32_t first_channel, uint32_t channels,
+                  const uint16_t *table, uint32_t frames, int circular, pwm_burst_cb_t done);
+
+/**
+ * @brief Stops a burst. The outputs keep the last frame written.
+ */
+void pwmBurstStop(pwm_timer_t timer);
+
+/**
+ * @brief Returns 1 while a burst is running on the timer.
+ */
+int pwmBurstActive(pwm_timer_t timer);
+
+/**
+ * @brief Encodes bytes (GRB order, MSB first) as a single-channel burst
+ * table for WS2812 LEDs on a timer started at PWM_WS2812_FREQ, followed by
+ * the low reset frames that latch the data.
+ * @param data Bytes to send.
+ * @param len Number of bytes.
+ * @param table Destination, PWM_WS2812_FRAMES(len) entries.
+ * @param period_ticks pwmPeriodTicks() of the timer.
+ * @return Number of frames written.
+ */
+uint32_t pwmWs2812Encode(const uint8_t *data, uint32_t len, uint16_t *table, uint32_t period_ticks);
+
+
+#endif /* PWM_H_ */
@@ -0,0 +1,165 @@
+/***************************************************************************
+ * File name     :  timing.h
+ * Description   :  Header-only, compile-time calculator for peripheral timing
+ *                  registers: USART BRR, I2C TIMINGR, timer PSC/ARR and the
+ *                  SysTick reload value. Every macro takes a bus clock from
+ *                  clock.h and a target rate, expands to a constant, and has a
+ *                  matching *_CHECK() that fails the build when the register
+ *                  field overflows or the achievable error is out of tolerance.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stdint.h>
+
+/* --- Generic integer helpers --- */
+#define TIMING_DIV_ROUND(n, d)          (((n) + ((d) / 2U)) / (d))
+#define TIMING_DIV_CEIL(n, d)           (((n) + (d) - 1U) / (d))
+#define TIMING_ABS_DIFF(a, b)           ((a) > (b) ? (a) - (b) : (b) - (a))
+
+/* Error of an achieved rate against its target, in parts per million */
+#define TIMING_ERR_PPM(actual, target)  \
+    ((TIMING_ABS_DIFF((uint64_t)(actual), (uint64_t)(target)) * 1000000ULL) / (uint64_t)(target))
+
+
+/***************************************************************************
+ * USART baud rate (oversampling by 16, BRR = USARTDIV)
+ **************************************************************************/
+#define UART_MAX_ERR_PPM                20000U      // 2 %, well inside the receiver tolerance
+
+#define UART_BRR(clk, baud)             ((uint32_t)TIMING_DIV_ROUND((uint64_t)(clk), (uint64_t)(baud)))
+#define UART_BAUD_ACTUAL(clk, baud)     ((clk) / UART_BRR((clk), (baud)))
+
+/* Bit time error in ppm, clock cycles per bit actually used vs. ideal */
+#define UART_BAUD_ERR_PPM(clk, baud)    \
+    TIMING_ERR_PPM((uint64_t)UART_BRR((clk), (baud)) * (uint64_t)(baud), (clk))
+
+#define UART_BRR_CHECK(clk, baud)                                                           \
+    _Static_assert((UART_BRR((clk), (baud)) >= 16U) && (UART_BRR((clk), (baud)) <= 0xFFFFU), \
+                   "USART BRR out of range for this clock");                                \
+    _Static_assert(UART_BAUD_ERR_PPM((clk), (baud)) <= UART_MAX_ERR_PPM,                  \
+                   "USART baud rate error above tolerance")
+
+
+/***************************************************************************
+ * General purpose timer PSC/ARR for a periodic update event
+ * The smallest prescaler that lets ARR fit in 16 bits is chosen, which gives
+ * the finest period resolution.
+ **************************************************************************/
+#define TIM_MAX_ERR_PPM                 1000U       // 0.1 %
+
+#define TIM_CYCLES(clk, freq)           TIMING_DIV_ROUND((uint64_t)(clk), (uint64_t)(freq))
+#define TIM_PSC(clk, freq)              ((uint32_t)(TIMING_DIV_CEIL(TIM_CYCLES((clk), (freq)), 65536ULL) - 1U))
+#define TIM_ARR(clk, freq)              \
+    ((uint32_t)(TIMING_DIV_ROUND(TIM_CYCLES((clk), (freq)), (uint64_t)TIM_PSC((clk), (freq)) + 1U) - 1U))
+#define TIM_PERIOD_CYCLES(clk, freq)    \
+    (((uint64_t)TIM_PSC((clk), (freq)) + 1U) * ((uint64_t)TIM_ARR((clk), (freq)) + 1U))
+
+/* Period error in ppm, clock cycles per update actually used vs. ideal */
+#define TIM_ERR_PPM(clk, freq)          \
+    TIMING_ERR_PPM(TIM_PERIOD_CYCLES((clk), (freq)) * (uint64_t)(freq), (clk))
+
+#define TIM_CHECK(clk, freq)                                                                \
+    _Static_assert(TIM_PSC((clk), (freq)) <= 0xFFFFU, "Timer rate too low for a 16-bit prescaler"); \
+    _Static_assert(TIM_ARR((clk), (freq)) >= 1U, "Timer rate too high for this clock");     \
+    _Static_assert(TIM_ERR_PPM((clk), (freq)) <= TIM_MAX_ERR_PPM,                          \
+                   "Timer rate error above tolerance")
+
+
+/***************************************************************************
+ * SysTick reload for a periodic tick (24-bit down counter, LOAD..0)
+ **************************************************************************/
+#define SYSTICK_RELOAD(clk, hz)         ((uint32_t)(TIMING_DIV_ROUND((uint64_t)(clk), (uint64_t)(hz)) - 1U))
+
+#define SYSTICK_RELOAD_CHECK(clk, hz)                                                       \
+    _Static_assert((SYSTICK_RELOAD((clk), (hz)) >= 1U) && (SYSTICK_RELOAD((clk), (hz)) <= 0xFFFFFFU), \
+                   "SysTick reload out of 24-bit range")
+
+
+/***************************************************************************
+ * I2C TIMINGR (master mode, analog filter on, digital filter off)
+ *
+ * Each speed mode is a set of targets: the prescaled timing clock and the SCL
+ * low/high, data hold and data setup times. PRESC brings I2CCLK down to about
+ * the timing clock (or as close as the 4-bit field allows for a fast I2CCLK),
+ * then every period is rounded up to whole tPRESC ticks so the bus minimums
+ * are always met. With the standard-mode targets and I2CCLK
+ * at 8/16/48 MHz this reproduces the reference manual tables exactly.
+ *
+ * The achieved SCL period is estimated as (SCLL + SCLH + 2) * tPRESC plus the
+ * SYNC time, which lumps rise/fall times, the analog filter and the clock
+ * synchronization delay together as implied by the reference manual tables.
+ **************************************************************************/
+#define I2C_MAX_ERR_PPM                 100000U     // 10 %, SYNC depends on bus capacitance
+
+/* Standard-mode, 100 kHz */
+#define I2C_STD_SCL_FREQ                100000U
+#define I2C_STD_TPRESC_FREQ             4000000U    // tPRESC = 250 ns
+#define I2C_STD_SCLL_NS                 5000U       // >= 4.7 us
+#define I2C_STD_SCLH_NS                 4000U       // >= 4.0 us
+#define I2C_STD_SDADEL_NS               500U
+#define I2C_STD_SCLDEL_NS               1250U       // >= 250 ns
+#define I2C_STD_SYNC_NS                 1000U
+#define I2C_STD_MIN_CLK                 2000000U
+
+/* Fast-mode, 400 kHz */
+#define I2C_FAST_SCL_FREQ               400000U
+#define I2C_FAST_TPRESC_FREQ            8000000U    // tPRESC = 125 ns
+#define I2C_FAST_SCLL_NS                1250U       // >= 1.3 us including SYNC
+#define I2C_FAST_SCLH_NS                500U        // >= 0.6 us including SYNC
+#define I2C_FAST_SDADEL_NS              250U
+#define I2C_FAST_SCLDEL_NS              500U        // >= 100 ns
+#define I2C_FAST_SYNC_NS                750U
+#define I2C_FAST_MIN_CLK                8000000U
+
+/* Fast-mode Plus, 1 MHz */
+#define I2C_FASTPLUS_SCL_FREQ           1000000U
+#define I2C_FASTPLUS_TPRESC_FREQ        8000000U    // tPRESC = 125 ns
+#define I2C_FASTPLUS_SCLL_NS            500U        // >= 0.5 us
+#define I2C_FASTPLUS_SCLH_NS            250U        // >= 0.26 us
+#define I2C_FASTPLUS_SDADEL_NS          0U
+#define I2C_FASTPLUS_SCLDEL_NS          250U        // >= 50 ns
+#define I2C_FASTPLUS_SYNC_NS            250U
+#define I2C_FASTPLUS_MIN_CLK            17000000U   // tI2CCLK < (tLOW - tfilters) / 4
+
+/* Mode parameter lookup, the extra level lets `mode` itself be a macro */
+#define I2C_MODE_PARAM(mode, param)     I2C_MODE_PARAM_(mode, param)
+#define I2C_MODE_PARAM_(mode, param)    I2C_##mode##_##param
+
+#define I2C_TIMING_PRESC_RAW(clk, mode) (TIMING_DIV_CEIL((uint64_t)(clk), (uint64_t)I2C_MODE_PARAM(mode, TPRESC_FREQ)) - 1U)
+#define I2C_TIMING_PRESC(clk, mode)     ((I2C_TIMING_PRESC_RAW((clk), mode) > 15U) ? 15U : I2C_TIMING_PRESC_RAW((clk), mode))
+#define I2C_TIMING_FPRESC(clk, mode)    ((uint64_t)(clk) / (I2C_TIMING_PRESC((clk), mode) + 1U))
+#define I2C_TIMING_TICKS(ns, fpresc)    TIMING_DIV_CEIL((uint64_t)(ns) * ((fpresc) / 1000U), 1000000ULL)
+
+#define I2C_TIMING_SCLL(clk, mode)      (I2C_TIMING_TICKS(I2C_MODE_PARAM(mode, SCLL_NS), I2C_TIMING_FPRESC((clk), mode)) - 1U)
+#define I2C_TIMING_SCLH(clk, mode)      (I2C_TIMING_TICKS(I2C_MODE_PARAM(mode, SCLH_NS), I2C_TIMING_FPRESC((clk), mode)) - 1U)
+#define I2C_TIMING_SDADEL(clk, mode)    I2C_TIMING_TICKS(I2C_MODE_PARAM(mode, SDADEL_NS), I2C_TIMING_FPRESC((clk), mode))
+#define I2C_TIMING_SCLDEL(clk, mode)    (I2C_TIMING_TICKS(I2C_MODE_PARAM(mode, SCLDEL_NS), I2C_TIMING_FPRESC((clk), mode)) - 1U)
+
+#define I2C_TIMINGR(clk, mode)                                  \
+    ((uint32_t)((I2C_TIMING_PRESC((clk), mode) << 28) |         \
+                (I2C_TIMING_SCLDEL((clk), mode) << 20) |        \
+                (I2C_TIMING_SDADEL((clk), mode) << 16) |        \
+                (I2C_TIMING_SCLH((clk), mode) << 8) |           \
+                (I2C_TIMING_SCLL((clk), mode) << 0)))
+
+/* Estimated SCL frequency, period computed in picoseconds */
+#define I2C_SCL_ACTUAL(clk, mode)                                                       \
+    (1000000000000ULL /                                                                 \
+     (((I2C_TIMING_SCLL((clk), mode) + I2C_TIMING_SCLH((clk), mode) + 2U) *             \
+       (I2C_TIMING_PRESC((clk), mode) + 1U) * 1000000000000ULL) / (uint64_t)(clk) +     \
+      (uint64_t)I2C_MODE_PARAM(mode, SYNC_NS) * 1000U))
+
+#define I2C_TIMING_CHECK(clk, mode)                                                     \
+    _Static_assert((clk) >= I2C_MODE_PARAM(mode, MIN_CLK), "I2CCLK too slow for this I2C mode"); \
+    _Static_assert((I2C_TIMING_SCLL((clk), mode) <= 255U) && (I2C_TIMING_SCLH((clk), mode) <= 255U), \
+                   "I2C SCLL/SCLH out of range");                                       \
+    _Static_assert((I2C_TIMING_SDADEL((clk), mode) <= 15U) && (I2C_TIMING_SCLDEL((clk), mode) <= 15U), \
+                   "I2C SDADEL/SCLDEL out of range");                                   \
+    _Static_assert(TIMING_ERR_PPM(I2C_SCL_ACTUAL((clk), mode), I2C_MODE_PARAM(mode, SCL_FREQ)) <= I2C_MAX_ERR_PPM, \
+                   "I2C SCL frequency error above tolerance")
+
+#endif /* TIMING_H_ */
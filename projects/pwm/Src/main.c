@@ -0,0 +1,118 @@
+/***************************************************************************
+ * File name     :      main.c
+ * Description   :      Main application file for an STM32F3 microcontroller.
+ *                      This program initializes UART3 for serial communication
+ *                      and drives PWM on three timers: the LED on PA5 (TIM2
+ *                      CH1) breathes from a circular DMA table with no CPU
+ *                      work, TIM1 CH1/CH1N run a 20 kHz complementary pair
+ *                      with dead time, and TIM3 CH1..CH4 hold four fixed
+ *                      duties at 1 kHz. Each breath is reported over UART3.
+ *
+ * Author        :      Jere Piirainen
+ * Date          :      2026-10-16
+ **************************************************************************/
+#include <stddef.h>
+#include "stm32f3xx.h"
+#include "pwm.h"
+#include "uart.h"
+
+/* --- LED breathing on TIM2 CH1, one table entry per PWM period --- */
+#define LED_CHANNEL         0U          // TIM2 CH1 = PA5
+#define LED_PWM_FREQ        200U        // 5 ms per step
+#define BREATH_STEPS        256U        // 1.28 s per breath
+#define BREATH_HALF         (BREATH_STEPS / 2U)
+
+/* --- Half bridge on TIM1 CH1 (PA8) / CH1N (PA7) --- */
+#define BRIDGE_CHANNEL      0U
+#define BRIDGE_FREQ         20000U
+#define BRIDGE_DUTY         2500U       // 25.00 %
+#define BRIDGE_DEADTIME_NS  500U
+
+#define TIM3_PWM_FREQ       1000U
+
+static uint16_t breath[BREATH_STEPS];
+static volatile uint32_t breaths;
+
+#ifdef PWM_WS2812_DEMO
+/* Three WS2812 LEDs on TIM3 CH1 (PC6), colours in GRB order */
+#define WS2812_LEDS         3U
+static const uint8_t leds[WS2812_LEDS * 3U] = {
+	0x00, 0x20, 0x00,       // Red
+	0x20, 0x00, 0x00,       // Green
+	0x00, 0x00, 0x20,       // Blue
+};
+static uint16_t ws2812_table[PWM_WS2812_FRAMES(sizeof(leds))];
+#endif
+
+static void breath_table_init(uint32_t period);
+static void on_breath(pwm_timer_t timer);
+
+int main(void)
+{
+	/* Initialize USART3 for transmit and receive functionality */
+	uart3_tx_rx_init();
+
+	/* LED: the DMA rewrites the duty every period, squared for an even fade */
+	(void)pwmInit(PWM_TIM2, LED_PWM_FREQ);
+	(void)pwmChannelEnable(PWM_TIM2, LED_CHANNEL, 0);
+	breath_table_init(pwmPeriodTicks(PWM_TIM2));
+	(void)pwmBurstStart(PWM_TIM2, LED_CHANNEL, 1U, breath, BREATH_STEPS, 1, on_breath);
+
+	/* Complementary pair, both edges of CH1N held off by the dead time */
+	(void)pwmInit(PWM_TIM1, BRIDGE_FREQ);
+	(void)pwmChannelEnable(PWM_TIM1, BRIDGE_CHANNEL, BRIDGE_DUTY);
+	if (pwmComplementaryEnable(BRIDGE_CHANNEL, BRIDGE_DEADTIME_NS) != 0) {
+		uart3_puts("Dead time out of range\r\n");
+	}
+
+#ifdef PWM_WS2812_DEMO
+	/* One frame per bit at 800 kHz, sent once and latched by the trailing low */
+	(void)pwmInit(PWM_TIM3, PWM_WS2812_FREQ);
+	(void)pwmChannelEnable(PWM_TIM3, 0, 0);
+	uint32_t frames = pwmWs2812Encode(leds, sizeof(leds), ws2812_table, pwmPeriodTicks(PWM_TIM3));
+	(void)pwmBurstStart(PWM_TIM3, 0, 1U, ws2812_table, frames, 0, NULL);
+#else
+	(void)pwmInit(PWM_TIM3, TIM3_PWM_FREQ);
+	(void)pwmChannelEnable(PWM_TIM3, 0, 1000U);    // 10 %
+	(void)pwmChannelEnable(PWM_TIM3, 1, 2500U);    // 25 %
+	(void)pwmChannelEnable(PWM_TIM3, 2, 5000U);    // 50 %
+	(void)pwmChannelEnable(PWM_TIM3, 3, 7500U);    // 75 %
+#endif
+
+	uart3_puts("PWM running\r\n");
+
+	while(1) {
+		uint32_t seen = breaths;
+
+		/* Nothing to do until the DMA wraps the breath table */
+		while (breaths == seen) {
+			__WFI();
+		}
+
+		uart3_puts("Breaths: ");
+		uart3_put_int((int)breaths);
+		uart3_puts("\r\n");
+	}
+}
+
+/**
+ * @brief Fills the breath table with a rising then falling ramp, squared
+ * so that the brightness looks linear.
+ */
+static void breath_table_init(uint32_t period)
+{
+	for (uint32_t i = 0; i < BREATH_STEPS; i++) {
+		uint32_t level = (i < BREATH_HALF) ? i : (BREATH_STEPS - 1U - i);
+
+		breath[i] = (uint16_t)((period * level * level) / (BREATH_HALF * BREATH_HALF));
+	}
+}
+
+/**
+ * @brief Runs in the DMA1 Channel 2 interrupt each time the table wraps.
+ */
+static void on_breath(pwm_timer_t timer)
+{
+	(void)timer;
+	breaths++;
+}
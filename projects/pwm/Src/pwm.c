@@ -0,0 +1,531 @@
+/***************************************************************************
+ * File name     :  pwm.c
+ * Description   :  This file provides functions to generate PWM on TIM1,
+ *                  TIM2 and TIM3 of an STM32F3 microcontroller. Every
+ *                  channel runs PWM mode 1 with preloaded compare and
+ *                  auto-reload registers, so frequency and duty changes
+ *                  take effect on a period boundary. Burst mode lets the
+ *                  update event request DMA1 writes to TIMx_DMAR, which the
+ *                  timer scatters over consecutive CCR registers.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stddef.h>
+#include "pwm.h"
+#include "clock.h"
+#include "timing.h"
+#include "stm32f3xx.h"
+
+/* --- RCC clock enable bits --- */
+#define TIM1EN          (1U << 11)  // RCC_APB2ENR
+#define TIM2EN          (1U << 0)   // RCC_APB1ENR
+#define TIM3EN          (1U << 1)   // RCC_APB1ENR
+#define DMA1EN          (1U << 0)   // RCC_AHBENR
+#define GPIOAEN         (1U << 17)  // RCC_AHBENR
+#define GPIOBEN         (1U << 18)
+#define GPIOCEN         (1U << 19)
+
+/* --- Timer register bits --- */
+#define CR1_CEN         (1U << 0)   // Counter enable
+#define CR1_UDIS        (1U << 1)   // Update disable, preloaded registers are not transferred
+#define CR1_ARPE        (1U << 7)   // ARR preload
+#define EGR_UG          (1U << 0)   // Update generation, loads PSC/ARR/CCR
+#define DIER_UDE        (1U << 8)   // DMA request on update
+#define CCMR_CCS_MASK   (3U << 0)   // CCxS, 00 = output
+#define CCMR_OCPE       (1U << 3)   // Compare preload
+#define CCMR_OCM_MASK   ((7U << 4) | (1U << 16))    // OCxM[3:0], bit 3 lives apart
+#define CCMR_OCM_PWM1   (6U << 4)   // High while CNT < CCR
+#define CCMR_CH_BITS    8U          // Second channel of a CCMR register
+#define CCER_CCE        (1U << 0)   // Output enable, CC2..CC4 every 4 bits
+#define CCER_CCNE       (1U << 2)   // Complementary output enable
+#define CCER_CH_BITS    4U
+#define BDTR_DTG_MASK   (0xFFU << 0)
+#define BDTR_MOE        (1U << 15)  // Main output enable, TIM1 outputs are off without it
+#define DCR_DBA_CCR1    13U         // CCR1 offset from CR1, in words
+#define DCR_DBL_POS     8U          // Burst length - 1
+
+/* --- DMA1 channel bits (CMSIS names avoided) --- */
+#define DMA1_CCR_EN     (1U << 0)
+#define DMA1_CCR_TCIE   (1U << 1)
+#define DMA1_CCR_TEIE   (1U << 3)
+#define DMA1_DIR        (1U << 4)   // Memory to peripheral
+#define DMA1_CIRC       (1U << 5)
+#define DMA1_MINC       (1U << 7)
+#define DMA1_PSIZE32    (2U << 8)   // DMAR is a word, the table half words are zero-extended
+#define DMA1_MSIZE16    (1U << 10)
+#define DMA1_PL_HIGH    (2U << 12)
+#define DMA1_FLAG_GIF   (1U << 0)   // ISR/IFCR, shifted by 4 per channel
+#define DMA1_FLAG_TCIF  (1U << 1)
+#define DMA1_FLAG_TEIF  (1U << 3)
+#define DMA1_CNDTR_MAX  0xFFFFU
+
+/* --- GPIO --- */
+#define MODER_AF        2U
+#define MODER_MASK      3U
+#define AFR_MASK        0xFU
+
+/* --- Dead-time generator steps, in timer clock ticks (CKD = 00) --- */
+#define DTG_MAX_LIN     127U        // DTG[7] = 0: DT = DTG[6:0]
+#define DTG_MAX_X2      254U        // DTG[7:6] = 10: DT = (64 + DTG[5:0]) x 2
+#define DTG_MAX_X8      504U        // DTG[7:5] = 110: DT = (32 + DTG[4:0]) x 8
+#define DTG_MAX_X16     1008U       // DTG[7:5] = 111: DT = (32 + DTG[4:0]) x 16
+
+#define PWM_TIM_APB2_FREQ   CLOCK_PCLK2_FREQ    // APB2 undivided, TIM1 runs at PCLK2
+#define PWM_MIN_PERIOD      2U                  // Ticks, one high and one low
+
+_Static_assert((PWM_DEADTIME_MAX_NS * (uint64_t)PWM_TIM_APB2_FREQ) / 1000000000U <= DTG_MAX_X16,
+               "Dead-time limit does not fit the TIM1 dead-time generator");
+
+/**
+ * @brief Fixed resources of one timer.
+ */
+typedef struct {
+    TIM_TypeDef *tim;
+    volatile uint32_t *enr;         // RCC enable register
+    uint32_t en_bit;
+    uint32_t clk;                   // Counter clock before the prescaler
+    DMA_Channel_TypeDef *dma;       // Update request channel on DMA1
+    IRQn_Type dma_irq;
+    uint8_t dma_shift;              // Flag position in DMA1 ISR/IFCR
+} pwm_hw_t;
+
+/**
+ * @brief Alternate function pin of an output.
+ */
+typedef struct {
+    GPIO_TypeDef *port;
+    uint32_t port_en;               // RCC_AHBENR bit
+    uint8_t pin;
+    uint8_t af;
+} pwm_pin_t;
+
+/**
+ * @brief Run-time state of one timer.
+ */
+typedef struct {
+    uint32_t period;                // ARR + 1, 0 before pwmInit()
+    uint16_t duty[PWM_CHANNELS];    // Kept to rescale the CCRs on a frequency change
+    pwm_burst_cb_t burst_done;
+    uint8_t burst_circular;
+    volatile uint8_t burst_active;
+} pwm_state_t;
+
+static const pwm_hw_t pwm_hw[PWM_TIMER_COUNT] = {
+    { TIM1, &RCC->APB2ENR, TIM1EN, PWM_TIM_APB2_FREQ,   DMA1_Channel5, DMA1_Channel5_IRQn, 16U },
+    { TIM2, &RCC->APB1ENR, TIM2EN, CLOCK_TIM_APB1_FREQ, DMA1_Channel2, DMA1_Channel2_IRQn, 4U },
+    { TIM3, &RCC->APB1ENR, TIM3EN, CLOCK_TIM_APB1_FREQ, DMA1_Channel3, DMA1_Channel3_IRQn, 8U },
+};
+
+static const pwm_pin_t pwm_pins[PWM_TIMER_COUNT][PWM_CHANNELS] = {
+    { { GPIOA, GPIOAEN, 8U, 6U },  { GPIOA, GPIOAEN, 9U, 6U },
+      { GPIOA, GPIOAEN, 10U, 6U }, { GPIOA, GPIOAEN, 11U, 11U } },
+    { { GPIOA, GPIOAEN, 5U, 1U },  { GPIOA, GPIOAEN, 1U, 1U },
+      { GPIOA, GPIOAEN, 2U, 1U },  { GPIOA, GPIOAEN, 3U, 1U } },
+    { { GPIOC, GPIOCEN, 6U, 2U },  { GPIOC, GPIOCEN, 7U, 2U },
+      { GPIOC, GPIOCEN, 8U, 2U },  { GPIOC, GPIOCEN, 9U, 2U } },
+};
+
+static const pwm_pin_t pwm_npins[PWM_COMPLEMENTARY] = {
+    { GPIOA, GPIOAEN, 7U, 6U }, { GPIOB, GPIOBEN, 0U, 6U }, { GPIOB, GPIOBEN, 1U, 6U },
+};
+
+static pwm_state_t pwm_state[PWM_TIMER_COUNT];
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static int pwm_timebase(uint32_t clk, uint32_t freq_hz, uint32_t *psc, uint32_t *arr);
+static uint32_t pwm_duty_to_ccr(uint32_t period, uint32_t duty);
+static void pwm_pin_init(const pwm_pin_t *p);
+static int pwm_dtg(uint32_t ticks, uint32_t *dtg);
+static void pwm_burst_halt(pwm_timer_t timer);
+static void pwm_dma_irq(pwm_timer_t timer);
+
+
+int pwmInit(pwm_timer_t timer, uint32_t freq_hz)
+{
+	const pwm_hw_t *hw;
+	pwm_state_t *st;
+	uint32_t psc;
+	uint32_t arr;
+
+	if ((timer >= PWM_TIMER_COUNT) || (pwm_timebase(pwm_hw[timer].clk, freq_hz, &psc, &arr) != 0)) {
+		return -1;
+	}
+	hw = &pwm_hw[timer];
+	st = &pwm_state[timer];
+
+	*hw->enr |= hw->en_bit;
+	if (st->burst_active) {
+		pwm_burst_halt(timer);
+	}
+
+	hw->tim->CR1 = 0;
+	hw->tim->DIER = 0;
+	hw->tim->DCR = 0;
+	hw->tim->CCER = 0;
+	hw->tim->CCMR1 = 0;
+	hw->tim->CCMR2 = 0;
+	hw->tim->CCR1 = 0;
+	hw->tim->CCR2 = 0;
+	hw->tim->CCR3 = 0;
+	hw->tim->CCR4 = 0;
+
+	hw->tim->PSC = psc;
+	hw->tim->ARR = arr;
+	hw->tim->CNT = 0;
+
+	/* Load PSC and ARR now instead of at the first overflow */
+	hw->tim->EGR = EGR_UG;
+	hw->tim->SR = 0;
+
+	st->period = arr + 1U;
+	for (uint32_t ch = 0; ch < PWM_CHANNELS; ch++) {
+		st->duty[ch] = 0;
+	}
+
+	/* TIM1 gates all its outputs with MOE, dead time stays 0 until asked for */
+	if (timer == PWM_TIM1) {
+		TIM1->BDTR = BDTR_MOE;
+	}
+
+	hw->tim->CR1 = CR1_ARPE | CR1_CEN;
+	return 0;
+}
+
+
+int pwmSetFrequency(pwm_timer_t timer, uint32_t freq_hz)
+{
+	TIM_TypeDef *tim;
+	pwm_state_t *st;
+	uint32_t psc;
+	uint32_t arr;
+	uint32_t primask;
+
+	if ((timer >= PWM_TIMER_COUNT) || (pwm_state[timer].period == 0U) || pwm_state[timer].burst_active ||
+	    (pwm_timebase(pwm_hw[timer].clk, freq_hz, &psc, &arr) != 0)) {
+		return -1;
+	}
+	tim = pwm_hw[timer].tim;
+	st = &pwm_state[timer];
+
+	/*
+	 * PSC, ARR and CCRs are all preloaded. UDIS holds back the update event
+	 * while they are written, so one falling in between cannot load half of
+	 * them; the next update after it is cleared loads them together.
+	 */
+	primask = __get_PRIMASK();
+	__disable_irq();
+	tim->CR1 |= CR1_UDIS;
+	tim->PSC = psc;
+	tim->ARR = arr;
+	st->period = arr + 1U;
+	for (uint32_t ch = 0; ch < PWM_CHANNELS; ch++) {
+		(&tim->CCR1)[ch] = pwm_duty_to_ccr(st->period, st->duty[ch]);
+	}
+	tim->CR1 &= ~CR1_UDIS;
+	__set_PRIMASK(primask);
+
+	return 0;
+}
+
+
+uint32_t pwmPeriodTicks(pwm_timer_t timer)
+{
+	return (timer < PWM_TIMER_COUNT) ? pwm_state[timer].period : 0U;
+}
+
+
+int pwmChannelEnable(pwm_timer_t timer, uint32_t channel, uint32_t duty)
+{
+	TIM_TypeDef *tim;
+	volatile uint32_t *ccmr;
+	uint32_t shift;
+
+	if ((timer >= PWM_TIMER_COUNT) || (channel >= PWM_CHANNELS) || (pwm_state[timer].period == 0U) ||
+	    (duty > PWM_DUTY_SCALE)) {
+		return -1;
+	}
+	tim = pwm_hw[timer].tim;
+
+	(void)pwmSetDuty(timer, channel, duty);
+
+	/* CH1/CH2 in CCMR1, CH3/CH4 in CCMR2 */
+	ccmr = (channel < 2U) ? &tim->CCMR1 : &tim->CCMR2;
+	shift = (channel & 1U) * CCMR_CH_BITS;
+	*ccmr = (*ccmr & ~((CCMR_OCM_MASK | CCMR_OCPE | CCMR_CCS_MASK) << shift)) |
+	        ((CCMR_OCM_PWM1 | CCMR_OCPE) << shift);
+
+	pwm_pin_init(&pwm_pins[timer][channel]);
+	tim->CCER |= CCER_CCE << (channel * CCER_CH_BITS);
+
+	return 0;
+}
+
+
+int pwmSetDuty(pwm_timer_t timer, uint32_t channel, uint32_t duty)
+{
+	pwm_state_t *st;
+
+	if ((timer >= PWM_TIMER_COUNT) || (channel >= PWM_CHANNELS) || (duty > PWM_DUTY_SCALE)) {
+		return -1;
+	}
+	st = &pwm_state[timer];
+
+	st->duty[channel] = (uint16_t)duty;
+	(&pwm_hw[timer].tim->CCR1)[channel] = pwm_duty_to_ccr(st->period, duty);
+	return 0;
+}
+
+
+void pwmChannelDisable(pwm_timer_t timer, uint32_t channel)
+{
+	if ((timer >= PWM_TIMER_COUNT) || (channel >= PWM_CHANNELS)) {
+		return;
+	}
+
+	pwm_hw[timer].tim->CCER &= ~((CCER_CCE | CCER_CCNE) << (channel * CCER_CH_BITS));
+}
+
+
+int pwmComplementaryEnable(uint32_t channel, uint32_t deadtime_ns)
+{
+	uint32_t ticks;
+	uint32_t dtg;
+
+	if ((channel >= PWM_COMPLEMENTARY) || (deadtime_ns > PWM_DEADTIME_MAX_NS) ||
+	    (pwm_state[PWM_TIM1].period == 0U)) {
+		return -1;
+	}
+
+	/* Rounded up, a dead time shorter than asked could let a bridge shoot through */
+	ticks = (uint32_t)(((uint64_t)deadtime_ns * PWM_TIM_APB2_FREQ + 999999999U) / 1000000000U);
+	if (pwm_dtg(ticks, &dtg) != 0) {
+		return -1;
+	}
+
+	/* DTG is writable while BDTR.LOCK is 0, which pwmInit() leaves it at */
+	TIM1->BDTR = (TIM1->BDTR & ~BDTR_DTG_MASK) | dtg;
+
+	pwm_pin_init(&pwm_npins[channel]);
+	TIM1->CCER |= CCER_CCNE << (channel * CCER_CH_BITS);
+
+	return 0;
+}
+
+
+int pwmBurstStart(pwm_timer_t timer, uint32_t first_channel, uint32_t channels,
+                  const uint16_t *table, uint32_t frames, int circular, pwm_burst_cb_t done)
+{
+	const pwm_hw_t *hw;
+	pwm_state_t *st;
+
+	if ((timer >= PWM_TIMER_COUNT) || (pwm_state[timer].period == 0U) || (table == NULL) ||
+	    (first_channel >= PWM_CHANNELS) || (channels == 0U) || (channels > PWM_CHANNELS - first_channel) ||
+	    (frames == 0U) || (frames > DMA1_CNDTR_MAX / channels)) {
+		return -1;
+	}
+	hw = &pwm_hw[timer];
+	st = &pwm_state[timer];
+
+	if (st->burst_active) {
+		pwm_burst_halt(timer);
+	}
+
+	RCC->AHBENR |= DMA1EN;
+
+	DMA1->IFCR = DMA1_FLAG_GIF << hw->dma_shift;
+	hw->dma->CPAR = (uint32_t)&hw->tim->DMAR;
+	hw->dma->CMAR = (uint32_t)table;
+	hw->dma->CNDTR = frames * channels;
+	hw->dma->CCR = DMA1_DIR | DMA1_MINC | DMA1_PSIZE32 | DMA1_MSIZE16 | DMA1_PL_HIGH |
+	               DMA1_CCR_TCIE | DMA1_CCR_TEIE | (circular ? DMA1_CIRC : 0U);
+
+	st->burst_done = done;
+	st->burst_circular = circular ? 1U : 0U;
+	st->burst_active = 1;
+
+	/* Each update request becomes `channels` DMAR writes, to CCRx onwards */
+	hw->tim->DCR = ((channels - 1U) << DCR_DBL_POS) | (DCR_DBA_CCR1 + first_channel);
+
+	NVIC_SetPriority(hw->dma_irq, PWM_DMA_IRQ_PRIORITY);
+	NVIC_EnableIRQ(hw->dma_irq);
+	hw->dma->CCR |= DMA1_CCR_EN;
+	hw->tim->DIER |= DIER_UDE;
+
+	return 0;
+}
+
+
+void pwmBurstStop(pwm_timer_t timer)
+{
+	uint32_t primask;
+
+	if (timer >= PWM_TIMER_COUNT) {
+		return;
+	}
+
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if (pwm_state[timer].burst_active) {
+		pwm_burst_halt(timer);
+	}
+	__set_PRIMASK(primask);
+}
+
+
+int pwmBurstActive(pwm_timer_t timer)
+{
+	return (timer < PWM_TIMER_COUNT) ? pwm_state[timer].burst_active : 0;
+}
+
+
+uint32_t pwmWs2812Encode(const uint8_t *data, uint32_t len, uint16_t *table, uint32_t period_ticks)
+{
+	/* T0H 0.40 us and T1H 0.80 us of the 1.25 us bit */
+	const uint16_t zero = (uint16_t)((period_ticks * 8U) / 25U);
+	const uint16_t one = (uint16_t)((period_ticks * 16U) / 25U);
+	uint32_t n = 0;
+
+	for (uint32_t i = 0; i < len; i++) {
+		for (uint32_t bit = 0x80U; bit != 0U; bit >>= 1) {
+			table[n++] = (data[i] & bit) ? one : zero;
+		}
+	}
+
+	for (uint32_t i = 0; i < PWM_WS2812_RESET_FRAMES; i++) {
+		table[n++] = 0;
+	}
+
+	return n;
+}
+
+
+/**
+ * @brief Prescaler and auto-reload for a PWM frequency.
+ * @return 0 when the period fits, -1 otherwise.
+ */
+static int pwm_timebase(uint32_t clk, uint32_t freq_hz, uint32_t *psc, uint32_t *arr)
+{
+	if ((freq_hz == 0U) || (freq_hz > clk / PWM_MIN_PERIOD) || (TIM_PSC(clk, freq_hz) > 0xFFFFU)) {
+		return -1;
+	}
+
+	*psc = TIM_PSC(clk, freq_hz);
+	*arr = TIM_ARR(clk, freq_hz);
+	return 0;
+}
+
+
+/**
+ * @brief Compare value for a duty cycle; PWM_DUTY_SCALE gives ARR + 1,
+ * which PWM mode 1 holds high for the whole period.
+ */
+static uint32_t pwm_duty_to_ccr(uint32_t period, uint32_t duty)
+{
+	return (uint32_t)(((uint64_t)period * duty) / PWM_DUTY_SCALE);
+}
+
+
+/**
+ * @brief Enables the port clock and hands the pin to its alternate function.
+ */
+static void pwm_pin_init(const pwm_pin_t *p)
+{
+	uint32_t afr_shift = (p->pin & 7U) * 4U;
+
+	RCC->AHBENR |= p->port_en;
+	p->port->AFR[p->pin >> 3] = (p->port->AFR[p->pin >> 3] & ~(AFR_MASK << afr_shift)) |
+	                            ((uint32_t)p->af << afr_shift);
+	p->port->MODER = (p->port->MODER & ~(MODER_MASK << (p->pin * 2U))) | (MODER_AF << (p->pin * 2U));
+}
+
+
+/**
+ * @brief Encodes a dead time in timer ticks into BDTR.DTG, rounding up to
+ * the step of the range it falls in.
+ * @return 0 on success, -1 when the dead time is out of range.
+ */
+static int pwm_dtg(uint32_t ticks, uint32_t *dtg)
+{
+	if (ticks <= DTG_MAX_LIN) {
+		*dtg = ticks;
+	} else if (ticks <= DTG_MAX_X2) {
+		*dtg = 0x80U | (((ticks + 1U) / 2U) - 64U);
+	} else if (ticks <= DTG_MAX_X8) {
+		*dtg = 0xC0U | (((ticks + 7U) / 8U) - 32U);
+	} else if (ticks <= DTG_MAX_X16) {
+		*dtg = 0xE0U | (((ticks + 15U) / 16U) - 32U);
+	} else {
+		return -1;
+	}
+	return 0;
+}
+
+
+/**
+ * @brief Stops the update DMA request and the channel serving it.
+ */
+static void pwm_burst_halt(pwm_timer_t timer)
+{
+	const pwm_hw_t *hw = &pwm_hw[timer];
+
+	hw->tim->DIER &= ~DIER_UDE;
+	hw->tim->DCR = 0;
+	hw->dma->CCR &= ~DMA1_CCR_EN;
+	DMA1->IFCR = DMA1_FLAG_GIF << hw->dma_shift;
+	pwm_state[timer].burst_active = 0;
+}
+
+
+/**
+ * @brief Common DMA1 interrupt body. A one-shot burst is over once its
+ * last frame is written; that frame still plays for the next period.
+ */
+static void pwm_dma_irq(pwm_timer_t timer)
+{
+	const pwm_hw_t *hw = &pwm_hw[timer];
+	pwm_state_t *st = &pwm_state[timer];
+	uint32_t flags = DMA1->ISR >> hw->dma_shift;
+
+	DMA1->IFCR = DMA1_FLAG_GIF << hw->dma_shift;
+
+	if (flags & DMA1_FLAG_TEIF) {
+		pwm_burst_halt(timer);
+	} else if (flags & DMA1_FLAG_TCIF) {
+		if (!st->burst_circular) {
+			pwm_burst_halt(timer);
+		}
+	} else {
+		return;
+	}
+
+	if (st->burst_done != NULL) {
+		st->burst_done(timer);
+	}
+}
+
+
+/**
+ * @brief DMA1 Channel 5 Interrupt Service Routine (ISR), TIM1 update bursts.
+ */
+void DMA1_CH5_IRQHandler(void)
+{
+	pwm_dma_irq(PWM_TIM1);
+}
+
+/**
+ * @brief DMA1 Channel 2 Interrupt Service Routine (ISR), TIM2 update bursts.
+ */
+void DMA1_CH2_IRQHandler(void)
+{
+	pwm_dma_irq(PWM_TIM2);
+}
+
+/**
+ * @brief DMA1 Channel 3 Interrupt Service Routine (ISR), TIM3 update bursts.
+ */
+void DMA1_CH3_IRQHandler(void)
+{
+	pwm_dma_irq(PWM_TIM3);
+}
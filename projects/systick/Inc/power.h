@@ -0,0 +1,73 @@
+/***************************************************************************
+ * File name     :  power.h
+ * Description   :  Header file for tickless idle. Declares the idle entry
+ *                  used by the scheduler: sleep until the next deadline
+ *                  with SysTick stretched (Sleep mode), or with the core
+ *                  clocks off and the RTC wakeup timer counting on LSI
+ *                  (Stop mode) for longer gaps, then correct the time base.
+ *                  Residency per power state is kept so the energy spent
+ *                  per unit of work can be worked out from the datasheet
+ *                  supply currents.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+
+/* --- Idle policy --- */
+#define POWER_STOP_MIN_MS       20U     // Shorter gaps use Sleep, Stop costs a PLL restart
+#define POWER_WAKE_MARGIN_MS    2U      // Leave Stop this early: regulator, HSI and PLL start-up
+#define POWER_CALIB_MS          250U    // LSI measured against HCLK for this long at init
+#define POWER_IRQ_PRIORITY      0U      // RTC wakeup, only clears its flags
+
+#define POWER_NO_DEADLINE       UINT64_MAX
+
+/**
+ * @brief Power states tracked for residency.
+ */
+typedef enum {
+    POWER_RUN = 0,
+    POWER_SLEEP,        // WFI, clocks running, SysTick times the wake-up
+    POWER_STOP,         // WFI + SLEEPDEEP, 1.8 V domain clocks off, RTC wakeup timer
+    POWER_STATE_COUNT,
+} power_state_t;
+
+/**
+ * @brief Time spent in each state since powerInit().
+ */
+typedef struct {
+    uint64_t residency_us[POWER_STATE_COUNT];
+    uint32_t entries[POWER_STATE_COUNT];    // Run counts wake-ups
+    uint32_t lsi_hz;                        // Calibrated LSI, 0 when Stop is not used
+} power_stats_t;
+
+
+/**
+ * @brief Sets up tickless idle. With Stop allowed, starts LSI, clocks the
+ * RTC from it (resetting the backup domain if it ran from another source)
+ * and calibrates LSI against the SysTick time base, blocking for
+ * POWER_CALIB_MS. Requires systickInit().
+ * @param allow_stop Non-zero to use Stop mode. A debugger loses the core in Stop.
+ * @return 0 on success, -1 if LSI did not start (Sleep only then).
+ */
+int powerInit(int allow_stop);
+
+/**
+ * @brief Sleeps until the deadline or the first interrupt, whichever comes
+ * first, in the deepest state that fits, and corrects the time base.
+ * Call with interrupts masked (PRIMASK) after checking there is no work:
+ * the wake-up interrupt is taken once the caller unmasks.
+ * @param deadline_ms Absolute now_ms() time of the next timer, or POWER_NO_DEADLINE.
+ */
+void powerIdle(uint64_t deadline_ms);
+
+/**
+ * @brief Returns the residency counters, run time included up to now.
+ * @param stats Destination.
+ */
+void powerGetStats(power_stats_t *stats);
+
+#endif /* POWER_H_ */
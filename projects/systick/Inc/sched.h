@@ -0,0 +1,134 @@
+/***************************************************************************
+ * File name     :  sched.h
+ * Description   :  Header file for the cooperative run-to-completion task
+ *                  scheduler. Tasks are released by a hierarchical timer
+ *                  wheel on the SysTick millisecond time base, or by event
+ *                  flags posted from interrupts, and run one at a time from
+ *                  schedRun(). While nothing is ready the core sleeps
+ *                  tickless until the next timer (see power.h).
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+
+/* --- Timer wheel geometry: 1 ms slots, then 256 ms, then 16.4 s --- */
+#define SCHED_L0_BITS       8U
+#define SCHED_L1_BITS       6U
+#define SCHED_L2_BITS       6U
+#define SCHED_SPAN_MS       (1UL << (SCHED_L0_BITS + SCHED_L1_BITS + SCHED_L2_BITS))  // ~17 min, longer timers re-cascade
+
+#define SCHED_NO_EXPIRY     UINT64_MAX  // No timer armed
+
+/* --- Event flags --- */
+#define SCHED_EVT_TIMER     (1UL << 31) // Set by the wheel, bits 30:0 are free for schedPost()
+
+typedef struct sched_task sched_task_t;
+
+/**
+ * @brief Task body. Runs to completion, never blocks.
+ * @param task The task being run, task->arg carries user data.
+ * @param events Flags collected since the last run, SCHED_EVT_TIMER for a timer release.
+ */
+typedef void (*sched_fn_t)(sched_task_t *task, uint32_t events);
+
+/**
+ * @brief Per-task counters.
+ */
+typedef struct {
+    uint32_t runs;
+    uint32_t wcet_cycles;       // Longest run, DWT->CYCCNT
+    uint32_t deadline_misses;   // Runs that finished late, or releases lost to an overrun
+} sched_stats_t;
+
+/**
+ * @brief Task control block, allocated by the caller (usually static).
+ * Fields below the first group belong to the scheduler.
+ */
+struct sched_task {
+    sched_fn_t fn;
+    void *arg;
+    const char *name;
+    uint32_t deadline_ms;       // Release to completion, 0 = the period (none for one-shot)
+
+    uint32_t period_ms;         // 0 = one-shot
+    uint64_t expires;           // Next timer release, ms
+    uint64_t release;           // Release time of the pending run, ms
+    sched_task_t *next;         // Wheel slot list
+    sched_task_t **pprev;       // Link pointing at this task, NULL when not in the wheel
+    sched_task_t *ready_next;   // Ready queue
+    volatile uint32_t events;   // Pending event flags, non-zero while queued
+    uint8_t queued;
+    sched_stats_t stats;
+};
+
+
+/**
+ * @brief Resets the wheel and ready queue and starts the cycle counter.
+ * Requires the SysTick time base (systickInit()).
+ */
+void schedInit(void);
+
+/**
+ * @brief Prepares a task control block.
+ * @param task Task to initialize.
+ * @param fn Task body.
+ * @param arg User data, available as task->arg.
+ * @param name Name for reports.
+ */
+void schedTaskInit(sched_task_t *task, sched_fn_t fn, void *arg, const char *name);
+
+/**
+ * @brief Arms the task's timer, replacing any earlier one. O(1).
+ * @param task Task to release.
+ * @param delay_ms First release after this many ms, 0 = at the next tick.
+ * @param period_ms Period of later releases, 0 for a one-shot.
+ */
+void schedStart(sched_task_t *task, uint32_t delay_ms, uint32_t period_ms);
+
+/**
+ * @brief Disarms the task's timer and drops a pending run. O(1).
+ * Task context only.
+ * @param task Task to cancel.
+ */
+void schedCancel(sched_task_t *task);
+
+/**
+ * @brief Posts event flags and makes the task ready. Safe from interrupts.
+ * Flags posted before the task runs are merged into one run.
+ * @param task Task to wake.
+ * @param flags Event bits, SCHED_EVT_TIMER excluded.
+ */
+void schedPost(sched_task_t *task, uint32_t flags);
+
+/**
+ * @brief Runs at most one ready task.
+ * @return 1 if a task ran, 0 if nothing was ready.
+ */
+int schedRunOnce(void);
+
+/**
+ * @brief Earliest time the wheel needs to run again. Exact for timers
+ * already in level 0; otherwise it is the cascade of the first occupied
+ * higher-level slot, early but never late. Task context only.
+ * @return Absolute now_ms() time, or SCHED_NO_EXPIRY.
+ */
+uint64_t schedNextExpiry(void);
+
+/**
+ * @brief Scheduler loop: runs ready tasks and, when none is ready, idles
+ * through powerIdle() until the next expiry or interrupt. Never returns.
+ */
+void schedRun(void);
+
+/**
+ * @brief Returns a task's counters.
+ * @param task Task.
+ * @param stats Destination.
+ */
+void schedGetStats(const sched_task_t *task, sched_stats_t *stats);
+
+#endif /* SCHED_H_ */
@@ -1,8 +1,11 @@
 /***************************************************************************
  * File name     :  systick.h
  * Description   :  Header file for SysTick timer functions.
- *                  Defines constants for SysTick configuration and declares
- *                  the millisecond delay function.
+ *                  SysTick runs free with a 1 ms interrupt that drives a
+ *                  64-bit millisecond counter. Declares the monotonic
+ *                  ms/us time base, the non-blocking deadline helpers,
+ *                  the millisecond delay built on them and the hooks that
+ *                  let idle code stop the tick and correct the time after.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-16
@@ -10,22 +13,83 @@
 #ifndef SYSTICK_H_
 #define SYSTICK_H_
 
+#include <stdint.h>
+
 /* --- SysTick configuration defines --- */
-#define SYSTICK_LOAD_VAL		8000        // For 8MHz system clock, 8000 cycles equals 1 ms
+#define SYSTICK_TICK_HZ			1000U       // One SysTick period per millisecond
+#define SYSTICK_IRQ_PRIORITY	0U          // Highest, the handler is a single increment
 
 /* --- SysTick control and status register bit defines --- */
 #define CSR_ENABLE				(1U << 0)   // Enable SysTick timer
+#define CSR_TICKINT				(1U << 1)   // Exception request when the counter reaches 0
 #define CSR_CLKSRC				(1U << 2)   // Select AHB clock as SysTick clock source
 #define CSR_COUNTFLAG			(1U << 16)  // Read-only flag: set when counter goes from 1 to 0
 
 
 /**
- * @brief Provides a blocking delay in milliseconds using the SysTick timer.
- * This function is CPU-blocking; no other tasks can run during the delay.
+ * @brief Starts SysTick as the free-running 1 ms time base.
+ * Call once at start-up; time counts from zero at this call.
+ */
+void systickInit(void);
+
+/**
+ * @brief Milliseconds since systickInit(). Never wraps in practice.
+ */
+uint64_t now_ms(void);
+
+/**
+ * @brief Microseconds since systickInit(): the millisecond count plus the
+ * part of the current period already counted down in SysTick->VAL.
+ * Consistent across the reload even when the tick interrupt is still
+ * pending, so it is safe from interrupt context and with interrupts masked
+ * for less than a millisecond.
+ */
+uint64_t now_us(void);
+
+/**
+ * @brief Microseconds elapsed since an earlier now_us() reading.
+ * @param since_us Start time.
+ */
+uint64_t elapsed_us(uint64_t since_us);
+
+/**
+ * @brief Non-blocking timeout check.
+ * @param deadline_us Absolute time, e.g. now_us() + timeout.
+ * @return 1 once now_us() has reached the deadline, 0 before.
+ */
+int deadline_expired(uint64_t deadline_us);
+
+/**
+ * @brief Tickless sleep: stretches the SysTick period so the next interrupt
+ * comes after `ticks` milliseconds, waits in WFI, then puts the counter back
+ * in phase and adds the ticks that passed. Another interrupt ends it early.
+ * Call with interrupts masked (PRIMASK). A few cycles are lost per call.
+ * @param ticks Milliseconds to sleep, clamped to what the 24-bit counter holds (233 at 72 MHz).
+ * @return HCLK cycles slept, 0 if a tick was already pending and nothing was done.
+ */
+uint32_t systickIdle(uint32_t ticks);
+
+/**
+ * @brief Stops the counter for a sleep SysTick cannot time itself (Stop mode).
+ * Call with interrupts masked, follow with systickResume().
+ * @return 0 when paused, -1 if a tick is pending (the counter keeps running).
+ */
+int systickPause(void);
+
+/**
+ * @brief Restarts the counter after systickPause(), advanced by the time
+ * measured elsewhere: whole ticks are added to the count and the rest sets
+ * the phase of the current tick.
+ * @param elapsed_cycles Time since the pause, in HCLK cycles.
+ */
+void systickResume(uint64_t elapsed_cycles);
+
+/**
+ * @brief Waits for the given number of milliseconds.
+ * The core sleeps (WFI) between ticks and interrupts keep running; the
+ * time base is left untouched.
  * @param delay The desired delay duration in milliseconds.
- * @note This implementation reconfigures SysTick for each call and polls the COUNTFLAG.
- * It assumes the core clock is consistent with SYSTICK_LOAD_VAL.
  */
 void systickDelayMs(int delay);
 
-#endif /* SYSTICK_H_ */
\ No newline at end of file
+#endif /* SYSTICK_H_ */
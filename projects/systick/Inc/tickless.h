@@ -0,0 +1,99 @@
+/***************************************************************************
+ * File name     :  tickless.h
+ * Description   :  Arithmetic of the tickless time base, kept free of
+ *                  register access so it can be checked off target: the
+ *                  length of a stretched SysTick period, the cycles it
+ *                  counted from the stopped counter, how those cycles
+ *                  split into whole ticks and the phase of the next one,
+ *                  and the distance between two RTC subsecond readings
+ *                  across midnight. systick.c and power.c do the register
+ *                  side around these.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef TICKLESS_H_
+#define TICKLESS_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Length of one stretched period ending on the tick boundary `ticks`
+ * ms ahead. A length under 2 would mean LOAD = 0, which stops the counter:
+ * the tick due now is slept through instead and counted on resume.
+ * @param paused_val Counter value when it was paused, cycles left in the tick.
+ * @param ticks Milliseconds to sleep, at least 1.
+ * @param period Cycles per tick (LOAD + 1).
+ * @return Cycles to program, LOAD = len - 1.
+ */
+static inline uint32_t tickless_idle_len(uint32_t paused_val, uint32_t ticks, uint32_t period)
+{
+	uint32_t len = paused_val + ((ticks - 1U) * period);
+
+	if (len < 2U) {
+		len += period;
+	}
+	return len;
+}
+
+/**
+ * @brief Cycles counted by a stretched period, read after stopping the counter.
+ * With COUNTFLAG set the long period ended and the counter went on from the
+ * normal reload value; the extra cycle is the one spent on the reload.
+ * @param len Length from tickless_idle_len().
+ * @param val Counter value once stopped.
+ * @param countflag Non-zero if COUNTFLAG was set.
+ * @param load Normal reload value.
+ */
+static inline uint32_t tickless_idle_elapsed(uint32_t len, uint32_t val, uint32_t countflag, uint32_t load)
+{
+	if (countflag) {
+		return len + 1U + (load - val);
+	}
+	return len - val;
+}
+
+/**
+ * @brief Splits the time since a pause into whole ticks and the cycles left
+ * to the next boundary. A remainder under 2 is folded into one more tick,
+ * as LOAD = 0 would stop the counter: at most one cycle is gained.
+ * @param elapsed_cycles Time since the pause, in cycles.
+ * @param paused_val Counter value when it was paused.
+ * @param period Cycles per tick.
+ * @param rem Out: cycles to the next boundary, 2..period.
+ * @return Ticks completed.
+ */
+static inline uint64_t tickless_resume_split(uint64_t elapsed_cycles, uint32_t paused_val, uint32_t period,
+                                             uint32_t *rem)
+{
+	uint64_t passed = 0;
+
+	if (elapsed_cycles < paused_val) {
+		*rem = paused_val - (uint32_t)elapsed_cycles;
+	} else {
+		uint64_t past = elapsed_cycles - paused_val;
+
+		passed = 1U + (past / period);
+		*rem = period - (uint32_t)(past % period);
+	}
+
+	if (*rem < 2U) {
+		passed++;
+		*rem = period;
+	}
+	return passed;
+}
+
+/**
+ * @brief Subsecond ticks from r0 to r1 on a counter that wraps at midnight.
+ * Readings are below day_ticks, and 2 * day_ticks must fit in 32 bits.
+ * @param r1 Later reading.
+ * @param r0 Earlier reading.
+ * @param day_ticks Counter value at which it wraps to 0.
+ */
+static inline uint32_t tickless_rtc_delta(uint32_t r1, uint32_t r0, uint32_t day_ticks)
+{
+	return (r1 - r0 + day_ticks) % day_ticks;
+}
+
+#endif /* TICKLESS_H_ */
@@ -2,21 +2,50 @@
  * File name     :      main.c
  * Description   :      Main application file for an STM32F3 microcontroller.
  *                      This program initializes UART3 for serial communication and
- *                      configures GPIOA pin 5 (PA5) to control an LED. It then
- *                      continuously transmits a message over UART and toggles the LED
- *                      every 2 seconds using a SysTick-based delay.
+ *                      configures GPIOA pin 5 (PA5) to control an LED. Work is
+ *                      split into scheduler tasks on the SysTick time base:
+ *                      a message and LED toggle every 2 seconds, the user
+ *                      button on PC13 woken by its EXTI interrupt, and a
+ *                      periodic report of the task statistics and the time
+ *                      spent per power state. Between tasks the core sleeps
+ *                      tickless, in Stop mode for the longer gaps.
  *
  * Author        :      Jere Piirainen
  * Date          :      2025-06-16
  **************************************************************************/
+#include <stddef.h>
 #include "stm32f3xx.h"
 #include "systick.h"
+#include "sched.h"
+#include "power.h"
 #include "uart.h"
 
 /* --- GPIOA defines --- */
 #define GPIOAEN     (1U << 17)  // Clock enable bit for GPIOA in RCC_AHBENR
 #define LED_PIN     (1U << 5)   // PA5
 
+/* --- User button: PC13 on EXTI13, falling edge on press --- */
+#define GPIOCEN             (1U << 19)      // Clock enable bit for GPIOC in RCC_AHBENR
+#define SYSCFGEN            (1U << 0)       // Clock enable bit for SYSCFG in RCC_APB2ENR
+#define MODER_PC13_MASK     (3U << 26)      // PC13 mode, 00 = input
+#define EXTICR4_EXTI13_MASK (0xFU << 4)     // EXTI13 source
+#define EXTICR4_EXTI13_PC   (0x2U << 4)     // 2 = port C
+#define EXTI_LINE13         (1U << 13)
+#define BTN_IRQ_PRIORITY    3U
+#define EVT_BUTTON          (1U << 0)
+
+#define TOGGLE_PERIOD_MS    2000U   // 2 seconds
+#define REPORT_PERIOD_MS    10000U
+
+static sched_task_t led_task;
+static sched_task_t button_task;
+static sched_task_t report_task;
+
+static void led_run(sched_task_t *task, uint32_t events);
+static void button_run(sched_task_t *task, uint32_t events);
+static void report_run(sched_task_t *task, uint32_t events);
+static void button_init(void);
+
 int main(void)
 {
     /* Enable clock access to GPIOA */
@@ -27,20 +56,114 @@ int main(void)
     GPIOA->MODER |= (1U << 10);
     GPIOA->MODER &= ~(1U << 11);
 
-    const char *string = "2 seconds has passed...\r\n"; // Message to be transmitted
-
     /* Initialize USART3 for transmit and receive functionality */
     uart3_tx_rx_init();
 
-    /* Main loop */
-    while (1) {
-        /* Transmit message over UART3 */
-        uart3_puts(string);
+    /* Start the free-running 1 ms time base, then the scheduler on top of it */
+    systickInit();
+    schedInit();
+    if (powerInit(1) != 0) {
+        uart3_puts("LSI not running, idling in Sleep only\r\n");
+    }
+
+    schedTaskInit(&led_task, led_run, "2 seconds has passed...\r\n", "led");
+    schedTaskInit(&button_task, button_run, NULL, "button");
+    schedTaskInit(&report_task, report_run, NULL, "report");
+
+    schedStart(&led_task, 0, TOGGLE_PERIOD_MS);
+    schedStart(&report_task, REPORT_PERIOD_MS, REPORT_PERIOD_MS);
+    button_init();
+
+    /* Never returns, sleeps between tasks */
+    schedRun();
+}
+
+/**
+ * @brief Transmits the message passed as the task argument and toggles the LED.
+ */
+static void led_run(sched_task_t *task, uint32_t events)
+{
+    (void)events;
+    uart3_puts((const char *)task->arg);
+    GPIOA->ODR ^= LED_PIN;
+}
+
+/**
+ * @brief Runs once per button press, posted from EXTI15_10_IRQHandler.
+ */
+static void button_run(sched_task_t *task, uint32_t events)
+{
+    (void)task;
+    if (events & EVT_BUTTON) {
+        uart3_puts("Button pressed at ");
+        uart3_put_int((int)now_ms());
+        uart3_puts(" ms\r\n");
+    }
+}
+
+/**
+ * @brief Prints run count, worst-case execution time and deadline misses
+ * per task, then the residency of each power state in ms.
+ */
+static void report_run(sched_task_t *task, uint32_t events)
+{
+    sched_task_t *const tasks[] = { &led_task, &button_task, &report_task };
+    static const char *const state_names[POWER_STATE_COUNT] = { "run", "sleep", "stop" };
+    sched_stats_t stats;
+    power_stats_t power;
+
+    (void)task;
+    (void)events;
 
-        /* Toggle LED */
-        GPIOA->ODR ^= LED_PIN;
+    for (uint32_t i = 0; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+        schedGetStats(tasks[i], &stats);
+        uart3_puts(tasks[i]->name);
+        uart3_puts(": runs ");
+        uart3_put_int((int)stats.runs);
+        uart3_puts(", wcet ");
+        uart3_put_int((int)stats.wcet_cycles);
+        uart3_puts(" cycles, misses ");
+        uart3_put_int((int)stats.deadline_misses);
+        uart3_puts("\r\n");
+    }
 
-        /* Introduce a 2000 ms (2 second) delay using SysTick timer */
-        systickDelayMs(2000);
+    powerGetStats(&power);
+    for (uint32_t i = 0; i < POWER_STATE_COUNT; i++) {
+        uart3_puts(state_names[i]);
+        uart3_puts(": ");
+        uart3_put_int((int)(power.residency_us[i] / 1000U));
+        uart3_puts(" ms, ");
+        uart3_put_int((int)power.entries[i]);
+        uart3_puts(" entries\r\n");
+    }
+}
+
+/**
+ * @brief PC13 input with EXTI13 on the falling edge (the button pulls low).
+ */
+static void button_init(void)
+{
+    RCC->AHBENR |= GPIOCEN;
+    RCC->APB2ENR |= SYSCFGEN;
+    GPIOC->MODER &= ~MODER_PC13_MASK;
+
+    SYSCFG->EXTICR[3] = (SYSCFG->EXTICR[3] & ~EXTICR4_EXTI13_MASK) | EXTICR4_EXTI13_PC;
+    EXTI->FTSR |= EXTI_LINE13;
+    EXTI->PR = EXTI_LINE13;
+    EXTI->IMR |= EXTI_LINE13;
+
+    NVIC_SetPriority(EXTI15_10_IRQn, BTN_IRQ_PRIORITY);
+    NVIC_EnableIRQ(EXTI15_10_IRQn);
+}
+
+/**
+ * @brief EXTI lines 10..15 Interrupt Service Routine (ISR), user button.
+ * Only wakes the button task, the work happens in task context.
+ */
+void EXTI15_10_IRQHandler(void)
+{
+    if (EXTI->PR & EXTI_LINE13) {
+        EXTI->PR = EXTI_LINE13;
+        schedPost(&button_task, EVT_BUTTON);
     }
 }
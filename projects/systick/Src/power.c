@@ -0,0 +1,346 @@
+/***************************************************************************
+ * File name     :  power.c
+ * Description   :  Tickless idle. A gap up to the next deadline is slept
+ *                  either in Sleep mode, with the SysTick period stretched
+ *                  to end on the deadline, or in Stop mode, with SysTick
+ *                  paused and the RTC wakeup timer on LSI ending it. After
+ *                  Stop the PLL is restarted and the time slept, read from
+ *                  the RTC subsecond counter and scaled by the calibrated
+ *                  LSI rate, is handed back to the SysTick time base.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "stm32f3xx.h"
+#include "power.h"
+#include "systick.h"
+#include "clock.h"
+#include "tickless.h"
+
+/* --- RCC --- */
+#define PWREN               (1U << 28)      // PWR clock enable bit in RCC_APB1ENR
+#define CR_PLLRDY           (1U << 25)      // PLL locked, lost in Stop
+#define RCCCSR_LSION        (1U << 0)
+#define RCCCSR_LSIRDY       (1U << 1)
+#define BDCR_RTCSEL_MASK    (3U << 8)
+#define BDCR_RTCSEL_LSI     (2U << 8)
+#define BDCR_RTCEN          (1U << 15)
+#define BDCR_BDRST          (1U << 16)
+#define LSI_TIMEOUT         100000U
+
+/* --- PWR --- */
+#define PWRCR_LPDS          (1U << 0)       // Regulator in low-power mode during Stop
+#define PWRCR_PDDS          (1U << 1)       // 0 = Stop, 1 = Standby
+#define PWRCR_DBP           (1U << 8)       // Backup domain (RTC) write access
+
+/* --- RTC --- */
+#define RTC_KEY1            0xCAU           // Write protection unlock sequence
+#define RTC_KEY2            0x53U
+#define RTC_LOCK            0xFFU
+#define RTCISR_WUTWF        (1U << 2)       // WUTR writable
+#define RTCISR_INITF        (1U << 6)
+#define RTCISR_INIT         (1U << 7)
+#define RTCISR_WUTF         (1U << 10)      // Wakeup timer flag, cleared by writing 0
+#define RTCCR_WUCKSEL_MASK  (7U << 0)
+#define RTCCR_WUCKSEL_DIV16 (0U << 0)       // Wakeup counter clock RTCCLK / 16
+#define RTCCR_BYPSHAD       (1U << 5)       // Read the counters directly, also right after Stop
+#define RTCCR_WUTE          (1U << 10)
+#define RTCCR_WUTIE         (1U << 14)
+#define RTC_PREDIV_A        1U              // Subsecond counter at LSI / 2, ~50 us steps
+#define RTC_PREDIV_S        19999U          // ~1 Hz calendar from a 40 kHz LSI
+#define RTC_SUBSEC_PER_S    (RTC_PREDIV_S + 1U)
+#define RTC_DAY_TICKS       (86400U * RTC_SUBSEC_PER_S)
+#define RTC_WUT_DIV         16U
+#define RTC_WUT_MAX         0x10000U
+#define POWER_STOP_MAX_MS   20000U          // Below the wakeup timer range (26 s at 40 kHz LSI)
+
+/* --- EXTI line 20: RTC wakeup --- */
+#define EXTI_LINE20         (1U << 20)
+
+/* --- Console: a frame still shifting out would be cut by Stop --- */
+#define USART3_TC           (1U << 6)
+
+#define CYCLES_PER_US       (CLOCK_HCLK_FREQ / 1000000U)
+
+_Static_assert((2ULL * RTC_DAY_TICKS) <= 0xFFFFFFFFULL, "RTC day wrap does not fit tickless_rtc_delta()");
+
+static int stop_allowed;
+static uint32_t rtc_tick_hz;                    // Subsecond counter rate, calibrated
+static uint64_t start_us;
+static power_stats_t power_stats;
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static int rtc_init(void);
+static uint32_t rtc_ticks(void);
+static void rtc_wakeup_arm(uint32_t count);
+static void rtc_wakeup_disarm(void);
+static int power_stop(uint64_t ticks);
+
+
+int powerInit(int allow_stop)
+{
+	uint32_t r0;
+	uint64_t t0;
+	uint64_t t1;
+
+	for (uint32_t i = 0; i < POWER_STATE_COUNT; i++) {
+		power_stats.residency_us[i] = 0;
+		power_stats.entries[i] = 0;
+	}
+	power_stats.lsi_hz = 0;
+	stop_allowed = 0;
+	start_us = now_us();
+
+	if (!allow_stop) {
+		return 0;
+	}
+
+	if (rtc_init() != 0) {
+		return -1;
+	}
+
+	/* Count subsecond ticks over a known stretch of SysTick time */
+	r0 = rtc_ticks();
+	t0 = now_us();
+	while (!deadline_expired(t0 + (POWER_CALIB_MS * 1000U))) {}
+	t1 = now_us();
+	rtc_tick_hz = (uint32_t)(((uint64_t)tickless_rtc_delta(rtc_ticks(), r0, RTC_DAY_TICKS) * 1000000U) / (t1 - t0));
+	power_stats.lsi_hz = rtc_tick_hz * (RTC_PREDIV_A + 1U);
+
+	/* Wakeup timer reaches the core through EXTI line 20 */
+	EXTI->RTSR |= EXTI_LINE20;
+	EXTI->PR = EXTI_LINE20;
+	EXTI->IMR |= EXTI_LINE20;
+	NVIC_SetPriority(RTC_WKUP_IRQn, POWER_IRQ_PRIORITY);
+	NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+	stop_allowed = 1;
+	start_us = now_us();
+
+	return 0;
+}
+
+
+void powerIdle(uint64_t deadline_ms)
+{
+	uint64_t now = now_ms();
+	uint64_t ticks = (deadline_ms > now) ? (deadline_ms - now) : 0U;
+	uint32_t cycles;
+
+	power_stats.entries[POWER_RUN]++;
+
+	if (stop_allowed && (ticks >= POWER_STOP_MIN_MS) && (USART3->ISR & USART3_TC)) {
+		if (power_stop(ticks) == 0) {
+			return;
+		}
+	}
+
+	/* Tick already due, or a one tick gap: plain WFI, SysTick wakes us */
+	if (ticks < 2U) {
+		uint64_t t0 = now_us();
+
+		__DSB();
+		__WFI();
+		power_stats.residency_us[POWER_SLEEP] += now_us() - t0;
+		power_stats.entries[POWER_SLEEP]++;
+		return;
+	}
+
+	cycles = systickIdle((ticks > UINT32_MAX) ? UINT32_MAX : (uint32_t)ticks);
+	if (cycles != 0U) {
+		power_stats.residency_us[POWER_SLEEP] += cycles / CYCLES_PER_US;
+		power_stats.entries[POWER_SLEEP]++;
+	}
+}
+
+
+void powerGetStats(power_stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint64_t total;
+
+	__disable_irq();
+	*stats = power_stats;
+	total = now_us() - start_us;
+	__set_PRIMASK(primask);
+
+	stats->residency_us[POWER_RUN] = total - stats->residency_us[POWER_SLEEP] - stats->residency_us[POWER_STOP];
+}
+
+
+/**
+ * @brief RTC wakeup Interrupt Service Routine (ISR).
+ * The wake-up itself is the point; powerIdle() has already accounted for
+ * it by the time this runs, only the flags are left.
+ */
+void RTC_WKUP_IRQHandler(void)
+{
+	rtc_wakeup_disarm();
+}
+
+
+/**
+ * @brief Sleeps in Stop mode until the RTC wakeup timer, set a margin short
+ * of the deadline, or an EXTI event ends it.
+ * @param ticks Milliseconds to the deadline.
+ * @return 0 when handled (slept, or a tick was pending), -1 if the gap is too short for the wakeup timer.
+ */
+static int power_stop(uint64_t ticks)
+{
+	uint64_t count;
+	uint32_t r0;
+	uint32_t slept;
+	uint64_t slept_us;
+
+	/* Longer gaps are slept in several pieces */
+	if (ticks > POWER_STOP_MAX_MS) {
+		ticks = POWER_STOP_MAX_MS;
+	}
+	count = ((ticks - POWER_WAKE_MARGIN_MS) * rtc_tick_hz * (RTC_PREDIV_A + 1U)) / (RTC_WUT_DIV * 1000U);
+	if (count < 2U) {
+		return -1;
+	}
+	if (count > RTC_WUT_MAX) {
+		count = RTC_WUT_MAX;
+	}
+
+	if (systickPause() != 0) {
+		return 0;
+	}
+
+	/* Time from the pause on is measured by the RTC, arming included */
+	r0 = rtc_ticks();
+	rtc_wakeup_arm((uint32_t)count - 1U);
+
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	PWR->CR = (PWR->CR & ~PWRCR_PDDS) | PWRCR_LPDS;
+	__DSB();
+	__WFI();
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+
+	/* Stop leaves the core on HSI: bring the PLL back before anything times itself */
+	if (!(RCC->CR & CR_PLLRDY)) {
+		SystemInit();
+	}
+
+	slept = tickless_rtc_delta(rtc_ticks(), r0, RTC_DAY_TICKS);
+	rtc_wakeup_disarm();
+	NVIC_ClearPendingIRQ(RTC_WKUP_IRQn);
+
+	slept_us = ((uint64_t)slept * 1000000U) / rtc_tick_hz;
+	systickResume(slept_us * CYCLES_PER_US);
+
+	power_stats.residency_us[POWER_STOP] += slept_us;
+	power_stats.entries[POWER_STOP]++;
+
+	return 0;
+}
+
+
+/**
+ * @brief Starts LSI and runs the RTC from it with the subsecond counter
+ * exposed through BYPSHAD.
+ * @return 0 on success, -1 if LSI does not become ready.
+ */
+static int rtc_init(void)
+{
+	uint32_t timeout;
+
+	RCC->APB1ENR |= PWREN;
+	PWR->CR |= PWRCR_DBP;
+
+	RCC->CSR |= RCCCSR_LSION;
+	for (timeout = LSI_TIMEOUT; timeout > 0U; timeout--) {
+		if (RCC->CSR & RCCCSR_LSIRDY) {
+			break;
+		}
+	}
+	if (!(RCC->CSR & RCCCSR_LSIRDY)) {
+		return -1;
+	}
+
+	/* RTCSEL can only be changed through a backup domain reset */
+	if ((RCC->BDCR & (BDCR_RTCSEL_MASK | BDCR_RTCEN)) != (BDCR_RTCSEL_LSI | BDCR_RTCEN)) {
+		RCC->BDCR |= BDCR_BDRST;
+		RCC->BDCR &= ~BDCR_BDRST;
+		RCC->BDCR |= BDCR_RTCSEL_LSI | BDCR_RTCEN;
+	}
+
+	RTC->WPR = RTC_KEY1;
+	RTC->WPR = RTC_KEY2;
+
+	/* Prescalers are only writable in init mode, two separate writes */
+	RTC->ISR |= RTCISR_INIT;
+	while (!(RTC->ISR & RTCISR_INITF)) {}
+	RTC->PRER = RTC_PREDIV_S;
+	RTC->PRER |= RTC_PREDIV_A << 16;
+	RTC->CR = (RTC->CR & ~(RTCCR_WUTE | RTCCR_WUTIE)) | RTCCR_BYPSHAD;
+	RTC->ISR &= ~RTCISR_INIT;
+
+	RTC->WPR = RTC_LOCK;
+
+	return 0;
+}
+
+
+/**
+ * @brief Reads the calendar time and subseconds as one counter.
+ * With BYPSHAD the registers are read live, so they are read until two
+ * passes agree.
+ * @return Subsecond ticks since midnight, wraps at RTC_DAY_TICKS.
+ */
+static uint32_t rtc_ticks(void)
+{
+	uint32_t ssr;
+	uint32_t tr;
+	uint32_t secs;
+
+	do {
+		ssr = RTC->SSR;
+		tr = RTC->TR;
+	} while ((ssr != RTC->SSR) || (tr != RTC->TR));
+
+	/* BCD hh:mm:ss */
+	secs = ((((tr >> 20) & 0x3U) * 10U) + ((tr >> 16) & 0xFU)) * 3600U +
+	       ((((tr >> 12) & 0x7U) * 10U) + ((tr >> 8) & 0xFU)) * 60U +
+	       (((tr >> 4) & 0x7U) * 10U) + (tr & 0xFU);
+
+	return (secs * RTC_SUBSEC_PER_S) + (RTC_PREDIV_S - (ssr & 0xFFFFU));
+}
+
+
+/**
+ * @brief Loads the wakeup timer and starts it with its interrupt.
+ * @param reload WUTR value, the timer fires after reload + 1 counts.
+ */
+static void rtc_wakeup_arm(uint32_t reload)
+{
+	RTC->WPR = RTC_KEY1;
+	RTC->WPR = RTC_KEY2;
+
+	RTC->CR &= ~(RTCCR_WUTE | RTCCR_WUTIE);
+	while (!(RTC->ISR & RTCISR_WUTWF)) {}
+	RTC->WUTR = reload;
+	RTC->CR = (RTC->CR & ~RTCCR_WUCKSEL_MASK) | RTCCR_WUCKSEL_DIV16 | RTCCR_WUTIE | RTCCR_WUTE;
+	RTC->ISR = ~(RTCISR_WUTF | RTCISR_INIT);
+
+	RTC->WPR = RTC_LOCK;
+	EXTI->PR = EXTI_LINE20;
+}
+
+
+/**
+ * @brief Stops the wakeup timer and clears its RTC and EXTI flags.
+ */
+static void rtc_wakeup_disarm(void)
+{
+	RTC->WPR = RTC_KEY1;
+	RTC->WPR = RTC_KEY2;
+
+	RTC->CR &= ~(RTCCR_WUTE | RTCCR_WUTIE);
+	RTC->ISR = ~(RTCISR_WUTF | RTCISR_INIT);
+
+	RTC->WPR = RTC_LOCK;
+	EXTI->PR = EXTI_LINE20;
+}
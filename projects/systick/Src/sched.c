@@ -0,0 +1,371 @@
+/***************************************************************************
+ * File name     :  sched.c
+ * Description   :  Cooperative task scheduler. Armed timers sit in a
+ *                  three-level hashed timer wheel: the slot is picked from
+ *                  the expiry time, so arming and cancelling are O(1), and
+ *                  each millisecond the wheel visits one level-0 slot and,
+ *                  every 256 ms, cascades a slot of the next level down.
+ *                  Expired and event-posted tasks go through a FIFO ready
+ *                  queue, the only structure shared with interrupts.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stddef.h>
+#include "stm32f3xx.h"
+#include "sched.h"
+#include "systick.h"
+#include "power.h"
+
+#define L0_SLOTS        (1U << SCHED_L0_BITS)
+#define L1_SLOTS        (1U << SCHED_L1_BITS)
+#define L2_SLOTS        (1U << SCHED_L2_BITS)
+#define L1_SHIFT        SCHED_L0_BITS
+#define L2_SHIFT        (SCHED_L0_BITS + SCHED_L1_BITS)
+#define L1_SPAN_MS      (1UL << L2_SHIFT)
+
+/* --- Timer wheel, main context only --- */
+static sched_task_t *wheel0[L0_SLOTS];
+static sched_task_t *wheel1[L1_SLOTS];
+static sched_task_t *wheel2[L2_SLOTS];
+static uint64_t wheel_time;                     // Next millisecond to process
+
+/* --- Ready queue, shared with schedPost() callers --- */
+static sched_task_t *ready_head;
+static sched_task_t *ready_tail;
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void wheel_insert(sched_task_t *task);
+static void wheel_remove(sched_task_t *task);
+static void wheel_cascade(sched_task_t **slot);
+static void wheel_advance(uint64_t now);
+static void ready_push(sched_task_t *task, uint32_t flags, uint64_t release);
+
+
+void schedInit(void)
+{
+	for (uint32_t i = 0; i < L0_SLOTS; i++) {
+		wheel0[i] = NULL;
+	}
+	for (uint32_t i = 0; i < L1_SLOTS; i++) {
+		wheel1[i] = NULL;
+	}
+	for (uint32_t i = 0; i < L2_SLOTS; i++) {
+		wheel2[i] = NULL;
+	}
+	ready_head = ready_tail = NULL;
+	wheel_time = now_ms();
+
+	/* Execution times are measured in core cycles */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+
+void schedTaskInit(sched_task_t *task, sched_fn_t fn, void *arg, const char *name)
+{
+	task->fn = fn;
+	task->arg = arg;
+	task->name = name;
+	task->deadline_ms = 0;
+	task->period_ms = 0;
+	task->expires = 0;
+	task->release = 0;
+	task->next = NULL;
+	task->pprev = NULL;
+	task->ready_next = NULL;
+	task->events = 0;
+	task->queued = 0;
+	task->stats.runs = 0;
+	task->stats.wcet_cycles = 0;
+	task->stats.deadline_misses = 0;
+}
+
+
+void schedStart(sched_task_t *task, uint32_t delay_ms, uint32_t period_ms)
+{
+	wheel_remove(task);
+	task->period_ms = period_ms;
+	task->expires = now_ms() + delay_ms;
+	wheel_insert(task);
+}
+
+
+void schedCancel(sched_task_t *task)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	wheel_remove(task);
+	task->period_ms = 0;
+
+	/* A queued task with no events is skipped when it reaches the head */
+	__disable_irq();
+	task->events = 0;
+	__set_PRIMASK(primask);
+}
+
+
+void schedPost(sched_task_t *task, uint32_t flags)
+{
+	ready_push(task, flags & ~SCHED_EVT_TIMER, now_ms());
+}
+
+
+int schedRunOnce(void)
+{
+	uint32_t primask;
+	sched_task_t *task;
+	uint32_t events;
+	uint32_t start;
+	uint32_t cycles;
+	uint32_t limit;
+
+	wheel_advance(now_ms());
+
+	/* Pop the head together with its events, cancelled entries are dropped */
+	do {
+		primask = __get_PRIMASK();
+		__disable_irq();
+		task = ready_head;
+		if (task != NULL) {
+			ready_head = task->ready_next;
+			if (ready_head == NULL) {
+				ready_tail = NULL;
+			}
+			task->queued = 0;
+			events = task->events;
+			task->events = 0;
+		}
+		__set_PRIMASK(primask);
+
+		if (task == NULL) {
+			return 0;
+		}
+	} while (events == 0U);
+
+	start = DWT->CYCCNT;
+	task->fn(task, events);
+	cycles = DWT->CYCCNT - start;
+
+	task->stats.runs++;
+	if (cycles > task->stats.wcet_cycles) {
+		task->stats.wcet_cycles = cycles;
+	}
+
+	/* Late if it finished after release + deadline (or period) */
+	limit = (task->deadline_ms != 0U) ? task->deadline_ms : task->period_ms;
+	if ((limit != 0U) && ((now_ms() - task->release) > limit)) {
+		task->stats.deadline_misses++;
+	}
+
+	return 1;
+}
+
+
+void schedRun(void)
+{
+	while (1) {
+		if (schedRunOnce()) {
+			continue;
+		}
+
+		/*
+		 * Sleep with interrupts masked so a wake-up between the check and
+		 * WFI is not lost: a pending interrupt still ends WFI, and is taken
+		 * once PRIMASK is cleared. No tick wakes the core in between.
+		 */
+		__disable_irq();
+		if ((ready_head == NULL) && (wheel_time > now_ms())) {
+			powerIdle(schedNextExpiry());
+		}
+		__enable_irq();
+	}
+}
+
+
+uint64_t schedNextExpiry(void)
+{
+	uint64_t next = SCHED_NO_EXPIRY;
+	uint64_t t;
+
+	/* Level 0 slots hold exact expiry times for the next 256 ms */
+	for (uint32_t i = 0; i < L0_SLOTS; i++) {
+		if (wheel0[(wheel_time + i) & (L0_SLOTS - 1U)] != NULL) {
+			next = wheel_time + i;
+			break;
+		}
+	}
+
+	/* Higher levels: the first boundary (not yet processed) whose slot is occupied */
+	t = (wheel_time + L0_SLOTS - 1U) & ~(uint64_t)(L0_SLOTS - 1U);
+	for (uint32_t i = 0; (i < L1_SLOTS) && (t < next); i++, t += L0_SLOTS) {
+		if (wheel1[(t >> L1_SHIFT) & (L1_SLOTS - 1U)] != NULL) {
+			next = t;
+		}
+	}
+
+	t = (wheel_time + L1_SPAN_MS - 1U) & ~(uint64_t)(L1_SPAN_MS - 1U);
+	for (uint32_t i = 0; (i < L2_SLOTS) && (t < next); i++, t += L1_SPAN_MS) {
+		if (wheel2[(t >> L2_SHIFT) & (L2_SLOTS - 1U)] != NULL) {
+			next = t;
+		}
+	}
+
+	return next;
+}
+
+
+void schedGetStats(const sched_task_t *task, sched_stats_t *stats)
+{
+	*stats = task->stats;
+}
+
+
+/**
+ * @brief Links an armed task into the wheel slot for its expiry time.
+ * Level 0 holds the next 256 ms, level 1 the next 16.4 s in 256 ms slots
+ * and level 2 the rest of SCHED_SPAN_MS. A slot is visited exactly when
+ * its time range begins, so a task cascades down as its expiry nears.
+ * Expiries already due go straight to the ready queue.
+ */
+static void wheel_insert(sched_task_t *task)
+{
+	uint64_t expires = task->expires;
+	sched_task_t **slot;
+
+	if (expires < wheel_time) {
+		ready_push(task, SCHED_EVT_TIMER, expires);
+		return;
+	}
+
+	/* Too far out for the top level: park at its end, re-cascaded from there */
+	if ((expires - wheel_time) >= SCHED_SPAN_MS) {
+		expires = wheel_time + SCHED_SPAN_MS - 1U;
+	}
+
+	if ((expires - wheel_time) < L0_SLOTS) {
+		slot = &wheel0[expires & (L0_SLOTS - 1U)];
+	} else if ((expires - wheel_time) < L1_SPAN_MS) {
+		slot = &wheel1[(expires >> L1_SHIFT) & (L1_SLOTS - 1U)];
+	} else {
+		slot = &wheel2[(expires >> L2_SHIFT) & (L2_SLOTS - 1U)];
+	}
+
+	task->next = *slot;
+	if (task->next != NULL) {
+		task->next->pprev = &task->next;
+	}
+	task->pprev = slot;
+	*slot = task;
+}
+
+
+/**
+ * @brief Unlinks a task from its wheel slot, if it is in one.
+ */
+static void wheel_remove(sched_task_t *task)
+{
+	if (task->pprev == NULL) {
+		return;
+	}
+
+	*task->pprev = task->next;
+	if (task->next != NULL) {
+		task->next->pprev = task->pprev;
+	}
+	task->next = NULL;
+	task->pprev = NULL;
+}
+
+
+/**
+ * @brief Empties a higher-level slot and re-inserts every task relative to
+ * the current wheel time, which moves it down one or more levels.
+ */
+static void wheel_cascade(sched_task_t **slot)
+{
+	sched_task_t *task = *slot;
+
+	*slot = NULL;
+	while (task != NULL) {
+		sched_task_t *next = task->next;
+
+		task->pprev = NULL;
+		wheel_insert(task);
+		task = next;
+	}
+}
+
+
+/**
+ * @brief Processes every millisecond up to and including now: cascades at
+ * level boundaries, then releases the level-0 slot. Periodic tasks are
+ * re-armed on release from their previous expiry, so they do not drift.
+ */
+static void wheel_advance(uint64_t now)
+{
+	while (wheel_time <= now) {
+		uint32_t idx0 = (uint32_t)(wheel_time & (L0_SLOTS - 1U));
+		sched_task_t *task;
+
+		if (idx0 == 0U) {
+			uint32_t idx1 = (uint32_t)((wheel_time >> L1_SHIFT) & (L1_SLOTS - 1U));
+
+			if (idx1 == 0U) {
+				wheel_cascade(&wheel2[(wheel_time >> L2_SHIFT) & (L2_SLOTS - 1U)]);
+			}
+			wheel_cascade(&wheel1[idx1]);
+		}
+
+		task = wheel0[idx0];
+		wheel0[idx0] = NULL;
+		wheel_time++;
+
+		while (task != NULL) {
+			sched_task_t *next = task->next;
+
+			task->next = NULL;
+			task->pprev = NULL;
+			ready_push(task, SCHED_EVT_TIMER, task->expires);
+
+			if (task->period_ms != 0U) {
+				task->expires += task->period_ms;
+				wheel_insert(task);
+			}
+			task = next;
+		}
+	}
+}
+
+
+/**
+ * @brief Adds event flags and queues the task unless it already is.
+ * A timer release that finds the previous one still queued is lost and
+ * counted as a deadline miss.
+ */
+static void ready_push(sched_task_t *task, uint32_t flags, uint64_t release)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if ((flags & SCHED_EVT_TIMER) && (task->events & SCHED_EVT_TIMER)) {
+		task->stats.deadline_misses++;
+	}
+	if (task->events == 0U) {
+		task->release = release;
+	}
+	task->events |= flags;
+
+	if (!task->queued) {
+		task->queued = 1;
+		task->ready_next = NULL;
+		if (ready_tail != NULL) {
+			ready_tail->ready_next = task;
+		} else {
+			ready_head = task;
+		}
+		ready_tail = task;
+	}
+	__set_PRIMASK(primask);
+}
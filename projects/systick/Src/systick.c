@@ -1,31 +1,196 @@
 /***************************************************************************
  * File name     :      systick.c
- * Description   :      This file implements a blocking delay function using
- *                      the ARM Cortex-M SysTick timer. It provides a millisecond
- *                      delay utility based on the system clock.
+ * Description   :      This file implements the system time base on the
+ *                      ARM Cortex-M SysTick timer. SysTick reloads every
+ *                      millisecond and its interrupt advances a 64-bit
+ *                      counter; sub-millisecond time comes from the current
+ *                      counter value. Delays and timeouts are deadlines
+ *                      against this clock instead of SysTick reprogramming.
  *
  * Author        :      Jere Piirainen
  * Date          :      2025-06-16
  **************************************************************************/
 #include "systick.h"
+#include "clock.h"
+#include "timing.h"
+#include "tickless.h"
+
+SYSTICK_RELOAD_CHECK(CLOCK_HCLK_FREQ, SYSTICK_TICK_HZ);
 #include "stm32f3xx.h"
 
-void systickDelayMs(int delay)
+#define SYSTICK_LOAD        SYSTICK_RELOAD(CLOCK_HCLK_FREQ, SYSTICK_TICK_HZ)
+#define SYSTICK_PERIOD_CYC  (SYSTICK_LOAD + 1U)
+#define SYSTICK_IDLE_MAX    (0xFFFFFFU / SYSTICK_PERIOD_CYC)    // Ticks one stretched period can hold
+#define US_PER_TICK         (1000000U / SYSTICK_TICK_HZ)
+#define CSR_RUN             (CSR_ENABLE | CSR_TICKINT | CSR_CLKSRC)
+
+/* Whole ticks since systickInit(), written by SysTick_Handler and, with the tick stopped, systickResume() */
+static volatile uint64_t systick_ms = 0;
+static uint32_t paused_val;                     // Cycles left in the tick when the counter was paused
+
+
+void systickInit(void)
 {
-	/* Configure SysTick timer for 1 ms counting */
-	/* Reload with number of clock cycles per millisecond */
-	SysTick->LOAD = SYSTICK_LOAD_VAL;
+	SysTick->CTRL = 0;
+	systick_ms = 0;
+
+	/* Reload with number of clock cycles per millisecond (counter counts LOAD..0) */
+	SysTick->LOAD = SYSTICK_LOAD;
 
 	/* Clear SysTick current value register */
 	SysTick->VAL = 0;
 
-	/* Enable SysTick and select internal clock source */
-	SysTick->CTRL = (CSR_ENABLE | CSR_CLKSRC);
+	NVIC_SetPriority(SysTick_IRQn, SYSTICK_IRQ_PRIORITY);
+
+	/* Enable SysTick with its interrupt, internal clock source */
+	SysTick->CTRL = CSR_RUN;
+}
+
+
+uint64_t now_ms(void)
+{
+	uint64_t ms;
+
+	/* Two halves, torn by a tick in between: read until stable */
+	do {
+		ms = systick_ms;
+	} while (ms != systick_ms);
+
+	return ms;
+}
+
+
+uint64_t now_us(void)
+{
+	uint64_t ms;
+	uint32_t val;
+	uint32_t pending;
+
+	/* Retry if the handler ran in between, ms and val must come from the same period */
+	do {
+		ms = systick_ms;
+		val = SysTick->VAL;
+
+		/*
+		 * Reloaded but the handler has not run yet (masked, or called from a
+		 * higher priority handler): read VAL again so it is surely past the
+		 * reload, and count the pending tick below.
+		 */
+		pending = SCB->ICSR & SCB_ICSR_PENDSTSET_Msk;
+		if (pending) {
+			val = SysTick->VAL;
+		}
+	} while (ms != systick_ms);
 
-	for (int i = 0; i < delay; i++) {
-		/* Wait until the countflag is set */
-		while ((SysTick->CTRL & CSR_COUNTFLAG) == 0) {}
+	if (pending) {
+		ms++;
 	}
-    /* Disable SysTick timer after delay completion */
-	SysTick->CTRL = 0;
-}
\ No newline at end of file
+
+	return (ms * US_PER_TICK) + (((SYSTICK_LOAD - val) * US_PER_TICK) / (SYSTICK_LOAD + 1U));
+}
+
+
+uint64_t elapsed_us(uint64_t since_us)
+{
+	return now_us() - since_us;
+}
+
+
+int deadline_expired(uint64_t deadline_us)
+{
+	return now_us() >= deadline_us;
+}
+
+
+uint32_t systickIdle(uint32_t ticks)
+{
+	uint32_t len;
+	uint32_t val;
+	uint32_t countflag;
+	uint32_t elapsed;
+
+	if (ticks > SYSTICK_IDLE_MAX) {
+		ticks = SYSTICK_IDLE_MAX;
+	}
+	if ((ticks == 0U) || (systickPause() != 0)) {
+		return 0;
+	}
+
+	/* One long period ending on the tick boundary `ticks` ms ahead, then normal ones again */
+	len = tickless_idle_len(paused_val, ticks, SYSTICK_PERIOD_CYC);
+
+	SysTick->LOAD = len - 1U;
+	SysTick->VAL = 0;
+	SysTick->CTRL = CSR_RUN;
+	SysTick->LOAD = SYSTICK_LOAD;   // Used from the next reload on
+
+	__DSB();
+	__WFI();
+
+	/* Stop first, COUNTFLAG survives a CTRL write but tells whether the long period ended */
+	SysTick->CTRL = CSR_TICKINT | CSR_CLKSRC;
+	val = SysTick->VAL;
+	countflag = SysTick->CTRL & CSR_COUNTFLAG;
+	elapsed = tickless_idle_elapsed(len, val, countflag, SYSTICK_LOAD);
+
+	/* Woken by the tick itself, it is counted below instead of by the handler */
+	if (countflag) {
+		SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+	}
+
+	systickResume(elapsed);
+
+	return elapsed;
+}
+
+
+int systickPause(void)
+{
+	SysTick->CTRL = CSR_TICKINT | CSR_CLKSRC;
+	paused_val = SysTick->VAL;
+
+	/* Reloaded but not yet counted: leave it to the handler */
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+		SysTick->CTRL = CSR_RUN;
+		return -1;
+	}
+
+	return 0;
+}
+
+
+void systickResume(uint64_t elapsed_cycles)
+{
+	uint64_t passed;
+	uint32_t rem;
+
+	/* Ticks completed since the pause, and cycles left to the next boundary */
+	passed = tickless_resume_split(elapsed_cycles, paused_val, SYSTICK_PERIOD_CYC, &rem);
+
+	systick_ms += passed;
+
+	SysTick->LOAD = rem - 1U;
+	SysTick->VAL = 0;
+	SysTick->CTRL = CSR_RUN;
+	SysTick->LOAD = SYSTICK_LOAD;
+}
+
+
+void systickDelayMs(int delay)
+{
+	uint64_t deadline = now_us() + ((uint64_t)delay * 1000U);
+
+	/* The tick wakes the core every millisecond, any other interrupt sooner */
+	while (!deadline_expired(deadline)) {
+		__WFI();
+	}
+}
+
+
+/**
+ * @brief SysTick exception handler, once per millisecond.
+ */
+void SysTick_Handler(void)
+{
+	systick_ms++;
+}
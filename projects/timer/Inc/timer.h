@@ -2,7 +2,11 @@
  * File name     :  timer.h
  * Description   :  Header file for Timer3 configuration and control.
  *                  Defines constants for Timer3 settings and declares the
- *                  initialization function.
+ *                  initialization function, and an interrupt-driven event
+ *                  generator: TIM3 free-runs at the full timer clock and
+ *                  its four capture/compare channels each fire a periodic
+ *                  or one-shot callback, with latency and jitter measured
+ *                  on the DWT cycle counter.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-16
@@ -10,9 +14,46 @@
 #ifndef TIMER_H_
 #define TIMER_H_
 
+#include <stdint.h>
+
 #define TIM3EN		(1U << 1)   // Clock enable bit for TIM3 in RCC_APB1ENR
 #define CR1_CEN		(1U << 0)   // Counter Enable bit in TIMx_CR1
 #define SR_UIF		(1U << 0)   // Update Interrupt Flag in TIMx_SR
+#define SR_CC1IF	(1U << 1)   // Capture/compare 1 flag, CC2IF..CC4IF follow
+#define DIER_UIE	(1U << 0)   // Update interrupt enable
+#define DIER_CC1IE	(1U << 1)   // Capture/compare 1 interrupt enable, CC2IE..CC4IE follow
+
+#define TIM3_UPDATE_FREQ	1U      // Update event rate (Hz)
+
+/* --- Event generator --- */
+#define TIM3_EVENT_CHANNELS     4U      // CC1..CC4
+#define TIM3_EVENT_PSC          0U      // Timer clock undivided: 72 MHz, 13.9 ns per tick
+#define TIM3_EVENT_TICK_HZ      (CLOCK_TIM_APB1_FREQ / (TIM3_EVENT_PSC + 1U))
+#define TIM3_EVENT_IRQ_PRIORITY 1U
+#define TIM3_EVENT_MAX_TICKS    0x7FFFFFFFU     // Longest delay or period, ~29.8 s at 72 MHz
+
+/* Microseconds to event ticks, for constant arguments (needs clock.h) */
+#define TIM3_US_TO_TICKS(us)    ((uint32_t)(((uint64_t)(us) * TIM3_EVENT_TICK_HZ) / 1000000U))
+
+/**
+ * @brief Event callback, runs in the TIM3 interrupt.
+ * @param channel Channel that fired, 0..TIM3_EVENT_CHANNELS-1.
+ */
+typedef void (*timer3_event_cb_t)(uint32_t channel);
+
+/**
+ * @brief Per-channel timing counters, in core cycles.
+ * Latency is from the scheduled compare time to the callback; jitter is
+ * the deviation of the time between two periodic callbacks from the period.
+ */
+typedef struct {
+    uint32_t fires;
+    uint32_t overruns;              // Periods skipped because the callback ran too late
+    uint32_t max_latency_cycles;
+    uint32_t max_jitter_cycles;
+    int32_t last_jitter_cycles;
+} timer3_event_stats_t;
+
 
 /**
  * @brief Initializes Timer3 to generate an update event every 1 second.
@@ -21,5 +62,42 @@
  */
 void timer3Init(void);
 
+/**
+ * @brief Starts TIM3 as a free-running 16-bit counter at TIM3_EVENT_TICK_HZ,
+ * extended to 32 bits by the update interrupt, with all channels idle.
+ * Replaces the timer3Init() configuration.
+ */
+void timer3EventInit(void);
+
+/**
+ * @brief Schedules a channel. The compare register is only 16 bits, so a
+ * delay or period over 65536 ticks also interrupts at each intermediate
+ * match (every 910 us), which is checked and ignored.
+ * @param channel 0..TIM3_EVENT_CHANNELS-1.
+ * @param delay_ticks First event this many ticks from now, 1..TIM3_EVENT_MAX_TICKS.
+ * @param period_ticks Period of later events, 0 for a one-shot.
+ * @param callback Called from the interrupt at each event.
+ * @return 0 on success, -1 on a bad argument.
+ */
+int timer3EventStart(uint32_t channel, uint32_t delay_ticks, uint32_t period_ticks, timer3_event_cb_t callback);
+
+/**
+ * @brief Stops a channel.
+ * @param channel 0..TIM3_EVENT_CHANNELS-1.
+ */
+void timer3EventStop(uint32_t channel);
+
+/**
+ * @brief Current time on the extended TIM3 counter, wraps every 2^32 ticks.
+ */
+uint32_t timer3EventNow(void);
+
+/**
+ * @brief Returns a snapshot of a channel's counters.
+ * @param channel 0..TIM3_EVENT_CHANNELS-1.
+ * @param stats Destination.
+ */
+void timer3EventGetStats(uint32_t channel, timer3_event_stats_t *stats);
+
 
 #endif /* TIMER_H_ */
@@ -2,14 +2,18 @@
  * File name     :      main.c
  * Description   :      Main application file for an STM32F3 microcontroller.
  *                      This program initializes UART3 for serial communication and
- *                      configures GPIOA pin 5 (PA5) to control an LED. It then
- *                      continuously transmits a message over UART and toggles the LED
- *                      every 1 second, driven by Timer3's update events.
- * 
+ *                      configures GPIOA pin 5 (PA5) to control an LED. Timer3's
+ *                      compare channels run three rate groups from the one
+ *                      free-running counter: the LED toggles every 1 second,
+ *                      and 1 kHz and 10 kHz events count in the background.
+ *                      Once a second the message is transmitted together with
+ *                      the latency and jitter measured on each rate group.
+ *
  * Author        :      Jere Piirainen
  * Date          :      2025-06-16
  **************************************************************************/
 #include "stm32f3xx.h"
+#include "clock.h"
 #include "timer.h"
 #include "uart.h"
 
@@ -17,6 +21,20 @@
 #define GPIOAEN     (1U << 17)  // Clock enable bit for GPIOA in RCC_AHBENR
 #define LED_PIN     (1U << 5)   // PA5
 
+/* --- Rate groups, one compare channel each --- */
+#define CH_1HZ      0U
+#define CH_1KHZ     1U
+#define CH_10KHZ    2U
+#define CH_ONESHOT  3U
+
+static volatile uint32_t second_elapsed;
+static volatile uint32_t count_1khz;
+static volatile uint32_t count_10khz;
+static volatile uint32_t oneshot_done;
+
+static void on_event(uint32_t channel);
+static void print_stats(const char *name, uint32_t channel);
+
 int main(void)
 {
     /* Enable clock access to GPIOA */
@@ -30,21 +48,77 @@ int main(void)
     /* Initialize USART3 for transmit and receive functionality */
     uart3_tx_rx_init();
 
-    /* Initialize Timer 3 for 1-second update events */
-	timer3Init();
+    /* Free-running Timer 3, events from its compare channels */
+	timer3EventInit();
+	(void)timer3EventStart(CH_1HZ, TIM3_US_TO_TICKS(1000000U), TIM3_US_TO_TICKS(1000000U), on_event);
+	(void)timer3EventStart(CH_1KHZ, TIM3_US_TO_TICKS(1000U), TIM3_US_TO_TICKS(1000U), on_event);
+	(void)timer3EventStart(CH_10KHZ, TIM3_US_TO_TICKS(100U), TIM3_US_TO_TICKS(100U), on_event);
+	(void)timer3EventStart(CH_ONESHOT, TIM3_US_TO_TICKS(500000U), 0, on_event);
 
 	const char *string = "1 second has passed\n\r"; // Message to be transmitted
 
     while(1) {
-    	/* Wait for UIF */
-    	while (!(TIM3->SR & SR_UIF)) {}
-
-    	/* Clear UIF */
-    	TIM3->SR &= ~SR_UIF;
+    	/* Sleep until an event, nothing is polled */
+    	while (!second_elapsed) {
+    		__WFI();
+    	}
+    	second_elapsed = 0;
 
         /* Transmit message over UART3 */
     	uart3_puts(string);
 
-    	GPIOA->ODR ^= LED_PIN;
+    	if (oneshot_done) {
+    		oneshot_done = 0;
+    		uart3_puts("one-shot fired at 500 ms\n\r");
+    	}
+
+    	print_stats("1 Hz", CH_1HZ);
+    	print_stats("1 kHz", CH_1KHZ);
+    	print_stats("10 kHz", CH_10KHZ);
     }
 }
+
+/**
+ * @brief Event callback for every channel, runs in the TIM3 interrupt.
+ */
+static void on_event(uint32_t channel)
+{
+	switch (channel) {
+	case CH_1HZ:
+		GPIOA->ODR ^= LED_PIN;
+		second_elapsed = 1;
+		break;
+
+	case CH_1KHZ:
+		count_1khz++;
+		break;
+
+	case CH_10KHZ:
+		count_10khz++;
+		break;
+
+	default:
+		oneshot_done = 1;
+		break;
+	}
+}
+
+/**
+ * @brief Transmits the event count, worst latency and jitter of one channel.
+ */
+static void print_stats(const char *name, uint32_t channel)
+{
+	timer3_event_stats_t stats;
+
+	timer3EventGetStats(channel, &stats);
+	uart3_puts(name);
+	uart3_puts(": fires ");
+	uart3_put_int((int)stats.fires);
+	uart3_puts(", max latency ");
+	uart3_put_int((int)stats.max_latency_cycles);
+	uart3_puts(" cycles, max jitter ");
+	uart3_put_int((int)stats.max_jitter_cycles);
+	uart3_puts(" cycles, overruns ");
+	uart3_put_int((int)stats.overruns);
+	uart3_puts("\n\r");
+}
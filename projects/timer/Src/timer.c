@@ -2,28 +2,284 @@
  * File name     :  timer.c
  * Description   :  This file provides functions to initialize and control
  *                  the Timer 3 (TIM3) module on an STM32F3 microcontroller.
- *                  It configures TIM3 for a 1-second periodic update event.
+ *                  It configures TIM3 for a 1-second periodic update event,
+ *                  or as an event generator: the counter free-runs, the
+ *                  update interrupt counts wraps, and each capture/compare
+ *                  channel in frozen output-compare mode marks the next
+ *                  event of its own periodic or one-shot schedule.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-16
  **************************************************************************/
+#include <stddef.h>
 #include "timer.h"
+#include "clock.h"
+#include "timing.h"
+
+TIM_CHECK(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
 #include "stm32f3xx.h"
 
+#define CNT_WRAP            0x10000U        // 16-bit counter
+#define CNT_HALF            0x8000U
+#define SR_CC_ALL           (0xFU << 1)     // CC1IF..CC4IF
+#define TICK_CYCLES         (CLOCK_HCLK_FREQ / TIM3_EVENT_TICK_HZ)  // Core cycles per timer tick
+
+_Static_assert((CLOCK_HCLK_FREQ % TIM3_EVENT_TICK_HZ) == 0U, "Timer tick must be a whole number of core cycles");
+
+/**
+ * @brief One compare channel's schedule.
+ */
+typedef struct {
+    timer3_event_cb_t callback;     // NULL when idle
+    uint32_t next;                  // Extended time of the next event
+    uint32_t period;                // 0 = one-shot
+    uint32_t last_cyc;              // DWT->CYCCNT at the previous periodic event
+    uint8_t have_last;
+    timer3_event_stats_t stats;
+} timer3_event_t;
+
+static timer3_event_t events[TIM3_EVENT_CHANNELS];
+static volatile uint32_t wrap_ticks;            // Counter wraps, in ticks (multiple of CNT_WRAP)
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void timer3_event_fire(uint32_t channel, uint32_t now);
+
+
 void timer3Init(void)
 {
 	/* Enable clock access to timer3 */
 	RCC->APB1ENR |= TIM3EN;
 
-	/* Set prescaler value */
-	TIM3->PSC = 800 - 1;		// 8 000 000 / 8 000 = 10 000
+	/* Set prescaler value, smallest that keeps ARR within 16 bits */
+	TIM3->PSC = TIM_PSC(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
 
 	/* Set auto-reload value */
-	TIM3->ARR = 10000 - 1;		// 10 000 / 10 000 = 1 Hz
+	TIM3->ARR = TIM_ARR(CLOCK_TIM_APB1_FREQ, TIM3_UPDATE_FREQ);
 
 	/* Clear counter */
 	TIM3->CNT = 0;
 
 	/* Enable timer */
 	TIM3->CR1 = CR1_CEN;
-}
\ No newline at end of file
+}
+
+
+void timer3EventInit(void)
+{
+	RCC->APB1ENR |= TIM3EN;
+
+	TIM3->CR1 = 0;
+	TIM3->DIER = 0;
+
+	/* Full 16-bit range, every channel in frozen output compare (no pin) */
+	TIM3->PSC = TIM3_EVENT_PSC;
+	TIM3->ARR = CNT_WRAP - 1U;
+	TIM3->CCMR1 = 0;
+	TIM3->CCMR2 = 0;
+	TIM3->CCER = 0;
+	TIM3->CNT = 0;
+
+	/* Load PSC now; the update from UG is not counted as a wrap */
+	TIM3->EGR = TIM_EGR_UG;
+	TIM3->SR = 0;
+
+	for (uint32_t ch = 0; ch < TIM3_EVENT_CHANNELS; ch++) {
+		events[ch].callback = NULL;
+	}
+	wrap_ticks = 0;
+
+	/* Latency and jitter are measured in core cycles */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	TIM3->DIER = DIER_UIE;
+	NVIC_SetPriority(TIM3_IRQn, TIM3_EVENT_IRQ_PRIORITY);
+	NVIC_EnableIRQ(TIM3_IRQn);
+
+	TIM3->CR1 = CR1_CEN;
+}
+
+
+int timer3EventStart(uint32_t channel, uint32_t delay_ticks, uint32_t period_ticks, timer3_event_cb_t callback)
+{
+	timer3_event_t *ev;
+	uint32_t primask;
+
+	if ((channel >= TIM3_EVENT_CHANNELS) || (callback == NULL) || (delay_ticks == 0U) ||
+	    (delay_ticks > TIM3_EVENT_MAX_TICKS) || (period_ticks > TIM3_EVENT_MAX_TICKS)) {
+		return -1;
+	}
+
+	ev = &events[channel];
+	primask = __get_PRIMASK();
+	__disable_irq();
+
+	TIM3->DIER &= ~(DIER_CC1IE << channel);
+	ev->callback = callback;
+	ev->period = period_ticks;
+	ev->have_last = 0;
+	ev->stats.fires = 0;
+	ev->stats.overruns = 0;
+	ev->stats.max_latency_cycles = 0;
+	ev->stats.max_jitter_cycles = 0;
+	ev->stats.last_jitter_cycles = 0;
+
+	ev->next = timer3EventNow() + delay_ticks;
+	(&TIM3->CCR1)[channel] = ev->next & (CNT_WRAP - 1U);
+	TIM3->SR = ~(SR_CC1IF << channel);
+	TIM3->DIER |= DIER_CC1IE << channel;
+
+	/* A short delay may already have passed the compare value: take it now */
+	if ((int32_t)(ev->next - timer3EventNow()) <= 0) {
+		TIM3->SR = ~(SR_CC1IF << channel);
+		timer3_event_fire(channel, timer3EventNow());
+	}
+
+	__set_PRIMASK(primask);
+
+	return 0;
+}
+
+
+void timer3EventStop(uint32_t channel)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	if (channel >= TIM3_EVENT_CHANNELS) {
+		return;
+	}
+
+	__disable_irq();
+	TIM3->DIER &= ~(DIER_CC1IE << channel);
+	TIM3->SR = ~(SR_CC1IF << channel);
+	events[channel].callback = NULL;
+	__set_PRIMASK(primask);
+}
+
+
+uint32_t timer3EventNow(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t base;
+	uint32_t cnt;
+
+	__disable_irq();
+	base = wrap_ticks;
+	cnt = TIM3->CNT;
+
+	/* Wrapped but not yet counted by the handler: a low count belongs after the wrap */
+	if ((TIM3->SR & SR_UIF) && (cnt < CNT_HALF)) {
+		base += CNT_WRAP;
+	}
+	__set_PRIMASK(primask);
+
+	return base + cnt;
+}
+
+
+void timer3EventGetStats(uint32_t channel, timer3_event_stats_t *stats)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	if (channel >= TIM3_EVENT_CHANNELS) {
+		return;
+	}
+
+	__disable_irq();
+	*stats = events[channel].stats;
+	__set_PRIMASK(primask);
+}
+
+
+/**
+ * @brief TIM3 Interrupt Service Routine (ISR).
+ * The wrap count is brought up to date first so every channel sees a
+ * consistent time; then each pending channel is dispatched straight from
+ * its flag bit, a fixed amount of work per channel.
+ */
+void TIM3_IRQHandler(void)
+{
+	uint32_t sr = TIM3->SR;
+	uint32_t pending;
+	uint32_t now;
+
+	if (sr & SR_UIF) {
+		TIM3->SR = ~SR_UIF;
+		wrap_ticks += CNT_WRAP;
+	}
+
+	pending = sr & TIM3->DIER & SR_CC_ALL;
+	if (pending == 0U) {
+		return;
+	}
+	TIM3->SR = ~pending;
+	now = timer3EventNow();
+
+	while (pending != 0U) {
+		uint32_t ch = __CLZ(__RBIT(pending)) - 1U;
+
+		pending &= pending - 1U;
+		timer3_event_fire(ch, now);
+	}
+}
+
+
+/**
+ * @brief Runs a channel's callback if its event is due, and schedules the next one.
+ * A match before the event is one of the intermediate 16-bit matches of a
+ * long delay and is ignored. Periods missed by a late callback are skipped
+ * rather than run back to back.
+ */
+static void timer3_event_fire(uint32_t channel, uint32_t now)
+{
+	timer3_event_t *ev = &events[channel];
+	uint32_t cyc = DWT->CYCCNT;
+	uint32_t latency;
+
+	if ((ev->callback == NULL) || ((int32_t)(ev->next - now) > 0)) {
+		return;
+	}
+
+	latency = (now - ev->next) * TICK_CYCLES;
+	if (latency > ev->stats.max_latency_cycles) {
+		ev->stats.max_latency_cycles = latency;
+	}
+
+	if (ev->period != 0U) {
+		/* Time between two callbacks against the period, both on the core clock */
+		if (ev->have_last) {
+			int32_t jitter = (int32_t)((cyc - ev->last_cyc) - (ev->period * TICK_CYCLES));
+			uint32_t mag = (jitter < 0) ? (uint32_t)(-jitter) : (uint32_t)jitter;
+
+			ev->stats.last_jitter_cycles = jitter;
+			if (mag > ev->stats.max_jitter_cycles) {
+				ev->stats.max_jitter_cycles = mag;
+			}
+		}
+		ev->last_cyc = cyc;
+		ev->have_last = 1;
+
+		ev->next += ev->period;
+		do {
+			while ((int32_t)(ev->next - timer3EventNow()) <= 0) {
+				ev->next += ev->period;
+				ev->stats.overruns++;
+				ev->have_last = 0;
+			}
+			(&TIM3->CCR1)[channel] = ev->next & (CNT_WRAP - 1U);
+
+			/* The counter may have passed the new compare value as it was written: skip that period too */
+		} while ((int32_t)(ev->next - timer3EventNow()) <= 0);
+	} else {
+		TIM3->DIER &= ~(DIER_CC1IE << channel);
+	}
+
+	ev->stats.fires++;
+	ev->callback(channel);
+
+	/* One-shot: the callback may have rescheduled it, otherwise it is done */
+	if ((ev->period == 0U) && !(TIM3->DIER & (DIER_CC1IE << channel))) {
+		ev->callback = NULL;
+	}
+}
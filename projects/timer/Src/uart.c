@@ -10,6 +10,8 @@
  * Date          :    2025-06-13
  **************************************************************************/
 #include "uart.h"
+#include "clock.h"
+#include "timing.h"
 #include "stm32f3xx.h"
 
 /* --- Peripheral base addresses and bit definitions --- */
@@ -23,17 +25,15 @@
 #define ISR_TXE         (1U << 7)       // Transmit data register empty flag
 #define ISR_RXNE		(1U << 5)	    // Read data register not empty flag
 
-/* --- System and UART configuration constants --- */
-#define SYS_FREQ       8000000          // System clock frequency (8 MHz)
-#define APB1_CLK       SYS_FREQ         // APB1 bus clock frequency 
-
+/* --- UART configuration constants --- */
 #define UART_BAUDRATE  115200           // Desired Baud rate
+#define UART3_BRR_VAL  UART_BRR(CLOCK_PCLK1_FREQ, UART_BAUDRATE)
+
+UART_BRR_CHECK(CLOCK_PCLK1_FREQ, UART_BAUDRATE);
 
 
 /* --- Static function prototypes (helper functions local to this file) --- */
 
-static void uart_set_baudrate(USART_TypeDef *UARTx, uint32_t PeriphClk, uint32_t BaudRate);
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate);
 static void uart3_write(int ch);
 
 
@@ -151,8 +151,8 @@ void uart3_tx_rx_init(void)
     /* Enable clock access to USART3 */
     RCC->APB1ENR |= USART3EN;
 
-    /* Configure baud rate */
-    uart_set_baudrate(USART3, APB1_CLK, UART_BAUDRATE);
+    /* Configure baud rate, BRR is resolved from PCLK1 at compile time */
+    USART3->BRR = UART3_BRR_VAL;
 
     /* Configure the transfer direction for both transmitter and receiver */
     USART3->CR1 = (CR1_TE |  CR1_RE);
@@ -193,33 +193,3 @@ void uart3_write(int ch)
     /* Write to transmit data register */
     USART3->TDR = (ch & 0xFF);
 }
-
-
-
-/**
- * @brief Sets the baud rate for the specified UART peripheral.
- * @param USARTx Pointer to the USART peripheral (e.g., USART3).
- * @param PeriphClk The peripheral clock frequency feeding the UART.
- * @param BaudRate The desired baud rate.
- */
-static void uart_set_baudrate(USART_TypeDef *USARTx, uint32_t PeriphClk, uint32_t BaudRate)
-{
-	USARTx->BRR = compute_uart_bd(PeriphClk, BaudRate);
-}
-
-
-
-/**
- * @brief Computes the value for the USART Baud Rate Register (BRR).
- * This calculation performs integer division with rounding for simplicity.
- * For high precision, refer to the MCU's reference manual for fractional baud rate settings.
- * @param PeriphClk The peripheral clock frequency.
- * @param BaudRate The desired baud rate.
- * @return The calculated 16-bit value for the BRR register.
- */
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate)
-{
-    // Calculation: BRR = PeriphClk / BaudRate
-    // Adding (BaudRate / 2U) before division performs rounding to the nearest integer.
-    return ((PeriphClk + (BaudRate / 2U)) / BaudRate);
-}
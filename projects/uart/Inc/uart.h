@@ -9,10 +9,46 @@
 
 #ifndef UART_H_
 #define UART_H_
- 
+
+#include <stdint.h>
+
+/* --- Interrupt-driven transmit configuration --- */
+#define UART3_TX_BUF_SIZE   256U        // TX ring buffer size in bytes (must be a power of two)
+
+/**
+ * @brief Policy applied by uart3_write_async() when the TX ring buffer is full.
+ */
+typedef enum {
+    UART_TX_DROP = 0,       // Reject the bytes that do not fit
+    UART_TX_BLOCK,          // Wait until the TX interrupt has freed enough space
+    UART_TX_OVERWRITE       // Discard the oldest queued bytes to make room
+} uart_tx_policy_t;
+
 void uart3_tx_rx_init(void);
 
 char uart3_read(void);
 void uart3_puts(const char *str);
- 
+
+/**
+ * @brief Queues bytes for interrupt-driven transmission over USART3.
+ * The bytes are copied into the TX ring buffer and drained by the USART3
+ * TXE interrupt, so the call returns without waiting for the line.
+ * @param data Pointer to the bytes to transmit.
+ * @param len Number of bytes to transmit.
+ * @return Number of bytes accepted into the ring buffer.
+ * @note With UART_TX_BLOCK this must not be called with interrupts disabled.
+ */
+uint32_t uart3_write_async(const uint8_t *data, uint32_t len);
+
+/**
+ * @brief Selects what uart3_write_async() does when the TX ring buffer is full.
+ * @param policy One of UART_TX_DROP, UART_TX_BLOCK or UART_TX_OVERWRITE.
+ */
+void uart3_set_tx_policy(uart_tx_policy_t policy);
+
+/**
+ * @brief Blocks until every queued byte has left the USART3 shift register.
+ */
+void uart3_flush(void);
+
 #endif /* UART_H_ */
\ No newline at end of file
@@ -1,8 +1,8 @@
 /***************************************************************************
  * File name     :  uart.h
  * Description   :  Header file for the UART3 driver module. Provides functions
- *                  for initializing UART3 (TX/RX) and configuring DMA1
- *                  Channel 2 for UART transmit operations.
+ *                  for initializing UART3 (TX/RX), a queued DMA1 Channel 2
+ *                  transmit engine and circular DMA1 Channel 3 reception.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-17
@@ -22,32 +22,80 @@
 #define CR1_RE          (1U << 2)  // Receiver Enable bit
 #define CR1_UE          (1U << 0)  // USART Enable bit
 #define CR1_RXNEIE      (1U << 5)  // RXNE Interrupt Enable (for receive interrupt)
+#define CR1_IDLEIE      (1U << 4)  // IDLE Interrupt Enable (line idle after a frame)
 
 /* --- USART Interrupt and Status Register (ISR) Bit Defines --- */
 #define ISR_TXE         (1U << 7)  // Transmit data register empty flag
 #define ISR_RXNE        (1U << 5)  // Read data register not empty flag (data ready to be read)
+#define ISR_IDLE        (1U << 4)  // IDLE line detected flag
+#define ISR_ORE         (1U << 3)  // Overrun error flag
+
+/* --- USART Interrupt Flag Clear Register (ICR) Bit Defines --- */
+#define ICR_IDLECF      (1U << 4)  // Clear IDLE line detected flag
+#define ICR_ORECF       (1U << 3)  // Clear overrun error flag
 
 /* --- USART Control Register 3 (CR3) Bit Defines --- */
 #define USART3_CR3_DMAT (1U << 7)  // DMA Enable Transmitter bit (for UART TX via DMA)
+#define USART3_CR3_DMAR (1U << 6)  // DMA Enable Receiver bit (for UART RX via DMA)
 
 /* --- DMA Control Register (CCR) Bit Defines (for DMA1_Channel2->CCR) --- */
 #define DMA1_CCR_EN          (1U << 0)   // DMA Channel Enable bit
 #define DMA1_MINC            (1U << 7)   // Memory Increment Mode Enable
 #define DMA1_DIR             (1U << 4)   // Transfer Direction (0: Periph to Mem; 1: Mem to Periph)
 #define DMA1_CCR_TCIE        (1U << 1)   // Transfer Complete Interrupt Enable
+#define DMA1_CCR_HTIE        (1U << 2)   // Half Transfer Interrupt Enable
+#define DMA1_CCR_TEIE        (1U << 3)   // Transfer Error Interrupt Enable
+#define DMA1_CIRC            (1U << 5)   // Circular Mode Enable
 
 /* --- DMA Interrupt and Status Register (ISR) and Clear Flag Register (IFCR) Defines --- */
 #define DMA1_ISR_TCIF2      (1U << 5)   // Transfer Complete Flag for Channel 2 in DMA_ISR
 #define DMA1_IFCR_CTCIF2    (1U << 5)   // Clear Transfer Complete Flag for Channel 2 in DMA_IFCR
+#define DMA1_ISR_TEIF2      (1U << 7)   // Transfer Error Flag for Channel 2 in DMA_ISR
+#define DMA1_IFCR_CGIF2     (1U << 4)   // Clear all flags for Channel 2 in DMA_IFCR
+#define DMA1_ISR_TCIF3      (1U << 9)   // Transfer Complete Flag for Channel 3 in DMA_ISR
+#define DMA1_ISR_HTIF3      (1U << 10)  // Half Transfer Flag for Channel 3 in DMA_ISR
+#define DMA1_IFCR_CTCIF3    (1U << 9)   // Clear Transfer Complete Flag for Channel 3 in DMA_IFCR
+#define DMA1_IFCR_CHTIF3    (1U << 10)  // Clear Half Transfer Flag for Channel 3 in DMA_IFCR
 
 /* --- DMA Clock Enable Define (specific for RCC_AHBENR) --- */
 //#define RCC_AHBENR_DMA1EN   (1U << 0)   // Clock enable bit for DMA1 in RCC_AHBENR
 
-/* --- System and UART Configuration Constants --- */
-#define SYS_FREQ       8000000          // System clock frequency (e.g., 8 MHz HSI)
-#define APB1_CLK       SYS_FREQ         // APB1 bus clock frequency (assuming no prescaler for APB1)
-
+/* --- UART Configuration Constants --- */
 #define UART_BAUDRATE  115200           // Desired UART Baud rate
+
+/* --- DMA Transmit Configuration --- */
+#define UART3_TX_QUEUE_DEPTH 8U         // Descriptors the TX engine can hold (power of two)
+
+/**
+ * @brief Called from the DMA interrupt once a descriptor has been fully handed
+ * to the USART. The buffer may be reused from this point on.
+ * @param data The buffer that was submitted.
+ * @param len Its length in bytes.
+ */
+typedef void (*uart_tx_callback_t)(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief One queued transmit request.
+ */
+typedef struct {
+    const uint8_t *data;            // Buffer to send, must stay valid until the callback
+    uint16_t len;                   // Number of bytes to send
+    uart_tx_callback_t callback;    // Completion callback, may be NULL
+} uart_tx_desc_t;
+
+/* --- DMA Receive Configuration --- */
+#define UART3_RX_BUF_SIZE   128U        // Circular DMA RX buffer, HT/TC split it into two halves
+#define UART3_RX_SPAN_QUEUE 8U          // Published frames waiting for the application (power of two)
+
+/**
+ * @brief A received frame, pointing straight into the circular DMA buffer.
+ * The bytes stay valid until uart3_rx_release() is called for this span,
+ * as long as the sender does not get a full buffer ahead of the consumer.
+ */
+typedef struct {
+    const uint8_t *data;    // First byte of the frame inside the DMA buffer
+    uint16_t len;           // Number of bytes in the frame
+} uart_rx_span_t;
  
 
 /**
@@ -58,15 +106,59 @@
 void uart3_tx_rx_init(void);
 
 /**
- * @brief Initializes DMA1 Channel 2 for a memory-to-peripheral transfer.
- * This function sets up the source, destination, length, and transfer direction,
- * and enables the DMA channel and its transfer complete interrupt.
- * It's typically used for UART Transmit via DMA.
- * @param src The starting address of the source data in memory.
- * @param dst The starting address of the destination peripheral register (e.g., USARTx->TDR).
- * @param len The number of data transfers to be performed.
+ * @brief Initializes the USART3 DMA transmit engine on DMA1 Channel 2.
+ * The engine owns the channel: it is configured once here and reloaded from
+ * the transfer complete interrupt for every queued descriptor.
+ */
+void uart3_tx_dma_init(void);
+
+/**
+ * @brief Queues a buffer for DMA transmission over USART3.
+ * If the engine is idle the transfer starts immediately, otherwise it is
+ * chained from the transfer complete interrupt of the previous descriptor.
+ * @param data Buffer to send, must stay valid until the callback runs.
+ * @param len Number of bytes to send (1 to 65535).
+ * @param callback Completion callback, may be NULL.
+ * @return 0 on success, -1 if the queue is full or len is 0.
+ */
+int uart3_tx_dma_submit(const uint8_t *data, uint16_t len, uart_tx_callback_t callback);
+
+/**
+ * @brief Number of descriptors not yet completed, including the active one.
+ */
+uint32_t uart3_tx_dma_queue_depth(void);
+
+/**
+ * @brief Number of submitted bytes not yet handed to the USART.
+ */
+uint32_t uart3_tx_dma_bytes_in_flight(void);
+
+/**
+ * @brief Starts USART3 reception on DMA1 Channel 3 in circular mode.
+ * Completed frames are detected by the USART IDLE interrupt and the DMA
+ * half/full transfer interrupts and published as spans, see uart3_rx_get_span().
+ * @note uart3_read() must not be used once DMA reception is running.
+ */
+void uart3_rx_dma_init(void);
+
+/**
+ * @brief Returns the oldest published RX frame without copying it.
+ * @param span Filled with a pointer into the DMA buffer and the frame length.
+ * @return 1 if a span was available, 0 otherwise.
+ */
+int uart3_rx_get_span(uart_rx_span_t *span);
+
+/**
+ * @brief Releases the span returned by the last uart3_rx_get_span() call,
+ * handing its bytes back to the DMA.
+ */
+void uart3_rx_release(void);
+
+/**
+ * @brief Number of times received data was lost because the consumer fell
+ * a full buffer behind, the span queue was full or the USART overran.
  */
-void dma1Channel2Init(uint32_t src, uint32_t dst, uint32_t len);
+uint32_t uart3_rx_overruns(void);
 
 /**
  * @brief Reads a single character from the USART3 receive data register.
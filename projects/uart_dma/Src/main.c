@@ -3,9 +3,11 @@
  * Description   :  Main application file for an STM32F303 microcontroller.
  *                  This program demonstrates UART serial communication using DMA
  *                  for efficient data transmission. It configures GPIOA pin 5 (PA5)
- *                  to control an LED, initializes UART3, and uses DMA1 Channel 2
- *                  to transfer a string to the UART transmit data register.
- *                  The LED is toggled upon completion of the DMA transfer.
+ *                  to control an LED, initializes UART3, and queues two strings
+ *                  on the DMA1 Channel 2 transmit engine, which chains them
+ *                  back to back. The LED is set upon completion of a transfer.
+ *                  Incoming data is received by circular DMA and every frame
+ *                  toggles the LED.
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-17
@@ -19,12 +21,16 @@
 #define LED_PIN         (1U << 5)   // PA5
 
 /* --- Static function prototype local to this file --- */
-static void dma_Callback(void);
+static void dma_Callback(const uint8_t *data, uint16_t len);
+
+/* Buffers are read by the DMA after submit returns, so they live outside the stack */
+static const char message[] = "Hello from STM32 DMA transfer\n\r";
+static const char follow_up[] = "Chained without a gap\n\r";
 
 
 int main(void)
 {
-	char message[31] = "Hello from STM32 DMA transfer\n\r";
+	uart_rx_span_t frame;
 
 	/* Enable clock access to GPIOA */
 	RCC->AHBENR |= GPIOAEN;
@@ -36,38 +42,31 @@ int main(void)
     /* Initialize USART3 */
 	uart3_tx_rx_init();
 
-    /* Initialize USART3 for transmit and receive functionality */
-	dma1Channel2Init((uint32_t)&message[0], (uint32_t)&USART3->TDR, 31);
+    /* Initialize the DMA transmit engine on DMA1 Channel 2 */
+	uart3_tx_dma_init();
+
+    /* Queue two messages, the second is chained from the first one's completion */
+	uart3_tx_dma_submit((const uint8_t *)message, sizeof(message) - 1, dma_Callback);
+	uart3_tx_dma_submit((const uint8_t *)follow_up, sizeof(follow_up) - 1, dma_Callback);
 
-    /* Kick-off the DMA transfer */
-	USART3->TDR = message[0]; // Write the first byte to start the chain.
+	/* Start circular DMA reception */
+	uart3_rx_dma_init();
 
-    return 0;
+	while (1) {
+		/* Consume received frames in place, straight from the DMA buffer */
+		while (uart3_rx_get_span(&frame)) {
+			GPIOA->ODR ^= LED_PIN;
+			uart3_rx_release();
+		}
+	}
 }
 
 
 /**
- * @brief Callback function executed when the DMA transfer completes.
+ * @brief Callback function executed when a DMA transmit descriptor completes.
  * This function is called from the DMA interrupt service routine.
  */
-static void dma_Callback(void)
+static void dma_Callback(const uint8_t *data, uint16_t len)
 {
 	GPIOA->ODR |= LED_PIN;
 }
-
-/**
- * @brief DMA1 Channel 2 Interrupt Service Routine (ISR).
- * This function is automatically called by the MCU when a DMA interrupt occurs
- * for Channel 2, typically signaling a transfer complete event.
- */
-void DMA1_CH2_IRQHandler(void)
-{
-	/* Check for transfer complete interrupt */
-	if (DMA1->ISR & DMA1_ISR_TCIF2) {
-		/* Clear flag */
-		DMA1->IFCR |= DMA1_IFCR_CTCIF2;
-
-		/* Do something */
-		dma_Callback();
-	}
-}
\ No newline at end of file
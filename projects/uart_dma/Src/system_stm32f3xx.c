@@ -0,0 +1,214 @@
+/***************************************************************************
+ * File name     :  system_stm32f3xx.c
+ * Description   :  Clock tree configuration for the STM32F303. Implements
+ *                  the CMSIS SystemInit() hook called by the startup code,
+ *                  which brings SYSCLK from the 8 MHz HSI up to 72 MHz through
+ *                  the PLL, sets the flash wait states, prefetch buffer and
+ *                  bus prescalers. SystemCoreClockUpdate() and the clockGet*
+ *                  functions read back the frequencies actually running.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "stm32f3xx.h"
+#include "clock.h"
+
+/* --- RCC Clock Control Register (CR) Bit Defines --- */
+#define CR_HSEON            (1U << 16)  // HSE oscillator enable
+#define CR_HSERDY           (1U << 17)  // HSE oscillator ready flag
+#define CR_HSEBYP           (1U << 18)  // HSE bypass (external clock on OSC_IN)
+#define CR_PLLON            (1U << 24)  // PLL enable
+#define CR_PLLRDY           (1U << 25)  // PLL locked flag
+
+/* --- RCC Clock Configuration Register (CFGR) Fields --- */
+#define CFGR_SW_MASK        (0x3U << 0)     // System clock switch
+#define CFGR_SW_PLL         (0x2U << 0)     // PLL selected as system clock
+#define CFGR_SWS_MASK       (0x3U << 2)     // System clock switch status
+#define CFGR_SWS_HSE        (0x1U << 2)     // HSE used as system clock
+#define CFGR_SWS_PLL        (0x2U << 2)     // PLL used as system clock
+#define CFGR_HPRE_POS       4               // AHB prescaler field position
+#define CFGR_HPRE_MASK      (0xFU << 4)
+#define CFGR_PPRE1_POS      8               // APB1 prescaler field position
+#define CFGR_PPRE1_MASK     (0x7U << 8)
+#define CFGR_PPRE1_DIV2     (0x4U << 8)     // HCLK / 2
+#define CFGR_PPRE2_POS      11              // APB2 prescaler field position
+#define CFGR_PPRE2_MASK     (0x7U << 11)
+#define CFGR_PLLSRC_POS     15              // PLL source field position (2 bits on F303xE)
+#define CFGR_PLLSRC_MASK    (0x3U << 15)
+#define CFGR_PLLSRC_HSI_2   (0x0U << 15)    // HSI / 2
+#define CFGR_PLLSRC_HSI     (0x1U << 15)    // HSI / PREDIV
+#define CFGR_PLLSRC_HSE     (0x2U << 15)    // HSE / PREDIV
+#define CFGR_PLLMUL_POS     18              // PLL multiplier field position
+#define CFGR_PLLMUL_MASK    (0xFU << 18)
+#define CFGR_PLLMUL9        (0x7U << 18)    // PLL input x 9
+
+/* --- RCC Clock Configuration Register 2 (CFGR2) / 3 (CFGR3) --- */
+#define CFGR2_PREDIV_MASK   (0xFU << 0)     // PLL input divider, 0 = /1
+#define CFGR3_I2C1SW        (1U << 4)       // I2C1 clock: 0 = HSI, 1 = SYSCLK
+
+/* --- FLASH Access Control Register (ACR) Bit Defines --- */
+#define ACR_LATENCY_MASK    (0x7U << 0)
+#define ACR_LATENCY_2WS     (0x2U << 0)     // Two wait states, 48 MHz < SYSCLK <= 72 MHz
+#define ACR_PRFTBE          (1U << 4)       // Prefetch buffer enable
+
+/* --- Start-up timeouts (loop iterations, no timebase exists yet) --- */
+#define HSE_STARTUP_TIMEOUT 50000U
+#define PLL_LOCK_TIMEOUT    50000U
+
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static uint32_t clock_get_sysclk(void);
+
+
+/* Updated by SystemCoreClockUpdate(). SystemInit() runs before .data is copied,
+ * so it cannot set this itself. */
+uint32_t SystemCoreClock = HSI_VALUE;
+
+const uint8_t AHBPrescTable[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+const uint8_t APBPrescTable[8]  = {0, 0, 0, 0, 1, 2, 3, 4};
+
+
+/**
+ * @brief Configures the clock tree: PLL at 72 MHz, AHB /1, APB1 /2, APB2 /1.
+ * Called from Reset_Handler before .data/.bss are initialized, so it must
+ * only touch registers. If the PLL does not lock the core stays on HSI.
+ */
+void SystemInit(void)
+{
+	uint32_t pllsrc = CFGR_PLLSRC_HSI;
+	uint32_t timeout;
+
+	/* Flash must be slowed down BEFORE the core speeds up */
+	FLASH->ACR = (FLASH->ACR & ~ACR_LATENCY_MASK) | ACR_LATENCY_2WS | ACR_PRFTBE;
+
+#if CLOCK_USE_HSE
+	/* Start HSE in bypass mode (clock driven by the ST-LINK MCO) */
+	RCC->CR |= CR_HSEBYP | CR_HSEON;
+
+	/* Wait for HSE, fall back to HSI if it never comes up */
+	for (timeout = HSE_STARTUP_TIMEOUT; timeout > 0U; timeout--) {
+		if (RCC->CR & CR_HSERDY) {
+			pllsrc = CFGR_PLLSRC_HSE;
+			break;
+		}
+	}
+
+	if (pllsrc != CFGR_PLLSRC_HSE) {
+		RCC->CR &= ~(CR_HSEON | CR_HSEBYP);
+	}
+#endif
+
+	/* Bus prescalers: AHB /1, APB1 /2 (36 MHz max), APB2 /1 */
+	RCC->CFGR = (RCC->CFGR & ~(CFGR_HPRE_MASK | CFGR_PPRE1_MASK | CFGR_PPRE2_MASK)) | CFGR_PPRE1_DIV2;
+
+	/* PLL input: selected source / 1, multiplied by 9 -> 72 MHz */
+	RCC->CFGR2 &= ~CFGR2_PREDIV_MASK;
+	RCC->CFGR = (RCC->CFGR & ~(CFGR_PLLSRC_MASK | CFGR_PLLMUL_MASK)) | pllsrc | CFGR_PLLMUL9;
+
+	/* Enable PLL and wait for lock */
+	RCC->CR |= CR_PLLON;
+	for (timeout = PLL_LOCK_TIMEOUT; timeout > 0U; timeout--) {
+		if (RCC->CR & CR_PLLRDY) {
+			break;
+		}
+	}
+
+	if (!(RCC->CR & CR_PLLRDY)) {
+		/* No lock: stay on HSI, the extra wait states are harmless */
+		return;
+	}
+
+	/* Switch SYSCLK to the PLL and wait until the switch is reported */
+	RCC->CFGR = (RCC->CFGR & ~CFGR_SW_MASK) | CFGR_SW_PLL;
+	while ((RCC->CFGR & CFGR_SWS_MASK) != CFGR_SWS_PLL) {}
+}
+
+
+/**
+ * @brief Recomputes SystemCoreClock (HCLK) from the RCC registers.
+ */
+void SystemCoreClockUpdate(void)
+{
+	SystemCoreClock = clock_get_sysclk() >> AHBPrescTable[(RCC->CFGR & CFGR_HPRE_MASK) >> CFGR_HPRE_POS];
+}
+
+
+/**
+ * @brief Decodes the SYSCLK frequency from the clock switch status and PLL setup.
+ * @return SYSCLK in Hz.
+ */
+static uint32_t clock_get_sysclk(void)
+{
+	uint32_t cfgr = RCC->CFGR;
+	uint32_t sysclk;
+
+	switch (cfgr & CFGR_SWS_MASK) {
+	case CFGR_SWS_HSE:
+		sysclk = HSE_VALUE;
+		break;
+
+	case CFGR_SWS_PLL: {
+		uint32_t pllmul = ((cfgr & CFGR_PLLMUL_MASK) >> CFGR_PLLMUL_POS) + 2U;
+		uint32_t prediv = (RCC->CFGR2 & CFGR2_PREDIV_MASK) + 1U;
+
+		if (pllmul > 16U) {
+			pllmul = 16U;   // PLLMUL values 0b1110 and 0b1111 both mean x16
+		}
+
+		if ((cfgr & CFGR_PLLSRC_MASK) == CFGR_PLLSRC_HSI_2) {
+			sysclk = (HSI_VALUE / 2U) * pllmul;
+		} else if ((cfgr & CFGR_PLLSRC_MASK) == CFGR_PLLSRC_HSE) {
+			sysclk = (HSE_VALUE / prediv) * pllmul;
+		} else {
+			sysclk = (HSI_VALUE / prediv) * pllmul;
+		}
+		break;
+	}
+
+	default:
+		sysclk = HSI_VALUE;
+		break;
+	}
+
+	return sysclk;
+}
+
+
+uint32_t clockGetHclkFreq(void)
+{
+	SystemCoreClockUpdate();
+	return SystemCoreClock;
+}
+
+
+uint32_t clockGetPclk1Freq(void)
+{
+	return clockGetHclkFreq() >> APBPrescTable[(RCC->CFGR & CFGR_PPRE1_MASK) >> CFGR_PPRE1_POS];
+}
+
+
+uint32_t clockGetPclk2Freq(void)
+{
+	return clockGetHclkFreq() >> APBPrescTable[(RCC->CFGR & CFGR_PPRE2_MASK) >> CFGR_PPRE2_POS];
+}
+
+
+uint32_t clockGetTimApb1Freq(void)
+{
+	/* Timer clock is doubled whenever the APB1 prescaler is not 1 */
+	if (APBPrescTable[(RCC->CFGR & CFGR_PPRE1_MASK) >> CFGR_PPRE1_POS] == 0U) {
+		return clockGetPclk1Freq();
+	}
+
+	return clockGetPclk1Freq() * 2U;
+}
+
+
+uint32_t clockGetI2c1Freq(void)
+{
+	if (RCC->CFGR3 & CFGR3_I2C1SW) {
+		return clock_get_sysclk();
+	}
+
+	return HSI_VALUE;
+}
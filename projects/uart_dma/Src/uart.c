@@ -3,13 +3,18 @@
  * Description   :  This file provides functions to initialize and control
  *                  USART3 on an STM32F3 microcontroller for serial
  *                  communication (UART). It includes functions for
- *                  transmitting (both polling and DMA-driven) and
- *                  receiving single characters.
+ *                  transmitting (polling, or a queued DMA engine that
+ *                  chains descriptors from the transfer complete interrupt) and
+ *                  receiving (polling, or circular DMA with IDLE-line
+ *                  frame detection).
  *
  * Author        :  Jere Piirainen
  * Date          :  2025-06-13 (Updated 2025-06-17 for DMA)
  **************************************************************************/
+#include <stddef.h>
 #include "uart.h"
+#include "clock.h"
+#include "timing.h"
 
 /* --- Peripheral base addresses and bit definitions --- */
 #define GPIOBEN         (1U << 18)
@@ -22,17 +27,45 @@
 #define ISR_TXE         (1U << 7)       // Transmit data register empty flag
 #define ISR_RXNE		(1U << 5)	    // Read data register not empty flag
 
-/* --- System and UART configuration constants --- */
-#define SYS_FREQ       8000000          // System clock frequency (8 MHz)
-#define APB1_CLK       SYS_FREQ         // APB1 bus clock frequency 
-
+/* --- UART configuration constants --- */
 #define UART_BAUDRATE  115200           // Desired Baud rate
+#define UART3_BRR_VAL  UART_BRR(CLOCK_PCLK1_FREQ, UART_BAUDRATE)
+
+UART_BRR_CHECK(CLOCK_PCLK1_FREQ, UART_BAUDRATE);
 
 
 /* --- Static function prototypes (helper functions local to this file) --- */
-static void uart_set_baudrate(USART_TypeDef *UARTx, uint32_t PeriphClk, uint32_t BaudRate);
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate);
 static void uart3_write(int ch);
+static void uart3_tx_dma_start(const uart_tx_desc_t *desc);
+static void uart3_rx_publish(uint32_t start, uint32_t len);
+static void uart3_rx_process(void);
+
+/* --- DMA TX engine state --- */
+#define TX_Q_MASK       (UART3_TX_QUEUE_DEPTH - 1U)
+
+_Static_assert((UART3_TX_QUEUE_DEPTH & TX_Q_MASK) == 0U, "UART3_TX_QUEUE_DEPTH must be a power of two");
+
+static uart_tx_desc_t tx_queue[UART3_TX_QUEUE_DEPTH];
+static volatile uint32_t tx_q_head = 0;             // Next free descriptor slot
+static volatile uint32_t tx_q_tail = 0;             // Active (or next) descriptor
+static volatile uint8_t tx_active = 0;              // DMA1 CH2 is moving a descriptor
+static volatile uint32_t tx_bytes_submitted = 0;
+static volatile uint32_t tx_bytes_completed = 0;
+static volatile uint32_t tx_errors = 0;
+
+/* --- Circular DMA RX state --- */
+#define RX_SPAN_MASK    (UART3_RX_SPAN_QUEUE - 1U)
+
+_Static_assert((UART3_RX_SPAN_QUEUE & RX_SPAN_MASK) == 0U, "UART3_RX_SPAN_QUEUE must be a power of two");
+
+static uint8_t rx_buf[UART3_RX_BUF_SIZE];
+static uart_rx_span_t rx_spans[UART3_RX_SPAN_QUEUE];
+static volatile uint32_t rx_span_head = 0;  // Advanced by the ISRs when a frame is published
+static volatile uint32_t rx_span_tail = 0;  // Advanced by uart3_rx_release()
+static uint32_t rx_last_pos = 0;            // DMA write position at the last publish (ISR only)
+static volatile uint32_t rx_published = 0;  // Bytes handed to the application (ISR only)
+static volatile uint32_t rx_released = 0;   // Bytes handed back to the DMA (application only)
+static volatile uint32_t rx_overruns = 0;
 
 
 /**
@@ -51,10 +84,13 @@ void uart3_puts(const char *str)
 }
 
 
-void dma1Channel2Init(uint32_t src, uint32_t dst, uint32_t len)
+/**
+ * @brief Initializes the USART3 DMA transmit engine on DMA1 Channel 2.
+ */
+void uart3_tx_dma_init(void)
 {
 	/* Enable clock access to DMA */
-	RCC->AHBENR |= DMA1_CCR_EN;
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
 
 	/* Disable DMA1 channel 2 */
 	DMA1_Channel2->CCR &= ~DMA1_CCR_EN;
@@ -62,34 +98,309 @@ void dma1Channel2Init(uint32_t src, uint32_t dst, uint32_t len)
 	/* Wait until DMA 1 CH2 is disabled */
 	while (DMA1_Channel2->CCR & DMA1_CCR_EN) {}
 
-	/* Set destination buffer */
-	DMA1_Channel2->CPAR = dst;
+	/* Set destination: USART3 transmit data register */
+	DMA1_Channel2->CPAR = (uint32_t)&USART3->TDR;
 
-	/* Set source buffer */
-	DMA1_Channel2->CMAR = src;
+	/* Memory increment, memory to peripheral, transfer complete and error interrupts */
+	DMA1_Channel2->CCR = DMA1_MINC | DMA1_DIR | DMA1_CCR_TCIE | DMA1_CCR_TEIE;
 
-	/* Set length */
-	DMA1_Channel2->CNDTR = len;
+	/* Enable UART3 transmitter DMA, TXE now raises the DMA request */
+	USART3->CR3 |= USART3_CR3_DMAT;
 
-	/* Enable memory increment */
-	DMA1_Channel2->CCR |= DMA1_MINC;
+	/* Enable DMA interrupt */
+	NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+}
 
-	/* Transfer direction: From memory to peripheral */
-	DMA1_Channel2->CCR |= DMA1_DIR;
 
-	/* Enable DMA transfer complete interrupt */
-	DMA1_Channel2->CCR |= DMA1_CCR_TCIE;
+int uart3_tx_dma_submit(const uint8_t *data, uint16_t len, uart_tx_callback_t callback)
+{
+	int status = 0;
+
+	if (len == 0U) {
+		return -1;
+	}
+
+	/* The ISR consumes the queue and decides when the engine goes idle, keep it out */
+	NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+
+	if ((tx_q_head - tx_q_tail) == UART3_TX_QUEUE_DEPTH) {
+		status = -1;
+	} else {
+		tx_queue[tx_q_head & TX_Q_MASK].data = data;
+		tx_queue[tx_q_head & TX_Q_MASK].len = len;
+		tx_queue[tx_q_head & TX_Q_MASK].callback = callback;
+		tx_q_head++;
+		tx_bytes_submitted += len;
+
+		/* Engine idle: start this descriptor right away */
+		if (!tx_active) {
+			uart3_tx_dma_start(&tx_queue[tx_q_tail & TX_Q_MASK]);
+		}
+	}
 
-	/* Enable DMA1 */
-	DMA1_Channel2->CCR |= DMA1_CCR_EN;
+	NVIC_EnableIRQ(DMA1_Channel2_IRQn);
 
-	/* Enable UART3 transmitter DMA */
-	USART3->CR3 |= USART3_CR3_DMAT;
+	return status;
+}
 
-	/* Enable DMA interrupt */
+
+uint32_t uart3_tx_dma_queue_depth(void)
+{
+	return tx_q_head - tx_q_tail;
+}
+
+
+uint32_t uart3_tx_dma_bytes_in_flight(void)
+{
+	uint32_t in_flight;
+
+	/* Snapshot both counters and the active channel without the ISR moving them */
+	NVIC_DisableIRQ(DMA1_Channel2_IRQn);
+	in_flight = tx_bytes_submitted - tx_bytes_completed;
+	if (tx_active) {
+		/* Part of the active descriptor has already been moved to TDR */
+		in_flight -= tx_queue[tx_q_tail & TX_Q_MASK].len - DMA1_Channel2->CNDTR;
+	}
 	NVIC_EnableIRQ(DMA1_Channel2_IRQn);
+
+	return in_flight;
+}
+
+
+/**
+ * @brief DMA1 Channel 2 Interrupt Service Routine (ISR).
+ * Retires the active descriptor, immediately chains the next one so the
+ * USART never runs dry, and only then runs the completion callback.
+ */
+void DMA1_CH2_IRQHandler(void)
+{
+	uart_tx_desc_t done;
+
+	if (!(DMA1->ISR & (DMA1_ISR_TCIF2 | DMA1_ISR_TEIF2))) {
+		return;
+	}
+
+	/* A transfer error aborts the descriptor, it is retired all the same */
+	if (DMA1->ISR & DMA1_ISR_TEIF2) {
+		tx_errors++;
+	}
+
+	/* Clear flags */
+	DMA1->IFCR = DMA1_IFCR_CGIF2;
+
+	/* Retire the active descriptor */
+	done = tx_queue[tx_q_tail & TX_Q_MASK];
+	tx_q_tail++;
+	tx_bytes_completed += done.len;
+	tx_active = 0;
+
+	/* Chain the next descriptor before doing anything slow */
+	if (tx_q_tail != tx_q_head) {
+		uart3_tx_dma_start(&tx_queue[tx_q_tail & TX_Q_MASK]);
+	} else {
+		DMA1_Channel2->CCR &= ~DMA1_CCR_EN;
+	}
+
+	if (done.callback != NULL) {
+		done.callback(done.data, done.len);
+	}
+}
+
+
+/**
+ * @brief Loads a descriptor into DMA1 Channel 2 and starts it.
+ * The USART TXE request starts the transfer as soon as the channel is enabled,
+ * no byte has to be written to TDR by hand.
+ * @param desc Descriptor to send.
+ */
+static void uart3_tx_dma_start(const uart_tx_desc_t *desc)
+{
+	/* CMAR/CNDTR can only be written while the channel is disabled */
+	DMA1_Channel2->CCR &= ~DMA1_CCR_EN;
+
+	DMA1_Channel2->CMAR = (uint32_t)desc->data;
+	DMA1_Channel2->CNDTR = desc->len;
+
+	tx_active = 1;
+	DMA1_Channel2->CCR |= DMA1_CCR_EN;
+}
+
+
+/**
+ * @brief Starts USART3 reception on DMA1 Channel 3 in circular mode.
+ * The DMA keeps writing into rx_buf forever; the USART IDLE interrupt and the
+ * DMA half/full transfer interrupts turn whatever arrived since the last event
+ * into a span the application can consume in place.
+ */
+void uart3_rx_dma_init(void)
+{
+	/* Enable clock access to DMA */
+	RCC->AHBENR |= RCC_AHBENR_DMA1EN;
+
+	/* Disable DMA1 channel 3 (USART3_RX) */
+	DMA1_Channel3->CCR &= ~DMA1_CCR_EN;
+
+	/* Wait until DMA 1 CH3 is disabled */
+	while (DMA1_Channel3->CCR & DMA1_CCR_EN) {}
+
+	/* Set source: USART3 receive data register */
+	DMA1_Channel3->CPAR = (uint32_t)&USART3->RDR;
+
+	/* Set destination: circular RX buffer */
+	DMA1_Channel3->CMAR = (uint32_t)&rx_buf[0];
+
+	/* Set length, reloaded automatically in circular mode */
+	DMA1_Channel3->CNDTR = UART3_RX_BUF_SIZE;
+
+	/* Memory increment, peripheral to memory, circular, half and full transfer interrupts */
+	DMA1_Channel3->CCR = DMA1_MINC | DMA1_CIRC | DMA1_CCR_HTIE | DMA1_CCR_TCIE;
+
+	/* Enable DMA1 CH3 */
+	DMA1_Channel3->CCR |= DMA1_CCR_EN;
+
+	/* Clear stale flags, then let the receiver hand bytes to the DMA */
+	USART3->ICR = ICR_IDLECF | ICR_ORECF;
+	USART3->CR3 |= USART3_CR3_DMAR;
+
+	/* Enable IDLE line interrupt to close frames shorter than half a buffer */
+	USART3->CR1 |= CR1_IDLEIE;
+
+	/* Same priority for both sources so uart3_rx_process() is never re-entered */
+	NVIC_SetPriority(DMA1_Channel3_IRQn, 1);
+	NVIC_SetPriority(USART3_IRQn, 1);
+	NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+	NVIC_EnableIRQ(USART3_IRQn);
+}
+
+
+int uart3_rx_get_span(uart_rx_span_t *span)
+{
+	/* Nothing published yet */
+	if (rx_span_tail == rx_span_head) {
+		return 0;
+	}
+
+	*span = rx_spans[rx_span_tail & RX_SPAN_MASK];
+	return 1;
 }
 
+
+void uart3_rx_release(void)
+{
+	if (rx_span_tail == rx_span_head) {
+		return;
+	}
+
+	/* Give the bytes back to the DMA, then free the queue slot */
+	rx_released += rx_spans[rx_span_tail & RX_SPAN_MASK].len;
+	rx_span_tail++;
+}
+
+
+uint32_t uart3_rx_overruns(void)
+{
+	return rx_overruns;
+}
+
+
+/**
+ * @brief DMA1 Channel 3 Interrupt Service Routine (ISR).
+ * Half and full transfer events publish the bytes received in the half that
+ * has just been filled.
+ */
+void DMA1_CH3_IRQHandler(void)
+{
+	if (DMA1->ISR & (DMA1_ISR_HTIF3 | DMA1_ISR_TCIF3)) {
+		/* Clear flags */
+		DMA1->IFCR = DMA1_IFCR_CHTIF3 | DMA1_IFCR_CTCIF3;
+
+		uart3_rx_process();
+	}
+}
+
+
+/**
+ * @brief USART3 global Interrupt Service Routine (ISR).
+ * An IDLE line after received data marks the end of a frame.
+ */
+void USART3_EXTI28_IRQHandler(void)
+{
+	if (USART3->ISR & ISR_IDLE) {
+		/* Clear flag */
+		USART3->ICR = ICR_IDLECF;
+
+		uart3_rx_process();
+	}
+
+	if (USART3->ISR & ISR_ORE) {
+		/* DMA did not keep up, a byte was lost */
+		USART3->ICR = ICR_ORECF;
+		rx_overruns++;
+	}
+}
+
+
+/**
+ * @brief Publishes everything the DMA wrote since the previous call.
+ * A run that wraps around the end of the buffer is split into two spans so
+ * every span is contiguous in memory.
+ */
+static void uart3_rx_process(void)
+{
+	/* CNDTR counts down from UART3_RX_BUF_SIZE, reloaded on wrap */
+	uint32_t pos = UART3_RX_BUF_SIZE - DMA1_Channel3->CNDTR;
+
+	if (pos == UART3_RX_BUF_SIZE) {
+		pos = 0;
+	}
+
+	if (pos == rx_last_pos) {
+		return;
+	}
+
+	if (pos > rx_last_pos) {
+		uart3_rx_publish(rx_last_pos, pos - rx_last_pos);
+	} else {
+		/* Tail of the buffer first, then the wrapped part */
+		uart3_rx_publish(rx_last_pos, UART3_RX_BUF_SIZE - rx_last_pos);
+		if (pos > 0U) {
+			uart3_rx_publish(0, pos);
+		}
+	}
+
+	rx_last_pos = pos;
+}
+
+
+/**
+ * @brief Queues one contiguous region of rx_buf as a span for the application.
+ * @param start Offset of the first byte in rx_buf.
+ * @param len Number of bytes in the span.
+ */
+static void uart3_rx_publish(uint32_t start, uint32_t len)
+{
+	/* The DMA has caught up with bytes the application still holds, the frame is lost */
+	if ((rx_published - rx_released) + len > UART3_RX_BUF_SIZE) {
+		rx_overruns++;
+		return;
+	}
+
+	/* No room in the span queue, the frame is lost */
+	if ((rx_span_head - rx_span_tail) == UART3_RX_SPAN_QUEUE) {
+		rx_overruns++;
+		return;
+	}
+
+	rx_spans[rx_span_head & RX_SPAN_MASK].data = &rx_buf[start];
+	rx_spans[rx_span_head & RX_SPAN_MASK].len = (uint16_t)len;
+	rx_published += len;
+
+	/* Span must be complete before the consumer can see the new head */
+	__DMB();
+	rx_span_head++;
+}
+
+
 /**
  * @brief Initializes USART3 for both transmit (TX) and receive (RX) functionality.
  * Configures GPIO pins PB10 (TX) and PB11 (RX) for Alternate Function 7 (AF7),
@@ -129,8 +440,8 @@ void uart3_tx_rx_init(void)
     /* Enable clock access to USART3 */
     RCC->APB1ENR |= USART3EN;
 
-    /* Configure baud rate */
-    uart_set_baudrate(USART3, APB1_CLK, UART_BAUDRATE);
+    /* Configure baud rate, BRR is resolved from PCLK1 at compile time */
+    USART3->BRR = UART3_BRR_VAL;
 
     /* Configure the transfer direction for both transmitter and receiver */
     USART3->CR1 = (CR1_TE |  CR1_RE);
@@ -171,33 +482,3 @@ void uart3_write(int ch)
     /* Write to transmit data register */
     USART3->TDR = (ch & 0xFF);
 }
-
-
-
-/**
- * @brief Sets the baud rate for the specified UART peripheral.
- * @param USARTx Pointer to the USART peripheral (e.g., USART3).
- * @param PeriphClk The peripheral clock frequency feeding the UART.
- * @param BaudRate The desired baud rate.
- */
-static void uart_set_baudrate(USART_TypeDef *USARTx, uint32_t PeriphClk, uint32_t BaudRate)
-{
-	USARTx->BRR = compute_uart_bd(PeriphClk, BaudRate);
-}
-
-
-
-/**
- * @brief Computes the value for the USART Baud Rate Register (BRR).
- * This calculation performs integer division with rounding for simplicity.
- * For high precision, refer to the MCU's reference manual for fractional baud rate settings.
- * @param PeriphClk The peripheral clock frequency.
- * @param BaudRate The desired baud rate.
- * @return The calculated 16-bit value for the BRR register.
- */
-static uint16_t compute_uart_bd(uint32_t PeriphClk, uint32_t BaudRate)
-{
-    // Calculation: BRR = PeriphClk / BaudRate
-    // Adding (BaudRate / 2U) before division performs rounding to the nearest integer.
-    return ((PeriphClk + (BaudRate / 2U)) / BaudRate);
-}
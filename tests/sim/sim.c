@@ -0,0 +1,299 @@
+/***************************************************************************
+ * File name     :  sim.c
+ * Description   :  Register blocks of the host build and the simulated
+ *                  NVIC. Registers are plain memory: writes stick and
+ *                  nothing sets a flag on its own, the test plays the
+ *                  hardware side by writing status bits and calling the
+ *                  driver's interrupt handlers.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "sim.h"
+
+#define SIM_STACK_SIZE  (256U * 1024U)
+
+RCC_TypeDef sim_RCC;
+GPIO_TypeDef sim_GPIOA, sim_GPIOB, sim_GPIOC;
+USART_TypeDef sim_USART3;
+DMA_TypeDef sim_DMA1;
+DMA_Channel_TypeDef sim_DMA1_Channel[7];
+I2C_TypeDef sim_I2C1;
+EXTI_TypeDef sim_EXTI;
+SYSCFG_TypeDef sim_SYSCFG;
+TIM_TypeDef sim_TIM1, sim_TIM2, sim_TIM3;
+ADC_TypeDef sim_ADC1, sim_ADC2;
+ADC_Common_TypeDef sim_ADC12_COMMON;
+RTC_TypeDef sim_RTC;
+PWR_TypeDef sim_PWR;
+FLASH_TypeDef sim_FLASH;
+SCB_Type sim_SCB;
+SysTick_Type sim_SysTick;
+NVIC_Type sim_NVIC;
+DWT_Type sim_DWT;
+CoreDebug_Type sim_CoreDebug;
+
+volatile uint32_t sim_primask;
+void (*sim_wfi_hook)(void);
+void (*sim_unmask_hook)(void);
+uint32_t sim_cyccnt_step = 1U;
+int check_failures;
+
+static uint8_t sim_stack[SIM_STACK_SIZE] __attribute__((aligned(16)));
+static ucontext_t sim_ctx_main;
+static ucontext_t sim_ctx_body;
+static int (*sim_body)(void);
+static int sim_body_result;
+
+#define IRQ_WORD(irq)   ((uint32_t)(irq) >> 5)
+#define IRQ_BIT(irq)    (1U << ((uint32_t)(irq) & 0x1FU))
+#define IRQ_COUNT       (sizeof(sim_NVIC.IP))
+#define THREAD_LEVEL    0x100U      // Below every interrupt priority
+
+static void (*sim_vector[IRQ_COUNT])(void);
+
+static uint32_t sim_exec_level(void);
+
+
+void sim_reset(void)
+{
+	memset(&sim_RCC, 0, sizeof(sim_RCC));
+	memset(&sim_GPIOA, 0, sizeof(sim_GPIOA));
+	memset(&sim_GPIOB, 0, sizeof(sim_GPIOB));
+	memset(&sim_GPIOC, 0, sizeof(sim_GPIOC));
+	memset(&sim_USART3, 0, sizeof(sim_USART3));
+	memset(&sim_DMA1, 0, sizeof(sim_DMA1));
+	memset(sim_DMA1_Channel, 0, sizeof(sim_DMA1_Channel));
+	memset(&sim_I2C1, 0, sizeof(sim_I2C1));
+	memset(&sim_EXTI, 0, sizeof(sim_EXTI));
+	memset(&sim_SYSCFG, 0, sizeof(sim_SYSCFG));
+	memset(&sim_TIM1, 0, sizeof(sim_TIM1));
+	memset(&sim_TIM2, 0, sizeof(sim_TIM2));
+	memset(&sim_TIM3, 0, sizeof(sim_TIM3));
+	memset(&sim_ADC1, 0, sizeof(sim_ADC1));
+	memset(&sim_ADC2, 0, sizeof(sim_ADC2));
+	memset(&sim_ADC12_COMMON, 0, sizeof(sim_ADC12_COMMON));
+	memset(&sim_RTC, 0, sizeof(sim_RTC));
+	memset(&sim_PWR, 0, sizeof(sim_PWR));
+	memset(&sim_FLASH, 0, sizeof(sim_FLASH));
+	memset(&sim_SCB, 0, sizeof(sim_SCB));
+	memset(&sim_SysTick, 0, sizeof(sim_SysTick));
+	memset(&sim_NVIC, 0, sizeof(sim_NVIC));
+	memset(&sim_DWT, 0, sizeof(sim_DWT));
+	memset(&sim_CoreDebug, 0, sizeof(sim_CoreDebug));
+
+	sim_primask = 0;
+	sim_wfi_hook = NULL;
+	sim_unmask_hook = NULL;
+	sim_cyccnt_step = 1U;
+	memset(sim_vector, 0, sizeof(sim_vector));
+}
+
+
+void sim_wfi(void)
+{
+	if (sim_wfi_hook != NULL) {
+		sim_wfi_hook();
+	}
+}
+
+
+void sim_irq_check(void)
+{
+	/* Highest priority (lowest value, then lowest number) first, until nothing more can be taken */
+	for (;;) {
+		uint32_t best = IRQ_COUNT;
+
+		for (uint32_t irq = 0; irq < IRQ_COUNT; irq++) {
+			if ((sim_vector[irq] != NULL) && NVIC_GetPendingIRQ((IRQn_Type)irq) &&
+			    sim_irq_can_take((IRQn_Type)irq) &&
+			    ((best == IRQ_COUNT) || (sim_NVIC.IP[irq] < sim_NVIC.IP[best]))) {
+				best = irq;
+			}
+		}
+		if (best == IRQ_COUNT) {
+			break;
+		}
+
+		NVIC_ClearPendingIRQ((IRQn_Type)best);
+		sim_NVIC.IABR[IRQ_WORD(best)] |= IRQ_BIT(best);
+		sim_vector[best]();
+		sim_NVIC.IABR[IRQ_WORD(best)] &= ~IRQ_BIT(best);
+	}
+
+	if (sim_unmask_hook != NULL) {
+		sim_unmask_hook();
+	}
+}
+
+
+void sim_set_vector(IRQn_Type irq, void (*handler)(void))
+{
+	sim_vector[(uint32_t)irq] = handler;
+}
+
+
+int sim_irq_can_take(IRQn_Type irq)
+{
+	return !sim_primask && sim_irq_enabled(irq) && (sim_NVIC.IP[(uint32_t)irq] < sim_exec_level());
+}
+
+
+void sim_irq_enter(IRQn_Type irq)
+{
+	sim_NVIC.IABR[IRQ_WORD(irq)] |= IRQ_BIT(irq);
+}
+
+
+void sim_irq_exit(IRQn_Type irq)
+{
+	sim_NVIC.IABR[IRQ_WORD(irq)] &= ~IRQ_BIT(irq);
+	sim_irq_check();
+}
+
+
+/**
+ * @brief Priority of the most urgent active handler, THREAD_LEVEL if none.
+ */
+static uint32_t sim_exec_level(void)
+{
+	uint32_t level = THREAD_LEVEL;
+
+	for (uint32_t irq = 0; irq < IRQ_COUNT; irq++) {
+		if ((sim_NVIC.IABR[IRQ_WORD(irq)] & IRQ_BIT(irq)) && (sim_NVIC.IP[irq] < level)) {
+			level = sim_NVIC.IP[irq];
+		}
+	}
+	return level;
+}
+
+
+DWT_Type *sim_dwt(void)
+{
+	sim_DWT.CYCCNT += sim_cyccnt_step;
+	return &sim_DWT;
+}
+
+
+void *sim_ptr(uint32_t addr)
+{
+	return (void *)(uintptr_t)addr;
+}
+
+
+static void sim_body_entry(void)
+{
+	sim_body_result = sim_body();
+}
+
+
+int sim_run_low_stack(int (*body)(void))
+{
+	sim_body = body;
+	getcontext(&sim_ctx_body);
+	sim_ctx_body.uc_stack.ss_sp = sim_stack;
+	sim_ctx_body.uc_stack.ss_size = sizeof(sim_stack);
+	sim_ctx_body.uc_link = &sim_ctx_main;
+	makecontext(&sim_ctx_body, sim_body_entry, 0);
+	swapcontext(&sim_ctx_main, &sim_ctx_body);
+	return sim_body_result;
+}
+
+
+int sim_irq_enabled(IRQn_Type irq)
+{
+	return (sim_NVIC.ISER[IRQ_WORD(irq)] & IRQ_BIT(irq)) ? 1 : 0;
+}
+
+
+/* --- Simulated NVIC: ISER holds the enable state, ISPR the pending state, IABR the active state --- */
+void NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+	sim_SCB.AIRCR = (PriorityGroup & 7U) << SCB_AIRCR_PRIGROUP_Pos;
+}
+
+uint32_t NVIC_GetPriorityGrouping(void)
+{
+	return (sim_SCB.AIRCR & SCB_AIRCR_PRIGROUP_Msk) >> SCB_AIRCR_PRIGROUP_Pos;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+	sim_NVIC.ISER[IRQ_WORD(IRQn)] |= IRQ_BIT(IRQn);
+	sim_irq_check();
+}
+
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+	return (uint32_t)sim_irq_enabled(IRQn);
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+	sim_NVIC.ISER[IRQ_WORD(IRQn)] &= ~IRQ_BIT(IRQn);
+}
+
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+	return (sim_NVIC.ISPR[IRQ_WORD(IRQn)] & IRQ_BIT(IRQn)) ? 1U : 0U;
+}
+
+void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+	sim_NVIC.ISPR[IRQ_WORD(IRQn)] |= IRQ_BIT(IRQn);
+	sim_irq_check();
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+	sim_NVIC.ISPR[IRQ_WORD(IRQn)] &= ~IRQ_BIT(IRQn);
+}
+
+uint32_t NVIC_GetActive(IRQn_Type IRQn)
+{
+	return (sim_NVIC.IABR[IRQ_WORD(IRQn)] & IRQ_BIT(IRQn)) ? 1U : 0U;
+}
+
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+	if ((int32_t)IRQn >= 0) {
+		sim_NVIC.IP[(uint32_t)IRQn] = (uint8_t)(priority << (8U - __NVIC_PRIO_BITS));
+	}
+}
+
+uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+	return ((int32_t)IRQn >= 0) ? ((uint32_t)sim_NVIC.IP[(uint32_t)IRQn] >> (8U - __NVIC_PRIO_BITS)) : 0U;
+}
+
+void NVIC_SystemReset(void)
+{
+	fprintf(stderr, "NVIC_SystemReset called\n");
+	exit(2);
+}
+
+
+/* --- Checks --- */
+void check_fail(const char *file, int line, const char *expr, long long actual, long long expected)
+{
+	check_failures++;
+	if ((actual == 0) && (expected == 0)) {
+		fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+	} else {
+		fprintf(stderr, "%s:%d: check failed: %s (got %lld, expected %lld)\n", file, line, expr, actual, expected);
+	}
+}
+
+int check_done(const char *name)
+{
+	if (check_failures != 0) {
+		printf("%s: %d check(s) failed\n", name, check_failures);
+		return 1;
+	}
+	printf("%s: passed\n", name);
+	return 0;
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+ * File name     :  sim.h
+ * Description   :  Host test support: reset of the simulated register
+ *                  blocks and NVIC, helpers for simulated DMA masters, and
+ *                  the CHECK macros every test uses. A test returns
+ *                  check_done() from main, non-zero if any check failed.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include "stm32f3xx.h"
+
+/* --- Simulated core and peripherals --- */
+
+/**
+ * @brief Clears every register block, the NVIC and PRIMASK, and the hooks.
+ */
+void sim_reset(void);
+
+/**
+ * @brief Runs in place of WFI/WFE, typically to advance time or raise an
+ * interrupt. NULL makes WFI return immediately.
+ */
+extern void (*sim_wfi_hook)(void);
+
+/**
+ * @brief Runs wherever the core could take an interrupt: PRIMASK cleared, an
+ * NVIC enable or pend, the end of a handler. A simulated peripheral uses it
+ * to make progress while a driver waits on it.
+ */
+extern void (*sim_unmask_hook)(void);
+
+/**
+ * @brief Installs the handler the simulated NVIC runs for irq once it is
+ * pending, enabled, unmasked and above the current execution priority.
+ * Pend it with NVIC_SetPendingIRQ(), as software or a peripheral would.
+ */
+void sim_set_vector(IRQn_Type irq, void (*handler)(void));
+
+/**
+ * @brief Returns 1 if irq would be taken now if it were pending: enabled,
+ * PRIMASK clear and its priority above every active handler.
+ */
+int sim_irq_can_take(IRQn_Type irq);
+
+/**
+ * @brief Marks irq active around test code that plays its handler, so equal
+ * and lower priorities wait; sim_irq_exit() then takes what was pended.
+ */
+void sim_irq_enter(IRQn_Type irq);
+void sim_irq_exit(IRQn_Type irq);
+
+/**
+ * @brief Cycles CYCCNT advances on every access to DWT (1 after reset), so
+ * busy-waits and deadlines on the cycle counter run out on the host too.
+ */
+extern uint32_t sim_cyccnt_step;
+
+/**
+ * @brief Memory behind an address a driver wrote to CPAR/CMAR. The tests
+ * link without PIE so static data sits below 4 GB and survives the cast.
+ */
+void *sim_ptr(uint32_t addr);
+
+/**
+ * @brief Runs a test body on a stack in static memory, below 4 GB like the
+ * rest of the data, for drivers that hand stack buffers to the DMA.
+ * @return What body returned.
+ */
+int sim_run_low_stack(int (*body)(void));
+
+/**
+ * @brief Returns 1 if the interrupt is enabled in the simulated NVIC.
+ */
+int sim_irq_enabled(IRQn_Type irq);
+
+
+/* --- Checks --- */
+extern int check_failures;
+
+void check_fail(const char *file, int line, const char *expr, long long actual, long long expected);
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            check_fail(__FILE__, __LINE__, #cond, 0, 0);                    \
+        }                                                                   \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                          \
+    do {                                                                    \
+        long long check_a_ = (long long)(actual);                           \
+        long long check_e_ = (long long)(expected);                         \
+        if (check_a_ != check_e_) {                                         \
+            check_fail(__FILE__, __LINE__, #actual " == " #expected, check_a_, check_e_); \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief Prints the result line of a test.
+ * @return Process exit status, 0 when every check passed.
+ */
+int check_done(const char *name);
+
+#endif /* SIM_H_ */
@@ -0,0 +1,283 @@
+/***************************************************************************
+ * File name     :  sim_i2c.c
+ * Description   :  Simulated I2C1 bus and register-file slave, see
+ *                  sim_i2c.h. One phase of a transaction runs per START:
+ *                  address, NBYTES chunks with a TCR between them, then STOP
+ *                  (AUTOEND) or TC for a repeated START. A DMA channel moves
+ *                  its bytes from or to the buffer it was armed with and
+ *                  raises transfer complete when CNDTR reaches zero. An
+ *                  injected fault raises its flag through the handler that
+ *                  serves it in hardware and ends the phase.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "sim.h"
+#include "sim_i2c.h"
+#include "i2c.h"
+
+#define I2C_ADDR(cr2)       (((cr2) >> 1) & 0x7FU)
+#define I2C_NBYTES(cr2)     (((cr2) & CR2_NBYTES_MASK) >> CR2_NBYTES_POS)
+#define PIN_SDA             (1U << 9)   // PB9
+
+void I2C1_EV_EXTI23_IRQHandler(void);
+void I2C1_ER_IRQHandler(void);
+void DMA1_CH6_IRQHandler(void);
+void DMA1_CH7_IRQHandler(void);
+
+sim_i2c_t sim_i2c;
+
+/**
+ * Where a channel is inside the buffer it was last armed with. The DMA
+ * counts CNDTR down and keeps CMAR, so a new arm shows as another CMAR or
+ * CNDTR going up.
+ */
+typedef struct {
+	uint32_t cmar;
+	uint32_t len;
+	uint32_t last;
+} dma_track_t;
+
+static dma_track_t dma_tx;
+static dma_track_t dma_rx;
+static uint8_t running;
+
+/* --- Static function prototypes (helper functions local to this file) --- */
+static void bus_unmasked(void);
+static int bus_phase(void);
+static int bus_fault(int read);
+static void bus_stop(void);
+static uint8_t *dma_next(DMA_Channel_TypeDef *ch, dma_track_t *t);
+static void i2c_event(uint32_t flags);
+
+
+void sim_i2c_attach(uint8_t addr)
+{
+	memset(&sim_i2c, 0, sizeof(sim_i2c));
+	memset(&dma_tx, 0, sizeof(dma_tx));
+	memset(&dma_rx, 0, sizeof(dma_rx));
+	running = 0;
+
+	sim_i2c.addr = addr;
+	GPIOB->IDR |= PIN_SDA;
+	sim_unmask_hook = bus_unmasked;
+	sim_set_vector(I2C1_EV_IRQn, I2C1_EV_EXTI23_IRQHandler);
+}
+
+
+void sim_i2c_run(void)
+{
+	if (running) {
+		return;
+	}
+
+	running = 1;
+	sim_i2c.hold = 0;
+
+	/* The bus events are served at the I2C1 interrupt priority */
+	sim_irq_enter(I2C1_EV_IRQn);
+
+	/* Every phase ends in STOP or TC; the driver answers with the next START or nothing */
+	while ((I2C1->CR1 & CR1_PE) && (I2C1->CR2 & CR2_START)) {
+		if (!bus_phase()) {
+			break;
+		}
+	}
+
+	running = 0;
+	sim_irq_exit(I2C1_EV_IRQn);
+}
+
+
+/**
+ * @brief Pending I2C1 work is served once the event interrupt can be taken.
+ */
+static void bus_unmasked(void)
+{
+	if (!sim_i2c.hold && (I2C1->CR2 & CR2_START) && sim_irq_can_take(I2C1_EV_IRQn)) {
+		sim_i2c_run();
+	}
+}
+
+
+/**
+ * @brief Runs one START ... STOP/TC phase as programmed in CR2.
+ * @return 0 if the bus stalled on a DMA channel that was not ready.
+ */
+static int bus_phase(void)
+{
+	uint32_t cr2 = I2C1->CR2;
+	int read = (cr2 & CR2_RD_WRN) != 0U;
+	int first = !read;      // The first byte of a write sets the register pointer
+
+	I2C1->CR2 = cr2 & ~CR2_START;
+
+	/* Nobody answers: NACK, and the hardware sends STOP on its own */
+	if (I2C_ADDR(cr2) != sim_i2c.addr) {
+		i2c_event(ISR_NACKF);
+		bus_stop();
+		return 1;
+	}
+
+	sim_i2c.starts++;
+
+	for (;;) {
+		uint32_t nbytes = I2C_NBYTES(I2C1->CR2);
+
+		for (uint32_t i = 0; i < nbytes; i++) {
+			uint8_t *p;
+
+			/* A NACK can only come from the slave, on a byte written to it */
+			if ((sim_i2c.fault != SIM_I2C_FAULT_NONE) && !(read && (sim_i2c.fault == SIM_I2C_FAULT_NACK))) {
+				if (sim_i2c.fault_after == 0U) {
+					return bus_fault(read);
+				}
+				sim_i2c.fault_after--;
+			}
+
+			p = read ? dma_next(DMA1_Channel7, &dma_rx) : dma_next(DMA1_Channel6, &dma_tx);
+
+			if (p == NULL) {
+				sim_i2c.stalls++;
+				return 0;
+			}
+
+			if (read) {
+				*p = (sim_i2c.read_reg != NULL) ? sim_i2c.read_reg(&sim_i2c.ptr) : sim_i2c.regs[sim_i2c.ptr++];
+				sim_i2c.read++;
+			} else if (first) {
+				sim_i2c.ptr = *p;
+				sim_i2c.written++;
+				first = 0;
+			} else {
+				if (sim_i2c.write_reg != NULL) {
+					sim_i2c.write_reg(&sim_i2c.ptr, *p);
+				} else {
+					sim_i2c.regs[sim_i2c.ptr++] = *p;
+				}
+				sim_i2c.written++;
+			}
+
+			/* Channel 6 interrupts on transfer complete, after the byte went out */
+			if (!read && (DMA1_Channel6->CNDTR == 0U) && (DMA1_Channel6->CCR & DMA1_CCR_TCIE)) {
+				DMA1->ISR |= DMA1_ISR_TCIF6;
+				DMA1_CH6_IRQHandler();
+				DMA1->ISR &= ~DMA1_ISR_TCIF6;
+			}
+		}
+
+		cr2 = I2C1->CR2;
+		if (cr2 & CR2_RELOAD) {
+			sim_i2c.reloads++;
+			i2c_event(ISR_TCR);
+			continue;
+		}
+
+		if (cr2 & CR2_AUTOEND) {
+			bus_stop();
+		} else {
+			sim_i2c.restarts++;
+			i2c_event(ISR_TC);
+		}
+		return 1;
+	}
+}
+
+
+/**
+ * @brief Injects the pending fault in place of the next data byte.
+ * @return 0 if the bus hangs, 1 if the phase ended.
+ */
+static int bus_fault(int read)
+{
+	static const uint32_t er_flags[] = {
+		[SIM_I2C_FAULT_BERR]    = ISR_BERR,
+		[SIM_I2C_FAULT_ARLO]    = ISR_ARLO,
+		[SIM_I2C_FAULT_OVR]     = ISR_OVR,
+		[SIM_I2C_FAULT_TIMEOUT] = ISR_TIMEOUT,
+	};
+	sim_i2c_fault_t fault = sim_i2c.fault;
+
+	sim_i2c.fault = SIM_I2C_FAULT_NONE;
+
+	switch (fault) {
+	case SIM_I2C_FAULT_NACK:
+		i2c_event(ISR_NACKF);
+		bus_stop();
+		return 1;
+
+	case SIM_I2C_FAULT_DMA:
+		DMA1->ISR |= read ? DMA1_ISR_TEIF7 : DMA1_ISR_TEIF6;
+		if (read) {
+			DMA1_CH7_IRQHandler();
+		} else {
+			DMA1_CH6_IRQHandler();
+		}
+		DMA1->ISR &= ~(DMA1_ISR_TEIF6 | DMA1_ISR_TEIF7);
+
+		/* The driver asked for a STOP to end the transaction */
+		if (I2C1->CR2 & CR2_STOP) {
+			I2C1->CR2 &= ~CR2_STOP;
+			bus_stop();
+		}
+		return 1;
+
+	case SIM_I2C_FAULT_HANG:
+		sim_i2c.hold = 1;
+		return 0;
+
+	default:
+		/* Error interrupt; the hardware releases the bus without a STOP */
+		I2C1->ISR |= er_flags[fault];
+		I2C1_ER_IRQHandler();
+		I2C1->ISR &= ~er_flags[fault];
+		return 1;
+	}
+}
+
+
+/**
+ * @brief STOP on the bus, reported with STOPF.
+ */
+static void bus_stop(void)
+{
+	sim_i2c.stops++;
+	i2c_event(ISR_STOPF);
+}
+
+
+/**
+ * @brief Next byte of a DMA channel's memory buffer, counting CNDTR down.
+ * @return NULL if the channel is disabled or has nothing left.
+ */
+static uint8_t *dma_next(DMA_Channel_TypeDef *ch, dma_track_t *t)
+{
+	uint8_t *p;
+
+	if (!(ch->CCR & DMA1_CCR_EN) || (ch->CNDTR == 0U)) {
+		return NULL;
+	}
+
+	if ((ch->CMAR != t->cmar) || (ch->CNDTR > t->last)) {
+		t->cmar = ch->CMAR;
+		t->len = ch->CNDTR;
+	}
+
+	p = (uint8_t *)sim_ptr(ch->CMAR) + (t->len - ch->CNDTR);
+	ch->CNDTR--;
+	t->last = ch->CNDTR;
+	return p;
+}
+
+
+/**
+ * @brief Raises I2C1 event flags for one run of the event interrupt.
+ */
+static void i2c_event(uint32_t flags)
+{
+	I2C1->ISR |= flags;
+	I2C1_EV_EXTI23_IRQHandler();
+	I2C1->ISR &= ~flags;
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+ * File name     :  sim_i2c.h
+ * Description   :  Simulated I2C1 bus master side and a register-file slave
+ *                  for the host tests of projects/i2c_mpu6050/Src/i2c.c.
+ *                  The bus reads what the driver programmed into CR2, moves
+ *                  the bytes through DMA1 Channel 6/7 the way the hardware
+ *                  does, and raises TCR/TC/STOPF/NACKF through the driver's
+ *                  interrupt handlers. It runs whenever the driver unmasks
+ *                  its interrupts, so blocking calls complete on the host.
+ *                  Faults (data NACK, BERR, ARLO, OVR, SCL-low timeout, DMA
+ *                  error, a slave that stops responding) can be injected at
+ *                  any byte of a transaction.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef SIM_I2C_H_
+#define SIM_I2C_H_
+
+#include <stdint.h>
+
+/**
+ * @brief Faults the bus can inject, once, when sim_i2c.fault_after reaches 0.
+ */
+typedef enum {
+    SIM_I2C_FAULT_NONE = 0,
+    SIM_I2C_FAULT_NACK,         // Slave NACKs the next byte written to it
+    SIM_I2C_FAULT_BERR,         // Misplaced START/STOP
+    SIM_I2C_FAULT_ARLO,         // Another master wins arbitration
+    SIM_I2C_FAULT_OVR,          // Overrun/underrun
+    SIM_I2C_FAULT_TIMEOUT,      // Slave holds SCL low, caught by the hardware timeout
+    SIM_I2C_FAULT_DMA,          // Transfer error on the active DMA channel
+    SIM_I2C_FAULT_HANG          // Slave stops responding and no flag is ever raised
+} sim_i2c_fault_t;
+
+/**
+ * @brief One slave with a 256-byte register file. The first byte of a write
+ * sets the register pointer, the following bytes are stored at it, and a read
+ * returns bytes from it; the pointer increments after every byte.
+ * A device model can take over register access (FIFO ports, self-clearing
+ * bits) through read_reg/write_reg, which then move the pointer themselves.
+ */
+typedef struct {
+    uint8_t addr;           // 7-bit address the slave answers
+    uint8_t regs[256];      // Register file
+    uint8_t ptr;            // Register pointer
+    uint8_t hold;           // Non-zero: the bus makes no progress until sim_i2c_run()
+
+    /* Device model, NULL for the plain register file */
+    uint8_t (*read_reg)(uint8_t *ptr);
+    void (*write_reg)(uint8_t *ptr, uint8_t value);
+
+    /* Fault injection */
+    sim_i2c_fault_t fault;  // Injected once, then reset to SIM_I2C_FAULT_NONE
+    uint32_t fault_after;   // Data bytes still moved before the fault hits
+
+    /* Bus log */
+    uint32_t starts;        // START and repeated START conditions with an ACKed address
+    uint32_t stops;         // STOP conditions
+    uint32_t reloads;       // TCR events, one per NBYTES reload
+    uint32_t restarts;      // TC events turning a write around into a read
+    uint32_t written;       // Data bytes written to the slave, register pointer included
+    uint32_t read;          // Data bytes read from the slave
+    uint32_t stalls;        // Bus needed a byte but the DMA channel was not ready
+} sim_i2c_t;
+
+extern sim_i2c_t sim_i2c;
+
+/**
+ * @brief Resets the slave and the bus log, releases SDA in GPIOB->IDR and
+ * lets the bus run whenever the driver unmasks its interrupts.
+ * Call after sim_reset().
+ * @param addr 7-bit slave address.
+ */
+void sim_i2c_attach(uint8_t addr);
+
+/**
+ * @brief Runs every transaction the driver has started, including the ones
+ * it chains from its interrupt handlers, until the bus is idle.
+ * Clears sim_i2c.hold first.
+ */
+void sim_i2c_run(void);
+
+#endif /* SIM_I2C_H_ */
@@ -0,0 +1,27 @@
+/***************************************************************************
+ * File name     :  sim_nvic.h
+ * Description   :  NVIC functions of the host build, pulled into
+ *                  core_cm4.h through CMSIS_NVIC_VIRTUAL. They keep the
+ *                  enable, pending and priority state of the simulated
+ *                  interrupt controller in sim.c.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef SIM_NVIC_H_
+#define SIM_NVIC_H_
+
+void NVIC_SetPriorityGrouping(uint32_t PriorityGroup);
+uint32_t NVIC_GetPriorityGrouping(void);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t NVIC_GetActive(IRQn_Type IRQn);
+void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority);
+uint32_t NVIC_GetPriority(IRQn_Type IRQn);
+void NVIC_SystemReset(void);
+
+#endif /* SIM_NVIC_H_ */
@@ -0,0 +1,178 @@
+/***************************************************************************
+ * File name     :  stm32f3xx.h
+ * Description   :  Host build replacement for the device header, found
+ *                  ahead of include/stm32f3xx.h by the tests only. The
+ *                  register layouts come from the real stm32f303xe.h, the
+ *                  core intrinsics are plain C on a simulated PRIMASK, and
+ *                  every peripheral instance points at a register block in
+ *                  RAM (sim.c) that a test drives and inspects.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#ifndef STM32F3XX_HOST_H_
+#define STM32F3XX_HOST_H_
+
+#include <stdint.h>
+
+/* --- cmsis_gcc.h replacement, its include guard keeps the ARM one out --- */
+#define __CMSIS_GCC_H
+
+#define __ASM                   __asm
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline
+#define __NO_RETURN             __attribute__((__noreturn__))
+#define __USED                  __attribute__((used))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT         struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION          union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __RESTRICT              __restrict
+#define __COMPILER_BARRIER()    __asm volatile("" ::: "memory")
+
+/* Interrupt mask of the simulated core, 1 = masked */
+extern volatile uint32_t sim_primask;
+
+/* Called for WFI/WFE; runs the test's hook, if any, in place of sleeping */
+void sim_wfi(void);
+
+/* Takes pending interrupts; called wherever the core could take one (unmask, pend, handler exit) */
+void sim_irq_check(void);
+
+#define __NOP()                 __COMPILER_BARRIER()
+#define __DSB()                 __COMPILER_BARRIER()
+#define __DMB()                 __COMPILER_BARRIER()
+#define __ISB()                 __COMPILER_BARRIER()
+#define __WFI()                 sim_wfi()
+#define __WFE()                 sim_wfi()
+#define __SEV()                 __COMPILER_BARRIER()
+
+static inline uint32_t __get_PRIMASK(void)      { return sim_primask; }
+static inline void __disable_irq(void)          { sim_primask = 1U; }
+
+static inline void __set_PRIMASK(uint32_t mask)
+{
+    uint32_t was = sim_primask;
+
+    sim_primask = mask & 1U;
+    if (was && !sim_primask) {
+        sim_irq_check();
+    }
+}
+
+static inline void __enable_irq(void)           { __set_PRIMASK(0U); }
+
+static inline uint32_t __CLZ(uint32_t value)
+{
+    return (value != 0U) ? (uint32_t)__builtin_clz(value) : 32U;
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32U; i++) {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+    return result;
+}
+
+/* Single core, no other bus master touches exclusive data: never fails */
+static inline uint32_t __LDREXW(volatile uint32_t *addr)             { return *addr; }
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) { *addr = value; return 0U; }
+static inline uint16_t __LDREXH(volatile uint16_t *addr)             { return *addr; }
+static inline uint32_t __STREXH(uint16_t value, volatile uint16_t *addr) { *addr = value; return 0U; }
+static inline void __CLREX(void) {}
+
+/* --- NVIC access goes to the simulated controller in sim.c --- */
+#define CMSIS_NVIC_VIRTUAL
+#define CMSIS_NVIC_VIRTUAL_HEADER_FILE  "sim_nvic.h"
+
+#include <stm32f303xe.h>
+
+/* --- Peripheral instances, redirected to the register blocks in sim.c --- */
+extern RCC_TypeDef sim_RCC;
+extern GPIO_TypeDef sim_GPIOA, sim_GPIOB, sim_GPIOC;
+extern USART_TypeDef sim_USART3;
+extern DMA_TypeDef sim_DMA1;
+extern DMA_Channel_TypeDef sim_DMA1_Channel[7];
+extern I2C_TypeDef sim_I2C1;
+extern EXTI_TypeDef sim_EXTI;
+extern SYSCFG_TypeDef sim_SYSCFG;
+extern TIM_TypeDef sim_TIM1, sim_TIM2, sim_TIM3;
+extern ADC_TypeDef sim_ADC1, sim_ADC2;
+extern ADC_Common_TypeDef sim_ADC12_COMMON;
+extern RTC_TypeDef sim_RTC;
+extern PWR_TypeDef sim_PWR;
+extern FLASH_TypeDef sim_FLASH;
+extern SCB_Type sim_SCB;
+extern SysTick_Type sim_SysTick;
+extern NVIC_Type sim_NVIC;
+extern DWT_Type sim_DWT;
+DWT_Type *sim_dwt(void);
+extern CoreDebug_Type sim_CoreDebug;
+
+#undef RCC
+#define RCC                 (&sim_RCC)
+#undef GPIOA
+#define GPIOA               (&sim_GPIOA)
+#undef GPIOB
+#define GPIOB               (&sim_GPIOB)
+#undef GPIOC
+#define GPIOC               (&sim_GPIOC)
+#undef USART3
+#define USART3              (&sim_USART3)
+#undef DMA1
+#define DMA1                (&sim_DMA1)
+#undef DMA1_Channel1
+#define DMA1_Channel1       (&sim_DMA1_Channel[0])
+#undef DMA1_Channel2
+#define DMA1_Channel2       (&sim_DMA1_Channel[1])
+#undef DMA1_Channel3
+#define DMA1_Channel3       (&sim_DMA1_Channel[2])
+#undef DMA1_Channel4
+#define DMA1_Channel4       (&sim_DMA1_Channel[3])
+#undef DMA1_Channel5
+#define DMA1_Channel5       (&sim_DMA1_Channel[4])
+#undef DMA1_Channel6
+#define DMA1_Channel6       (&sim_DMA1_Channel[5])
+#undef DMA1_Channel7
+#define DMA1_Channel7       (&sim_DMA1_Channel[6])
+#undef I2C1
+#define I2C1                (&sim_I2C1)
+#undef EXTI
+#define EXTI                (&sim_EXTI)
+#undef SYSCFG
+#define SYSCFG              (&sim_SYSCFG)
+#undef TIM1
+#define TIM1                (&sim_TIM1)
+#undef TIM2
+#define TIM2                (&sim_TIM2)
+#undef TIM3
+#define TIM3                (&sim_TIM3)
+#undef ADC1
+#define ADC1                (&sim_ADC1)
+#undef ADC2
+#define ADC2                (&sim_ADC2)
+#undef ADC1_2_COMMON
+#define ADC1_2_COMMON       (&sim_ADC12_COMMON)
+#undef RTC
+#define RTC                 (&sim_RTC)
+#undef PWR
+#define PWR                 (&sim_PWR)
+#undef FLASH
+#define FLASH               (&sim_FLASH)
+#undef SCB
+#define SCB                 (&sim_SCB)
+#undef SysTick
+#define SysTick             (&sim_SysTick)
+#undef NVIC
+#define NVIC                (&sim_NVIC)
+#undef DWT
+#define DWT                 (sim_dwt())     // Every access moves CYCCNT on
+#undef CoreDebug
+#define CoreDebug           (&sim_CoreDebug)
+
+#endif /* STM32F3XX_HOST_H_ */
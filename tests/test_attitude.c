@@ -0,0 +1,256 @@
+/***************************************************************************
+ * File name     :  test_attitude.c
+ * Description   :  Host test of the attitude estimator
+ *                  (projects/i2c_mpu6050/Src/attitude.c) against reference
+ *                  trajectories. The reference orientation is integrated in
+ *                  double precision at ten substeps per sample from a known
+ *                  body rate; the sensor samples the filter sees are that
+ *                  rate plus a gyro bias and the reference gravity vector,
+ *                  quantized to Q16.16 like mpu6050_CalibApply() output.
+ *                  Checks roll/pitch tracking, Mahony bias convergence, the
+ *                  complementary filter's bias-induced tilt, the accel trust
+ *                  gate, and the per-update cycle accounting; host time per
+ *                  update is printed for reference.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+#include "attitude.h"
+
+#define RATE_HZ         1000U
+#define DT              (1.0f / (float)RATE_HZ)
+#define SUBSTEPS        10U
+#define R2D             (180.0 / M_PI)
+
+typedef struct {
+	double w, x, y, z;
+} quat_t;
+
+typedef struct {
+	double t;               // s
+	quat_t q;               // Reference orientation, body to earth
+	double rate[3];         // True body rate, rad/s
+} truth_t;
+
+/* Body rate of the dynamic trajectory: a roll/pitch wobble with some yaw */
+static void rate_wobble(double t, double rate[3])
+{
+	rate[0] = 1.2 * cos(2.0 * M_PI * 0.5 * t);
+	rate[1] = 0.8 * sin(2.0 * M_PI * 0.3 * t);
+	rate[2] = 0.3 * cos(2.0 * M_PI * 0.1 * t);
+}
+
+static void rate_still(double t, double rate[3])
+{
+	rate[0] = rate[1] = rate[2] = 0.0;
+}
+
+
+/**
+ * @brief Advances the reference by one sample period with exact rotations per substep.
+ */
+static void truth_step(truth_t *tr, void (*rate_fn)(double, double[3]))
+{
+	const double h = 1.0 / RATE_HZ / SUBSTEPS;
+
+	for (uint32_t s = 0; s < SUBSTEPS; s++) {
+		double w[3];
+		double mag;
+		double c;
+		double k;
+		quat_t q = tr->q;
+		quat_t d;
+
+		rate_fn(tr->t + (s + 0.5) * h, w);
+		mag = sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+		c = cos(0.5 * mag * h);
+		k = (mag > 0.0) ? sin(0.5 * mag * h) / mag : 0.5 * h;
+		d = (quat_t){ c, w[0] * k, w[1] * k, w[2] * k };
+
+		/* q (x) d: body-frame rate */
+		tr->q.w = q.w * d.w - q.x * d.x - q.y * d.y - q.z * d.z;
+		tr->q.x = q.w * d.x + q.x * d.w + q.y * d.z - q.z * d.y;
+		tr->q.y = q.w * d.y - q.x * d.z + q.y * d.w + q.z * d.x;
+		tr->q.z = q.w * d.z + q.x * d.y - q.y * d.x + q.z * d.w;
+	}
+	tr->t += 1.0 / RATE_HZ;
+	rate_fn(tr->t, tr->rate);
+}
+
+
+/**
+ * @brief Sensor sample for the reference state: rate + bias (°/s), gravity in the body frame (g).
+ */
+static void truth_sample(const truth_t *tr, const double bias_dps[3], double accel_g, mpu6050_scaled_t *s)
+{
+	const quat_t *q = &tr->q;
+	double g[3] = {
+		2.0 * (q->x * q->z - q->w * q->y),
+		2.0 * (q->w * q->x + q->y * q->z),
+		q->w * q->w - q->x * q->x - q->y * q->y + q->z * q->z,
+	};
+
+	for (uint32_t i = 0; i < 3U; i++) {
+		s->accel[i] = (q16_t)lround(g[i] * accel_g * 65536.0);
+		s->gyro[i] = (q16_t)lround((tr->rate[i] * R2D + bias_dps[i]) * 65536.0);
+	}
+	s->temp = 0;
+}
+
+
+/**
+ * @brief Roll/pitch error in degrees between the filter and the reference.
+ */
+static double tilt_error(const truth_t *tr)
+{
+	const quat_t *q = &tr->q;
+	attitude_euler_t e;
+	double roll = atan2(2.0 * (q->w * q->x + q->y * q->z), 1.0 - 2.0 * (q->x * q->x + q->y * q->y)) * R2D;
+	double pitch = asin(2.0 * (q->w * q->y - q->z * q->x)) * R2D;
+	double er;
+	double ep;
+
+	attitude_GetEuler(&e);
+	er = fabs(remainder(e.roll - roll, 360.0));
+	ep = fabs(e.pitch - pitch);
+	return (er > ep) ? er : ep;
+}
+
+
+/**
+ * @brief Runs the filter along a reference trajectory.
+ * @return Largest tilt error in degrees after the settle time.
+ */
+static double run(attitude_filter_t filter, void (*rate_fn)(double, double[3]), const double bias_dps[3],
+                  double seconds, double settle, truth_t *tr)
+{
+	mpu6050_scaled_t s;
+	double worst = 0.0;
+
+	attitude_Init(filter);
+	*tr = (truth_t){ .q = { 1.0, 0.0, 0.0, 0.0 } };
+	rate_fn(0.0, tr->rate);
+
+	for (uint32_t n = 0; n < (uint32_t)(seconds * RATE_HZ); n++) {
+		double err;
+
+		truth_step(tr, rate_fn);
+		truth_sample(tr, bias_dps, 1.0, &s);
+		attitude_Update(&s, DT);
+
+		err = tilt_error(tr);
+		if ((tr->t >= settle) && (err > worst)) {
+			worst = err;
+		}
+	}
+	return worst;
+}
+
+
+static void test_tracking(void)
+{
+	static const double no_bias[3] = { 0.0, 0.0, 0.0 };
+	truth_t tr;
+
+	/* Exact gyro: only the first-order step and float rounding separate filter and reference */
+	CHECK(run(ATTITUDE_COMPLEMENTARY, rate_wobble, no_bias, 30.0, 0.0, &tr) < 0.2);
+	CHECK(run(ATTITUDE_MAHONY, rate_wobble, no_bias, 30.0, 0.0, &tr) < 0.2);
+}
+
+
+static void test_bias(void)
+{
+	static const double bias[3] = { 0.5, -0.3, 0.2 };
+	float q[4];
+	truth_t tr;
+	double err;
+
+	/* Complementary: a constant gyro bias leaves a standing tilt of about bias / KP */
+	err = run(ATTITUDE_COMPLEMENTARY, rate_still, bias, 60.0, 30.0, &tr);
+	CHECK(err > 0.3);
+	CHECK(err < 0.8);
+
+	/* Mahony: the integral term takes the bias out of roll and pitch */
+	err = run(ATTITUDE_MAHONY, rate_still, bias, 120.0, 90.0, &tr);
+	CHECK(err < 0.05);
+
+	/* Wobbling, the bias is observable on every axis and the tilt still converges */
+	err = run(ATTITUDE_MAHONY, rate_wobble, bias, 120.0, 90.0, &tr);
+	CHECK(err < 0.1);
+	attitude_GetQuaternion(q);
+	CHECK(fabs(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3] - 1.0) < 1e-5);
+}
+
+
+static void test_accel_gate(void)
+{
+	static const double no_bias[3] = { 0.0, 0.0, 0.0 };
+	mpu6050_scaled_t s;
+	truth_t tr;
+	double err;
+
+	/* A 3 g push along X (at least 2 g total) is not taken as gravity */
+	(void)run(ATTITUDE_MAHONY, rate_wobble, no_bias, 5.0, 0.0, &tr);
+	for (uint32_t n = 0; n < RATE_HZ; n++) {
+		truth_step(&tr, rate_wobble);
+		truth_sample(&tr, no_bias, 1.0, &s);
+		s.accel[0] += (q16_t)(3.0 * 65536.0);
+		attitude_Update(&s, DT);
+	}
+	err = tilt_error(&tr);
+	CHECK(err < 0.2);
+}
+
+
+static void test_cycles(void)
+{
+	static const double no_bias[3] = { 0.0, 0.0, 0.0 };
+	attitude_stats_t st;
+	mpu6050_scaled_t s;
+	truth_t tr = { .q = { 1.0, 0.0, 0.0, 0.0 } };
+	uint32_t n = 100000U;
+	struct timespec t0;
+	struct timespec t1;
+
+	/* The two DWT reads around an update are one step apart on the host */
+	attitude_Init(ATTITUDE_MAHONY);
+	truth_sample(&tr, no_bias, 1.0, &s);
+
+	sim_cyccnt_step = ATTITUDE_CYCLE_BUDGET;
+	attitude_Update(&s, DT);
+	sim_cyccnt_step = ATTITUDE_CYCLE_BUDGET + 1U;
+	attitude_Update(&s, DT);
+	sim_cyccnt_step = 700U;
+	attitude_Update(&s, DT);
+
+	attitude_GetStats(&st);
+	CHECK_EQ(st.updates, 3);
+	CHECK_EQ(st.last_cycles, 700);
+	CHECK_EQ(st.max_cycles, ATTITUDE_CYCLE_BUDGET + 1U);
+	CHECK_EQ(st.over_budget, 1);
+	sim_cyccnt_step = 1U;
+
+	/* Host cost per update, for comparison with the target figure main prints */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t i = 0; i < n; i++) {
+		attitude_Update(&s, DT);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	printf("host attitude_Update: %.1f ns/update\n",
+	       ((double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec)) / n);
+}
+
+
+int main(void)
+{
+	test_tracking();
+	test_bias();
+	test_accel_gate();
+	test_cycles();
+
+	return check_done("test_attitude");
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+ * File name     :  test_calib.c
+ * Description   :  Host test of the MPU6050 calibration flow
+ *                  (projects/i2c_mpu6050/Src/mpu6050_calib.c) against a
+ *                  synthetic sensor whose gyro and accel biases drift with
+ *                  die temperature: the stationary capture, the background
+ *                  temperature fit fed from stream samples while the board
+ *                  warms up, the restart on a new orientation, and that the
+ *                  fitted offsets cancel the drift across the span.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "mpu6050_calib.h"
+#include "flash.h"
+#include "systick.h"
+
+#define T_START             25.0f   // °C at the stationary capture
+#define DRIFT_GYRO_C1       3.0f    // Gyro X counts per °C
+#define DRIFT_GYRO_C2       0.2f    // Gyro X counts per °C^2
+#define DRIFT_ACCEL_C1      5.0f    // Accel X counts per °C
+#define Q16_MDPS            66      // 1 m°/s in Q16.16
+#define Q16_ACCEL_LSB       ((int32_t)(Q16_ONE / MPU6050_ACCEL_LSB_PER_G))
+
+static float sensor_t = T_START;
+static int16_t sensor_flip = 1;     // Sign of gravity on Z
+static uint8_t sensor_quiet;        // Non-zero: no noise
+static uint32_t sensor_n;
+
+static mpu6050_calib_t saved;
+static uint32_t saves;
+
+
+/* --- Stand-ins for the sensor bus, flash and time base --- */
+
+/**
+ * @brief Sample of a board lying still at sensor_t, with +-1 count of noise.
+ */
+static void sensor_sample(mpu6050_motion_t *m)
+{
+	float dt = sensor_t - T_START;
+	int16_t noise = sensor_quiet ? 0 : ((sensor_n++ & 1U) ? 1 : -1);
+
+	m->accel[0] = (int16_t)(100.0f + DRIFT_ACCEL_C1 * dt) + noise;
+	m->accel[1] = (int16_t)(-50 - noise);
+	m->accel[2] = (int16_t)(sensor_flip * (int16_t)MPU6050_ACCEL_LSB_PER_G);
+	m->temp = (int16_t)((sensor_t - 36.53f) * 340.0f);
+	m->gyro[0] = (int16_t)(40.0f + DRIFT_GYRO_C1 * dt + DRIFT_GYRO_C2 * dt * dt) + noise;
+	m->gyro[1] = (int16_t)(-20 + noise);
+	m->gyro[2] = 0;
+}
+
+int mpu6050_ReadMotion(mpu6050_motion_t *motion)
+{
+	sensor_sample(motion);
+	return 0;
+}
+
+int flash_ErasePage(uint32_t page_addr)
+{
+	memset(&saved, 0xFF, sizeof(saved));
+	return 0;
+}
+
+int flash_Program(uint32_t addr, const void *data, uint32_t len)
+{
+	CHECK_EQ(len, sizeof(saved));
+	memcpy(&saved, data, sizeof(saved));
+	saves++;
+	return 0;
+}
+
+void systickDelayMs(int delay)
+{
+}
+
+
+/**
+ * @brief Largest calibrated error across the span, gyro X in m°/s and
+ * accel X in accel counts.
+ */
+static void drift_error(float t_from, float t_to, int32_t *gyro_err, int32_t *accel_err)
+{
+	mpu6050_motion_t m;
+	mpu6050_scaled_t s;
+
+	*gyro_err = 0;
+	*accel_err = 0;
+	sensor_quiet = 1;
+	for (sensor_t = t_from; sensor_t <= t_to; sensor_t += 0.5f) {
+		int32_t g;
+		int32_t a;
+
+		sensor_sample(&m);
+		mpu6050_CalibSetTemp(m.temp);
+		mpu6050_CalibApply(&m, &s);
+
+		g = s.gyro[0] / Q16_MDPS;
+		a = s.accel[0] / Q16_ACCEL_LSB;
+		g = (g < 0) ? -g : g;
+		a = (a < 0) ? -a : a;
+		*gyro_err = (g > *gyro_err) ? g : *gyro_err;
+		*accel_err = (a > *accel_err) ? a : *accel_err;
+	}
+	sensor_quiet = 0;
+}
+
+
+/**
+ * @brief Feeds stream samples while the temperature ramps, as main does at 10 Hz.
+ * @return Number of calls that reported a finished fit.
+ */
+static uint32_t warm_up(float t_from, float t_to)
+{
+	mpu6050_motion_t m;
+	uint32_t fits = 0;
+
+	for (sensor_t = t_from; sensor_t <= t_to; sensor_t += 0.01f) {
+		sensor_sample(&m);
+		if (mpu6050_CalibTempTrack(&m) > 0) {
+			fits++;
+			CHECK_EQ(mpu6050_CalibSave(), 0);
+		}
+	}
+	return fits;
+}
+
+
+static void test_capture(void)
+{
+	int32_t gyro_err;
+	int32_t accel_err;
+
+	sensor_t = T_START;
+	CHECK_EQ(mpu6050_CalibRun(MPU6050_CALIB_SAMPLES), 0);
+
+	/* Bias removed at the capture temperature */
+	drift_error(T_START, T_START, &gyro_err, &accel_err);
+	CHECK(gyro_err <= 10);
+	CHECK(accel_err <= 1);
+
+	/* Uncompensated, 6 °C later: 18 + 7.2 counts of gyro, 30 counts of accel */
+	drift_error(T_START + 6.0f, T_START + 6.0f, &gyro_err, &accel_err);
+	CHECK(gyro_err > 150);
+	CHECK(accel_err > 25);
+}
+
+
+static void test_skips_motion(void)
+{
+	mpu6050_motion_t m;
+
+	/* Rotation is never fitted, whatever the temperature */
+	for (sensor_t = T_START; sensor_t <= T_START + 8.0f; sensor_t += 0.01f) {
+		sensor_sample(&m);
+		m.gyro[2] = 10000;
+		CHECK_EQ(mpu6050_CalibTempTrack(&m), 0);
+	}
+}
+
+
+static void test_reorient_restarts(void)
+{
+	/* Three degrees, then the board is turned over: the data so far is dropped */
+	CHECK_EQ(warm_up(T_START, T_START + 3.0f), 0);
+	sensor_flip = -1;
+	CHECK_EQ(warm_up(T_START + 3.0f, T_START + 7.0f), 0);
+	sensor_flip = 1;
+}
+
+
+static void test_warm_up_fit(void)
+{
+	int32_t gyro_err;
+	int32_t accel_err;
+
+	/* The span is covered once, the fit is saved once, then tracking stops */
+	CHECK_EQ(warm_up(T_START, T_START + 6.0f), 1);
+	CHECK_EQ(saves, 1);
+	CHECK_EQ(saved.magic, MPU6050_CALIB_MAGIC);
+	CHECK(saved.temp_coef[3][0] != 0.0f);
+	CHECK_EQ(warm_up(T_START, T_START + 8.0f), 0);
+
+	/* Drift cancelled across the fit span, to about a count */
+	drift_error(T_START, T_START + 5.0f, &gyro_err, &accel_err);
+	CHECK(gyro_err <= 15);
+	CHECK(accel_err <= 2);
+}
+
+
+int main(void)
+{
+	test_capture();
+	test_skips_motion();
+	test_reorient_restarts();
+	test_warm_up_fit();
+
+	return check_done("test_calib");
+}
@@ -0,0 +1,287 @@
+/***************************************************************************
+ * File name     :  test_i2c.c
+ * Description   :  Host test of the queued I2C1 engine (projects/i2c_mpu6050)
+ *                  against a simulated register-file slave: register setup,
+ *                  write, read and write-then-read with a repeated START,
+ *                  NBYTES reload past 255 bytes, queue chaining and callback
+ *                  order, nesting of the critical sections, and the speed
+ *                  switch.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "sim_i2c.h"
+#include "i2c.h"
+#include "clock.h"
+#include "timing.h"
+
+#define SLAVE_ADDR      0x68U
+#define CFGR3_I2C1SW    (1U << 4)
+#define LOG_MAX         16U
+
+static i2c_xfer_t *cb_log[LOG_MAX];
+static i2c_xfer_status_t cb_status[LOG_MAX];
+static uint32_t cb_depth[LOG_MAX];
+static uint32_t cb_count;
+
+
+static void on_done(i2c_xfer_t *xfer)
+{
+	if (cb_count < LOG_MAX) {
+		cb_log[cb_count] = xfer;
+		cb_status[cb_count] = xfer->status;
+		cb_depth[cb_count] = I2C1_QueueDepth();
+	}
+	cb_count++;
+}
+
+
+/* Resubmits itself once from its own callback */
+static void on_done_resubmit(i2c_xfer_t *xfer)
+{
+	on_done(xfer);
+	if (cb_count == 1U) {
+		CHECK_EQ(I2C1_Submit(xfer), 0);
+	}
+}
+
+
+static void test_init(void)
+{
+	sim_reset();
+	sim_i2c_attach(SLAVE_ADDR);
+	I2C1_Init();
+
+	CHECK(RCC->CFGR3 & CFGR3_I2C1SW);
+	CHECK_EQ(I2C1->TIMINGR, I2C_TIMINGR(CLOCK_I2C1_FREQ, FAST));
+	CHECK(I2C1->TIMEOUTR & TIMEOUTR_TIMOUTEN);
+	CHECK((I2C1->CR1 & (CR1_PE | CR1_TXDMAEN | CR1_RXDMAEN | CR1_NACKIE | CR1_STOPIE | CR1_TCIE | CR1_ERRIE)) ==
+	      (CR1_PE | CR1_TXDMAEN | CR1_RXDMAEN | CR1_NACKIE | CR1_STOPIE | CR1_TCIE | CR1_ERRIE));
+	CHECK_EQ(DMA1_Channel6->CPAR, (uint32_t)&I2C1->TXDR);
+	CHECK_EQ(DMA1_Channel7->CPAR, (uint32_t)&I2C1->RXDR);
+	CHECK(sim_irq_enabled(I2C1_EV_IRQn));
+	CHECK(sim_irq_enabled(I2C1_ER_IRQn));
+	CHECK(sim_irq_enabled(DMA1_Channel6_IRQn));
+	CHECK(sim_irq_enabled(DMA1_Channel7_IRQn));
+	CHECK_EQ(NVIC_GetPriority(I2C1_EV_IRQn), I2C1_IRQ_PRIORITY);
+
+	/* SDA was released, no bus clear at start-up */
+	CHECK_EQ(sim_i2c.stops, 0);
+	CHECK_EQ(I2C1_QueueDepth(), 0);
+}
+
+
+static void test_write_read(void)
+{
+	uint8_t out[6] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+	uint8_t in[6] = { 0 };
+	uint8_t byte = 0;
+
+	/* Register address and data in one write, one STOP */
+	CHECK_EQ(I2C1_BurstWrite(SLAVE_ADDR, 0x3B, sizeof(out), out), I2C_XFER_DONE);
+	CHECK(memcmp(&sim_i2c.regs[0x3B], out, sizeof(out)) == 0);
+	CHECK_EQ(sim_i2c.starts, 1);
+	CHECK_EQ(sim_i2c.stops, 1);
+	CHECK_EQ(sim_i2c.written, 1U + sizeof(out));
+
+	/* Address write, repeated START, read: two STARTs, one STOP */
+	CHECK_EQ(I2C1_BurstRead(SLAVE_ADDR, 0x3B, sizeof(in), in), I2C_XFER_DONE);
+	CHECK(memcmp(in, out, sizeof(in)) == 0);
+	CHECK_EQ(sim_i2c.starts, 3);
+	CHECK_EQ(sim_i2c.restarts, 1);
+	CHECK_EQ(sim_i2c.stops, 2);
+
+	sim_i2c.regs[0x75] = 0x68;
+	CHECK_EQ(I2C1_ByteRead(SLAVE_ADDR, 0x75, &byte), I2C_XFER_DONE);
+	CHECK_EQ(byte, 0x68);
+
+	CHECK_EQ(sim_i2c.reloads, 0);
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+static void test_long_transfers(void)
+{
+	static uint8_t out[600];
+	static uint8_t in[600];
+	uint32_t reloads = sim_i2c.reloads;
+
+	for (uint32_t i = 0; i < sizeof(out); i++) {
+		out[i] = (uint8_t)(i * 13U + 1U);
+	}
+
+	/* 1 + 300 bytes: NBYTES 255 with RELOAD, then 46 with AUTOEND */
+	CHECK_EQ(I2C1_BurstWrite(SLAVE_ADDR, 0x00, 300, out), I2C_XFER_DONE);
+	CHECK_EQ(sim_i2c.reloads, reloads + 1U);
+
+	/* The slave pointer wrapped at 256, the last write to each register wins */
+	for (uint32_t r = 0; r < 256U; r++) {
+		uint32_t last = (r + 256U < 300U) ? r + 256U : r;
+
+		if (sim_i2c.regs[r] != out[last]) {
+			CHECK_EQ(sim_i2c.regs[r], out[last]);
+			break;
+		}
+	}
+
+	/* 600 bytes read: 255 + 255 + 90 */
+	reloads = sim_i2c.reloads;
+	CHECK_EQ(I2C1_BurstRead(SLAVE_ADDR, 0x10, sizeof(in), in), I2C_XFER_DONE);
+	CHECK_EQ(sim_i2c.reloads, reloads + 2U);
+	for (uint32_t i = 0; i < sizeof(in); i++) {
+		if (in[i] != sim_i2c.regs[(0x10U + i) & 0xFFU]) {
+			CHECK_EQ(in[i], sim_i2c.regs[(0x10U + i) & 0xFFU]);
+			break;
+		}
+	}
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+static void test_headerless(void)
+{
+	uint8_t ptr = 0x40;
+	uint8_t in[3] = { 0 };
+	i2c_xfer_t wr = { .saddr = SLAVE_ADDR, .tx = &ptr, .tx_len = 1 };
+	i2c_xfer_t rd = { .saddr = SLAVE_ADDR, .rx = in, .rx_len = sizeof(in) };
+	i2c_xfer_t empty = { .saddr = SLAVE_ADDR };
+
+	sim_i2c.regs[0x40] = 0xA0;
+	sim_i2c.regs[0x41] = 0xA1;
+	sim_i2c.regs[0x42] = 0xA2;
+
+	/* Pointer set by a plain write, then a read without a header */
+	CHECK_EQ(I2C1_Transfer(&wr), I2C_XFER_DONE);
+	CHECK_EQ(I2C1_Transfer(&rd), I2C_XFER_DONE);
+	CHECK_EQ(in[0], 0xA0);
+	CHECK_EQ(in[2], 0xA2);
+
+	CHECK_EQ(I2C1_Submit(&empty), -1);
+	CHECK_EQ(I2C1_Transfer(&empty), I2C_XFER_ERROR);
+}
+
+
+static void test_queue(void)
+{
+	static uint8_t bufs[I2C1_XFER_QUEUE_DEPTH + 1U][4];
+	static i2c_xfer_t xfers[I2C1_XFER_QUEUE_DEPTH + 1U];
+	i2c_stats_t before;
+	i2c_stats_t after;
+
+	I2C1_GetStats(&before);
+	cb_count = 0;
+
+	for (uint32_t i = 0; i < I2C1_XFER_QUEUE_DEPTH + 1U; i++) {
+		sim_i2c.regs[0x20U + i] = (uint8_t)(0xC0U + i);
+		xfers[i] = (i2c_xfer_t){ .saddr = SLAVE_ADDR, .hdr = { (uint8_t)(0x20U + i) }, .hdr_len = 1,
+		                         .rx = bufs[i], .rx_len = 1, .callback = on_done };
+	}
+
+	/* Slave stretching SCL: everything stays queued, the first on the bus */
+	sim_i2c.hold = 1;
+	for (uint32_t i = 0; i < I2C1_XFER_QUEUE_DEPTH; i++) {
+		CHECK_EQ(I2C1_Submit(&xfers[i]), 0);
+	}
+	CHECK_EQ(I2C1_Submit(&xfers[I2C1_XFER_QUEUE_DEPTH]), -1);
+	CHECK_EQ(I2C1_QueueDepth(), I2C1_XFER_QUEUE_DEPTH);
+	CHECK_EQ(xfers[0].status, I2C_XFER_BUSY);
+	CHECK_EQ(xfers[1].status, I2C_XFER_QUEUED);
+	CHECK(I2C1_XferPending(&xfers[1]));
+
+	/* The queue is not empty, the speed cannot change under it */
+	CHECK_EQ(I2C1_SetSpeed(I2C_SPEED_STANDARD), -1);
+	CHECK_EQ(I2C1_GetSpeed(), I2C_SPEED_FAST);
+
+	/* Drained in order; each callback sees the next transaction already chained */
+	sim_i2c_run();
+	CHECK_EQ(cb_count, I2C1_XFER_QUEUE_DEPTH);
+	for (uint32_t i = 0; i < I2C1_XFER_QUEUE_DEPTH; i++) {
+		CHECK(cb_log[i] == &xfers[i]);
+		CHECK_EQ(cb_status[i], I2C_XFER_DONE);
+		CHECK_EQ(cb_depth[i], I2C1_XFER_QUEUE_DEPTH - 1U - i);
+		CHECK_EQ(bufs[i][0], 0xC0U + i);
+	}
+
+	I2C1_GetStats(&after);
+	CHECK_EQ(after.completed - before.completed, I2C1_XFER_QUEUE_DEPTH);
+
+	/* A callback may resubmit its own descriptor */
+	cb_count = 0;
+	xfers[0].callback = on_done_resubmit;
+	CHECK_EQ(I2C1_Submit(&xfers[0]), 0);
+	CHECK_EQ(cb_count, 2);
+	CHECK_EQ(I2C1_QueueDepth(), 0);
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+static void test_nesting(void)
+{
+	uint8_t in[2];
+	i2c_xfer_t xfer = { .saddr = SLAVE_ADDR, .hdr = { 0x40 }, .hdr_len = 1, .rx = in, .rx_len = sizeof(in) };
+	i2c_stats_t stats;
+
+	/* Inside the caller's own critical section: still masked afterwards, nothing ran */
+	__disable_irq();
+	CHECK_EQ(I2C1_Submit(&xfer), 0);
+	I2C1_GetStats(&stats);
+	I2C1_Poll();
+	CHECK_EQ(sim_primask, 1);
+	CHECK(I2C1_XferPending(&xfer));
+	__enable_irq();
+	CHECK_EQ(xfer.status, I2C_XFER_DONE);
+
+	/* From EXTI0 at the I2C1 priority, as the FIFO drain does: the bus waits for it to return */
+	NVIC_SetPriority(EXTI0_IRQn, I2C1_IRQ_PRIORITY);
+	NVIC_EnableIRQ(EXTI0_IRQn);
+	sim_irq_enter(EXTI0_IRQn);
+	CHECK_EQ(I2C1_Submit(&xfer), 0);
+	CHECK(I2C1_XferPending(&xfer));
+	CHECK_EQ(sim_primask, 0);
+	sim_irq_exit(EXTI0_IRQn);
+	CHECK_EQ(xfer.status, I2C_XFER_DONE);
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+static void test_speed(void)
+{
+	uint8_t byte = 0;
+
+	CHECK_EQ(I2C1_SetSpeed(I2C_SPEED_FAST_PLUS), 0);
+	CHECK_EQ(I2C1->TIMINGR, I2C_TIMINGR(CLOCK_I2C1_FREQ, FASTPLUS));
+	CHECK((SYSCFG->CFGR1 & (SYSCFG_CFGR1_PB8_FMP | SYSCFG_CFGR1_PB9_FMP)) ==
+	      (SYSCFG_CFGR1_PB8_FMP | SYSCFG_CFGR1_PB9_FMP));
+	CHECK(I2C1->CR1 & CR1_PE);
+	CHECK_EQ(I2C1_ByteRead(SLAVE_ADDR, 0x75, &byte), I2C_XFER_DONE);
+
+	CHECK_EQ(I2C1_SetSpeed(I2C_SPEED_STANDARD), 0);
+	CHECK_EQ(I2C1->TIMINGR, I2C_TIMINGR(CLOCK_I2C1_FREQ, STD));
+	CHECK((SYSCFG->CFGR1 & (SYSCFG_CFGR1_PB8_FMP | SYSCFG_CFGR1_PB9_FMP)) == 0U);
+
+	CHECK_EQ(I2C1_SetSpeed(I2C_SPEED_COUNT), -1);
+	CHECK_EQ(I2C1_GetSpeed(), I2C_SPEED_STANDARD);
+}
+
+
+/* The blocking calls put their descriptor on the stack and DMA the header out of it */
+static int run(void)
+{
+	test_init();
+	test_write_read();
+	test_long_transfers();
+	test_headerless();
+	test_queue();
+	test_nesting();
+	test_speed();
+
+	return check_done("test_i2c");
+}
+
+
+int main(void)
+{
+	return sim_run_low_stack(run);
+}
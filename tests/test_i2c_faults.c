@@ -0,0 +1,242 @@
+/***************************************************************************
+ * File name     :  test_i2c_faults.c
+ * Description   :  Host test of the I2C1 error paths (projects/i2c_mpu6050)
+ *                  with faults injected into the simulated bus: address and
+ *                  data NACK, bus error, arbitration loss, overrun, the
+ *                  hardware SCL-low timeout, DMA errors and a slave that
+ *                  stops responding. Checks the final status, the link
+ *                  health counters, the bus clear, that each wait is bounded
+ *                  and that the queue moves on to the next transaction.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "sim_i2c.h"
+#include "i2c.h"
+#include "clock.h"
+
+#define SLAVE_ADDR          0x68U
+#define PIN_SDA             (1U << 9)
+#define MODER_PB8_PB9_MASK  ((3U << 16) | (3U << 18))
+#define MODER_PB8_PB9_AF    ((2U << 16) | (2U << 18))
+#define CYCLES_PER_US       (CLOCK_HCLK_FREQ / 1000000U)
+
+static i2c_stats_t stats;
+static i2c_stats_t last;
+
+
+/**
+ * @brief Refreshes the counters, keeping the previous snapshot in last.
+ */
+static void stats_update(void)
+{
+	last = stats;
+	I2C1_GetStats(&stats);
+}
+
+
+/**
+ * @brief One write of two data bytes with a fault injected after `after` bytes.
+ * @return Final status.
+ */
+static i2c_xfer_status_t write_with_fault(sim_i2c_fault_t fault, uint32_t after)
+{
+	uint8_t data[2] = { 0x5A, 0xA5 };
+
+	sim_i2c.fault = fault;
+	sim_i2c.fault_after = after;
+	return I2C1_BurstWrite(SLAVE_ADDR, 0x10, sizeof(data), data);
+}
+
+
+static void check_pins_back(void)
+{
+	CHECK_EQ(GPIOB->MODER & MODER_PB8_PB9_MASK, MODER_PB8_PB9_AF);
+	CHECK(I2C1->CR1 & CR1_PE);
+}
+
+
+static void test_stuck_sda_at_init(void)
+{
+	uint32_t start;
+
+	sim_reset();
+	sim_i2c_attach(SLAVE_ADDR);
+
+	/* A slave reset mid-byte holds SDA low: cleared in bounded time, then a normal start */
+	GPIOB->IDR &= ~PIN_SDA;
+	start = DWT->CYCCNT;
+	I2C1_Init();
+	CHECK((DWT->CYCCNT - start) < 1000U * CYCLES_PER_US);
+	GPIOB->IDR |= PIN_SDA;
+
+	stats_update();
+	CHECK_EQ(stats.recoveries, 1);
+	check_pins_back();
+
+	/* Explicit recovery on an idle bus */
+	I2C1_BusRecover();
+	stats_update();
+	CHECK_EQ(stats.recoveries, 2);
+	check_pins_back();
+}
+
+
+static void test_nack(void)
+{
+	uint8_t byte;
+
+	/* Nobody at the address */
+	CHECK_EQ(I2C1_ByteRead(0x42, 0x75, &byte), I2C_XFER_NACK);
+	stats_update();
+	CHECK_EQ(stats.nack, last.nack + 1U);
+	CHECK_EQ(stats.recoveries, last.recoveries);
+
+	/* Slave refuses the second data byte */
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_NACK, 2), I2C_XFER_NACK);
+	stats_update();
+	CHECK_EQ(stats.nack, last.nack + 1U);
+	CHECK_EQ(stats.completed, last.completed);
+	CHECK_EQ(I2C1_QueueDepth(), 0);
+}
+
+
+static void test_error_interrupts(void)
+{
+	uint8_t in[4];
+
+	/* Bus error: status, counter and a bus clear */
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_BERR, 1), I2C_XFER_BUS_ERROR);
+	stats_update();
+	CHECK_EQ(stats.bus_error, last.bus_error + 1U);
+	CHECK_EQ(stats.recoveries, last.recoveries + 1U);
+	check_pins_back();
+
+	/* Arbitration lost: no bus clear, the other master owns the bus */
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_ARLO, 0), I2C_XFER_ARB_LOST);
+	stats_update();
+	CHECK_EQ(stats.arb_lost, last.arb_lost + 1U);
+	CHECK_EQ(stats.recoveries, last.recoveries);
+	check_pins_back();
+
+	/* Overrun in the read phase */
+	sim_i2c.fault = SIM_I2C_FAULT_OVR;
+	sim_i2c.fault_after = 3;
+	CHECK_EQ(I2C1_BurstRead(SLAVE_ADDR, 0x00, sizeof(in), in), I2C_XFER_ERROR);
+	stats_update();
+	CHECK_EQ(stats.overrun, last.overrun + 1U);
+
+	/* SCL held low: the hardware timeout fires and the bus is cleared */
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_TIMEOUT, 1), I2C_XFER_TIMEOUT);
+	stats_update();
+	CHECK_EQ(stats.timeout, last.timeout + 1U);
+	CHECK_EQ(stats.recoveries, last.recoveries + 1U);
+	check_pins_back();
+}
+
+
+static void test_dma_error(void)
+{
+	uint8_t in[4];
+
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_DMA, 1), I2C_XFER_ERROR);
+	stats_update();
+	CHECK_EQ(stats.dma_error, last.dma_error + 1U);
+
+	sim_i2c.fault = SIM_I2C_FAULT_DMA;
+	sim_i2c.fault_after = 2;
+	CHECK_EQ(I2C1_BurstRead(SLAVE_ADDR, 0x00, sizeof(in), in), I2C_XFER_ERROR);
+	stats_update();
+	CHECK_EQ(stats.dma_error, last.dma_error + 1U);
+
+	/* The STOP the driver asked for went out, the channels are off */
+	CHECK((I2C1->CR2 & CR2_STOP) == 0U);
+	CHECK((DMA1_Channel6->CCR & DMA1_CCR_EN) == 0U);
+	CHECK((DMA1_Channel7->CCR & DMA1_CCR_EN) == 0U);
+}
+
+
+static void test_deadline(void)
+{
+	uint8_t in[6];
+	uint32_t start;
+	uint32_t elapsed;
+
+	/* Slave goes silent with no flag raised: only the software deadline ends the wait */
+	sim_cyccnt_step = 64U;
+	I2C1_SetTimeout(1000U);
+	sim_i2c.fault = SIM_I2C_FAULT_HANG;
+	sim_i2c.fault_after = 3;
+
+	start = DWT->CYCCNT;
+	CHECK_EQ(I2C1_BurstRead(SLAVE_ADDR, 0x00, sizeof(in), in), I2C_XFER_TIMEOUT);
+	elapsed = DWT->CYCCNT - start;
+
+	/* At least the allowance, at most allowance + nominal bus time + the bus clear */
+	CHECK(elapsed >= 1000U * CYCLES_PER_US);
+	CHECK(elapsed < 1500U * CYCLES_PER_US);
+
+	stats_update();
+	CHECK_EQ(stats.timeout, last.timeout + 1U);
+	CHECK_EQ(stats.recoveries, last.recoveries + 1U);
+	check_pins_back();
+
+	sim_i2c_run();
+	sim_cyccnt_step = 1U;
+	I2C1_SetTimeout(I2C1_TIMEOUT_US);
+}
+
+
+static void test_queue_moves_on(void)
+{
+	static uint8_t bufs[3][2];
+	static i2c_xfer_t xfers[3];
+
+	for (uint32_t i = 0; i < 3U; i++) {
+		xfers[i] = (i2c_xfer_t){ .saddr = SLAVE_ADDR, .hdr = { 0x30 }, .hdr_len = 1, .rx = bufs[i], .rx_len = 2 };
+	}
+	sim_i2c.regs[0x30] = 0x12;
+	sim_i2c.regs[0x31] = 0x34;
+
+	/* A failed transaction is retired and the next one starts on a recovered bus */
+	sim_i2c.hold = 1;
+	for (uint32_t i = 0; i < 3U; i++) {
+		CHECK_EQ(I2C1_Submit(&xfers[i]), 0);
+	}
+	sim_i2c.fault = SIM_I2C_FAULT_BERR;
+	sim_i2c.fault_after = 0;
+	sim_i2c_run();
+
+	CHECK_EQ(xfers[0].status, I2C_XFER_BUS_ERROR);
+	CHECK_EQ(xfers[1].status, I2C_XFER_DONE);
+	CHECK_EQ(xfers[2].status, I2C_XFER_DONE);
+	CHECK_EQ(bufs[2][0], 0x12);
+	CHECK_EQ(bufs[2][1], 0x34);
+	CHECK_EQ(I2C1_QueueDepth(), 0);
+
+	/* Healthy link afterwards */
+	CHECK_EQ(write_with_fault(SIM_I2C_FAULT_NONE, 0), I2C_XFER_DONE);
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+/* The blocking calls put their descriptor on the stack and DMA the header out of it */
+static int run(void)
+{
+	test_stuck_sda_at_init();
+	test_nack();
+	test_error_interrupts();
+	test_dma_error();
+	test_deadline();
+	test_queue_moves_on();
+
+	return check_done("test_i2c_faults");
+}
+
+
+int main(void)
+{
+	return sim_run_low_stack(run);
+}
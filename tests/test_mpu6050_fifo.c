@@ -0,0 +1,376 @@
+/***************************************************************************
+ * File name     :  test_mpu6050_fifo.c
+ * Description   :  Host test of the MPU6050 FIFO streaming mode
+ *                  (projects/i2c_mpu6050). A model of the sensor's 1 KB FIFO
+ *                  sits behind the simulated I2C1 slave; the test replays a
+ *                  synthetic sample stream into it, raising the data-ready
+ *                  edge on EXTI0 for each sample, and checks frame alignment,
+ *                  timestamps, batching, and recovery from FIFO overflow,
+ *                  missed edges, a full sample ring and a failed drain.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "sim_i2c.h"
+#include "i2c.h"
+#include "clock.h"
+#include "mpu6050.h"
+#include "systick.h"
+
+#define EXTI_LINE0          (1U << 0)
+#define SAMPLE_PERIOD_CYC   (CLOCK_HCLK_FREQ / MPU6050_SAMPLE_RATE_HZ)
+#define DEVICE_RESET_MS     100U    // Register access after PWR_MGMT_1 DEVICE_RESET (datasheet)
+
+void EXTI0_IRQHandler(void);
+
+/* --- Sensor model: FIFO ring, count registers and the self-clearing reset --- */
+static uint8_t fifo[MPU6050_FIFO_SIZE];
+static uint32_t fifo_rd;
+static uint32_t fifo_count;
+static uint32_t fifo_hw_resets;
+static uint32_t reset_wait_ms;  // Delayed since the device reset, UINT32_MAX when none is pending
+
+static uint32_t edge_time;      // DWT->CYCCNT of the next data-ready edge
+static uint32_t next_k;         // Index encoded into the next frame
+
+
+static void fifo_push(uint8_t b)
+{
+	/* Full: the sensor overwrites the oldest byte, frame boundaries are lost */
+	if (fifo_count == MPU6050_FIFO_SIZE) {
+		fifo_rd = (fifo_rd + 1U) % MPU6050_FIFO_SIZE;
+		fifo_count--;
+	}
+	fifo[(fifo_rd + fifo_count) % MPU6050_FIFO_SIZE] = b;
+	fifo_count++;
+}
+
+
+static uint8_t mpu_read(uint8_t *ptr)
+{
+	uint8_t b;
+
+	switch (*ptr) {
+	case MPU6050_FIFO_R_W_REG:
+		/* The data port does not advance the pointer */
+		if (fifo_count == 0U) {
+			return 0xFF;
+		}
+		b = fifo[fifo_rd];
+		fifo_rd = (fifo_rd + 1U) % MPU6050_FIFO_SIZE;
+		fifo_count--;
+		return b;
+	case MPU6050_FIFO_COUNTH_REG:
+		(*ptr)++;
+		return (uint8_t)(fifo_count >> 8);
+	case MPU6050_FIFO_COUNTH_REG + 1U:
+		(*ptr)++;
+		return (uint8_t)fifo_count;
+	default:
+		return sim_i2c.regs[(*ptr)++];
+	}
+}
+
+
+static void mpu_write(uint8_t *ptr, uint8_t value)
+{
+	/* Registers are only back this long after a device reset */
+	if (reset_wait_ms != UINT32_MAX) {
+		CHECK(reset_wait_ms >= DEVICE_RESET_MS);
+		reset_wait_ms = UINT32_MAX;
+	}
+	if ((*ptr == MPU6050_PWR_MGMT_1_REG) && (value & MPU6050_PWR_MGMT_1_RESET)) {
+		reset_wait_ms = 0;
+		value &= (uint8_t)~MPU6050_PWR_MGMT_1_RESET;
+	}
+	if ((*ptr == MPU6050_USER_CTRL_REG) && (value & MPU6050_USER_CTRL_FIFO_RESET)) {
+		fifo_rd = 0;
+		fifo_count = 0;
+		fifo_hw_resets++;
+		value &= (uint8_t)~MPU6050_USER_CTRL_FIFO_RESET;
+	}
+	sim_i2c.regs[(*ptr)++] = value;
+}
+
+
+void systickDelayMs(int delay)
+{
+	if (reset_wait_ms != UINT32_MAX) {
+		reset_wait_ms += (uint32_t)delay;
+	}
+}
+
+
+/**
+ * @brief Motion values encoded for sample k, unique per sample.
+ */
+static void frame_values(uint32_t k, mpu6050_motion_t *m)
+{
+	m->accel[0] = (int16_t)k;
+	m->accel[1] = (int16_t)(-(int32_t)k);
+	m->accel[2] = (int16_t)(2U * k);
+	m->temp = (int16_t)(1000U + k);
+	m->gyro[0] = (int16_t)(3U * k);
+	m->gyro[1] = (int16_t)(-3 * (int32_t)k);
+	m->gyro[2] = (int16_t)(100 - (int32_t)k);
+}
+
+
+/**
+ * @brief Latches the next sample into the FIFO as the sensor does, big-endian
+ * in register order, without a data-ready edge.
+ */
+static void sensor_frame(void)
+{
+	mpu6050_motion_t m;
+	int16_t w[MPU6050_FIFO_FRAME_SIZE / 2U];
+
+	frame_values(next_k++, &m);
+	memcpy(w, &m, sizeof(w));
+	for (uint32_t i = 0; i < MPU6050_FIFO_FRAME_SIZE / 2U; i++) {
+		fifo_push((uint8_t)((uint16_t)w[i] >> 8));
+		fifo_push((uint8_t)w[i]);
+	}
+}
+
+
+/**
+ * @brief One sample period: frames into the FIFO, then the data-ready edge.
+ * The drain the edge starts runs to completion before this returns.
+ */
+static void sensor_edge(uint32_t frames)
+{
+	for (uint32_t i = 0; i < frames; i++) {
+		sensor_frame();
+	}
+
+	sim_DWT.CYCCNT = edge_time;
+	edge_time += SAMPLE_PERIOD_CYC;
+	EXTI->PR |= EXTI_LINE0;
+	NVIC_SetPendingIRQ(EXTI0_IRQn);
+}
+
+
+/**
+ * @brief Pulls every sample from the ring and checks it against the frame
+ * and edge it came from.
+ * @param k  First expected sample index.
+ * @param ts Timestamp expected for it; the handler's own read moves CYCCNT one step.
+ * @return Number of samples pulled.
+ */
+static uint32_t pull_check(uint32_t k, uint32_t ts)
+{
+	mpu6050_sample_t s;
+	mpu6050_motion_t m;
+	uint32_t n = 0;
+
+	while (mpu6050_SampleGet(&s) == 0) {
+		frame_values(k + n, &m);
+		if (memcmp(&s.motion, &m, sizeof(m)) != 0) {
+			CHECK_EQ(s.motion.accel[0], m.accel[0]);
+			CHECK(memcmp(&s.motion, &m, sizeof(m)) == 0);
+			return n;
+		}
+		CHECK_EQ(s.timestamp, ts + n * SAMPLE_PERIOD_CYC + sim_cyccnt_step);
+		n++;
+	}
+	return n;
+}
+
+
+static void stats(mpu6050_stream_stats_t *st)
+{
+	mpu6050_GetStreamStats(st);
+}
+
+
+static void test_start(void)
+{
+	sim_reset();
+	sim_i2c_attach(MPU6050_DEVICE_ADDR);
+	sim_i2c.read_reg = mpu_read;
+	sim_i2c.write_reg = mpu_write;
+	sim_i2c.regs[MPU6050_WHO_AM_I_REG] = MPU6050_DEVICE_ADDR;
+	sim_set_vector(EXTI0_IRQn, EXTI0_IRQHandler);
+	reset_wait_ms = UINT32_MAX;
+
+	CHECK_EQ(mpu6050_Init(), 0);
+	CHECK_EQ(reset_wait_ms, UINT32_MAX);
+	CHECK_EQ(mpu6050_StreamStart(), 0);
+
+	CHECK_EQ(sim_i2c.regs[MPU6050_SMPLRT_DIV_REG], MPU6050_SMPLRT_DIV_1KHZ);
+	CHECK_EQ(sim_i2c.regs[MPU6050_CONFIG_REG], MPU6050_DLPF_CFG_188HZ);
+	CHECK_EQ(sim_i2c.regs[MPU6050_FIFO_EN_REG], MPU6050_FIFO_EN_MOTION);
+	CHECK_EQ(sim_i2c.regs[MPU6050_INT_ENABLE_REG], MPU6050_INT_DATA_RDY_EN);
+	CHECK_EQ(fifo_hw_resets, 1);
+	CHECK(EXTI->IMR & EXTI_LINE0);
+	CHECK(sim_irq_enabled(EXTI0_IRQn));
+	CHECK_EQ(NVIC_GetPriority(EXTI0_IRQn), I2C1_IRQ_PRIORITY);
+
+	edge_time = 1000000U;
+	next_k = 0;
+}
+
+
+static void test_steady_stream(void)
+{
+	mpu6050_stream_stats_t st;
+	uint32_t starts = sim_i2c.starts;
+	uint32_t k = next_k;
+	uint32_t ts = edge_time;
+
+	/* 64 samples, drained every MPU6050_FIFO_BATCH edges in one count + one burst read */
+	for (uint32_t batch = 0; batch < 64U / MPU6050_FIFO_BATCH; batch++) {
+		for (uint32_t i = 0; i < MPU6050_FIFO_BATCH - 1U; i++) {
+			sensor_edge(1);
+		}
+		CHECK_EQ(pull_check(k, ts), 0);
+
+		sensor_edge(1);
+		CHECK_EQ(pull_check(k, ts), MPU6050_FIFO_BATCH);
+		CHECK_EQ(fifo_count, 0);
+		k += MPU6050_FIFO_BATCH;
+		ts += MPU6050_FIFO_BATCH * SAMPLE_PERIOD_CYC;
+	}
+
+	/* Two write-then-read transactions per batch, two STARTs each */
+	CHECK_EQ(sim_i2c.starts - starts, (64U / MPU6050_FIFO_BATCH) * 4U);
+
+	stats(&st);
+	CHECK_EQ(st.samples, 64);
+	CHECK_EQ(st.dropped, 0);
+	CHECK_EQ(st.fifo_resets, 0);
+	CHECK_EQ(st.bus_errors, 0);
+}
+
+
+static void test_missed_edge(void)
+{
+	uint32_t k = next_k;
+	uint32_t ts = edge_time;
+
+	/* Last edge of the batch covers two frames: the extra one is extrapolated a period later */
+	for (uint32_t i = 0; i < MPU6050_FIFO_BATCH - 1U; i++) {
+		sensor_edge(1);
+	}
+	sensor_edge(2);
+	CHECK_EQ(pull_check(k, ts), MPU6050_FIFO_BATCH + 1U);
+
+	/* Back in step with the edges */
+	k = next_k;
+	ts = edge_time;
+	for (uint32_t i = 0; i < MPU6050_FIFO_BATCH; i++) {
+		sensor_edge(1);
+	}
+	CHECK_EQ(pull_check(k, ts), MPU6050_FIFO_BATCH);
+}
+
+
+static void test_fifo_overflow(void)
+{
+	mpu6050_stream_stats_t before;
+	mpu6050_stream_stats_t after;
+	uint32_t frames_fit = MPU6050_FIFO_SIZE / MPU6050_FIFO_FRAME_SIZE;
+	uint32_t k;
+	uint32_t ts;
+
+	stats(&before);
+
+	/* Bus stalled: the first drain waits on the queue while the FIFO wraps mid-frame */
+	sim_i2c.hold = 1;
+	for (uint32_t i = 0; i < frames_fit + 8U; i++) {
+		sensor_edge(1);
+	}
+	CHECK_EQ(fifo_count, MPU6050_FIFO_SIZE);
+
+	/* The count comes back full: reset instead of reading misaligned frames */
+	sim_i2c_run();
+	stats(&after);
+	CHECK_EQ(after.fifo_resets, before.fifo_resets + 1U);
+	CHECK_EQ(after.samples, before.samples);
+	CHECK_EQ(fifo_count, 0);
+	CHECK_EQ(pull_check(0, 0), 0);
+
+	/* Aligned again, with fresh timestamps */
+	k = next_k;
+	ts = edge_time;
+	for (uint32_t i = 0; i < 2U * MPU6050_FIFO_BATCH; i++) {
+		sensor_edge(1);
+	}
+	CHECK_EQ(pull_check(k, ts), 2U * MPU6050_FIFO_BATCH);
+}
+
+
+static void test_ring_full(void)
+{
+	mpu6050_stream_stats_t before;
+	mpu6050_stream_stats_t after;
+	uint32_t k = next_k;
+	uint32_t ts = edge_time;
+
+	stats(&before);
+
+	/* The application stops reading: the newest samples are dropped, the ring keeps its order */
+	for (uint32_t i = 0; i < MPU6050_SAMPLE_RING + 2U * MPU6050_FIFO_BATCH; i++) {
+		sensor_edge(1);
+	}
+	CHECK_EQ(pull_check(k, ts), MPU6050_SAMPLE_RING);
+
+	stats(&after);
+	CHECK_EQ(after.dropped, before.dropped + 2U * MPU6050_FIFO_BATCH);
+	CHECK_EQ(after.fifo_resets, before.fifo_resets);
+}
+
+
+static void test_drain_error(void)
+{
+	mpu6050_stream_stats_t before;
+	mpu6050_stream_stats_t after;
+	uint32_t k;
+	uint32_t ts;
+
+	stats(&before);
+
+	/* DMA error in the middle of the third frame of the burst: count read (3 bytes), then header + 30 bytes */
+	sim_i2c.fault = SIM_I2C_FAULT_DMA;
+	sim_i2c.fault_after = 3U + 1U + 2U * MPU6050_FIFO_FRAME_SIZE + 2U;
+	for (uint32_t i = 0; i < MPU6050_FIFO_BATCH; i++) {
+		sensor_edge(1);
+	}
+
+	stats(&after);
+	CHECK_EQ(after.bus_errors, before.bus_errors + 1U);
+	CHECK_EQ(after.fifo_resets, before.fifo_resets + 1U);
+	CHECK_EQ(after.samples, before.samples);
+	CHECK_EQ(pull_check(0, 0), 0);
+
+	k = next_k;
+	ts = edge_time;
+	for (uint32_t i = 0; i < MPU6050_FIFO_BATCH; i++) {
+		sensor_edge(1);
+	}
+	CHECK_EQ(pull_check(k, ts), MPU6050_FIFO_BATCH);
+	CHECK_EQ(sim_i2c.stalls, 0);
+}
+
+
+/* The blocking register writes put their descriptor on the stack and DMA the header out of it */
+static int run(void)
+{
+	test_start();
+	test_steady_stream();
+	test_missed_edge();
+	test_fifo_overflow();
+	test_ring_full();
+	test_drain_error();
+
+	return check_done("test_mpu6050_fifo");
+}
+
+
+int main(void)
+{
+	return sim_run_low_stack(run);
+}
@@ -0,0 +1,165 @@
+/***************************************************************************
+ * File name     :  test_scale.c
+ * Description   :  Host test of the MPU6050 Q16.16 scaling path
+ *                  (projects/i2c_mpu6050): mpu6050_Scale() against a double
+ *                  reference over every raw value, q16_format() against
+ *                  snprintf(), and a host-build timing of the float and
+ *                  fixed loops of scale_benchmark() with the same
+ *                  volatile source and asm barriers, so a loop the compiler
+ *                  folds shows up as a result that was never computed.
+ *                  Host timings are printed for comparison, not checked.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "mpu6050.h"
+#include "systick.h"
+
+#define SCALE_RUNS      1000000U    // Host iterations per timed path
+
+void systickDelayMs(int delay)
+{
+}
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+ * @brief Largest Q16.16 error of scale_q32 over the whole raw range against raw * lsb.
+ */
+static double max_error(int32_t scale_q32, double lsb)
+{
+	double worst = 0.0;
+
+	for (int32_t raw = INT16_MIN; raw <= INT16_MAX; raw++) {
+		double err = (double)q16_from_raw((int16_t)raw, scale_q32) - raw * lsb * Q16_ONE;
+
+		if (err < 0.0) {
+			err = -err;
+		}
+		if (err > worst) {
+			worst = err;
+		}
+	}
+	return worst;
+}
+
+
+static void test_scale(void)
+{
+	mpu6050_motion_t raw = { .accel = { -8192, 123, 32767 }, .temp = -1200, .gyro = { 131, -32768, 4000 } };
+	mpu6050_scaled_t scaled;
+
+	/* Truncating shift plus the rounded Q0.32 factor: under 2 LSB of Q16.16 */
+	CHECK(max_error(MPU6050_ACCEL_SCALE_Q32, 1.0 / MPU6050_ACCEL_LSB_PER_G) < 2.0);
+	CHECK(max_error(MPU6050_GYRO_SCALE_Q32, 10.0 / MPU6050_GYRO_LSB10_PER_DPS) < 2.0);
+	CHECK(max_error(MPU6050_TEMP_SCALE_Q32, 1.0 / 340.0) < 2.0);
+
+	mpu6050_Scale(&raw, &scaled);
+	CHECK_EQ(scaled.accel[0], -8192 * (Q16_ONE / (int32_t)MPU6050_ACCEL_LSB_PER_G));
+	CHECK_EQ(scaled.gyro[0], q16_from_raw(131, MPU6050_GYRO_SCALE_Q32));
+	CHECK_EQ(scaled.gyro[1], q16_from_raw(-32768, MPU6050_GYRO_SCALE_Q32));
+	CHECK_EQ(scaled.temp, q16_from_raw(-1200, MPU6050_TEMP_SCALE_Q32) + MPU6050_TEMP_OFFSET_Q16);
+}
+
+
+static void test_format(void)
+{
+	char buf[Q16_STR_MAX];
+	char ref[32];
+	uint32_t mismatches = 0;
+
+	CHECK_EQ(q16_format(buf, INT32_MIN, 4), 11);
+	CHECK(strcmp(buf, "-32768.0000") == 0);
+	CHECK_EQ(q16_format(buf, -1, 4), 6);
+	CHECK(strcmp(buf, "0.0000") == 0);
+	CHECK_EQ(q16_format(buf, Q16_ONE + Q16_ONE / 2, 0), 1);
+	CHECK(strcmp(buf, "2") == 0);
+	(void)q16_format(buf, Q16_ONE - 1, 4);
+	CHECK(strcmp(buf, "1.0000") == 0);
+
+	/* Every fraction, in a few integer ranges; exact halves round away from zero in q16_format */
+	for (int32_t ip = -3; ip <= 2; ip++) {
+		for (int32_t f = 0; f < Q16_ONE; f++) {
+			q16_t v = ip * Q16_ONE + f;
+			double frac = (double)((uint32_t)((v < 0) ? -v : v) & Q16_FRAC_MASK) * 10000.0 / Q16_ONE;
+
+			if ((frac - (int32_t)frac) == 0.5) {
+				continue;
+			}
+			(void)snprintf(ref, sizeof(ref), "%.4f", (double)v / Q16_ONE);
+			(void)q16_format(buf, v, 4);
+			if (strcmp(buf, (strcmp(ref, "-0.0000") == 0) ? "0.0000" : ref) != 0) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK_EQ(mismatches, 0);
+}
+
+
+/**
+ * @brief The scale_benchmark() loops, timed with the host clock.
+ * The sums prove every iteration converted the input.
+ */
+static void test_host_timing(void)
+{
+	static const mpu6050_motion_t raw = {
+		.accel = { -8192, 123, 32767 }, .temp = -1200, .gyro = { 131, -32768, 4000 },
+	};
+	const volatile mpu6050_motion_t *src = &raw;
+	volatile float sink_f;
+	mpu6050_motion_t in;
+	mpu6050_scaled_t scaled;
+	int64_t sum = 0;
+	uint64_t start;
+	uint64_t float_ns;
+	uint64_t fixed_ns;
+
+	start = host_ns();
+	for (uint32_t i = 0; i < SCALE_RUNS; i++) {
+		sink_f = (float)src->accel[0] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->accel[1] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->accel[2] / (float)MPU6050_ACCEL_LSB_PER_G;
+		sink_f = (float)src->temp / 340.0f + 36.53f;
+		sink_f = (float)src->gyro[0] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+		sink_f = (float)src->gyro[1] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+		sink_f = (float)src->gyro[2] / ((float)MPU6050_GYRO_LSB10_PER_DPS / 10.0f);
+	}
+	float_ns = host_ns() - start;
+	CHECK(sink_f > 30.0f);
+
+	in = raw;
+	start = host_ns();
+	for (uint32_t i = 0; i < SCALE_RUNS; i++) {
+		__asm volatile ("" : : "r" (&in) : "memory");
+		mpu6050_Scale(&in, &scaled);
+		__asm volatile ("" : : "r" (&scaled) : "memory");
+		sum += scaled.gyro[2];
+	}
+	fixed_ns = host_ns() - start;
+	CHECK_EQ(sum, (int64_t)SCALE_RUNS * q16_from_raw(4000, MPU6050_GYRO_SCALE_Q32));
+
+	printf("host scale float: %.2f ns/sample\n", (double)float_ns / SCALE_RUNS);
+	printf("host scale fixed: %.2f ns/sample\n", (double)fixed_ns / SCALE_RUNS);
+}
+
+
+int main(void)
+{
+	test_scale();
+	test_format();
+	test_host_timing();
+
+	return check_done("test_scale");
+}
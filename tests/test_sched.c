@@ -0,0 +1,326 @@
+/***************************************************************************
+ * File name     :  test_sched.c
+ * Description   :  Host simulation of the timer-wheel scheduler
+ *                  (projects/systick/Src/sched.c). sched.c is compiled into
+ *                  this file so the wheel internals are reachable; now_ms()
+ *                  is a fake clock the test moves, and powerIdle() is never
+ *                  called. A reference model of every armed timer checks
+ *                  that each release runs exactly at its expiry while the
+ *                  clock jumps tickless-style to schedNextExpiry() (never
+ *                  late, possibly early at a cascade), through start/cancel
+ *                  churn at all three wheel levels and past SCHED_SPAN_MS.
+ *                  Also covers overrun merging, deadline accounting,
+ *                  cancelling a queued task and event posting.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "sim.h"
+#include "sched.c"
+
+#define TASKS           16U
+#define STEPS           20000U
+
+static uint64_t fake_ms;
+
+/* Reference model, one per task */
+typedef struct {
+	uint8_t armed;
+	uint64_t expires;
+	uint32_t period;
+	uint32_t runs;
+} model_t;
+
+static sched_task_t tasks[TASKS];
+static model_t model[TASKS];
+static uint32_t rng = 12345U;
+static uint32_t late_runs;
+static uint32_t stray_runs;
+
+
+uint64_t now_ms(void)
+{
+	return fake_ms;
+}
+
+void powerIdle(uint64_t deadline_ms)
+{
+	CHECK(0);
+}
+
+
+static uint32_t rand_next(void)
+{
+	rng = rng * 1664525U + 1013904223U;
+	return rng >> 8;
+}
+
+
+/**
+ * @brief Task body of the random test: the run must match an armed timer
+ * expiring exactly now.
+ */
+static void model_run(sched_task_t *task, uint32_t events)
+{
+	model_t *m = &model[(sched_task_t *)task - tasks];
+
+	if (!(events & SCHED_EVT_TIMER) || !m->armed) {
+		stray_runs++;
+		return;
+	}
+	if ((m->expires != fake_ms) || (task->release != fake_ms)) {
+		late_runs++;
+	}
+
+	m->runs++;
+	if (m->period != 0U) {
+		m->expires += m->period;
+	} else {
+		m->armed = 0;
+	}
+}
+
+
+static void drain(void)
+{
+	while (schedRunOnce()) {
+	}
+}
+
+
+/**
+ * @brief A delay or period at one of the wheel levels, or beyond its span.
+ */
+static uint32_t rand_delay(void)
+{
+	switch (rand_next() % 4U) {
+	case 0:
+		return rand_next() % L0_SLOTS;
+	case 1:
+		return rand_next() % L1_SPAN_MS;
+	case 2:
+		return rand_next() % SCHED_SPAN_MS;
+	default:
+		return SCHED_SPAN_MS + (rand_next() % SCHED_SPAN_MS);
+	}
+}
+
+
+static void test_random_tickless(void)
+{
+	uint32_t total_runs = 0;
+
+	fake_ms = 1000U;
+	schedInit();
+	for (uint32_t i = 0; i < TASKS; i++) {
+		schedTaskInit(&tasks[i], model_run, NULL, "t");
+		model[i] = (model_t){ 0 };
+	}
+
+	for (uint32_t step = 0; step < STEPS; step++) {
+		uint64_t next;
+		uint64_t earliest = SCHED_NO_EXPIRY;
+		uint32_t r = rand_next() % 8U;
+		uint32_t i = rand_next() % TASKS;
+
+		/* Churn: arm, re-arm or cancel, at any level */
+		if (r < 2U) {
+			uint32_t delay = rand_delay();
+			uint32_t period = (rand_next() & 1U) ? 1U + rand_delay() : 0U;
+
+			schedStart(&tasks[i], delay, period);
+			model[i] = (model_t){ .armed = 1, .expires = fake_ms + delay, .period = period, .runs = model[i].runs };
+		} else if (r == 2U) {
+			schedCancel(&tasks[i]);
+			model[i].armed = 0;
+		}
+
+		/* A zero delay is due now */
+		drain();
+
+		for (uint32_t k = 0; k < TASKS; k++) {
+			if (model[k].armed && (model[k].expires < earliest)) {
+				earliest = model[k].expires;
+			}
+		}
+
+		/* Never late, never in the past */
+		next = schedNextExpiry();
+		CHECK(next <= earliest);
+		CHECK(next > fake_ms);
+		if (next == SCHED_NO_EXPIRY) {
+			fake_ms += 1U + (rand_next() % 1000U);
+			continue;
+		}
+
+		/* Sleep to the expiry, or wake early on an interrupt */
+		if ((rand_next() % 4U) == 0U) {
+			uint64_t wake = fake_ms + 1U + (rand_next() % 300U);
+
+			fake_ms = (wake < next) ? wake : next;
+		} else {
+			fake_ms = next;
+		}
+		drain();
+
+		/* Nothing due was left behind */
+		for (uint32_t k = 0; k < TASKS; k++) {
+			CHECK(!model[k].armed || (model[k].expires > fake_ms));
+		}
+	}
+
+	for (uint32_t i = 0; i < TASKS; i++) {
+		total_runs += model[i].runs;
+		CHECK_EQ(tasks[i].stats.runs, model[i].runs);
+		CHECK_EQ(tasks[i].stats.deadline_misses, 0);
+	}
+	CHECK_EQ(late_runs, 0);
+	CHECK_EQ(stray_runs, 0);
+	CHECK(total_runs > STEPS / 4U);
+}
+
+
+static void count_run(sched_task_t *task, uint32_t events)
+{
+	uint32_t *count = task->arg;
+
+	(*count)++;
+}
+
+
+static void test_every_millisecond(void)
+{
+	static const uint32_t periods[] = { 1U, 7U, L0_SLOTS, 300U, L1_SPAN_MS, 20000U };
+	static sched_task_t t[sizeof(periods) / sizeof(periods[0])];
+	static uint32_t counts[sizeof(periods) / sizeof(periods[0])];
+	uint64_t start;
+
+	/* Ticking clock: every period holds for 100 s from an unaligned start */
+	fake_ms = 123457U;
+	start = fake_ms;
+	schedInit();
+	for (uint32_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+		schedTaskInit(&t[i], count_run, &counts[i], "p");
+		schedStart(&t[i], periods[i], periods[i]);
+	}
+
+	while (fake_ms < start + 100000U) {
+		fake_ms++;
+		drain();
+	}
+
+	for (uint32_t i = 0; i < sizeof(periods) / sizeof(periods[0]); i++) {
+		CHECK_EQ(counts[i], 100000U / periods[i]);
+		CHECK_EQ(t[i].stats.deadline_misses, 0);
+		CHECK_EQ(t[i].expires, start + (100000U / periods[i] + 1U) * periods[i]);
+	}
+}
+
+
+static void test_overrun(void)
+{
+	static sched_task_t t;
+	static uint32_t count;
+
+	/* Four releases in one 23 ms jump: one run, from the first release, three lost */
+	fake_ms = 0;
+	schedInit();
+	schedTaskInit(&t, count_run, &count, "o");
+	schedStart(&t, 5U, 5U);
+
+	fake_ms = 23U;
+	drain();
+	CHECK_EQ(count, 1);
+	CHECK_EQ(t.release, 5);
+	CHECK_EQ(t.stats.deadline_misses, 3U + 1U);     // Lost releases, then the late finish
+	CHECK_EQ(t.expires, 25);
+
+	/* Back on schedule afterwards */
+	fake_ms = 25U;
+	drain();
+	CHECK_EQ(count, 2);
+	CHECK_EQ(t.stats.deadline_misses, 4);
+}
+
+
+static void test_cascade_boundary(void)
+{
+	static sched_task_t t;
+	static uint32_t count;
+
+	/* In level 1 from the start, its slot begins where the wheel stands next */
+	fake_ms = 0;
+	schedInit();
+	schedTaskInit(&t, count_run, &count, "c");
+	schedStart(&t, 300U, 0U);
+	CHECK_EQ(schedNextExpiry(), L0_SLOTS);
+
+	/* Woken just before the boundary: the cascade is still due, not the next one */
+	fake_ms = L0_SLOTS - 1U;
+	drain();
+	CHECK_EQ(schedNextExpiry(), L0_SLOTS);
+
+	/* Cascaded into level 0, now exact */
+	fake_ms = L0_SLOTS;
+	drain();
+	CHECK_EQ(schedNextExpiry(), 300);
+	fake_ms = 300U;
+	drain();
+	CHECK_EQ(count, 1);
+}
+
+
+static uint32_t posted_events;
+
+static void post_run(sched_task_t *task, uint32_t events)
+{
+	posted_events |= events;
+}
+
+
+static void test_post_and_cancel(void)
+{
+	static sched_task_t t;
+
+	fake_ms = 50U;
+	schedInit();
+	schedTaskInit(&t, post_run, NULL, "e");
+
+	/* Flags posted before the run merge into one, SCHED_EVT_TIMER is not postable */
+	schedPost(&t, 0x1U);
+	schedPost(&t, 0x4U | SCHED_EVT_TIMER);
+	CHECK_EQ(schedRunOnce(), 1);
+	CHECK_EQ(posted_events, 0x5U);
+	CHECK_EQ(t.stats.runs, 1);
+
+	/* Cancelled while queued: skipped when it reaches the head */
+	schedStart(&t, 10U, 10U);
+	schedPost(&t, 0x2U);
+	schedCancel(&t);
+	CHECK_EQ(schedRunOnce(), 0);
+	CHECK_EQ(t.stats.runs, 1);
+	CHECK(t.pprev == NULL);
+	CHECK_EQ(schedNextExpiry(), SCHED_NO_EXPIRY);
+
+	/* And re-armed afterwards */
+	schedStart(&t, 10U, 0U);
+	CHECK_EQ(schedNextExpiry(), 60);
+	fake_ms = 60U;
+	CHECK_EQ(schedRunOnce(), 1);
+	CHECK_EQ(t.stats.runs, 2);
+	CHECK_EQ(schedNextExpiry(), SCHED_NO_EXPIRY);
+}
+
+
+int main(void)
+{
+	sim_reset();
+
+	test_random_tickless();
+	test_every_millisecond();
+	test_overrun();
+	test_cascade_boundary();
+	test_post_and_cancel();
+
+	return check_done("test_sched");
+}
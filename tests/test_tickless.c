@@ -0,0 +1,162 @@
+/***************************************************************************
+ * File name     :  test_tickless.c
+ * Description   :  Host test of the tickless time base arithmetic
+ *                  (projects/systick/Inc/tickless.h) with the 72 MHz SysTick
+ *                  period: the stretched period length and its fold at a
+ *                  one cycle pause, elapsed cycles with and without
+ *                  COUNTFLAG, the tick/phase split and its fold at a one
+ *                  cycle remainder, a sleep/resume round trip that must
+ *                  keep the phase to within that folded cycle, and the RTC
+ *                  subsecond delta across midnight.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "sim.h"
+#include "systick.h"
+#include "clock.h"
+#include "timing.h"
+#include "tickless.h"
+
+#define LOAD            SYSTICK_RELOAD(CLOCK_HCLK_FREQ, SYSTICK_TICK_HZ)
+#define PERIOD          (LOAD + 1U)
+#define IDLE_MAX        (0xFFFFFFU / PERIOD)
+#define DAY_TICKS       (86400U * 20000U)   // RTC_DAY_TICKS in power.c
+#define RANDOM_RUNS     200000U
+
+static uint32_t rng = 2024U;
+
+static uint32_t rand_next(void)
+{
+	rng = rng * 1664525U + 1013904223U;
+	return rng >> 8;
+}
+
+
+static void test_idle_len(void)
+{
+	/* Ends on the boundary `ticks` ahead */
+	CHECK_EQ(tickless_idle_len(5000U, 1U, PERIOD), 5000U);
+	CHECK_EQ(tickless_idle_len(5000U, 3U, PERIOD), 5000U + 2U * PERIOD);
+	CHECK_EQ(tickless_idle_len(LOAD, IDLE_MAX, PERIOD), LOAD + (IDLE_MAX - 1U) * PERIOD);
+	CHECK(tickless_idle_len(PERIOD, IDLE_MAX, PERIOD) - 1U <= 0xFFFFFFU);
+
+	/* LOAD = 0 never programmed: a boundary 0 or 1 cycle away is slept through */
+	CHECK_EQ(tickless_idle_len(2U, 1U, PERIOD), 2U);
+	CHECK_EQ(tickless_idle_len(1U, 1U, PERIOD), 1U + PERIOD);
+	CHECK_EQ(tickless_idle_len(0U, 1U, PERIOD), PERIOD);
+	CHECK_EQ(tickless_idle_len(1U, 2U, PERIOD), 1U + PERIOD);
+}
+
+
+static void test_idle_elapsed(void)
+{
+	uint32_t len = 5000U + PERIOD;
+
+	/* Ended early: counted down from LOAD = len - 1 */
+	CHECK_EQ(tickless_idle_elapsed(len, len - 1U, 0U, LOAD), 1U);
+	CHECK_EQ(tickless_idle_elapsed(len, 0U, 0U, LOAD), len);
+
+	/* Long period done: the reload cycle, then down from the normal LOAD */
+	CHECK_EQ(tickless_idle_elapsed(len, LOAD, CSR_COUNTFLAG, LOAD), len + 1U);
+	CHECK_EQ(tickless_idle_elapsed(len, 0U, CSR_COUNTFLAG, LOAD), len + PERIOD);
+}
+
+
+static void test_resume_split(void)
+{
+	uint32_t rem;
+
+	/* Still inside the paused tick */
+	CHECK_EQ(tickless_resume_split(0U, 5000U, PERIOD, &rem), 0);
+	CHECK_EQ(rem, 5000U);
+	CHECK_EQ(tickless_resume_split(4998U, 5000U, PERIOD, &rem), 0);
+	CHECK_EQ(rem, 2U);
+
+	/* Exactly on a boundary: a full period to the next one */
+	CHECK_EQ(tickless_resume_split(5000U, 5000U, PERIOD, &rem), 1);
+	CHECK_EQ(rem, PERIOD);
+	CHECK_EQ(tickless_resume_split(5000U + 3ULL * PERIOD, 5000U, PERIOD, &rem), 4);
+	CHECK_EQ(rem, PERIOD);
+
+	/* One cycle short of a boundary: folded into that tick */
+	CHECK_EQ(tickless_resume_split(4999U, 5000U, PERIOD, &rem), 1);
+	CHECK_EQ(rem, PERIOD);
+	CHECK_EQ(tickless_resume_split(5000U + PERIOD - 1U, 5000U, PERIOD, &rem), 2);
+	CHECK_EQ(rem, PERIOD);
+	CHECK_EQ(tickless_resume_split(5000U + PERIOD - 2U, 5000U, PERIOD, &rem), 1);
+	CHECK_EQ(rem, 2U);
+
+	/* A long Stop: past the 32-bit cycle range */
+	CHECK_EQ(tickless_resume_split(20ULL * PERIOD * 1000U + 7U, 5000U, PERIOD, &rem), 20000U);
+	CHECK_EQ(rem, 5000U - 7U);
+}
+
+
+/**
+ * @brief systickIdle() then systickResume() on random pauses and wake-ups.
+ * Cycles into the paused tick plus the sleep must equal the ticks counted
+ * plus cycles into the new tick, one cycle more where the remainder folded.
+ */
+static void test_round_trip(void)
+{
+	uint32_t folds = 0;
+
+	for (uint32_t n = 0; n < RANDOM_RUNS; n++) {
+		uint32_t paused_val = rand_next() % PERIOD;
+		uint32_t ticks = 1U + (rand_next() % IDLE_MAX);
+		uint32_t len = tickless_idle_len(paused_val, ticks, PERIOD);
+		uint32_t full = (rand_next() & 1U);
+		uint32_t val = full ? (rand_next() % PERIOD) : (rand_next() % len);
+		uint32_t elapsed = tickless_idle_elapsed(len, val, full, LOAD);
+		uint64_t before;
+		uint64_t after;
+		uint64_t passed;
+		uint32_t rem;
+
+		CHECK((len >= 2U) && (len - 1U <= 0xFFFFFFU));
+		CHECK(elapsed > 0U);
+
+		passed = tickless_resume_split(elapsed, paused_val, PERIOD, &rem);
+		CHECK((rem >= 2U) && (rem <= PERIOD));
+
+		before = (uint64_t)(PERIOD - paused_val) + elapsed;
+		after = passed * PERIOD + (PERIOD - rem);
+		CHECK((after == before) || (after == before + 1U));
+		folds += (after != before);
+
+		/* The long period ran out on its boundary: the ticks asked for, more only past a fold */
+		if (full && (val == LOAD)) {
+			CHECK_EQ(passed, ticks + ((paused_val + (ticks - 1U) * PERIOD < 2U) ? 1U : 0U));
+			CHECK_EQ(rem, PERIOD - 1U);
+		}
+	}
+
+	/* One cycle remainders do turn up at this rate */
+	CHECK(folds > 0U);
+	CHECK(folds < RANDOM_RUNS / 1000U);
+}
+
+
+static void test_rtc_delta(void)
+{
+	CHECK_EQ(tickless_rtc_delta(1000U, 1000U, DAY_TICKS), 0);
+	CHECK_EQ(tickless_rtc_delta(460000U, 60000U, DAY_TICKS), 400000U);
+
+	/* Across midnight */
+	CHECK_EQ(tickless_rtc_delta(5U, DAY_TICKS - 10U, DAY_TICKS), 15U);
+	CHECK_EQ(tickless_rtc_delta(0U, DAY_TICKS - 1U, DAY_TICKS), 1U);
+	CHECK_EQ(tickless_rtc_delta(DAY_TICKS - 1U, 0U, DAY_TICKS), DAY_TICKS - 1U);
+}
+
+
+int main(void)
+{
+	test_idle_len();
+	test_idle_elapsed();
+	test_resume_split();
+	test_round_trip();
+	test_rtc_delta();
+
+	return check_done("test_tickless");
+}
@@ -0,0 +1,191 @@
+/***************************************************************************
+ * File name     :  test_timing.c
+ * Description   :  Host test of the timing.h calculators against the
+ *                  reference manual (RM0316): USART BRR against the baud
+ *                  rate error table at 72 MHz, I2C TIMINGR against the
+ *                  timing settings examples at 8, 16 and 48 MHz, timer
+ *                  PSC/ARR against hand-computed values, and the values the
+ *                  projects actually build with.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include "sim.h"
+#include "clock.h"
+#include "timing.h"
+
+#define TIMINGR_PRESC(t)    (((t) >> 28) & 0xFU)
+#define TIMINGR_SCLDEL(t)   (((t) >> 20) & 0xFU)
+#define TIMINGR_SDADEL(t)   (((t) >> 16) & 0xFU)
+#define TIMINGR_SCLH(t)     (((t) >> 8) & 0xFFU)
+#define TIMINGR_SCLL(t)     ((t) & 0xFFU)
+
+typedef enum {
+	MODE_STD = 0,
+	MODE_FAST,
+	MODE_FASTPLUS
+} i2c_mode_t;
+
+/* RM0316, "Error calculation for programmed baud rates at fCK = 72 MHz", oversampling by 16 */
+static const struct {
+	uint32_t baud;
+	uint32_t brr;
+} brr_table[] = {
+	{ 9600U,    0x1D4CU },
+	{ 19200U,   0xEA6U },
+	{ 38400U,   0x753U },
+	{ 57600U,   0x4E2U },
+	{ 115200U,  0x271U },
+	{ 230400U,  0x139U },
+	{ 460800U,  0x9CU },
+	{ 921600U,  0x4EU },
+	{ 4000000U, 0x12U },
+	{ 4500000U, 0x10U },
+};
+
+/*
+ * RM0316, "Examples of timings settings for fI2CCLK = 8/16/48 MHz". Standard
+ * mode is reproduced field for field. In Fast-mode the calculator rounds the
+ * data hold up to whole 125 ns ticks, so SDADEL may sit one tick away from the
+ * table where the table picked a different point inside the hold window.
+ * Fast-mode Plus needs I2CCLK >= 17 MHz here, so only the 48 MHz row applies.
+ */
+static const struct {
+	uint32_t clk;
+	i2c_mode_t mode;
+	uint32_t presc, scll, sclh, sdadel, scldel;
+	uint32_t sdadel_tol;
+} timingr_table[] = {
+	{ 8000000U,  MODE_STD,      0x1U, 0x13U, 0x0FU, 0x2U, 0x4U, 0U },
+	{ 16000000U, MODE_STD,      0x3U, 0x13U, 0x0FU, 0x2U, 0x4U, 0U },
+	{ 48000000U, MODE_STD,      0xBU, 0x13U, 0x0FU, 0x2U, 0x4U, 0U },
+	{ 8000000U,  MODE_FAST,     0x0U, 0x09U, 0x03U, 0x1U, 0x3U, 1U },
+	{ 16000000U, MODE_FAST,     0x1U, 0x09U, 0x03U, 0x2U, 0x3U, 1U },
+	{ 48000000U, MODE_FAST,     0x5U, 0x09U, 0x03U, 0x3U, 0x3U, 1U },
+	{ 48000000U, MODE_FASTPLUS, 0x5U, 0x03U, 0x01U, 0x0U, 0x1U, 0U },
+};
+
+/* I2C-bus specification (UM10204) limits the calculator targets */
+static const struct {
+	uint32_t scl_freq;
+	uint32_t tr_max_ns;         // SCL/SDA rise time
+	uint32_t tsu_dat_min_ns;    // Data setup time
+} i2c_spec[] = {
+	[MODE_STD]      = { 100000U,  1000U, 250U },
+	[MODE_FAST]     = { 400000U,  300U,  100U },
+	[MODE_FASTPLUS] = { 1000000U, 120U,  50U },
+};
+
+
+static uint32_t timingr(uint32_t clk, i2c_mode_t mode)
+{
+	switch (mode) {
+	case MODE_STD:
+		return I2C_TIMINGR(clk, STD);
+	case MODE_FAST:
+		return I2C_TIMINGR(clk, FAST);
+	default:
+		return I2C_TIMINGR(clk, FASTPLUS);
+	}
+}
+
+
+static uint64_t scl_actual(uint32_t clk, i2c_mode_t mode)
+{
+	switch (mode) {
+	case MODE_STD:
+		return I2C_SCL_ACTUAL(clk, STD);
+	case MODE_FAST:
+		return I2C_SCL_ACTUAL(clk, FAST);
+	default:
+		return I2C_SCL_ACTUAL(clk, FASTPLUS);
+	}
+}
+
+
+/**
+ * @brief Checks the fields a TIMINGR value for clk and mode must satisfy
+ * whatever the clock: field ranges, the data setup after the slowest
+ * allowed rise, and the estimated SCL rate within tolerance.
+ */
+static void check_i2c_limits(uint32_t clk, i2c_mode_t mode)
+{
+	uint32_t t = timingr(clk, mode);
+	uint64_t tpresc_ps = ((uint64_t)(TIMINGR_PRESC(t) + 1U) * 1000000000000ULL) / clk;
+	uint64_t tscldel_ns = ((TIMINGR_SCLDEL(t) + 1U) * tpresc_ps) / 1000U;
+	uint64_t scl = scl_actual(clk, mode);
+
+	CHECK(TIMINGR_SCLL(t) >= TIMINGR_SCLH(t));
+	CHECK(tscldel_ns >= (uint64_t)i2c_spec[mode].tr_max_ns + i2c_spec[mode].tsu_dat_min_ns);
+	CHECK(TIMING_ERR_PPM(scl, i2c_spec[mode].scl_freq) <= I2C_MAX_ERR_PPM);
+}
+
+
+static void test_uart_brr(void)
+{
+	for (uint32_t i = 0; i < sizeof(brr_table) / sizeof(brr_table[0]); i++) {
+		CHECK_EQ(UART_BRR(72000000U, brr_table[i].baud), brr_table[i].brr);
+		CHECK(UART_BAUD_ERR_PPM(72000000U, brr_table[i].baud) <= UART_MAX_ERR_PPM);
+	}
+
+	/* What every project builds with: 36 MHz / 115200 = 312.5 */
+	CHECK_EQ(UART_BRR(CLOCK_PCLK1_FREQ, 115200U), 313);
+	CHECK(UART_BAUD_ERR_PPM(CLOCK_PCLK1_FREQ, 115200U) <= UART_MAX_ERR_PPM);
+}
+
+
+static void test_tim(void)
+{
+	static const uint32_t rates[] = { 1U, 2U, 50U, 100U, 1000U, 1100U, 20000U, 44100U, 1000000U };
+
+	/* 72 MHz: 1 kHz needs a prescaler of 2, 10 kHz none */
+	CHECK_EQ(TIM_PSC(72000000U, 1000U), 1);
+	CHECK_EQ(TIM_ARR(72000000U, 1000U), 35999);
+	CHECK_EQ(TIM_PSC(72000000U, 10000U), 0);
+	CHECK_EQ(TIM_ARR(72000000U, 10000U), 7199);
+	CHECK_EQ(TIM_PSC(72000000U, 1U), 1098);
+	CHECK_EQ(TIM_ARR(72000000U, 1U), 65513);
+
+	/* Smallest prescaler that fits: one less would overflow ARR */
+	for (uint32_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+		uint64_t cycles = TIM_CYCLES(CLOCK_TIM_APB1_FREQ, rates[i]);
+		uint32_t psc = TIM_PSC(CLOCK_TIM_APB1_FREQ, rates[i]);
+
+		CHECK(TIM_ARR(CLOCK_TIM_APB1_FREQ, rates[i]) <= 0xFFFFU);
+		CHECK((psc == 0U) || (cycles > (uint64_t)psc * 65536U));
+		CHECK(TIM_ERR_PPM(CLOCK_TIM_APB1_FREQ, rates[i]) <= TIM_MAX_ERR_PPM);
+	}
+}
+
+
+static void test_i2c_timingr(void)
+{
+	for (uint32_t i = 0; i < sizeof(timingr_table) / sizeof(timingr_table[0]); i++) {
+		uint32_t t = timingr(timingr_table[i].clk, timingr_table[i].mode);
+		uint32_t sdadel = TIMINGR_SDADEL(t);
+
+		CHECK_EQ(TIMINGR_PRESC(t), timingr_table[i].presc);
+		CHECK_EQ(TIMINGR_SCLL(t), timingr_table[i].scll);
+		CHECK_EQ(TIMINGR_SCLH(t), timingr_table[i].sclh);
+		CHECK_EQ(TIMINGR_SCLDEL(t), timingr_table[i].scldel);
+		CHECK(TIMING_ABS_DIFF(sdadel, timingr_table[i].sdadel) <= timingr_table[i].sdadel_tol);
+
+		check_i2c_limits(timingr_table[i].clk, timingr_table[i].mode);
+	}
+
+	/* The clock the driver runs I2C1 from, where PRESC saturates in standard mode */
+	CHECK_EQ(TIMINGR_PRESC(I2C_TIMINGR(CLOCK_I2C1_FREQ, STD)), 15);
+	check_i2c_limits(CLOCK_I2C1_FREQ, MODE_STD);
+	check_i2c_limits(CLOCK_I2C1_FREQ, MODE_FAST);
+	check_i2c_limits(CLOCK_I2C1_FREQ, MODE_FASTPLUS);
+}
+
+
+int main(void)
+{
+	test_uart_brr();
+	test_tim();
+	test_i2c_timingr();
+
+	return check_done("test_timing");
+}
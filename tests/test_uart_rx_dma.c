@@ -0,0 +1,259 @@
+/***************************************************************************
+ * File name     :  test_uart_rx_dma.c
+ * Description   :  Host test of the circular DMA USART3 receiver
+ *                  (projects/uart_dma). The test plays DMA1 Channel 3: it
+ *                  writes synthetic bursts into the buffer at CMAR, counts
+ *                  CNDTR down with the circular reload, raises HT/TC at the
+ *                  buffer halves and IDLE after each burst, and checks the
+ *                  published spans, the wrap split and the overrun paths.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "uart.h"
+
+void DMA1_CH3_IRQHandler(void);
+void USART3_EXTI28_IRQHandler(void);
+
+static uint32_t dma_pos;        // Next buffer offset the simulated DMA writes
+static uint8_t pattern;         // Running byte value, every burst byte is unique mod 256
+
+
+/**
+ * @brief Raises DMA flags and runs the channel 3 interrupt.
+ */
+static void dma_irq(uint32_t flags)
+{
+	DMA1->ISR = flags;
+	DMA1_CH3_IRQHandler();
+	DMA1->ISR = 0;
+}
+
+
+/**
+ * @brief Line goes idle after a burst.
+ */
+static void usart_idle(void)
+{
+	USART3->ISR = ISR_IDLE;
+	USART3_EXTI28_IRQHandler();
+	USART3->ISR = 0;
+}
+
+
+/**
+ * @brief Receives len bytes through the simulated DMA, with HT and TC
+ * interrupts where the hardware raises them.
+ * @param out Copy of the bytes sent, may be NULL.
+ */
+static void rx_burst(uint32_t len, uint8_t *out)
+{
+	uint8_t *buf = sim_ptr(DMA1_Channel3->CMAR);
+
+	for (uint32_t i = 0; i < len; i++) {
+		buf[dma_pos] = pattern;
+		if (out != NULL) {
+			out[i] = pattern;
+		}
+		pattern++;
+
+		dma_pos = (dma_pos + 1U) % UART3_RX_BUF_SIZE;
+		DMA1_Channel3->CNDTR = (DMA1_Channel3->CNDTR == 1U) ? UART3_RX_BUF_SIZE : DMA1_Channel3->CNDTR - 1U;
+
+		if (dma_pos == UART3_RX_BUF_SIZE / 2U) {
+			dma_irq(DMA1_ISR_HTIF3);
+		} else if (dma_pos == 0U) {
+			dma_irq(DMA1_ISR_TCIF3);
+		}
+	}
+}
+
+
+/**
+ * @brief Pops every published span, checking each is contiguous inside the
+ * DMA buffer, and concatenates them.
+ * @return Total bytes collected, or -1 on a span outside the buffer.
+ */
+static int collect(uint8_t *out, uint32_t *spans)
+{
+	const uint8_t *buf = sim_ptr(DMA1_Channel3->CMAR);
+	uart_rx_span_t span;
+	int total = 0;
+
+	*spans = 0;
+	while (uart3_rx_get_span(&span)) {
+		if ((span.len == 0U) || (span.data < buf) || (span.data + span.len > buf + UART3_RX_BUF_SIZE)) {
+			return -1;
+		}
+		memcpy(&out[total], span.data, span.len);
+		total += span.len;
+		(*spans)++;
+		uart3_rx_release();
+	}
+	return total;
+}
+
+
+/**
+ * @brief Fills up to the end of the buffer and drops whatever was published,
+ * so the next burst starts at offset 0.
+ */
+static void align_to_start(void)
+{
+	static uint8_t scratch[UART3_RX_BUF_SIZE];
+	uint32_t spans;
+
+	rx_burst((UART3_RX_BUF_SIZE - dma_pos) % UART3_RX_BUF_SIZE, NULL);
+	usart_idle();
+	(void)collect(scratch, &spans);
+}
+
+
+static void test_init(void)
+{
+	sim_reset();
+	uart3_tx_rx_init();
+	uart3_rx_dma_init();
+
+	CHECK_EQ(DMA1_Channel3->CPAR, (uint32_t)&USART3->RDR);
+	CHECK_EQ(DMA1_Channel3->CNDTR, UART3_RX_BUF_SIZE);
+	CHECK((DMA1_Channel3->CCR & (DMA1_CIRC | DMA1_MINC | DMA1_CCR_HTIE | DMA1_CCR_TCIE | DMA1_CCR_EN)) ==
+	      (DMA1_CIRC | DMA1_MINC | DMA1_CCR_HTIE | DMA1_CCR_TCIE | DMA1_CCR_EN));
+	CHECK(USART3->CR3 & USART3_CR3_DMAR);
+	CHECK(USART3->CR1 & CR1_IDLEIE);
+	CHECK(sim_irq_enabled(DMA1_Channel3_IRQn));
+	CHECK(sim_irq_enabled(USART3_IRQn));
+}
+
+
+static void test_frames(void)
+{
+	static uint8_t sent[3U * UART3_RX_BUF_SIZE];
+	static uint8_t got[3U * UART3_RX_BUF_SIZE];
+	uint32_t spans;
+	int n;
+
+	/* Short frame closed by IDLE */
+	rx_burst(5, sent);
+	usart_idle();
+	n = collect(got, &spans);
+	CHECK_EQ(n, 5);
+	CHECK_EQ(spans, 1);
+	CHECK(memcmp(got, sent, 5) == 0);
+
+	/* Across the half: HT publishes the first part, IDLE the rest */
+	rx_burst(70, sent);
+	usart_idle();
+	n = collect(got, &spans);
+	CHECK_EQ(n, 70);
+	CHECK_EQ(spans, 2);
+	CHECK(memcmp(got, sent, 70) == 0);
+
+	/* Across the end: TC at the wrap, then the wrapped part as its own span */
+	CHECK_EQ(dma_pos, 75);
+	rx_burst(100, sent);
+	usart_idle();
+	n = collect(got, &spans);
+	CHECK_EQ(n, 100);
+	CHECK_EQ(spans, 2);
+	CHECK(memcmp(got, sent, 100) == 0);
+
+	/* IDLE with nothing new publishes nothing */
+	usart_idle();
+	CHECK_EQ(collect(got, &spans), 0);
+
+	/* Longer than the whole buffer, drained half by half as HT/TC publish it */
+	align_to_start();
+	for (uint32_t i = 0; i < 6U; i++) {
+		rx_burst(UART3_RX_BUF_SIZE / 2U, sent);
+		n = collect(got, &spans);
+		CHECK_EQ(n, UART3_RX_BUF_SIZE / 2U);
+		CHECK(memcmp(got, sent, UART3_RX_BUF_SIZE / 2U) == 0);
+	}
+	usart_idle();
+	CHECK_EQ(collect(got, &spans), 0);
+	CHECK_EQ(uart3_rx_overruns(), 0);
+}
+
+
+static void test_consumer_behind(void)
+{
+	static uint8_t first[UART3_RX_BUF_SIZE];
+	static uint8_t second[UART3_RX_BUF_SIZE];
+	uart_rx_span_t span;
+	uint32_t overruns = uart3_rx_overruns();
+	uint32_t fits = UART3_RX_BUF_SIZE - 100U;
+
+	align_to_start();
+
+	/* 100 bytes held (HT splits them 64 + 36), then 40 more: 28 fit before the wrap, the 12 after it land on held bytes */
+	rx_burst(100, first);
+	usart_idle();
+	rx_burst(40, second);
+	usart_idle();
+
+	CHECK_EQ(uart3_rx_overruns(), overruns + 1U);
+
+	CHECK(uart3_rx_get_span(&span));
+	CHECK_EQ(span.len, UART3_RX_BUF_SIZE / 2U);
+	uart3_rx_release();
+	CHECK(uart3_rx_get_span(&span));
+	CHECK_EQ(span.len, 100U - UART3_RX_BUF_SIZE / 2U);
+	uart3_rx_release();
+
+	CHECK(uart3_rx_get_span(&span));
+	CHECK_EQ(span.len, fits);
+	CHECK(memcmp(span.data, second, fits) == 0);
+	uart3_rx_release();
+
+	/* The overwritten part is not handed out */
+	CHECK(!uart3_rx_get_span(&span));
+
+	/* Back in step afterwards */
+	rx_burst(10, first);
+	usart_idle();
+	CHECK(uart3_rx_get_span(&span));
+	CHECK_EQ(span.len, 10);
+	CHECK(memcmp(span.data, first, 10) == 0);
+	uart3_rx_release();
+}
+
+
+static void test_queue_full_and_ore(void)
+{
+	uart_rx_span_t span;
+	uint32_t overruns = uart3_rx_overruns();
+	uint32_t count = 0;
+
+	/* One more frame than the span queue holds */
+	for (uint32_t i = 0; i < UART3_RX_SPAN_QUEUE + 1U; i++) {
+		rx_burst(3, NULL);
+		usart_idle();
+	}
+	CHECK_EQ(uart3_rx_overruns(), overruns + 1U);
+	while (uart3_rx_get_span(&span)) {
+		CHECK_EQ(span.len, 3);
+		uart3_rx_release();
+		count++;
+	}
+	CHECK_EQ(count, UART3_RX_SPAN_QUEUE);
+
+	/* USART overrun, the DMA missed a byte */
+	USART3->ISR = ISR_ORE;
+	USART3_EXTI28_IRQHandler();
+	USART3->ISR = 0;
+	CHECK_EQ(uart3_rx_overruns(), overruns + 2U);
+}
+
+
+int main(void)
+{
+	test_init();
+	test_frames();
+	test_consumer_behind();
+	test_queue_full_and_ore();
+
+	return check_done("test_uart_rx_dma");
+}
@@ -0,0 +1,212 @@
+/***************************************************************************
+ * File name     :  test_uart_tx_dma.c
+ * Description   :  Host test of the queued DMA1 Channel 2 transmit engine
+ *                  (projects/uart_dma). The test plays the DMA: it moves the
+ *                  bytes of the enabled channel from CMAR to the line, counts
+ *                  CNDTR down and raises transfer complete or error, and
+ *                  checks descriptor chaining, queue wraparound, callback
+ *                  order and the depth and in-flight counters.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "uart.h"
+
+#define LINE_MAX            4096U
+#define LOG_MAX             64U
+
+void DMA1_CH2_IRQHandler(void);
+
+static uint8_t line[LINE_MAX];      // Everything the DMA has handed to TDR
+static uint32_t line_len;
+
+/* Callback log, with the channel state seen at the time of each callback */
+static const uint8_t *cb_data[LOG_MAX];
+static uint16_t cb_len[LOG_MAX];
+static uint32_t cb_next_cmar[LOG_MAX];
+static uint32_t cb_count;
+
+static uint8_t msgs[24][40];
+
+
+static void on_sent(const uint8_t *data, uint16_t len)
+{
+	if (cb_count < LOG_MAX) {
+		cb_data[cb_count] = data;
+		cb_len[cb_count] = len;
+		cb_next_cmar[cb_count] = (DMA1_Channel2->CCR & DMA1_CCR_EN) ? DMA1_Channel2->CMAR : 0U;
+	}
+	cb_count++;
+}
+
+
+/**
+ * @brief Moves the rest of the active transfer to the line and raises
+ * transfer complete (or error) on channel 2.
+ * @return 0 if the channel was not enabled.
+ */
+static int dma_finish(int error)
+{
+	const uint8_t *src;
+
+	if (!(DMA1_Channel2->CCR & DMA1_CCR_EN)) {
+		return 0;
+	}
+
+	src = sim_ptr(DMA1_Channel2->CMAR);
+	while (DMA1_Channel2->CNDTR > 0U) {
+		line[line_len++ % LINE_MAX] = *src++;
+		DMA1_Channel2->CNDTR--;
+	}
+
+	DMA1->ISR = error ? DMA1_ISR_TEIF2 : DMA1_ISR_TCIF2;
+	DMA1_CH2_IRQHandler();
+	DMA1->ISR = 0;
+	return 1;
+}
+
+
+static void fill_msgs(void)
+{
+	for (uint32_t m = 0; m < sizeof(msgs) / sizeof(msgs[0]); m++) {
+		for (uint32_t i = 0; i < sizeof(msgs[0]); i++) {
+			msgs[m][i] = (uint8_t)(m * 40U + i);
+		}
+	}
+}
+
+
+static void test_init(void)
+{
+	sim_reset();
+	uart3_tx_rx_init();
+	uart3_tx_dma_init();
+
+	CHECK_EQ(DMA1_Channel2->CPAR, (uint32_t)&USART3->TDR);
+	CHECK((DMA1_Channel2->CCR & (DMA1_MINC | DMA1_DIR | DMA1_CCR_TCIE | DMA1_CCR_TEIE)) ==
+	      (DMA1_MINC | DMA1_DIR | DMA1_CCR_TCIE | DMA1_CCR_TEIE));
+	CHECK((DMA1_Channel2->CCR & DMA1_CCR_EN) == 0U);
+	CHECK(USART3->CR3 & USART3_CR3_DMAT);
+	CHECK(sim_irq_enabled(DMA1_Channel2_IRQn));
+
+	CHECK_EQ(uart3_tx_dma_submit(msgs[0], 0, on_sent), -1);
+	CHECK_EQ(uart3_tx_dma_queue_depth(), 0);
+}
+
+
+static void test_chaining(void)
+{
+	line_len = 0;
+	cb_count = 0;
+
+	/* First submit starts the idle engine at once */
+	CHECK_EQ(uart3_tx_dma_submit(msgs[0], 10, on_sent), 0);
+	CHECK(DMA1_Channel2->CCR & DMA1_CCR_EN);
+	CHECK_EQ(DMA1_Channel2->CMAR, (uint32_t)msgs[0]);
+	CHECK_EQ(DMA1_Channel2->CNDTR, 10);
+
+	CHECK_EQ(uart3_tx_dma_submit(msgs[1], 20, on_sent), 0);
+	CHECK_EQ(uart3_tx_dma_submit(msgs[2], 30, NULL), 0);
+	CHECK_EQ(uart3_tx_dma_queue_depth(), 3);
+	CHECK_EQ(uart3_tx_dma_bytes_in_flight(), 60);
+	CHECK(sim_irq_enabled(DMA1_Channel2_IRQn));
+
+	/* Four bytes of the first message are out */
+	DMA1_Channel2->CNDTR = 6;
+	CHECK_EQ(uart3_tx_dma_bytes_in_flight(), 56);
+	DMA1_Channel2->CNDTR = 10;
+
+	/* The next descriptor is already running when the callback sees the channel */
+	CHECK(dma_finish(0));
+	CHECK_EQ(cb_count, 1);
+	CHECK(cb_data[0] == msgs[0]);
+	CHECK_EQ(cb_len[0], 10);
+	CHECK_EQ(cb_next_cmar[0], (uint32_t)msgs[1]);
+	CHECK_EQ(uart3_tx_dma_queue_depth(), 2);
+
+	CHECK(dma_finish(0));
+	CHECK_EQ(cb_next_cmar[1], (uint32_t)msgs[2]);
+	CHECK(dma_finish(0));
+
+	/* NULL callback: retired silently, engine idle */
+	CHECK_EQ(cb_count, 2);
+	CHECK((DMA1_Channel2->CCR & DMA1_CCR_EN) == 0U);
+	CHECK_EQ(uart3_tx_dma_queue_depth(), 0);
+	CHECK_EQ(uart3_tx_dma_bytes_in_flight(), 0);
+
+	/* Back to back on the line, nothing repeated or skipped */
+	CHECK_EQ(line_len, 60);
+	CHECK(memcmp(line, msgs[0], 10) == 0);
+	CHECK(memcmp(&line[10], msgs[1], 20) == 0);
+	CHECK(memcmp(&line[30], msgs[2], 30) == 0);
+	CHECK(!dma_finish(0));
+}
+
+
+static void test_wraparound(void)
+{
+	uint32_t submitted = 0;
+	uint32_t expected = 0;
+
+	line_len = 0;
+	cb_count = 0;
+
+	/* Fill the queue: one descriptor more than it holds is refused */
+	for (uint32_t i = 0; i < UART3_TX_QUEUE_DEPTH; i++) {
+		CHECK_EQ(uart3_tx_dma_submit(msgs[submitted], (uint16_t)(5U + submitted), on_sent), 0);
+		submitted++;
+	}
+	CHECK_EQ(uart3_tx_dma_submit(msgs[submitted], 5, on_sent), -1);
+	CHECK_EQ(uart3_tx_dma_queue_depth(), UART3_TX_QUEUE_DEPTH);
+
+	/* Keep it topped up while it drains, the slots wrap twice */
+	while (submitted < 24U) {
+		CHECK(dma_finish(0));
+		CHECK_EQ(uart3_tx_dma_submit(msgs[submitted], (uint16_t)(5U + submitted), on_sent), 0);
+		submitted++;
+	}
+	while (dma_finish(0)) {}
+
+	/* Callbacks in submission order, each with its own buffer and length */
+	CHECK_EQ(cb_count, 24);
+	for (uint32_t i = 0; i < 24U; i++) {
+		CHECK(cb_data[i] == msgs[i]);
+		CHECK_EQ(cb_len[i], 5U + i);
+	}
+
+	for (uint32_t i = 0; i < 24U; i++) {
+		CHECK(memcmp(&line[expected], msgs[i], 5U + i) == 0);
+		expected += 5U + i;
+	}
+	CHECK_EQ(line_len, expected);
+	CHECK_EQ(uart3_tx_dma_bytes_in_flight(), 0);
+}
+
+
+static void test_error(void)
+{
+	cb_count = 0;
+
+	/* A transfer error retires the descriptor and the engine moves on */
+	CHECK_EQ(uart3_tx_dma_submit(msgs[0], 8, on_sent), 0);
+	CHECK_EQ(uart3_tx_dma_submit(msgs[1], 8, on_sent), 0);
+	CHECK(dma_finish(1));
+	CHECK_EQ(cb_count, 1);
+	CHECK_EQ(cb_next_cmar[0], (uint32_t)msgs[1]);
+	CHECK(dma_finish(0));
+	CHECK_EQ(uart3_tx_dma_queue_depth(), 0);
+}
+
+
+int main(void)
+{
+	fill_msgs();
+	test_init();
+	test_chaining();
+	test_wraparound();
+	test_error();
+
+	return check_done("test_uart_tx_dma");
+}
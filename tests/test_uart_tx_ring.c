@@ -0,0 +1,160 @@
+/***************************************************************************
+ * File name     :  test_uart_tx_ring.c
+ * Description   :  Host test of the interrupt-driven USART3 TX ring buffer
+ *                  (projects/uart). The test plays the USART: it raises TXE,
+ *                  calls the interrupt handler and collects what the driver
+ *                  writes to TDR, checking order, index wrap, the drop and
+ *                  overwrite policies and the TXEIE hand-off.
+ *
+ * Author        :  Jere Piirainen
+ * Date          :  2026-10-16
+ **************************************************************************/
+#include <string.h>
+#include "sim.h"
+#include "uart.h"
+
+#define CR1_TXEIE       (1U << 7)
+#define ISR_TXE         (1U << 7)
+#define ISR_TC          (1U << 6)
+#define MAX_DRAIN       (4U * UART3_TX_BUF_SIZE)
+
+void USART3_EXTI28_IRQHandler(void);
+
+static uint8_t sent[MAX_DRAIN];
+
+
+/**
+ * @brief Runs the TXE interrupt until the driver masks it, as the USART
+ * would with an empty data register after every byte.
+ * @param max Stop after this many bytes even if TXEIE stays on.
+ * @return Number of bytes written to TDR.
+ */
+static uint32_t drain(uint32_t max)
+{
+	uint32_t n = 0;
+
+	while ((USART3->CR1 & CR1_TXEIE) && (n < max)) {
+		USART3->TDR = 0xFFFFU;      // Marker, a sent byte replaces it
+		USART3->ISR = ISR_TXE | ISR_TC;
+		USART3_EXTI28_IRQHandler();
+		if (USART3->TDR != 0xFFFFU) {
+			sent[n++] = (uint8_t)USART3->TDR;
+		}
+	}
+	return n;
+}
+
+
+static void test_init(void)
+{
+	sim_reset();
+	uart3_tx_rx_init();
+
+	/* 36 MHz / 115200 = 312.5, rounded */
+	CHECK_EQ(USART3->BRR, 313);
+	CHECK(sim_irq_enabled(USART3_IRQn));
+	CHECK((USART3->CR1 & CR1_TXEIE) == 0U);
+}
+
+
+static void test_order_and_drop(void)
+{
+	static uint8_t data[UART3_TX_BUF_SIZE + 44U];
+
+	for (uint32_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)i;
+	}
+
+	uart3_set_tx_policy(UART_TX_DROP);
+	CHECK_EQ(uart3_write_async(data, sizeof(data)), UART3_TX_BUF_SIZE);
+	CHECK(USART3->CR1 & CR1_TXEIE);
+
+	/* Full: nothing more until the ISR makes room */
+	CHECK_EQ(uart3_write_async(data, 1), 0);
+
+	CHECK_EQ(drain(MAX_DRAIN), UART3_TX_BUF_SIZE);
+	CHECK(memcmp(sent, data, UART3_TX_BUF_SIZE) == 0);
+
+	/* Ring empty: the handler turns TXE interrupts off */
+	CHECK((USART3->CR1 & CR1_TXEIE) == 0U);
+}
+
+
+static void test_wrap(void)
+{
+	static uint8_t chunk[97];
+	uint8_t next = 0;
+	uint8_t expect = 0;
+
+	/* Odd chunk sizes against partial drains move the indices across the buffer end many times */
+	for (uint32_t round = 0; round < 40U; round++) {
+		uint32_t n;
+
+		for (uint32_t i = 0; i < sizeof(chunk); i++) {
+			chunk[i] = next++;
+		}
+		CHECK_EQ(uart3_write_async(chunk, sizeof(chunk)), sizeof(chunk));
+
+		n = drain(sizeof(chunk));
+		for (uint32_t i = 0; i < n; i++) {
+			if (sent[i] != expect) {
+				CHECK_EQ(sent[i], expect);
+				return;
+			}
+			expect++;
+		}
+	}
+	CHECK_EQ(next, expect);
+}
+
+
+static void test_overwrite(void)
+{
+	static uint8_t data[UART3_TX_BUF_SIZE + 10U];
+
+	for (uint32_t i = 0; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 7U);
+	}
+
+	uart3_set_tx_policy(UART_TX_OVERWRITE);
+	CHECK_EQ(uart3_write_async(data, UART3_TX_BUF_SIZE), UART3_TX_BUF_SIZE);
+	CHECK_EQ(uart3_write_async(&data[UART3_TX_BUF_SIZE], 10), 10);
+
+	/* The interrupt is back on after the oldest bytes were discarded */
+	CHECK(sim_irq_enabled(USART3_IRQn));
+
+	/* The ten oldest bytes are gone, the newest are at the end */
+	CHECK_EQ(drain(MAX_DRAIN), UART3_TX_BUF_SIZE);
+	CHECK(memcmp(sent, &data[10], UART3_TX_BUF_SIZE) == 0);
+}
+
+
+static void test_spurious(void)
+{
+	/* TXE without TXEIE, as in the idle state: the handler must not touch TDR */
+	USART3->TDR = 0x1234U;
+	USART3->ISR = ISR_TXE;
+	USART3_EXTI28_IRQHandler();
+	CHECK_EQ(USART3->TDR, 0x1234U);
+
+	/* TXEIE on but TDR still full */
+	uart3_set_tx_policy(UART_TX_DROP);
+	uart3_puts("ab");
+	USART3->ISR = 0;
+	USART3_EXTI28_IRQHandler();
+	CHECK_EQ(USART3->TDR, 0x1234U);
+	CHECK_EQ(drain(MAX_DRAIN), 2);
+	CHECK(memcmp(sent, "ab", 2) == 0);
+}
+
+
+int main(void)
+{
+	test_init();
+	test_order_and_drop();
+	test_wrap();
+	test_overwrite();
+	test_spurious();
+
+	return check_done("test_uart_tx_ring");
+}